@@ -0,0 +1,57 @@
+/**
+ * @file button_debounce.h
+ * @brief Header for button_debounce.c file. Filtro anti-rebote bit a bit con contadores verticales.
+ *
+ * Cada bit de una palabra de 32 bits es un botón. Para cada bit se mantiene un contador de 2 bits repartido en dos
+ * palabras (`cnt0` y `cnt1`, el contador "vertical"), de modo que una muestra de todos los botones se filtra con unas
+ * pocas operaciones lógicas, sin bucles ni saltos. Un botón cambia de estado cuando `BUTTON_DEBOUNCE_SAMPLES` muestras
+ * consecutivas difieren de su estado filtrado; cualquier muestra igual al estado reinicia su contador.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+#ifndef BUTTON_DEBOUNCE_H_
+#define BUTTON_DEBOUNCE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define BUTTON_DEBOUNCE_SAMPLES 4 /*!< Muestras consecutivas necesarias para aceptar un cambio (fijado por el contador de 2 bits) */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Estado del filtro de hasta 32 botones.
+ */
+typedef struct
+{
+    uint32_t state; /*!< Estado filtrado: bit a 1 si el botón está presionado */
+    uint32_t cnt0;  /*!< Bit 0 de los contadores verticales */
+    uint32_t cnt1;  /*!< Bit 1 de los contadores verticales */
+} button_debounce_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Inicializa el filtro con un estado estable, sin generar flancos.
+ *
+ * @param p_debounce Puntero al filtro.
+ * @param state Estado inicial (bit a 1 si el botón está presionado).
+ */
+void button_debounce_init(button_debounce_t *p_debounce, uint32_t state);
+
+/**
+ * @brief Procesa una muestra de todos los botones.
+ *
+ * @param p_debounce Puntero al filtro.
+ * @param sample Muestra sin filtrar (bit a 1 si el botón está presionado).
+ * @param p_pressed Puntero donde se guardan los botones que pasan a presionados en esta muestra.
+ * @param p_released Puntero donde se guardan los botones que pasan a liberados en esta muestra.
+ * @return Máscara de los botones que han cambiado de estado.
+ */
+uint32_t button_debounce_update(button_debounce_t *p_debounce, uint32_t sample, uint32_t *p_pressed, uint32_t *p_released);
+
+#endif /* BUTTON_DEBOUNCE_H_ */
@@ -0,0 +1,128 @@
+/**
+ * @file cmd_registry.h
+ * @brief Header for cmd_registry.c file. Registro de órdenes de la consola serie con hash perfecto.
+ *
+ * Las órdenes se declaran en una tabla `cmd_entry_t` terminada en la fila centinela `{NULL, NULL, 0, 0}`, con su nombre,
+ * su función y el número de argumentos numéricos que aceptan. cmd_registry_build() busca, una sola vez, una semilla
+ * del hash con la que cada nombre de la tabla cae en una casilla distinta (hash perfecto). Después,
+ * cmd_registry_dispatch() calcula el hash del nombre mientras lo recorre, comprueba la única orden candidata con una
+ * comparación y convierte los argumentos: el coste es proporcional a la longitud de la línea y no al número de órdenes.
+ *
+ * La línea es `nombre [arg1 [arg2 ...]]`, separada por espacios. Los argumentos son enteros de 32 bits en decimal
+ * (con signo opcional) o en hexadecimal con el prefijo `0x`.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+#ifndef CMD_REGISTRY_H_
+#define CMD_REGISTRY_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define CMD_REGISTRY_MAX_COMMANDS 64  /*!< Número máximo de órdenes de una tabla */
+#define CMD_REGISTRY_TABLE_SIZE 256   /*!< Casillas máximas del hash perfecto (potencia de 2) */
+#define CMD_REGISTRY_MAX_ARGS 4       /*!< Número máximo de argumentos numéricos de una orden */
+#define CMD_REGISTRY_MAX_SEEDS 4096   /*!< Semillas que se prueban con cada tamaño antes de duplicar las casillas */
+
+/* Enums */
+/**
+ * @brief Resultado de cmd_registry_dispatch(). Las funciones de las órdenes devuelven uno de estos valores.
+ */
+enum CMD_REGISTRY_STATUS
+{
+    CMD_REGISTRY_OK = 0,           /*!< Orden ejecutada */
+    CMD_REGISTRY_UNKNOWN,          /*!< No hay ninguna orden con ese nombre */
+    CMD_REGISTRY_BAD_ARGUMENT,     /*!< Argumento que no es un entero de 32 bits o número de argumentos incorrecto */
+    CMD_REGISTRY_FAILED            /*!< La orden no se ha podido ejecutar */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Argumentos numéricos de una orden, ya convertidos.
+ */
+typedef struct
+{
+    uint32_t argc;                        /*!< Número de argumentos */
+    int32_t argv[CMD_REGISTRY_MAX_ARGS];  /*!< Valores de los argumentos */
+} cmd_args_t;
+
+/**
+ * @brief Función de una orden.
+ * @param p_context Contexto pasado a cmd_registry_dispatch() (p. ej. la FSM de la jukebox).
+ * @param p_args Argumentos de la orden.
+ * @return Resultado (`enum CMD_REGISTRY_STATUS`).
+ */
+typedef uint32_t (*cmd_handler_t)(void *p_context, const cmd_args_t *p_args);
+
+/**
+ * @brief Fila de la tabla de órdenes.
+ */
+typedef struct
+{
+    const char *p_name;   /*!< Nombre de la orden (`NULL` en la fila centinela) */
+    cmd_handler_t handler; /*!< Función de la orden */
+    uint8_t min_args;     /*!< Número mínimo de argumentos */
+    uint8_t max_args;     /*!< Número máximo de argumentos (no mayor que `CMD_REGISTRY_MAX_ARGS`) */
+} cmd_entry_t;
+
+/**
+ * @brief Hash perfecto de una tabla de órdenes.
+ */
+typedef struct
+{
+    const cmd_entry_t *p_table;                 /*!< Tabla registrada, o `NULL` si no se ha podido construir el hash */
+    uint32_t seed;                              /*!< Semilla con la que no hay colisiones */
+    uint32_t mask;                              /*!< Casillas usadas menos 1 */
+    uint8_t slots[CMD_REGISTRY_TABLE_SIZE];     /*!< Fila de la tabla más 1 de cada casilla (0: casilla vacía) */
+} cmd_registry_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Construye el hash perfecto de una tabla de órdenes terminada en la fila centinela.
+ *
+ * Se llama una sola vez por tabla (normalmente desde la función `init` de la FSM que atiende la consola).
+ *
+ * @param p_registry Puntero al registro.
+ * @param p_table Tabla de órdenes.
+ * @return `true` si se ha construido; `false` si la tabla tiene demasiadas órdenes o nombres repetidos.
+ */
+bool cmd_registry_build(cmd_registry_t *p_registry, const cmd_entry_t *p_table);
+
+/**
+ * @brief Comprueba si el registro ya se ha construido para una tabla.
+ *
+ * @param p_registry Puntero al registro.
+ * @param p_table Tabla de órdenes.
+ * @return `true` si el registro corresponde a la tabla.
+ */
+bool cmd_registry_is_built(const cmd_registry_t *p_registry, const cmd_entry_t *p_table);
+
+/**
+ * @brief Busca una orden por su nombre.
+ *
+ * @param p_registry Puntero al registro.
+ * @param p_name Nombre (no hace falta que termine en carácter nulo).
+ * @param length Longitud del nombre.
+ * @return Fila de la orden, o `NULL` si no existe.
+ */
+const cmd_entry_t *cmd_registry_find(const cmd_registry_t *p_registry, const char *p_name, uint32_t length);
+
+/**
+ * @brief Interpreta una línea y ejecuta su orden.
+ *
+ * @param p_registry Puntero al registro.
+ * @param p_line Línea recibida, sin el delimitador (p. ej. la vista de fsm_usart_get_in_line()); no hace falta que termine en carácter nulo.
+ * @param length Longitud de la línea.
+ * @param p_context Contexto que se pasa a la función de la orden.
+ * @return Resultado de la orden, o `CMD_REGISTRY_UNKNOWN` / `CMD_REGISTRY_BAD_ARGUMENT` si no se ha ejecutado.
+ */
+uint32_t cmd_registry_dispatch(const cmd_registry_t *p_registry, const char *p_line, uint32_t length, void *p_context);
+
+#endif /* CMD_REGISTRY_H_ */
@@ -16,8 +16,18 @@
 
 /* Other includes */
 #include "fsm.h"
+#include "sw_timer.h"
 
 /* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#ifndef FSM_BUTTON_POOL_SIZE
+#define FSM_BUTTON_POOL_SIZE 4 /*!< Número de botones que se pueden crear con fsm_button_new() (pool estático) */
+#endif
+#define FSM_BUTTON_GESTURE_QUEUE_LENGTH 8 /*!< Gestos que caben en la cola de cada botón (potencia de 2) */
+#define FSM_BUTTON_LONG_PRESS_MS 800      /*!< Umbral por defecto de la pulsación larga, desde el flanco de presionado */
+#define FSM_BUTTON_REPEAT_MS 200          /*!< Periodo por defecto de repetición mientras dura la pulsación larga */
+#define FSM_BUTTON_DOUBLE_CLICK_MS 300    /*!< Ventana por defecto entre la liberación y la siguiente pulsación de un doble clic */
+
 /* Enums */
 enum FSM_BUTTON
 {
@@ -27,13 +37,35 @@ enum FSM_BUTTON
     BUTTON_PRESSED_WAIT /**< Espera del botón presionado */
 };
 
+/**
+ * @brief Tipos de gesto que el botón deja en su cola.
+ */
+enum FSM_BUTTON_GESTURE
+{
+    BUTTON_GESTURE_PRESS = 0,     /**< Pulsación confirmada por el anti-rebote */
+    BUTTON_GESTURE_RELEASE,       /**< Liberación */
+    BUTTON_GESTURE_CLICK,         /**< Pulsación corta sin segunda pulsación dentro de la ventana de doble clic */
+    BUTTON_GESTURE_DOUBLE_CLICK,  /**< Segunda pulsación corta dentro de la ventana de doble clic */
+    BUTTON_GESTURE_LONG_PRESS,    /**< La pulsación ha superado el umbral de pulsación larga (el botón sigue presionado) */
+    BUTTON_GESTURE_REPEAT         /**< Repetición periódica mientras dura la pulsación larga */
+};
+
 /* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Gesto del botón.
+ */
+typedef struct
+{
+    uint8_t type; /**< Tipo de gesto (`enum FSM_BUTTON_GESTURE`) */
+    uint32_t tick; /**< Tick del sistema del gesto; en pulsaciones, liberaciones y clics es el del flanco tomado en la ISR */
+} fsm_button_gesture_t;
+
 typedef struct
 {
     fsm_t f; /**< Máquina de estados finita */
     uint32_t debounce_time; /**< Tiempo de rebote */
 
-    uint32_t next_timeout; /**< Próximo tiempo de espera */
+    sw_timer_t debounce_timer; /**< Temporizador anti-rebote; al vencer publica el evento del botón */
  
     uint32_t tick_pressed; /**< Tiempo de inicio de la pulsación */
 
@@ -41,6 +73,28 @@ typedef struct
 
     uint32_t button_id; /**< Identificador del botón */
 
+    sw_timer_t gesture_timer; /**< Temporizador de la pulsación larga, de la repetición y de la ventana de doble clic */
+
+    uint32_t long_press_ms; /**< Umbral de la pulsación larga (0: sin pulsación larga) */
+
+    uint32_t repeat_ms; /**< Periodo de repetición (0: sin repetición) */
+
+    uint32_t double_click_ms; /**< Ventana de doble clic (0: cada pulsación corta es un clic) */
+
+    uint32_t tick_released; /**< Tick de la última liberación */
+
+    bool click_pending; /**< Hay un clic esperando a ver si llega la segunda pulsación */
+
+    bool long_pressed; /**< La pulsación actual ya es una pulsación larga */
+
+    fsm_button_gesture_t gestures[FSM_BUTTON_GESTURE_QUEUE_LENGTH]; /**< Cola de gestos */
+
+    uint32_t gesture_head; /**< Índice (sin envolver) donde se escribe el siguiente gesto */
+
+    uint32_t gesture_tail; /**< Índice (sin envolver) del siguiente gesto a leer */
+
+    uint32_t gestures_dropped; /**< Gestos descartados porque la cola estaba llena */
+
 } fsm_button_t;
 
 /* Function prototypes and explanation -------------------------------------------------*/
@@ -48,17 +102,59 @@ typedef struct
  * @brief  se crea un nuevo botón FSM.Este FSM implementa un mecanismo anti-rebote. Los rebotes (o pulsaciones de botones muy rápidas) que duran menos de lo que se filtran.
  * @param debounce_time Tiempo de rebote del botón.
  * @param button_id Identificador del botón.
- * @return Puntero a la nueva instancia de la máquina de estados finita.
+ * @note La memoria sale de un pool estático de `FSM_BUTTON_POOL_SIZE` objetos y se libera con `fsm_destroy()`.
+ * @return Puntero a la nueva instancia de la máquina de estados finita, o `NULL` si el pool está lleno.
  */
 fsm_t *fsm_button_new(uint32_t debounce_time, uint32_t button_id);
+/**
+ * @brief Crea un botón FSM sobre memoria proporcionada por el llamante (p. ej. una variable estática), sin usar el pool.
+ * @warning La FSM no se debe liberar con `fsm_destroy()`: la memoria pertenece al llamante. Antes de reutilizarla para
+ * otra cosa, o para crear otro botón en ella, hay que llamar a fsm_button_destroy().
+ * @param p_storage Memoria donde se crea la FSM.
+ * @param debounce_time Tiempo de rebote del botón.
+ * @param button_id Identificador del botón.
+ * @return Puntero a la nueva instancia de la máquina de estados finita.
+ */
+fsm_t *fsm_button_new_static(fsm_button_t *p_storage, uint32_t debounce_time, uint32_t button_id);
+/**
+ * @brief Para los temporizadores de anti-rebote y de gestos del botón y los saca de la rueda de `sw_timer`.
+ *
+ * `fsm_destroy()` la llama antes de devolver al pool un botón creado con fsm_button_new(). Los botones creados con
+ * fsm_button_new_static() la deben llamar antes de dejar de usar su memoria.
+ * @param p_this Puntero a la instancia de la máquina de estados finita.
+ */
+void fsm_button_destroy(fsm_t *p_this);
 /**
  * @brief  Inicialice un botón FSM. Esta función inicializa los valores predeterminados de la estructura FSM y
- *  llama a la para inicializar el hardware asociado al ID dado.
+ *  llama a la para inicializar el hardware asociado al ID dado. Los temporizadores se inicializan sin leer la memoria,
+ *  que puede no estar inicializada: si contenía un botón en marcha, antes hay que llamar a fsm_button_destroy().
  * @param p_this Puntero a la instancia de la máquina de estados finita.
  * @param debounce_time Tiempo de rebote del botón.
  * @param button_id Identificador del botón.
  */
 void fsm_button_init(fsm_t *p_this, uint32_t debounce_time, uint32_t button_id);
+/**
+ * @brief Dispara la FSM del botón con `fsm_fire()` y, además, atiende el temporizador de gestos (pulsación larga,
+ * repetición y fin de la ventana de doble clic).
+ * @param p_this Puntero a la instancia de la máquina de estados finita.
+ * @return 1 si se ha ejecutado una transición o se ha generado un gesto, 0 en caso contrario.
+ */
+int fsm_button_fire(fsm_t *p_this);
+/**
+ * @brief Configura los umbrales de los gestos del botón.
+ * @param p_this Puntero a la instancia de la máquina de estados finita.
+ * @param long_press_ms Umbral de la pulsación larga, medido desde el flanco de presionado (0 la deshabilita).
+ * @param repeat_ms Periodo de repetición mientras dura la pulsación larga (0 la deshabilita).
+ * @param double_click_ms Ventana entre la liberación y la siguiente pulsación para un doble clic (0 lo deshabilita).
+ */
+void fsm_button_set_gesture_config(fsm_t *p_this, uint32_t long_press_ms, uint32_t repeat_ms, uint32_t double_click_ms);
+/**
+ * @brief Saca el gesto más antiguo de la cola del botón.
+ * @param p_this Puntero a la instancia de la máquina de estados finita.
+ * @param p_gesture Puntero donde se copia el gesto.
+ * @return Verdadero si había algún gesto, falso si la cola estaba vacía.
+ */
+bool fsm_button_get_gesture(fsm_t *p_this, fsm_button_gesture_t *p_gesture);
 /**
  * @brief Obtiene la duración de la pulsación del botón.
  * @param p_this Puntero a la instancia de la máquina de estados finita.
@@ -0,0 +1,84 @@
+/**
+ * @file fsm_index.h
+ * @brief Header for fsm_index.c file. Índice de la tabla de transiciones de una FSM para despachar en O(1) por estado.
+ *
+ * `fsm_fire()` de la librería FSM recorre toda la tabla `fsm_trans_t` comprobando `orig_state` fila a fila en cada
+ * llamada. El índice agrupa, una sola vez, las filas de cada estado (respetando su orden en la tabla), de modo que
+ * fsm_index_fire() sólo evalúa las transiciones candidatas del estado actual. La tabla se escribe igual que siempre,
+ * terminada con la fila centinela `{-1, NULL, -1, NULL}`, y la semántica es la de `fsm_fire()`: se ejecuta la primera
+ * transición del estado actual cuya función de entrada devuelve `true`.
+ *
+ * El índice sólo compensa en tablas grandes: en las de pocas filas recorrer la tabla entera es igual de rápido y el
+ * índice ocuparía memoria para nada. Por eso las tablas con menos de `FSM_INDEX_MIN_TRANSITIONS` filas no se indexan y
+ * fsm_index_fire() las dispara con `fsm_fire()`; las FSM con tablas pequeñas (botón, USART) llaman directamente a
+ * `fsm_fire()` y no reservan índice.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+#ifndef FSM_INDEX_H_
+#define FSM_INDEX_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include "fsm.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define FSM_INDEX_MAX_STATES 64       /*!< Número máximo de estados de una tabla indexada (de 0 a FSM_INDEX_MAX_STATES - 1) */
+#define FSM_INDEX_MAX_TRANSITIONS 256 /*!< Número máximo de transiciones de una tabla indexada (sin contar la centinela) */
+#define FSM_INDEX_MIN_TRANSITIONS 16  /*!< Número mínimo de transiciones para indexar una tabla; con menos, `fsm_fire()` es igual de rápido */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Índice de una tabla de transiciones. Las transiciones del estado `s` son `p_rows[first[s]]` a `p_rows[first[s + 1] - 1]`.
+ */
+typedef struct
+{
+    fsm_trans_t *p_tt;                                 /*!< Tabla indexada, o `NULL` si no se ha podido indexar */
+    uint32_t num_states;                               /*!< Número de estados (mayor estado de origen + 1) */
+    uint16_t first[FSM_INDEX_MAX_STATES + 1];          /*!< Primera fila de cada estado en `p_rows` */
+    fsm_trans_t *p_rows[FSM_INDEX_MAX_TRANSITIONS];    /*!< Filas de la tabla agrupadas por estado de origen */
+} fsm_index_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Construye el índice de una tabla de transiciones terminada en la fila centinela (`orig_state` igual a -1).
+ *
+ * Se llama una sola vez por tabla (normalmente desde la función `init` de la FSM). Si la tabla tiene menos de
+ * `FSM_INDEX_MIN_TRANSITIONS` transiciones, o más estados o transiciones de las soportadas, el índice queda vacío y
+ * fsm_index_fire() recurre a `fsm_fire()`.
+ *
+ * @param p_index Puntero al índice a construir.
+ * @param p_tt Tabla de transiciones.
+ * @return `true` si la tabla se ha indexado, `false` en caso contrario.
+ */
+bool fsm_index_build(fsm_index_t *p_index, fsm_trans_t *p_tt);
+
+/**
+ * @brief Comprueba si el índice ya se ha construido para una tabla.
+ *
+ * @param p_index Puntero al índice.
+ * @param p_tt Tabla de transiciones.
+ * @return `true` si el índice corresponde a la tabla.
+ */
+bool fsm_index_is_built(const fsm_index_t *p_index, const fsm_trans_t *p_tt);
+
+/**
+ * @brief Dispara la FSM evaluando sólo las transiciones de su estado actual.
+ *
+ * Equivale a `fsm_fire()` sobre la tabla de la FSM: actualiza el estado y después llama a la función de salida.
+ *
+ * @param p_fsm Puntero a la FSM. Su tabla debe ser la del índice.
+ * @param p_index Índice de la tabla de la FSM.
+ * @return 1 si se ha ejecutado una transición, 0 en caso contrario.
+ */
+int fsm_index_fire(fsm_t *p_fsm, const fsm_index_t *p_index);
+
+#endif /* FSM_INDEX_H_ */
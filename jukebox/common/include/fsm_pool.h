@@ -0,0 +1,139 @@
+/**
+ * @file fsm_pool.h
+ * @brief Header for fsm_pool.c file. Pools estáticos de objetos para las FSM.
+ *
+ * Cada tipo de FSM reserva en tiempo de compilación un array de objetos con `FSM_POOL_DEFINE()`. Reservar y liberar
+ * un objeto es O(1) (lista de libres guardada en los propios objetos libres), sin pasar por `malloc()` ni por `_sbrk()`,
+ * de modo que el tiempo de arranque y la memoria usada son deterministas. Delante de cada objeto hay una cabecera que
+ * indica si está en uso. Los objetos se liberan con `fsm_destroy()`: la librería FSM libera la memoria a través de
+ * `fsm_free()`, que este módulo redefine para devolver el objeto a su pool después de llamar a la función de liberación
+ * del pool, si la tiene (p. ej. para parar los temporizadores del objeto). Un puntero que no está en la memoria de ningún
+ * pool (una FSM creada con `fsm_new()`) se libera con `free()`, como en la librería; `fsm_malloc()` no se redefine.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+#ifndef FSM_POOL_H_
+#define FSM_POOL_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define FSM_POOL_MAX_POOLS 8 /*!< Número máximo de pools (uno por tipo de FSM) */
+#define FSM_POOL_NONE UINT32_MAX /*!< Fin de la lista de objetos libres */
+
+/**
+ * @brief Define un pool estático de `n` objetos de tipo `type` con el nombre `name`. Cada objeto va precedido de su
+ * cabecera `fsm_pool_header_t`. `release_fn` se llama con cada objeto antes de devolverlo al pool (puede ser `NULL`).
+ */
+#define FSM_POOL_DEFINE(name, type, n, release_fn)                                       \
+    typedef struct                                                                       \
+    {                                                                                    \
+        fsm_pool_header_t header;                                                        \
+        type obj;                                                                        \
+    } name##_slot_t;                                                                     \
+    _Static_assert(offsetof(name##_slot_t, obj) == sizeof(fsm_pool_header_t),            \
+                   "El objeto debe ir justo detrás de su cabecera");                    \
+    static name##_slot_t name##_storage[n];                                              \
+    static fsm_pool_t name = {.p_name = #name,                                           \
+                              .p_storage = (uint8_t *)name##_storage,                    \
+                              .slot_size = sizeof(name##_slot_t),                        \
+                              .obj_size = sizeof(type),                                  \
+                              .capacity = (n),                                           \
+                              .on_release = (release_fn)}
+
+/* Typedefs --------------------------------------------------------------------*/
+struct fsm_pool_t;
+
+/**
+ * @brief Cabecera de un objeto de un pool: el pool que lo ha entregado, o `NULL` si el objeto está libre. Ocupa lo
+ * mismo que el tipo con mayor alineamiento para que el objeto que la sigue quede bien alineado.
+ */
+typedef union
+{
+    struct fsm_pool_t *p_owner; /*!< Pool del objeto, o `NULL` si está libre */
+    max_align_t align;          /*!< Relleno hasta el alineamiento máximo */
+} fsm_pool_header_t;
+
+/**
+ * @brief Pool de objetos de tamaño fijo. Se define con `FSM_POOL_DEFINE()`; sus campos son privados.
+ */
+typedef struct fsm_pool_t
+{
+    const char *p_name;  /*!< Nombre del pool */
+    uint8_t *p_storage;  /*!< Memoria de los objetos, cada uno precedido de su cabecera */
+    size_t slot_size;    /*!< Tamaño de cada objeto con su cabecera en bytes */
+    size_t obj_size;     /*!< Tamaño de cada objeto en bytes */
+    uint32_t capacity;   /*!< Número de objetos */
+    void (*on_release)(void *p_obj); /*!< Función a la que se llama antes de devolver un objeto, o `NULL` */
+    bool ready;          /*!< La lista de libres está construida y el pool registrado */
+    bool rejected;       /*!< El pool no se ha podido registrar: no entrega objetos */
+    uint32_t free_head;  /*!< Primer objeto libre, o `FSM_POOL_NONE` */
+    uint32_t used;       /*!< Objetos en uso */
+    uint32_t high_water; /*!< Máximo de objetos en uso a la vez */
+    uint32_t failures;   /*!< Peticiones rechazadas (pool lleno o sin registrar) */
+} fsm_pool_t;
+
+/**
+ * @brief Estadísticas de un pool.
+ */
+typedef struct
+{
+    const char *p_name;  /*!< Nombre del pool */
+    size_t obj_size;     /*!< Tamaño de cada objeto en bytes */
+    uint32_t capacity;   /*!< Número de objetos */
+    uint32_t used;       /*!< Objetos en uso */
+    uint32_t high_water; /*!< Máximo de objetos en uso a la vez desde el arranque */
+    uint32_t failures;   /*!< Peticiones rechazadas por estar el pool lleno */
+} fsm_pool_stats_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Reserva un objeto del pool en O(1).
+ *
+ * La primera vez que se usa, el pool se registra para fsm_pool_get_stats(). Si ya hay `FSM_POOL_MAX_POOLS` pools
+ * registrados, el pool no se puede usar: todas sus peticiones fallan y se cuentan en `failures`.
+ *
+ * @param p_pool Puntero al pool.
+ * @return Puntero al objeto, o `NULL` si el pool está lleno o no se ha podido registrar.
+ */
+void *fsm_pool_acquire(fsm_pool_t *p_pool);
+
+/**
+ * @brief Devuelve un objeto a su pool. El pool se busca por la dirección del objeto entre los registrados (como mucho
+ * `FSM_POOL_MAX_POOLS`), sin leer la memoria de un puntero que no sea de ningún pool. Antes de devolverlo llama a la
+ * función `on_release` del pool.
+ *
+ * @param p_obj Puntero a un objeto entregado por fsm_pool_acquire().
+ * @return `true` si el objeto se ha devuelto, `false` si ya estaba libre o no es un objeto de ningún pool.
+ */
+bool fsm_pool_release(void *p_obj);
+
+/**
+ * @brief Obtiene las estadísticas de los pools usados hasta el momento.
+ *
+ * @param p_stats Array donde se copian las estadísticas.
+ * @param max_pools Longitud del array.
+ * @return Número de pools copiados.
+ */
+uint32_t fsm_pool_get_stats(fsm_pool_stats_t *p_stats, uint32_t max_pools);
+
+/**
+ * @brief Libera la memoria de una FSM. Redefine la función débil de la librería FSM a la que llama `fsm_destroy()`.
+ *
+ * Los objetos de un pool se devuelven a su pool; cualquier otro puntero se libera con `free()`, como en la librería.
+ *
+ * @warning Las FSM creadas sobre memoria del llamante (`fsm_*_new_static()`) no se deben pasar a `fsm_destroy()`.
+ *
+ * @param p Puntero a la memoria.
+ */
+void fsm_free(void *p);
+
+#endif /* FSM_POOL_H_ */
@@ -0,0 +1,107 @@
+/**
+ * @file fsm_sched.h
+ * @brief Header for fsm_sched.c file. Planificador de FSM guiado por eventos.
+ *
+ * En lugar de disparar todas las FSM en cada vuelta del bucle principal, cada FSM se registra con la máscara de eventos
+ * que pueden cambiar sus entradas (p. ej. `BUTTON_0_EVENT`, `USART_0_EVENT_RX`). Las ISR publican los eventos con
+ * `port_system_post_event()` y el planificador sólo dispara las FSM que tienen trabajo pendiente. Los temporizadores de
+ * las FSM (p. ej. el anti-rebote del botón) son `sw_timer_t` que, al vencer, publican el evento de su FSM desde la ISR
+ * del SysTick, así que el planificador no necesita conocerlos. Si no hay trabajo pendiente, el bucle duerme hasta la
+ * siguiente interrupción.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+#ifndef FSM_SCHED_H_
+#define FSM_SCHED_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include "fsm.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define FSM_SCHED_MAX_FSMS 8       /*!< Número máximo de FSM registradas */
+#define FSM_SCHED_RUN_LIMIT 16     /*!< Número máximo de transiciones seguidas de una FSM en un mismo despacho */
+#define FSM_SCHED_EVENT(e) (1U << (e)) /*!< Máscara de un evento de `port_system_post_event()` */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Función que dispara una FSM (p. ej. `fsm_fire()` o `fsm_button_fire()`).
+ */
+typedef int (*fsm_sched_fire_t)(fsm_t *p_fsm);
+
+/**
+ * @brief Contadores del planificador.
+ */
+typedef struct
+{
+    uint32_t dispatches;  /*!< Llamadas a fsm_sched_dispatch() */
+    uint32_t fires;       /*!< Llamadas a las funciones de disparo de las FSM */
+    uint32_t transitions; /*!< Disparos que han ejecutado una transición */
+    uint32_t sleeps;      /*!< Veces que el bucle ha dormido esperando un evento */
+} fsm_sched_stats_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Elimina todas las FSM registradas y reinicia los contadores.
+ */
+void fsm_sched_init(void);
+
+/**
+ * @brief Registra una FSM en el planificador. La FSM queda pendiente para evaluarse en el primer despacho.
+ *
+ * @param p_fsm Puntero a la FSM.
+ * @param fire Función de disparo de la FSM.
+ * @param events Máscara de los eventos que pueden cambiar sus entradas (construida con `FSM_SCHED_EVENT()`).
+ * @return Identificador de la FSM en el planificador, o -1 si no caben más FSM.
+ */
+int fsm_sched_add(fsm_t *p_fsm, fsm_sched_fire_t fire, uint32_t events);
+
+/**
+ * @brief Marca una FSM como pendiente desde el programa principal, p. ej. cuando la aplicación cambia una de sus entradas.
+ *
+ * @param fsm_id Identificador devuelto por fsm_sched_add().
+ */
+void fsm_sched_post(int fsm_id);
+
+/**
+ * @brief Recoge los eventos publicados por las ISR y dispara las FSM con trabajo pendiente hasta que dejan de transitar.
+ *
+ * @return `true` si alguna FSM ha ejecutado una transición.
+ */
+bool fsm_sched_dispatch(void);
+
+/**
+ * @brief Comprueba si alguna FSM tiene trabajo pendiente (marcado desde el programa principal).
+ *
+ * @return `true` si hay FSM pendientes de despachar.
+ */
+bool fsm_sched_has_work(void);
+
+/**
+ * @brief Una vuelta del bucle principal: si no hay trabajo pendiente duerme hasta el siguiente evento y, después, despacha las FSM pendientes.
+ *
+ * Al volver, las salidas de las FSM están actualizadas y el programa principal puede consultarlas antes de la siguiente vuelta.
+ */
+void fsm_sched_run(void);
+
+/**
+ * @brief Obtiene los contadores del planificador.
+ *
+ * @param p_stats Puntero donde se copian los contadores.
+ */
+void fsm_sched_get_stats(fsm_sched_stats_t *p_stats);
+
+/**
+ * @brief Pone a cero los contadores del planificador.
+ */
+void fsm_sched_reset_stats(void);
+
+#endif /* FSM_SCHED_H_ */
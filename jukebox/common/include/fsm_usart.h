@@ -14,6 +14,8 @@
 #include <stdbool.h>
 #include <fsm.h>
 #include "port_usart.h"
+#include "usart_frame.h"
+#include "cmd_registry.h"
 /* Standard C includes */
 
 /* Other includes */
@@ -21,11 +23,16 @@
 /* HW dependent includes */
 
 /* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#ifndef FSM_USART_POOL_SIZE
+#define FSM_USART_POOL_SIZE USART_INSTANCES /*!< Número de USART que se pueden crear con fsm_usart_new() (pool estático): uno por puerto */
+#endif
+
 /* Enums */
 enum FSM_USART
 {
     WAIT_DATA = 0, /*!< Estado de espera de datos */
-    SEND_DATA     /*!< Estado de envío de datos */
+    SEND_DATA     /*!< Estado de envío de datos: la ISR de TXE está vaciando la cola de transmisión */
 };
 /* Typedefs --------------------------------------------------------------------*/
 /**
@@ -37,9 +44,15 @@ typedef struct
 
     bool data_received; /*!< Indicador de si se han recibido datos */
 
-    char in_data[USART_INPUT_BUFFER_LENGTH]; /*!< Búfer de datos de entrada */
+    const char *p_in_line; /*!< Vista sin copia de la línea recibida, dentro del anillo de recepción del USART */
+
+    uint32_t in_line_length; /*!< Longitud de la línea recibida */
+
+    bool binary; /*!< Transporte binario: tramas COBS con CRC16 en lugar de líneas de texto */
 
-    char out_data[USART_OUTPUT_BUFFER_LENGTH]; /*!< Búfer de datos de salida */
+    usart_frame_t in_frame; /*!< Trama recibida, ya decodificada y comprobada (transporte binario) */
+
+    uint32_t frames_rejected; /*!< Tramas descartadas por estar mal codificadas o fallar el CRC */
 
     uint8_t usart_id;  /*!< Identificador USART */
 } fsm_usart_t;
@@ -47,16 +60,31 @@ typedef struct
 /* Function prototypes and explanation -------------------------------------------------*/
 /**
  * @brief Crea una nueva instancia  
+ * @note La memoria sale de un pool estático de `FSM_USART_POOL_SIZE` objetos y se libera con `fsm_destroy()`.
  * @param usart_id El identificador USART
- * @return Puntero a la instancia creada de la Máquina de Estados Finita
+ * @return Puntero a la instancia creada de la Máquina de Estados Finita, o `NULL` si el pool está lleno
  */
 fsm_t *fsm_usart_new(uint32_t usart_id);
+/**
+ * @brief Crea una instancia sobre memoria proporcionada por el llamante (p. ej. una variable estática), sin usar el pool
+ * @warning La FSM no se debe liberar con `fsm_destroy()`: la memoria pertenece al llamante.
+ * @param p_storage Memoria donde se crea la FSM
+ * @param usart_id El identificador USART
+ * @return Puntero a la instancia creada de la Máquina de Estados Finita
+ */
+fsm_t *fsm_usart_new_static(fsm_usart_t *p_storage, uint32_t usart_id);
 /**
  * @brief Inicializa una instancia  T
  * @param p_this Puntero a la instancia de la Máquina de Estados Finita
  * @param usart_id El identificador USART
  */
 void fsm_usart_init(fsm_t *p_this, uint32_t usart_id);
+/**
+ * @brief Dispara la FSM del USART con `fsm_fire()`.
+ * @param p_this Puntero a la instancia de la Máquina de Estados Finita
+ * @return 1 si se ha ejecutado una transición, 0 en caso contrario
+ */
+int fsm_usart_fire(fsm_t *p_this);
 /**
  * @brief Comprueba si se han recibido datos
  * @param p_this Puntero a la instancia  
@@ -65,19 +93,92 @@ void fsm_usart_init(fsm_t *p_this, uint32_t usart_id);
 bool fsm_usart_check_data_received(fsm_t *p_this);
 
 /**
- * @brief Obtiene los datos de entrada  
+ * @brief Obtiene una copia de los datos de entrada, completada con caracteres nulos
  * @param p_this Puntero a la instancia de la Máquina de Estados Finita
- * @param p_data Puntero al búfer donde se almacenarán los datos de entrada
+ * @param p_data Puntero al búfer de `USART_INPUT_BUFFER_LENGTH` bytes donde se almacenarán los datos de entrada
  */
 void fsm_usart_get_in_data(fsm_t *p_this, char *p_data);
 /**
- * @brief Establece los datos de salida  
+ * @brief Obtiene una vista sin copia de la línea recibida (sin el delimitador)
+ * @note La vista es válida hasta que se llama a `fsm_usart_reset_input_data()`, que libera la línea en el anillo de recepción.
+ * @param p_this Puntero a la instancia de la Máquina de Estados Finita
+ * @param pp_line Puntero donde se guarda el puntero a la línea
+ * @param p_length Puntero donde se guarda la longitud de la línea
+ * @return Verdadero si hay una línea recibida, falso en caso contrario
+ */
+bool fsm_usart_get_in_line(fsm_t *p_this, const char **pp_line, uint32_t *p_length);
+/**
+ * @brief Encola un mensaje en la cola de transmisión del USART, sin bloquear
+ * @note Los mensajes encolados se envían uno detrás de otro desde la interrupción TXE; un mensaje no sobrescribe al anterior.
+ * @param p_this Puntero a la instancia de la Máquina de Estados Finita
+ * @param p_data Puntero a los bytes del mensaje
+ * @param length Longitud del mensaje (como mucho `USART_TX_MESSAGE_MAX_LENGTH`)
+ * @return Verdadero si se ha encolado, falso si la cola está llena (contrapresión: el mensaje no se encola)
+ */
+bool fsm_usart_send(fsm_t *p_this, const char *p_data, uint32_t length);
+/**
+ * @brief Encola un mensaje sin copiarlo: el USART lo envía directamente desde la memoria del llamante
+ * @note La memoria no se debe modificar hasta que se llama a `callback`, desde la interrupción que termina de leerla.
+ * Para cadenas constantes (p. ej. tablas en flash) `callback` puede ser `NULL`.
+ * @param p_this Puntero a la instancia de la Máquina de Estados Finita
+ * @param p_data Puntero a los bytes del mensaje
+ * @param length Longitud del mensaje (como mucho `USART_TX_REF_MAX_LENGTH`)
+ * @param callback Función que libera la memoria del mensaje, o `NULL`
+ * @param p_arg Argumento de `callback`
+ * @return Verdadero si se ha encolado, falso si la cola está llena (contrapresión: el mensaje no se encola)
+ */
+bool fsm_usart_send_ref(fsm_t *p_this, const char *p_data, uint32_t length, port_usart_tx_callback_t callback, void *p_arg);
+/**
+ * @brief Encola una copia de los datos de salida: hasta el primer `END_CHAR_CONSTANT` (incluido), el carácter nulo o
+ * `USART_OUTPUT_BUFFER_LENGTH` bytes. No se lee más allá del final de la cadena.
  * @param p_this Puntero a la instancia de la Máquina de Estados Finita
  * @param p_data Puntero a los datos que se establecerán como salida
+ * @return Verdadero si se ha encolado, falso si la cola está llena
+ */
+bool fsm_usart_set_out_data(fsm_t *p_this, const char *p_data);
+/**
+ * @brief Selecciona el transporte: líneas de texto terminadas en `END_CHAR_CONSTANT` o tramas binarias (`usart_frame.h`)
+ * @note Vacía el anillo de recepción y descarta la línea o trama recibida.
+ * @param p_this Puntero a la instancia de la Máquina de Estados Finita
+ * @param binary Verdadero para el transporte binario
+ * @return Verdadero si se ha cambiado; falso si el USART usa control de flujo XON/XOFF, que sólo admite texto
+ */
+bool fsm_usart_set_binary(fsm_t *p_this, bool binary);
+/**
+ * @brief Obtiene la trama recibida (transporte binario)
+ * @note Las tramas mal codificadas o con el CRC incorrecto se descartan sin entregarse. El anfitrión puede enviar varias
+ * órdenes seguidas: se entregan de una en una, en orden, cada vez que se llama a `fsm_usart_reset_input_data()`.
+ * @param p_this Puntero a la instancia de la Máquina de Estados Finita
+ * @param pp_frame Puntero donde se guarda el puntero a la trama, válido hasta `fsm_usart_reset_input_data()`
+ * @return Verdadero si hay una trama recibida, falso en caso contrario
+ */
+bool fsm_usart_get_in_frame(fsm_t *p_this, const usart_frame_t **pp_frame);
+/**
+ * @brief Codifica una trama y la encola en la cola de transmisión del USART, sin bloquear
+ * @param p_this Puntero a la instancia de la Máquina de Estados Finita
+ * @param p_frame Trama que se envía
+ * @return Verdadero si se ha encolado, falso si la carga es demasiado larga o la cola está llena
+ */
+bool fsm_usart_send_frame(fsm_t *p_this, const usart_frame_t *p_frame);
+/**
+ * @brief Obtiene el número de tramas descartadas por estar mal codificadas o fallar el CRC
+ * @param p_this Puntero a la instancia de la Máquina de Estados Finita
+ * @return Tramas descartadas desde la inicialización
+ */
+uint32_t fsm_usart_get_frames_rejected(fsm_t *p_this);
+/**
+ * @brief Orden de consola `usart [id]`: envía por el USART de la FSM los contadores de recepción de un USART
+ * @note Se declara en la tabla de órdenes de la aplicación, p. ej. `{"usart", fsm_usart_cmd_stats, 0, 1}`, y se ejecuta
+ * con cmd_registry_dispatch() pasando como contexto la FSM del USART de la consola. Sin argumento informa de ese mismo
+ * USART. La respuesta es una línea de texto:
+ * `usart <id> rx <bytes> frames <tramas> ore <n> fe <n> ne <n> pe <n> drop <n>`.
+ * @param p_context Puntero a la instancia de la Máquina de Estados Finita de la consola
+ * @param p_args Argumentos: identificador del USART (opcional)
+ * @return `CMD_REGISTRY_OK`, `CMD_REGISTRY_BAD_ARGUMENT` si el USART no existe, o `CMD_REGISTRY_FAILED` si la respuesta no cabe en la cola
  */
-void fsm_usart_set_out_data(fsm_t *p_this, char *p_data);
+uint32_t fsm_usart_cmd_stats(void *p_context, const cmd_args_t *p_args);
 /**
- * @brief Restablece el búfer de datos de entrada  
+ * @brief Restablece los datos de entrada y libera la línea recibida en el anillo de recepción
  * @param p_this Puntero a la instancia de la Máquina de Estados Finita
  */
 void fsm_usart_reset_input_data(fsm_t *p_this);
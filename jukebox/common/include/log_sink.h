@@ -0,0 +1,126 @@
+/**
+ * @file log_sink.h
+ * @brief Header for log_sink.c file. Salida de `printf()` con búfer y sin esperas.
+ *
+ * `_write()` (y por tanto `printf()`) copia los bytes en un anillo de `LOG_SINK_BUFFER_LENGTH` bytes con log_sink_write(),
+ * en un tiempo proporcional a su longitud y sin esperar nunca a la salida. log_sink_tick(), llamada desde la ISR del
+ * SysTick, vacía como mucho `LOG_SINK_DRAIN_BUDGET` bytes por milisegundo hacia el ITM (SWO) o hacia un USART.
+ *
+ * Si el anillo no tiene sitio, la política configurada decide qué se pierde; los bytes perdidos se cuentan en las
+ * estadísticas. Sin configurar nada, la salida es el ITM y se descarta la escritura que no cabe.
+ *
+ * @note El USART de trazas debe estar dedicado a ellas: el SysTick encola los mensajes con port_usart_send(), que no
+ * admite otro productor en el programa principal. Tampoco se debe llamar a `printf()` desde una ISR.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+#ifndef LOG_SINK_H_
+#define LOG_SINK_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define LOG_SINK_BUFFER_LENGTH 1024 /*!< Tamaño del anillo de trazas (potencia de 2) */
+#define LOG_SINK_DRAIN_BUDGET 64    /*!< Bytes que log_sink_tick() entrega como mucho en cada milisegundo */
+
+/* Enums */
+/**
+ * @brief Destino de las trazas.
+ */
+enum LOG_SINK_OUTPUT
+{
+    LOG_SINK_OUTPUT_ITM = 0, /*!< Puerto 0 del ITM (SWO), como el `printf()` original */
+    LOG_SINK_OUTPUT_USART,   /*!< USART dedicado a las trazas */
+    LOG_SINK_OUTPUT_NONE     /*!< Sin salida: los bytes se quedan en el anillo */
+};
+
+/**
+ * @brief Qué se pierde cuando una escritura no cabe en el anillo.
+ */
+enum LOG_SINK_POLICY
+{
+    LOG_SINK_POLICY_DROP_NEWEST = 0, /*!< Se descarta la escritura entera: no quedan líneas cortadas */
+    LOG_SINK_POLICY_TRUNCATE,        /*!< Se guarda lo que cabe de la escritura y se descarta el resto */
+    LOG_SINK_POLICY_DROP_OLDEST      /*!< Se descartan los bytes más antiguos pendientes para hacer sitio */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Estadísticas de las trazas, en bytes.
+ */
+typedef struct
+{
+    uint32_t written;    /*!< Bytes guardados en el anillo */
+    uint32_t dropped;    /*!< Bytes perdidos por falta de sitio */
+    uint32_t drained;    /*!< Bytes entregados a la salida */
+    uint32_t high_water; /*!< Máximo número de bytes pendientes que ha llegado a haber en el anillo */
+} log_sink_stats_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Selecciona el destino de las trazas.
+ *
+ * @param output Destino (`enum LOG_SINK_OUTPUT`).
+ * @param usart_id Identificador del USART si el destino es `LOG_SINK_OUTPUT_USART`; se ignora en otro caso.
+ */
+void log_sink_set_output(uint32_t output, uint32_t usart_id);
+
+/**
+ * @brief Selecciona la política con el anillo lleno.
+ *
+ * @param policy Política (`enum LOG_SINK_POLICY`).
+ */
+void log_sink_set_policy(uint32_t policy);
+
+/**
+ * @brief Guarda bytes en el anillo, sin esperar a la salida.
+ *
+ * La copia no enmascara las interrupciones: el anillo tiene un solo productor (el programa principal) y un solo
+ * consumidor (la ISR del SysTick). Sólo la política `LOG_SINK_POLICY_DROP_OLDEST` enmascara las interrupciones, el
+ * tiempo justo de descartar los bytes más antiguos.
+ *
+ * @param p_data Bytes que se guardan.
+ * @param length Número de bytes.
+ * @return Bytes guardados (menos que `length` si la política ha descartado parte de la escritura).
+ */
+uint32_t log_sink_write(const char *p_data, uint32_t length);
+
+/**
+ * @brief Entrega a la salida los bytes pendientes que acepte, sin esperar.
+ *
+ * @param budget Número máximo de bytes que se entregan.
+ * @return Bytes entregados.
+ */
+uint32_t log_sink_drain(uint32_t budget);
+
+/**
+ * @brief Vacía el anillo poco a poco. Se llama desde la ISR del SysTick cada milisegundo.
+ */
+void log_sink_tick(void);
+
+/**
+ * @brief Obtiene el número de bytes pendientes de entregar.
+ *
+ * @return Bytes en el anillo.
+ */
+uint32_t log_sink_get_pending(void);
+
+/**
+ * @brief Obtiene una copia de las estadísticas.
+ *
+ * @param p_stats Puntero donde se copian.
+ */
+void log_sink_get_stats(log_sink_stats_t *p_stats);
+
+/**
+ * @brief Descarta los bytes pendientes y pone a cero las estadísticas.
+ */
+void log_sink_reset(void);
+
+#endif /* LOG_SINK_H_ */
@@ -1,6 +1,13 @@
 /**
  * @file melodies.h
- * @brief Definition of notes and melodies arrays in file `melodies.c`.
+ * @brief Definition of notes and melodies. The melodies are generated in `melody_library.c` from the files of
+ * `melodies/`, and their notes are decoded in `melodies.c`.
+ *
+ * Each note of a melody is packed in one `uint16_t`: the note index of `note_table.h` in the 7 upper bits and the
+ * duration in the 9 lower bits, as a number of `tempo_base_ms` units of its melody. A note takes 2 bytes instead of the
+ * 10 bytes of a `double` frequency plus a `uint16_t` duration, and the player reads one array. The melody is read note
+ * by note through a `melody_cursor_t`.
+ *
  * @author Sistemas Digitales II
  * @date 2024-01-01
  */
@@ -10,67 +17,98 @@
 /* Includes ------------------------------------------------------------------*/
 /* Standard C includes */
 #include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include "note_table.h"
 
 /* Defines and enums ----------------------------------------------------------*/
-#define SILENCE 0 /*!< Silence note */
+#define SILENCE NOTE_SILENCE /*!< Silence note */
+
+#define MELODY_DURATION_BITS 9                                  /*!< Bits of the duration code of a packed note */
+#define MELODY_DURATION_MAX ((1U << MELODY_DURATION_BITS) - 1U) /*!< Largest duration code */
+#define MELODY_NOTE_MAX 0x7FU                                   /*!< Largest note index that can be packed */
+
+#define MELODY_PACK(note, code) ((uint16_t)(((note) << MELODY_DURATION_BITS) | (code))) /*!< Pack a note index and a duration code */
+#define MELODY_PACK_MS(note, duration_ms, base_ms) MELODY_PACK(note, ((duration_ms) + (base_ms) / 2U) / (base_ms)) /*!< Pack a note with a duration in ms, rounded to the tempo base */
+#define MELODY_NOTE(packed) ((uint32_t)(packed) >> MELODY_DURATION_BITS)                /*!< Note index of a packed note */
+#define MELODY_CODE(packed) ((uint32_t)(packed) & MELODY_DURATION_MAX)                  /*!< Duration code of a packed note */
 
 // 3rd Octave (Tercera Octava)
-#define DO3 130.813   /*!< DO3 note frequency */
-#define DOs3 138.591  /*!< DO#3 note frequency */
-#define RE3 146.832   /*!< RE3 note frequency */
-#define REs3 155.563  /*!< RE#3 note frequency */
-#define MI3 164.814   /*!< MI3 note frequency */
-#define FA3 174.614   /*!< FA3 note frequency */
-#define FAs3 184.997  /*!< FA#3 note frequency */
-#define SOL3 195.998  /*!< SOL3 note frequency */
-#define SOLs3 207.652 /*!< SOL#3 note frequency */
-#define LA3 220.000   /*!< LA3 note frequency */
-#define LAs3 233.082  /*!< LA#3 note frequency */
-#define SI3 246.942   /*!< SI3 note frequency */
+#define DO3 NOTE_INDEX(NOTE_DO, 3)     /*!< DO3 note index */
+#define DOs3 NOTE_INDEX(NOTE_DOs, 3)   /*!< DO#3 note index */
+#define RE3 NOTE_INDEX(NOTE_RE, 3)     /*!< RE3 note index */
+#define REs3 NOTE_INDEX(NOTE_REs, 3)   /*!< RE#3 note index */
+#define MI3 NOTE_INDEX(NOTE_MI, 3)     /*!< MI3 note index */
+#define FA3 NOTE_INDEX(NOTE_FA, 3)     /*!< FA3 note index */
+#define FAs3 NOTE_INDEX(NOTE_FAs, 3)   /*!< FA#3 note index */
+#define SOL3 NOTE_INDEX(NOTE_SOL, 3)   /*!< SOL3 note index */
+#define SOLs3 NOTE_INDEX(NOTE_SOLs, 3) /*!< SOL#3 note index */
+#define LA3 NOTE_INDEX(NOTE_LA, 3)     /*!< LA3 note index */
+#define LAs3 NOTE_INDEX(NOTE_LAs, 3)   /*!< LA#3 note index */
+#define SI3 NOTE_INDEX(NOTE_SI, 3)     /*!< SI3 note index */
 
 // 4th Octave (Cuarta Octava)
-#define DO4 261.626   /*!< DO4 note frequency */
-#define DOs4 277.183  /*!< DO#4 note frequency */
-#define RE4 293.665   /*!< RE4 note frequency */
-#define REs4 311.127  /*!< RE#4 note frequency */
-#define MI4 329.628   /*!< MI4 note frequency */
-#define FA4 349.228   /*!< FA4 note frequency */
-#define FAs4 369.994  /*!< FA#4 note frequency */
-#define SOL4 391.995  /*!< SOL4 note frequency */
-#define SOLs4 415.305 /*!< SOL#4 note frequency */
-#define LA4 440.000   /*!< LA4 note frequency */
-#define LAs4 466.164  /*!< LA#4 note frequency */
-#define SI4 493.883   /*!< SI4 note frequency */
+#define DO4 NOTE_INDEX(NOTE_DO, 4)     /*!< DO4 note index */
+#define DOs4 NOTE_INDEX(NOTE_DOs, 4)   /*!< DO#4 note index */
+#define RE4 NOTE_INDEX(NOTE_RE, 4)     /*!< RE4 note index */
+#define REs4 NOTE_INDEX(NOTE_REs, 4)   /*!< RE#4 note index */
+#define MI4 NOTE_INDEX(NOTE_MI, 4)     /*!< MI4 note index */
+#define FA4 NOTE_INDEX(NOTE_FA, 4)     /*!< FA4 note index */
+#define FAs4 NOTE_INDEX(NOTE_FAs, 4)   /*!< FA#4 note index */
+#define SOL4 NOTE_INDEX(NOTE_SOL, 4)   /*!< SOL4 note index */
+#define SOLs4 NOTE_INDEX(NOTE_SOLs, 4) /*!< SOL#4 note index */
+#define LA4 NOTE_INDEX(NOTE_LA, 4)     /*!< LA4 note index */
+#define LAs4 NOTE_INDEX(NOTE_LAs, 4)   /*!< LA#4 note index */
+#define SI4 NOTE_INDEX(NOTE_SI, 4)     /*!< SI4 note index */
 
 // 5th Octave (Quinta Octava)
-#define DO5 523.251   /*!< DO5 note frequency */
-#define DOs5 554.365  /*!< DO#5 note frequency */
-#define RE5 587.330   /*!< RE5 note frequency */
-#define REs5 622.254  /*!< RE#5 note frequency */
-#define MI5 659.255   /*!< MI5 note frequency */
-#define FA5 698.456   /*!< FA5 note frequency */
-#define FAs5 739.989  /*!< FA#5 note frequency */
-#define SOL5 783.991  /*!< SOL5 note frequency */
-#define SOLs5 830.609 /*!< SOL#5 note frequency */
-#define LA5 880.000   /*!< LA5 note frequency */
-#define LAs5 932.328  /*!< LA#5 note frequency */
-#define SI5 987.767   /*!< SI5 note frequency */
+#define DO5 NOTE_INDEX(NOTE_DO, 5)     /*!< DO5 note index */
+#define DOs5 NOTE_INDEX(NOTE_DOs, 5)   /*!< DO#5 note index */
+#define RE5 NOTE_INDEX(NOTE_RE, 5)     /*!< RE5 note index */
+#define REs5 NOTE_INDEX(NOTE_REs, 5)   /*!< RE#5 note index */
+#define MI5 NOTE_INDEX(NOTE_MI, 5)     /*!< MI5 note index */
+#define FA5 NOTE_INDEX(NOTE_FA, 5)     /*!< FA5 note index */
+#define FAs5 NOTE_INDEX(NOTE_FAs, 5)   /*!< FA#5 note index */
+#define SOL5 NOTE_INDEX(NOTE_SOL, 5)   /*!< SOL5 note index */
+#define SOLs5 NOTE_INDEX(NOTE_SOLs, 5) /*!< SOL#5 note index */
+#define LA5 NOTE_INDEX(NOTE_LA, 5)     /*!< LA5 note index */
+#define LAs5 NOTE_INDEX(NOTE_LAs, 5)   /*!< LA#5 note index */
+#define SI5 NOTE_INDEX(NOTE_SI, 5)     /*!< SI5 note index */
 
 /* Typedefs --------------------------------------------------------------------*/
 /**
- * @brief Structure to define the Buzzer melody player FSM.
+ * @brief Structure to define a melody.
  */
 typedef struct
 {
-    char *p_name;           /*!< Pointer to the name of the melody to play */
-    double *p_notes;        /*!< Pointer to the notes of the melody */
-    uint16_t *p_durations;  /*!< Pointer to the duration of each note of the melody in milliseconds */
-    uint16_t melody_length; /*!< Length of the melody to play */
+    const char *p_name;       /*!< Pointer to the name of the melody to play */
+    const uint16_t *p_notes;  /*!< Pointer to the packed notes of the melody (`MELODY_PACK()`) */
+    uint16_t melody_length;   /*!< Length of the melody to play */
+    uint16_t tempo_base_ms;   /*!< Milliseconds of one unit of the duration codes */
 } melody_t;
 
-// Melodies must be defined in melodies.c, and declared here as extern
+/**
+ * @brief Note decoded from a melody.
+ */
+typedef struct
+{
+    uint32_t note;        /*!< Note index (`NOTE_SILENCE` for a rest) */
+    uint32_t duration_ms; /*!< Duration of the note in milliseconds */
+} melody_note_t;
+
+/**
+ * @brief Cursor to read a melody note by note.
+ */
+typedef struct
+{
+    const melody_t *p_melody; /*!< Melody being read */
+    uint32_t index;           /*!< Index of the next note */
+} melody_cursor_t;
+
+// Melodies are generated by melody_gen from the files of `melodies/` (see tools/melody_gen), and declared here as extern
 // Scale melody
-extern const melody_t scale_melody; 
+extern const melody_t scale_melody;
 
 // Melody Happy Birthday
 extern const melody_t happy_birthday_melody;
@@ -78,4 +116,60 @@ extern const melody_t happy_birthday_melody;
 // Tetris melody
 extern const melody_t tetris_melody;
 
-#endif /* MELODIES_H_ */
\ No newline at end of file
+// Every melody of `melodies/`, in the order of the files and of the lines
+extern const melody_t *const melody_library[];
+extern const uint32_t melody_library_length;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Place a cursor at the first note of a melody.
+ *
+ * @param p_cursor Pointer to the cursor.
+ * @param p_melody Pointer to the melody.
+ */
+void melody_cursor_init(melody_cursor_t *p_cursor, const melody_t *p_melody);
+
+/**
+ * @brief Decode the next note of the melody and advance the cursor.
+ *
+ * @param p_cursor Pointer to the cursor.
+ * @param p_note Pointer where the note is decoded.
+ * @return `true` if a note was decoded, `false` at the end of the melody.
+ */
+bool melody_cursor_next(melody_cursor_t *p_cursor, melody_note_t *p_note);
+
+/**
+ * @brief Get the total duration of a melody.
+ *
+ * @param p_melody Pointer to the melody.
+ * @return Sum of the durations of its notes in milliseconds.
+ */
+uint32_t melody_get_duration_ms(const melody_t *p_melody);
+
+/**
+ * @brief Largest tempo base in which every duration of a melody in the old layout (parallel arrays of notes and of
+ * durations in ms) is exact: the greatest common divisor of the durations.
+ *
+ * @param p_durations Durations of the notes in milliseconds.
+ * @param length Number of notes.
+ * @return Tempo base in ms, or 0 if there are no notes.
+ */
+uint32_t melody_tempo_base(const uint16_t *p_durations, uint32_t length);
+
+/**
+ * @brief Convert a melody in the old layout to packed notes.
+ *
+ * Each duration is rounded to the nearest multiple of `tempo_base_ms`. The conversion fails, and leaves `p_packed`
+ * partially written, if a note index is not in `note_table` or a duration needs a code larger than
+ * `MELODY_DURATION_MAX`.
+ *
+ * @param p_packed Array of `length` packed notes that is written.
+ * @param p_notes Note indices.
+ * @param p_durations Durations of the notes in milliseconds.
+ * @param length Number of notes.
+ * @param tempo_base_ms Milliseconds of one unit of the duration codes (not 0).
+ * @return `true` if every note was packed.
+ */
+bool melody_pack(uint16_t *p_packed, const uint8_t *p_notes, const uint16_t *p_durations, uint32_t length, uint32_t tempo_base_ms);
+
+#endif /* MELODIES_H_ */
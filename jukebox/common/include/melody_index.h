@@ -0,0 +1,141 @@
+/**
+ * @file melody_index.h
+ * @brief Header for melody_index.c file. Índice de metadatos de la biblioteca de melodías.
+ *
+ * melody_gen genera el índice junto a `melody_library.c`, en memoria de sólo lectura: una entrada por melodía de
+ * `melody_library[]` (en el mismo orden) con su nombre, número de notas, duración total y hash del nombre; las
+ * permutaciones de la biblioteca ordenada por nombre y por duración, con sus inversas; y una tabla hash de los nombres.
+ * Así, la melodía más larga o más corta, la anterior o la siguiente en cualquier orden y el listado son consultas a
+ * tablas en O(1), y buscar una melodía por su nombre es O(1) en media, sin recorrer ni decodificar las melodías.
+ *
+ * Las melodías se identifican por su posición en `melody_library[]`.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+#ifndef MELODY_INDEX_H_
+#define MELODY_INDEX_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Other includes */
+#include "melodies.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define MELODY_INDEX_NOT_FOUND 0xFFFFU /*!< Posición que devuelve melody_index_find() si no hay ninguna melodía con el nombre (y casilla vacía de la tabla hash) */
+
+/* Enums */
+/**
+ * @brief Órdenes en los que se recorre la biblioteca.
+ */
+enum MELODY_ORDER
+{
+    MELODY_ORDER_LIBRARY = 0, /*!< Orden de `melody_library[]` (el de los ficheros de `melodies/`) */
+    MELODY_ORDER_NAME,        /*!< Orden alfabético del nombre */
+    MELODY_ORDER_DURATION     /*!< Duración total creciente; a igual duración, por nombre */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Metadatos de una melodía.
+ */
+typedef struct
+{
+    const melody_t *p_melody; /*!< Melodía */
+    const char *p_name;       /*!< Nombre de la melodía */
+    uint16_t melody_length;   /*!< Número de notas */
+    uint32_t duration_ms;     /*!< Duración total en ms */
+    uint32_t name_hash;       /*!< Hash FNV-1a de 32 bits del nombre */
+} melody_info_t;
+
+/* Global variables ------------------------------------------------------------*/
+/* Generadas por melody_gen en `melody_library.c`; todas tienen `melody_library_length` entradas salvo la tabla hash */
+extern const melody_info_t melody_index[];     /*!< Metadatos de cada melodía de `melody_library[]` */
+extern const uint16_t melody_by_name[];        /*!< Posiciones de las melodías en orden alfabético */
+extern const uint16_t melody_name_rank[];      /*!< Lugar de cada melodía en `melody_by_name[]` */
+extern const uint16_t melody_by_duration[];    /*!< Posiciones de las melodías por duración creciente */
+extern const uint16_t melody_duration_rank[];  /*!< Lugar de cada melodía en `melody_by_duration[]` */
+extern const uint16_t melody_name_slots[];     /*!< Tabla hash de los nombres (direccionamiento abierto, `MELODY_INDEX_NOT_FOUND` si está vacía) */
+extern const uint32_t melody_name_mask;        /*!< Máscara de `melody_name_slots[]` (casillas - 1) */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Obtiene el número de melodías de la biblioteca.
+ *
+ * @return Número de melodías.
+ */
+uint32_t melody_index_count(void);
+
+/**
+ * @brief Obtiene los metadatos de una melodía.
+ *
+ * @param melody Posición de la melodía en `melody_library[]`.
+ * @return Puntero a sus metadatos, o `NULL` si la posición no existe.
+ */
+const melody_info_t *melody_index_get(uint32_t melody);
+
+/**
+ * @brief Obtiene la melodía que ocupa un lugar en un orden. Sirve para listar la biblioteca en ese orden.
+ *
+ * @param order Orden (`enum MELODY_ORDER`).
+ * @param rank Lugar en el orden, desde 0.
+ * @return Posición de la melodía en `melody_library[]`, o `MELODY_INDEX_NOT_FOUND` si el lugar no existe.
+ */
+uint32_t melody_index_at(uint32_t order, uint32_t rank);
+
+/**
+ * @brief Obtiene el lugar que ocupa una melodía en un orden.
+ *
+ * @param order Orden (`enum MELODY_ORDER`).
+ * @param melody Posición de la melodía en `melody_library[]`.
+ * @return Lugar en el orden, o `MELODY_INDEX_NOT_FOUND` si la melodía no existe.
+ */
+uint32_t melody_index_rank(uint32_t order, uint32_t melody);
+
+/**
+ * @brief Obtiene la melodía siguiente a otra en un orden; después de la última viene la primera.
+ *
+ * @param order Orden (`enum MELODY_ORDER`).
+ * @param melody Posición de la melodía en `melody_library[]`.
+ * @return Posición de la melodía siguiente, o `MELODY_INDEX_NOT_FOUND` si la melodía no existe.
+ */
+uint32_t melody_index_next(uint32_t order, uint32_t melody);
+
+/**
+ * @brief Obtiene la melodía anterior a otra en un orden; antes de la primera viene la última.
+ *
+ * @param order Orden (`enum MELODY_ORDER`).
+ * @param melody Posición de la melodía en `melody_library[]`.
+ * @return Posición de la melodía anterior, o `MELODY_INDEX_NOT_FOUND` si la melodía no existe.
+ */
+uint32_t melody_index_previous(uint32_t order, uint32_t melody);
+
+/**
+ * @brief Obtiene la melodía más larga (la última por duración).
+ *
+ * @return Posición de la melodía en `melody_library[]`.
+ */
+uint32_t melody_index_longest(void);
+
+/**
+ * @brief Obtiene la melodía más corta (la primera por duración).
+ *
+ * @return Posición de la melodía en `melody_library[]`.
+ */
+uint32_t melody_index_shortest(void);
+
+/**
+ * @brief Busca una melodía por su nombre en la tabla hash.
+ *
+ * @param p_name Nombre; no hace falta que acabe en carácter nulo (p. ej. el argumento de una orden en el anillo de recepción).
+ * @param length Longitud del nombre.
+ * @return Posición de la melodía en `melody_library[]`, o `MELODY_INDEX_NOT_FOUND`.
+ */
+uint32_t melody_index_find(const char *p_name, uint32_t length);
+
+#endif /* MELODY_INDEX_H_ */
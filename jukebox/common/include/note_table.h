@@ -0,0 +1,92 @@
+/**
+ * @file note_table.h
+ * @brief Header for note_table.c file. Tabla constante de registros del temporizador para cada nota.
+ *
+ * Las notas se identifican por un índice entero: `NOTE_INDEX(semitono, octava)` para las 12 notas de la escala temperada
+ * en las octavas 0 a 8 (índices 1 a 108), y `NOTE_SILENCE` (0) para el silencio. Para cada nota la tabla guarda el
+ * prescaler (PSC) y el auto-reload (ARR) que dan su frecuencia con un reloj del temporizador de
+ * `NOTE_TABLE_TIMER_CLOCK_HZ`. Los valores se calculan en tiempo de compilación con aritmética entera a partir de las
+ * frecuencias de la octava 0 en µHz (cada octava dobla la frecuencia), de modo que cambiar de nota no usa punto flotante:
+ * es una lectura de la tabla.
+ *
+ * El PSC es el menor que deja el ARR en 16 bits y el ARR se redondea al más cercano, así que el error de frecuencia
+ * de cualquier nota es menor que 1/(2·(ARR+1)): con 16 MHz, por debajo de 0,025 % (SI8, ARR = 2024) en todo el rango.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+#ifndef NOTE_TABLE_H_
+#define NOTE_TABLE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#ifndef NOTE_TABLE_TIMER_CLOCK_HZ
+#define NOTE_TABLE_TIMER_CLOCK_HZ 16000000U /*!< Reloj del temporizador del buzzer: APB1 con el HSI de 16 MHz sin dividir */
+#endif
+
+#define NOTE_TABLE_OCTAVES 9                                  /*!< Octavas de la tabla (0 a 8) */
+#define NOTE_TABLE_SEMITONES 12                               /*!< Notas de cada octava */
+#define NOTE_SILENCE 0                                        /*!< Índice del silencio */
+#define NOTE_TABLE_LENGTH (NOTE_TABLE_OCTAVES * NOTE_TABLE_SEMITONES + 1) /*!< Entradas de la tabla, silencio incluido */
+
+#define NOTE_INDEX(semitone, octave) ((octave) * NOTE_TABLE_SEMITONES + (semitone) + 1) /*!< Índice de una nota */
+#define NOTE_OCTAVE(note) (((note) - 1) / NOTE_TABLE_SEMITONES)                         /*!< Octava de un índice distinto del silencio */
+#define NOTE_SEMITONE(note) (((note) - 1) % NOTE_TABLE_SEMITONES)                       /*!< Semitono de un índice distinto del silencio */
+
+/* Enums */
+/**
+ * @brief Semitonos de una octava, con los nombres de las notas de `melodies.h`.
+ */
+enum NOTE_SEMITONE
+{
+    NOTE_DO = 0, /*!< DO */
+    NOTE_DOs,    /*!< DO# */
+    NOTE_RE,     /*!< RE */
+    NOTE_REs,    /*!< RE# */
+    NOTE_MI,     /*!< MI */
+    NOTE_FA,     /*!< FA */
+    NOTE_FAs,    /*!< FA# */
+    NOTE_SOL,    /*!< SOL */
+    NOTE_SOLs,   /*!< SOL# */
+    NOTE_LA,     /*!< LA */
+    NOTE_LAs,    /*!< LA# */
+    NOTE_SI      /*!< SI */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Registros del temporizador para una nota. La frecuencia es `NOTE_TABLE_TIMER_CLOCK_HZ / ((psc + 1) · (arr + 1))`.
+ */
+typedef struct
+{
+    uint16_t psc; /*!< Valor del registro PSC */
+    uint16_t arr; /*!< Valor del registro ARR (0 para el silencio) */
+} note_timer_t;
+
+/* Global variables ------------------------------------------------------------*/
+extern const note_timer_t note_table[NOTE_TABLE_LENGTH]; /*!< Registros de cada índice de nota, calculados al compilar */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Obtiene los registros del temporizador de una nota.
+ *
+ * @param note Índice de la nota.
+ * @return Puntero a la entrada de la tabla, o `NULL` si el índice no existe.
+ */
+const note_timer_t *note_table_get(uint32_t note);
+
+/**
+ * @brief Obtiene la frecuencia exacta de la escala temperada de una nota, sin punto flotante.
+ *
+ * @param note Índice de la nota.
+ * @return Frecuencia en mHz, o 0 para el silencio o un índice que no existe.
+ */
+uint32_t note_table_get_frequency_mhz(uint32_t note);
+
+#endif /* NOTE_TABLE_H_ */
@@ -0,0 +1,119 @@
+/**
+ * @file spsc_ring.h
+ * @brief Header for spsc_ring.c file. Búfer circular de bytes sin cerrojos para un productor y un consumidor.
+ *
+ * El productor (normalmente una ISR) sólo escribe `head` y el consumidor (el programa principal) sólo escribe `tail`;
+ * ambos índices avanzan sin envolver y se enmascaran con `size - 1`, por lo que el tamaño debe ser potencia de 2 y no
+ * hace falta deshabilitar interrupciones.
+ *
+ * Para poder entregar vistas contiguas (puntero + longitud) sin copiar, el búfer tiene `slack` bytes más tras el final
+ * del anillo: si un bloque da la vuelta, spsc_ring_peek() copia sólo la parte que ha dado la vuelta a continuación del
+ * final. El productor nunca escribe en esa zona.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Búfer circular de un productor y un consumidor.
+ */
+typedef struct
+{
+    uint8_t *p_buffer;      /*!< Memoria del anillo: `size + slack` bytes */
+    uint32_t size;          /*!< Tamaño del anillo (potencia de 2) */
+    uint32_t slack;         /*!< Bytes tras el final del anillo para linealizar bloques que dan la vuelta */
+    volatile uint32_t head; /*!< Índice de escritura (sin envolver); sólo lo escribe el productor */
+    volatile uint32_t tail; /*!< Índice de lectura (sin envolver); sólo lo escribe el consumidor */
+    uint32_t scanned;       /*!< Bytes desde `tail` ya recorridos por spsc_ring_find() sin encontrar el delimitador */
+    uint32_t dropped;       /*!< Bytes descartados por el productor con el anillo lleno */
+} spsc_ring_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Inicializa un anillo vacío.
+ *
+ * @param p_ring Puntero al anillo.
+ * @param p_buffer Memoria de `size + slack` bytes.
+ * @param size Tamaño del anillo (potencia de 2).
+ * @param slack Bytes adicionales tras el final; es la longitud máxima de un bloque que da la vuelta y se puede ver contiguo.
+ */
+void spsc_ring_init(spsc_ring_t *p_ring, uint8_t *p_buffer, uint32_t size, uint32_t slack);
+
+/**
+ * @brief Añade un byte (lado del productor).
+ *
+ * @param p_ring Puntero al anillo.
+ * @param byte Byte que se añade.
+ * @return `true` si se ha añadido, `false` si el anillo estaba lleno (el byte se descarta y se cuenta).
+ */
+bool spsc_ring_push(spsc_ring_t *p_ring, uint8_t byte);
+
+/**
+ * @brief Añade un bloque completo o nada (lado del productor).
+ *
+ * Los bytes se copian con, como mucho, dos `memcpy` y se publican con una sola actualización de `head`, de modo que el
+ * consumidor nunca ve el bloque a medias.
+ *
+ * @param p_ring Puntero al anillo.
+ * @param p_data Bytes que se añaden.
+ * @param length Número de bytes.
+ * @return `true` si se ha añadido, `false` si no cabía (no se añade nada y los bytes se cuentan como descartados).
+ */
+bool spsc_ring_write(spsc_ring_t *p_ring, const uint8_t *p_data, uint32_t length);
+
+/**
+ * @brief Obtiene el número de bytes almacenados.
+ *
+ * @param p_ring Puntero al anillo.
+ * @return Bytes pendientes de consumir.
+ */
+uint32_t spsc_ring_count(const spsc_ring_t *p_ring);
+
+/**
+ * @brief Obtiene cuántos de los bytes almacenados están seguidos en memoria desde el principio (lado del consumidor).
+ *
+ * @param p_ring Puntero al anillo.
+ * @return Bytes desde `tail` hasta el final de los datos o del anillo.
+ */
+uint32_t spsc_ring_contiguous(const spsc_ring_t *p_ring);
+
+/**
+ * @brief Busca un delimitador desde el principio de los datos (lado del consumidor).
+ *
+ * Los bytes ya recorridos en llamadas anteriores no se vuelven a recorrer.
+ *
+ * @param p_ring Puntero al anillo.
+ * @param delimiter Byte delimitador.
+ * @param p_length Puntero donde se guarda el número de bytes anteriores al delimitador.
+ * @return `true` si se ha encontrado el delimitador.
+ */
+bool spsc_ring_find(spsc_ring_t *p_ring, uint8_t delimiter, uint32_t *p_length);
+
+/**
+ * @brief Obtiene una vista contigua de los primeros bytes almacenados, sin consumirlos (lado del consumidor).
+ *
+ * @param p_ring Puntero al anillo.
+ * @param length Número de bytes de la vista (no mayor que spsc_ring_count()).
+ * @return Puntero a los bytes, válido hasta que se consuman, o `NULL` si dan la vuelta y la parte que da la vuelta no cabe en `slack`.
+ */
+const uint8_t *spsc_ring_peek(spsc_ring_t *p_ring, uint32_t length);
+
+/**
+ * @brief Libera los primeros bytes almacenados (lado del consumidor).
+ *
+ * @param p_ring Puntero al anillo.
+ * @param length Número de bytes que se liberan (no mayor que spsc_ring_count()).
+ */
+void spsc_ring_consume(spsc_ring_t *p_ring, uint32_t length);
+
+#endif /* SPSC_RING_H_ */
@@ -0,0 +1,96 @@
+/**
+ * @file sw_timer.h
+ * @brief Header for sw_timer.c file. Servicio de temporizadores software sobre una rueda (hashed timing wheel).
+ *
+ * Los temporizadores se guardan en `SW_TIMER_WHEEL_SLOTS` listas según los bits bajos del tick de vencimiento. La ISR
+ * del SysTick llama a sw_timer_tick() una vez por milisegundo y sólo recorre la lista del tick actual; los temporizadores
+ * de esa lista que vencen en una vuelta posterior de la rueda se saltan. Arrancar y parar un temporizador es O(1). Al
+ * vencer, el temporizador se marca como vencido y publica su evento con `port_system_post_event()`, de modo que la FSM
+ * que lo usa se despierta en lugar de comparar el tick del sistema en cada disparo.
+ *
+ * Los vencimientos se comparan por igualdad en aritmética módulo 2^32, por lo que el desbordamiento del tick del sistema
+ * (cada 49,7 días) no afecta.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+#ifndef SW_TIMER_H_
+#define SW_TIMER_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define SW_TIMER_WHEEL_SLOTS 64 /*!< Número de ranuras de la rueda (potencia de 2) */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Temporizador software. Se reserva dentro del objeto que lo usa (p. ej. la FSM); sus campos son privados.
+ */
+typedef struct sw_timer_t
+{
+    struct sw_timer_t *p_next; /*!< Siguiente temporizador de la ranura */
+    struct sw_timer_t *p_prev; /*!< Temporizador anterior de la ranura */
+    uint32_t expiry;           /*!< Tick del sistema en el que vence */
+    uint32_t event;            /*!< Evento que se publica al vencer */
+    volatile bool running;     /*!< El temporizador está en la rueda */
+    volatile bool expired;     /*!< El temporizador ha vencido desde que se arrancó */
+} sw_timer_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Inicializa un temporizador parado.
+ *
+ * @param p_timer Puntero al temporizador.
+ * @param event Evento que se publica con `port_system_post_event()` cuando vence.
+ */
+void sw_timer_init(sw_timer_t *p_timer, uint32_t event);
+
+/**
+ * @brief Arranca (o rearranca) un temporizador en O(1).
+ *
+ * Vence en el primer tick en el que el tick del sistema supera el actual en más de `delay_ms`, es decir, cuando han
+ * transcurrido al menos `delay_ms` milisegundos completos.
+ *
+ * @param p_timer Puntero al temporizador.
+ * @param delay_ms Tiempo en milisegundos (menor que 2^32 - 1).
+ */
+void sw_timer_start(sw_timer_t *p_timer, uint32_t delay_ms);
+
+/**
+ * @brief Para un temporizador en O(1) y borra su indicación de vencido.
+ *
+ * @param p_timer Puntero al temporizador.
+ */
+void sw_timer_stop(sw_timer_t *p_timer);
+
+/**
+ * @brief Comprueba si el temporizador ha vencido desde que se arrancó.
+ *
+ * @param p_timer Puntero al temporizador.
+ * @return `true` si ha vencido.
+ */
+bool sw_timer_has_expired(const sw_timer_t *p_timer);
+
+/**
+ * @brief Comprueba si el temporizador está en marcha.
+ *
+ * @param p_timer Puntero al temporizador.
+ * @return `true` si está arrancado y no ha vencido.
+ */
+bool sw_timer_is_running(const sw_timer_t *p_timer);
+
+/**
+ * @brief Procesa los temporizadores que vencen en el tick actual.
+ * @warning This function must be used only by the SysTick_Handler() ISR in file `interr.c`, after updating the System tick.
+ *
+ * @param now Tick del sistema actual.
+ */
+void sw_timer_tick(uint32_t now);
+
+#endif /* SW_TIMER_H_ */
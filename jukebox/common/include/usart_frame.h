@@ -0,0 +1,101 @@
+/**
+ * @file usart_frame.h
+ * @brief Header for usart_frame.c file. Tramas binarias del USART: COBS con CRC16.
+ *
+ * Cada trama es `[tipo][secuencia][código][longitud][carga...][CRC16]` codificada con COBS (Consistent Overhead Byte
+ * Stuffing) y terminada en `USART_FRAME_DELIMITER`. COBS elimina los bytes `0x00` de la trama, así que el delimitador
+ * marca sin ambigüedad el final de cada trama y el receptor se resincroniza en el siguiente tras un error. El CRC16
+ * (CCITT, polinomio 0x1021, valor inicial 0xFFFF) cubre la cabecera y la carga y se añade con el byte alto primero.
+ *
+ * El número de secuencia lo elige el anfitrión y se copia en la respuesta, de modo que puede enviar muchas órdenes
+ * seguidas sin esperar a cada respuesta y emparejarlas después.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+#ifndef USART_FRAME_H_
+#define USART_FRAME_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define USART_FRAME_DELIMITER 0x00 /*!< Byte que termina cada trama codificada */
+#define USART_FRAME_HEADER_LENGTH 4 /*!< Bytes de la cabecera: tipo, secuencia, código y longitud de la carga */
+#define USART_FRAME_CRC_LENGTH 2 /*!< Bytes del CRC16 */
+#define USART_FRAME_PAYLOAD_MAX_LENGTH 48 /*!< Longitud máxima de la carga */
+#define USART_FRAME_RAW_MAX_LENGTH (USART_FRAME_HEADER_LENGTH + USART_FRAME_PAYLOAD_MAX_LENGTH + USART_FRAME_CRC_LENGTH) /*!< Longitud máxima de una trama antes de codificarla */
+#define USART_FRAME_ENCODED_MAX_LENGTH (USART_FRAME_RAW_MAX_LENGTH + (USART_FRAME_RAW_MAX_LENGTH / 254) + 2) /*!< Longitud máxima de una trama codificada, con el delimitador */
+
+/* Enums */
+/**
+ * @brief Tipos de trama.
+ */
+enum USART_FRAME_TYPE
+{
+    USART_FRAME_COMMAND = 1, /*!< Orden del anfitrión; `code` es la orden */
+    USART_FRAME_RESPONSE,    /*!< Respuesta a una orden, con su número de secuencia; `code` es `enum USART_FRAME_STATUS` */
+    USART_FRAME_EVENT        /*!< Aviso espontáneo del equipo */
+};
+
+/**
+ * @brief Códigos de estado de las respuestas.
+ */
+enum USART_FRAME_STATUS
+{
+    USART_FRAME_STATUS_OK = 0,       /*!< Orden ejecutada */
+    USART_FRAME_STATUS_UNKNOWN,      /*!< Orden desconocida */
+    USART_FRAME_STATUS_BAD_ARGUMENT, /*!< Carga incorrecta para la orden */
+    USART_FRAME_STATUS_BUSY          /*!< La orden no se puede ejecutar ahora */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Trama decodificada.
+ */
+typedef struct
+{
+    uint8_t type; /*!< Tipo de trama (`enum USART_FRAME_TYPE`) */
+    uint8_t seq; /*!< Número de secuencia: el de la orden se copia en su respuesta */
+    uint8_t code; /*!< Orden o estado, según el tipo */
+    uint8_t length; /*!< Bytes de la carga */
+    uint8_t payload[USART_FRAME_PAYLOAD_MAX_LENGTH]; /*!< Carga */
+} usart_frame_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Calcula el CRC16-CCITT de un bloque de bytes.
+ *
+ * @param crc Valor inicial (0xFFFF) o CRC de los bloques anteriores.
+ * @param p_data Bytes.
+ * @param length Número de bytes.
+ * @return CRC actualizado.
+ */
+uint16_t usart_frame_crc16(uint16_t crc, const uint8_t *p_data, uint32_t length);
+
+/**
+ * @brief Codifica una trama: añade el CRC, la codifica con COBS y la termina con el delimitador.
+ *
+ * @param p_frame Trama (con `length` no mayor que `USART_FRAME_PAYLOAD_MAX_LENGTH`).
+ * @param p_buffer Búfer de al menos `USART_FRAME_ENCODED_MAX_LENGTH` bytes.
+ * @return Bytes escritos en `p_buffer`, con el delimitador, o 0 si la carga es demasiado larga.
+ */
+uint32_t usart_frame_encode(const usart_frame_t *p_frame, uint8_t *p_buffer);
+
+/**
+ * @brief Decodifica una trama recibida y comprueba su CRC y su longitud.
+ *
+ * La decodificación COBS y el CRC se calculan en una sola pasada sobre los bytes recibidos.
+ * @param p_data Bytes de la trama codificada, sin el delimitador.
+ * @param length Número de bytes.
+ * @param p_frame Puntero donde se guarda la trama.
+ * @return Verdadero si la trama es correcta, falso si está mal codificada, es demasiado corta o larga, o falla el CRC.
+ */
+bool usart_frame_decode(const uint8_t *p_data, uint32_t length, usart_frame_t *p_frame);
+
+#endif /* USART_FRAME_H_ */
@@ -0,0 +1,34 @@
+/**
+ * @file button_debounce.c
+ * @brief Filtro anti-rebote bit a bit con contadores verticales.
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "button_debounce.h"
+
+/* Public functions */
+void button_debounce_init(button_debounce_t *p_debounce, uint32_t state)
+{
+    p_debounce->state = state;
+    p_debounce->cnt0 = UINT32_MAX;
+    p_debounce->cnt1 = UINT32_MAX;
+}
+
+uint32_t button_debounce_update(button_debounce_t *p_debounce, uint32_t sample, uint32_t *p_pressed, uint32_t *p_released)
+{
+    uint32_t delta = p_debounce->state ^ sample; /* Botones cuya muestra difiere del estado filtrado */
+
+    /* Cuenta atrás de 3 a 0 en los bits que difieren; los demás vuelven a 3 */
+    p_debounce->cnt0 = ~(p_debounce->cnt0 & delta);
+    p_debounce->cnt1 = p_debounce->cnt0 ^ (p_debounce->cnt1 & delta);
+
+    uint32_t toggle = delta & p_debounce->cnt0 & p_debounce->cnt1; /* El contador ha dado la vuelta */
+    p_debounce->state ^= toggle;
+
+    *p_pressed = toggle & p_debounce->state;
+    *p_released = toggle & ~p_debounce->state;
+    return toggle;
+}
@@ -0,0 +1,257 @@
+/**
+ * @file cmd_registry.c
+ * @brief Registro de órdenes de la consola serie con hash perfecto.
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "cmd_registry.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define FNV_OFFSET_BASIS 2166136261U /*!< Valor inicial del hash FNV-1a de 32 bits */
+#define FNV_PRIME 16777619U          /*!< Multiplicador del hash FNV-1a de 32 bits */
+#define CMD_REGISTRY_MIN_SLOTS 8U    /*!< Casillas mínimas del hash perfecto */
+
+/* Private functions */
+/**
+ * @brief Añade un carácter al hash FNV-1a.
+ */
+static inline uint32_t _hash_step(uint32_t hash, char c)
+{
+    return (hash ^ (uint8_t)c) * FNV_PRIME;
+}
+
+/**
+ * @brief Casilla de un hash con la máscara del registro.
+ */
+static inline uint32_t _slot(uint32_t hash, uint32_t mask)
+{
+    return (hash ^ (hash >> 16)) & mask;
+}
+
+/**
+ * @brief Comprueba si un carácter separa el nombre y los argumentos (`\r` incluido, por los terminales que envían CRLF).
+ */
+static inline bool _is_separator(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\r');
+}
+
+/**
+ * @brief Comprueba la única orden candidata de una casilla.
+ *
+ * @param p_registry Puntero al registro.
+ * @param hash Hash del nombre con la semilla del registro.
+ * @param p_name Nombre.
+ * @param length Longitud del nombre.
+ * @return Fila de la orden, o `NULL` si la casilla está vacía o tiene otro nombre.
+ */
+static const cmd_entry_t *_lookup(const cmd_registry_t *p_registry, uint32_t hash, const char *p_name, uint32_t length)
+{
+    uint32_t row = p_registry->slots[_slot(hash, p_registry->mask)];
+    if (row == 0)
+    {
+        return NULL;
+    }
+    const cmd_entry_t *p_entry = &p_registry->p_table[row - 1];
+    if ((strnlen(p_entry->p_name, length + 1U) != length) || (memcmp(p_entry->p_name, p_name, length) != 0))
+    {
+        return NULL; /* La longitud se compara primero: el nombre puede tener un carácter nulo y no se lee tras el de la fila */
+    }
+    return p_entry;
+}
+
+/**
+ * @brief Convierte un argumento numérico: decimal con signo opcional o hexadecimal con el prefijo `0x`.
+ *
+ * @param p_line Línea.
+ * @param length Longitud de la línea.
+ * @param p_pos Posición del primer carácter del argumento; se deja tras el último.
+ * @param p_value Puntero donde se guarda el valor.
+ * @return `true` si el argumento es un entero de 32 bits terminado en un separador o en el final de la línea.
+ */
+static bool _parse_int(const char *p_line, uint32_t length, uint32_t *p_pos, int32_t *p_value)
+{
+    uint32_t i = *p_pos;
+    bool negative = false;
+    uint64_t value = 0;
+    uint64_t limit = 0x7FFFFFFFU;
+    uint32_t base = 10;
+    if ((i < length) && ((p_line[i] == '-') || (p_line[i] == '+')))
+    {
+        negative = (p_line[i++] == '-');
+        limit += negative;
+    }
+    else if ((i + 1 < length) && (p_line[i] == '0') && ((p_line[i + 1] == 'x') || (p_line[i + 1] == 'X')))
+    {
+        base = 16;
+        limit = 0xFFFFFFFFU; /* Los hexadecimales son patrones de bits: 0xFFFFFFFF es -1 */
+        i += 2;
+    }
+    uint32_t first = i;
+    for (; (i < length) && !_is_separator(p_line[i]); i++)
+    {
+        char c = p_line[i];
+        uint32_t digit;
+        if ((c >= '0') && (c <= '9'))
+        {
+            digit = (uint32_t)(c - '0');
+        }
+        else if ((base == 16) && (c >= 'a') && (c <= 'f'))
+        {
+            digit = (uint32_t)(c - 'a' + 10);
+        }
+        else if ((base == 16) && (c >= 'A') && (c <= 'F'))
+        {
+            digit = (uint32_t)(c - 'A' + 10);
+        }
+        else
+        {
+            return false;
+        }
+        value = value * base + digit;
+        if (value > limit)
+        {
+            return false;
+        }
+    }
+    if (i == first)
+    {
+        return false; /* Signo o prefijo sin dígitos */
+    }
+    *p_value = negative ? (int32_t)(0U - (uint32_t)value) : (int32_t)(uint32_t)value;
+    *p_pos = i;
+    return true;
+}
+
+/* Public functions */
+bool cmd_registry_build(cmd_registry_t *p_registry, const cmd_entry_t *p_table)
+{
+    memset(p_registry, 0, sizeof(cmd_registry_t));
+
+    uint32_t num_commands = 0;
+    for (const cmd_entry_t *p_entry = p_table; p_entry->p_name != NULL; p_entry++)
+    {
+        if ((num_commands >= CMD_REGISTRY_MAX_COMMANDS) || (p_entry->max_args > CMD_REGISTRY_MAX_ARGS) || (p_entry->min_args > p_entry->max_args))
+        {
+            return false;
+        }
+        for (const cmd_entry_t *p_other = p_table; p_other != p_entry; p_other++)
+        {
+            if (strcmp(p_other->p_name, p_entry->p_name) == 0)
+            {
+                return false; /* Con nombres repetidos no hay hash perfecto */
+            }
+        }
+        num_commands++;
+    }
+
+    /* Se empieza con al menos el doble de casillas que órdenes y se duplican si ninguna semilla las separa */
+    uint32_t size = CMD_REGISTRY_MIN_SLOTS;
+    while (size < 2 * num_commands)
+    {
+        size *= 2;
+    }
+    for (; size <= CMD_REGISTRY_TABLE_SIZE; size *= 2)
+    {
+        for (uint32_t seed = 0; seed < CMD_REGISTRY_MAX_SEEDS; seed++)
+        {
+            memset(p_registry->slots, 0, sizeof(p_registry->slots));
+            uint32_t row;
+            for (row = 0; row < num_commands; row++)
+            {
+                uint32_t hash = FNV_OFFSET_BASIS ^ seed;
+                for (const char *p_c = p_table[row].p_name; *p_c != '\0'; p_c++)
+                {
+                    hash = _hash_step(hash, *p_c);
+                }
+                uint32_t slot = _slot(hash, size - 1);
+                if (p_registry->slots[slot] != 0)
+                {
+                    break; /* Colisión: se prueba la siguiente semilla */
+                }
+                p_registry->slots[slot] = (uint8_t)(row + 1);
+            }
+            if (row == num_commands)
+            {
+                p_registry->seed = seed;
+                p_registry->mask = size - 1;
+                p_registry->p_table = p_table;
+                return true;
+            }
+        }
+    }
+    memset(p_registry->slots, 0, sizeof(p_registry->slots));
+    return false;
+}
+
+bool cmd_registry_is_built(const cmd_registry_t *p_registry, const cmd_entry_t *p_table)
+{
+    return p_registry->p_table == p_table;
+}
+
+const cmd_entry_t *cmd_registry_find(const cmd_registry_t *p_registry, const char *p_name, uint32_t length)
+{
+    if (p_registry->p_table == NULL)
+    {
+        return NULL;
+    }
+    uint32_t hash = FNV_OFFSET_BASIS ^ p_registry->seed;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        hash = _hash_step(hash, p_name[i]);
+    }
+    return _lookup(p_registry, hash, p_name, length);
+}
+
+uint32_t cmd_registry_dispatch(const cmd_registry_t *p_registry, const char *p_line, uint32_t length, void *p_context)
+{
+    if (p_registry->p_table == NULL)
+    {
+        return CMD_REGISTRY_UNKNOWN;
+    }
+
+    /* El hash del nombre se calcula mientras se busca su final */
+    uint32_t i = 0;
+    while ((i < length) && _is_separator(p_line[i]))
+    {
+        i++;
+    }
+    const char *p_name = &p_line[i];
+    uint32_t hash = FNV_OFFSET_BASIS ^ p_registry->seed;
+    for (; (i < length) && !_is_separator(p_line[i]); i++)
+    {
+        hash = _hash_step(hash, p_line[i]);
+    }
+    const cmd_entry_t *p_entry = _lookup(p_registry, hash, p_name, (uint32_t)(&p_line[i] - p_name));
+    if (p_entry == NULL)
+    {
+        return CMD_REGISTRY_UNKNOWN;
+    }
+
+    cmd_args_t args = {0};
+    while (true)
+    {
+        while ((i < length) && _is_separator(p_line[i]))
+        {
+            i++;
+        }
+        if (i == length)
+        {
+            break;
+        }
+        if ((args.argc == p_entry->max_args) || !_parse_int(p_line, length, &i, &args.argv[args.argc]))
+        {
+            return CMD_REGISTRY_BAD_ARGUMENT;
+        }
+        args.argc++;
+    }
+    if (args.argc < p_entry->min_args)
+    {
+        return CMD_REGISTRY_BAD_ARGUMENT;
+    }
+    return p_entry->handler(p_context, &args);
+}
@@ -9,7 +9,9 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdlib.h>
 #include "fsm_button.h"
+#include "fsm_pool.h"
 #include "port_button.h"
+#include "sw_timer.h"
 
 /* State machine input or transition functions */
 
@@ -17,13 +19,97 @@
 
 /* Other auxiliary functions */
 
+/**
+ * @brief Función de liberación del pool de botones: fsm_destroy() pasa por fsm_button_destroy() antes de devolver el objeto.
+ */
+static void _release_button(void *p_obj)
+{
+    fsm_button_destroy((fsm_t *)p_obj);
+}
+
+FSM_POOL_DEFINE(fsm_button_pool, fsm_button_t, FSM_BUTTON_POOL_SIZE, _release_button); /*!< Pool estático de botones */
+
 fsm_t *fsm_button_new(uint32_t debounce_time, uint32_t button_id)
 {
-    fsm_t *p_fsm = malloc(sizeof(fsm_button_t)); /* Do malloc to reserve memory of all other FSM elements, although it is interpreted as fsm_t (the first element of the structure) */
+    fsm_t *p_fsm = fsm_pool_acquire(&fsm_button_pool); /* Reserve memory of all other FSM elements from the static pool, although it is interpreted as fsm_t (the first element of the structure) */
+    if (p_fsm != NULL)
+    {
+        fsm_button_init(p_fsm, debounce_time, button_id);
+    }
+    return p_fsm;
+}
+
+void fsm_button_destroy(fsm_t *p_this)
+{
+    fsm_button_t *p_fsm = (fsm_button_t *)(p_this);
+    sw_timer_stop(&p_fsm->debounce_timer);
+    sw_timer_stop(&p_fsm->gesture_timer);
+}
+
+fsm_t *fsm_button_new_static(fsm_button_t *p_storage, uint32_t debounce_time, uint32_t button_id)
+{
+    fsm_t *p_fsm = (fsm_t *)p_storage;
     fsm_button_init(p_fsm, debounce_time, button_id);
     return p_fsm;
 }
 
+/**
+ * @brief Deja un gesto en la cola del botón; si está llena, lo descarta y lo cuenta.
+ */
+static void _push_gesture(fsm_button_t *p_fsm, uint8_t type, uint32_t tick)
+{
+    if ((p_fsm->gesture_head - p_fsm->gesture_tail) >= FSM_BUTTON_GESTURE_QUEUE_LENGTH)
+    {
+        p_fsm->gestures_dropped++;
+        return;
+    }
+    p_fsm->gestures[p_fsm->gesture_head & (FSM_BUTTON_GESTURE_QUEUE_LENGTH - 1U)] = (fsm_button_gesture_t){.type = type, .tick = tick};
+    p_fsm->gesture_head++;
+}
+
+/**
+ * @brief Atiende el vencimiento del temporizador de gestos: pulsación larga, repetición o fin de la ventana de doble clic.
+ * @return 1 si se ha generado algún gesto, 0 en caso contrario.
+ */
+static int _update_gestures(fsm_button_t *p_fsm)
+{
+    if (!sw_timer_has_expired(&p_fsm->gesture_timer))
+    {
+        return 0;
+    }
+    sw_timer_stop(&p_fsm->gesture_timer); /* Borra la indicación de vencido */
+    uint32_t tick = port_button_get_tick();
+    int state = fsm_get_state(&p_fsm->f);
+
+    if (state == BUTTON_PRESSED)
+    {
+        if (p_fsm->click_pending) /* La segunda pulsación es larga: la primera fue un clic */
+        {
+            _push_gesture(p_fsm, BUTTON_GESTURE_CLICK, p_fsm->tick_released);
+            p_fsm->click_pending = false;
+        }
+        _push_gesture(p_fsm, p_fsm->long_pressed ? BUTTON_GESTURE_REPEAT : BUTTON_GESTURE_LONG_PRESS, tick);
+        p_fsm->long_pressed = true;
+        if (p_fsm->repeat_ms > 0)
+        {
+            sw_timer_start(&p_fsm->gesture_timer, p_fsm->repeat_ms);
+        }
+        return 1;
+    }
+
+    if (p_fsm->click_pending)
+    {
+        /* Si ya hay una segunda pulsación dentro de la ventana, la decide do_confirm_press() */
+        if ((state == BUTTON_PRESSED_WAIT) && ((p_fsm->tick_pressed - p_fsm->tick_released) <= p_fsm->double_click_ms))
+        {
+            return 0;
+        }
+        _push_gesture(p_fsm, BUTTON_GESTURE_CLICK, p_fsm->tick_released);
+        p_fsm->click_pending = false;
+        return 1;
+    }
+    return 0;
+}
 
 static bool check_button_pressed(fsm_t *p_this)
 {
@@ -38,44 +124,99 @@ static bool check_button_released(fsm_t *p_this)
 static bool check_timeout(fsm_t *p_this)
 {
     fsm_button_t *p_fsm = (fsm_button_t *)(p_this);
-    uint32_t tick = port_button_get_tick();
-    if (tick > p_fsm->next_timeout)
-    {
-        return true;
-    }
-    else
-    {
-        return false;
-    }
+    return sw_timer_has_expired(&p_fsm->debounce_timer);
 }
 static void do_store_tick_pressed(fsm_t *p_this)
 {
     fsm_button_t *p_fsm = (fsm_button_t *)(p_this);
-    uint32_t tick = port_button_get_tick();
-    p_fsm->tick_pressed = tick;
-    p_fsm->next_timeout = tick + p_fsm->debounce_time;
+    p_fsm->tick_pressed = port_button_get_edge_tick(p_fsm->button_id); /* Tick tomado por la ISR en el flanco */
+    sw_timer_start(&p_fsm->debounce_timer, p_fsm->debounce_time);
+}
+
+static void do_confirm_press(fsm_t *p_this)
+{
+    fsm_button_t *p_fsm = (fsm_button_t *)(p_this);
+    if (p_fsm->click_pending && ((p_fsm->tick_pressed - p_fsm->tick_released) > p_fsm->double_click_ms))
+    {
+        _push_gesture(p_fsm, BUTTON_GESTURE_CLICK, p_fsm->tick_released);
+        p_fsm->click_pending = false;
+    }
+    _push_gesture(p_fsm, BUTTON_GESTURE_PRESS, p_fsm->tick_pressed);
+    p_fsm->long_pressed = false;
+    sw_timer_stop(&p_fsm->gesture_timer);
+    if (p_fsm->long_press_ms > 0)
+    {
+        uint32_t elapsed = port_button_get_tick() - p_fsm->tick_pressed; /* El anti-rebote ya ha consumido parte del umbral */
+        sw_timer_start(&p_fsm->gesture_timer, (p_fsm->long_press_ms > elapsed) ? (p_fsm->long_press_ms - elapsed) : 0);
+    }
 }
 
 static void do_set_duration(fsm_t *p_this)
 {
 fsm_button_t *p_fsm = (fsm_button_t *)(p_this);
-    uint32_t tick = port_button_get_tick();
+    uint32_t tick = port_button_get_edge_tick(p_fsm->button_id); /* Tick tomado por la ISR en el flanco */
     p_fsm->duration=tick-p_fsm->tick_pressed;
-    p_fsm->next_timeout = tick + p_fsm->debounce_time;
+    sw_timer_start(&p_fsm->debounce_timer, p_fsm->debounce_time);
+
+    sw_timer_stop(&p_fsm->gesture_timer);
+    _push_gesture(p_fsm, BUTTON_GESTURE_RELEASE, tick);
+    if (p_fsm->long_pressed)
+    {
+        return; /* Una pulsación larga no es un clic */
+    }
+    if (p_fsm->click_pending)
+    {
+        _push_gesture(p_fsm, BUTTON_GESTURE_DOUBLE_CLICK, tick);
+        p_fsm->click_pending = false;
+    }
+    else if (p_fsm->double_click_ms == 0)
+    {
+        _push_gesture(p_fsm, BUTTON_GESTURE_CLICK, tick);
+    }
+    else
+    {
+        p_fsm->click_pending = true;
+        p_fsm->tick_released = tick;
+        sw_timer_start(&p_fsm->gesture_timer, p_fsm->double_click_ms);
+    }
 
 }
 
 static fsm_trans_t fsm_trans_button[] = {{BUTTON_RELEASED, check_button_pressed, BUTTON_PRESSED_WAIT, do_store_tick_pressed},
- {BUTTON_PRESSED_WAIT, check_timeout, BUTTON_PRESSED, NULL},
+ {BUTTON_PRESSED_WAIT, check_timeout, BUTTON_PRESSED, do_confirm_press},
  {BUTTON_PRESSED,check_button_released,BUTTON_RELEASED_WAIT,do_set_duration},
  {BUTTON_RELEASED_WAIT,check_timeout,BUTTON_RELEASED,NULL},
  {-1, NULL, -1, NULL}};
+
  
 uint32_t fsm_button_get_duration(fsm_t *p_this)
 {
      fsm_button_t *p_fsm = (fsm_button_t *)(p_this);
      return p_fsm->duration;
 }
+int fsm_button_fire(fsm_t *p_this)
+{
+    int fired = fsm_fire(p_this); /* Tabla de 4 filas: no compensa indexarla (ver fsm_index.h) */
+    return fired | _update_gestures((fsm_button_t *)(p_this));
+}
+void fsm_button_set_gesture_config(fsm_t *p_this, uint32_t long_press_ms, uint32_t repeat_ms, uint32_t double_click_ms)
+{
+    fsm_button_t *p_fsm = (fsm_button_t *)(p_this);
+    p_fsm->long_press_ms = long_press_ms;
+    p_fsm->repeat_ms = repeat_ms;
+    p_fsm->double_click_ms = double_click_ms;
+}
+bool fsm_button_get_gesture(fsm_t *p_this, fsm_button_gesture_t *p_gesture)
+{
+    fsm_button_t *p_fsm = (fsm_button_t *)(p_this);
+    if (p_fsm->gesture_head == p_fsm->gesture_tail)
+    {
+        return false;
+    }
+    *p_gesture = p_fsm->gestures[p_fsm->gesture_tail & (FSM_BUTTON_GESTURE_QUEUE_LENGTH - 1U)];
+    p_fsm->gesture_tail++;
+    return true;
+}
 void fsm_button_reset_duration(fsm_t *p_this)
 {
      fsm_button_t *p_fsm = (fsm_button_t *)(p_this);
@@ -92,5 +233,14 @@ void fsm_button_reset_duration(fsm_t *p_this)
     p_fsm->tick_pressed = 0;
     p_fsm->debounce_time = debounce_time;
     p_fsm->button_id= button_id;
+    sw_timer_init(&p_fsm->debounce_timer, port_button_get_event(button_id));
+    sw_timer_init(&p_fsm->gesture_timer, port_button_get_event(button_id));
+    fsm_button_set_gesture_config(p_this, FSM_BUTTON_LONG_PRESS_MS, FSM_BUTTON_REPEAT_MS, FSM_BUTTON_DOUBLE_CLICK_MS);
+    p_fsm->tick_released = 0;
+    p_fsm->click_pending = false;
+    p_fsm->long_pressed = false;
+    p_fsm->gesture_head = 0;
+    p_fsm->gesture_tail = 0;
+    p_fsm->gestures_dropped = 0;
     port_button_init(button_id);
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+/**
+ * @file fsm_index.c
+ * @brief Índice por estado de las tablas de transiciones de las FSM.
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "fsm_index.h"
+
+/* Public functions */
+bool fsm_index_build(fsm_index_t *p_index, fsm_trans_t *p_tt)
+{
+    memset(p_index, 0, sizeof(fsm_index_t));
+
+    /* Primera pasada: número de transiciones de cada estado */
+    uint32_t num_rows = 0;
+    uint16_t count[FSM_INDEX_MAX_STATES] = {0};
+    for (fsm_trans_t *p_t = p_tt; p_t->orig_state >= 0; p_t++)
+    {
+        if ((p_t->orig_state >= FSM_INDEX_MAX_STATES) || (num_rows >= FSM_INDEX_MAX_TRANSITIONS))
+        {
+            return false; /* Tabla demasiado grande: se usará fsm_fire() */
+        }
+        if ((uint32_t)p_t->orig_state >= p_index->num_states)
+        {
+            p_index->num_states = (uint32_t)p_t->orig_state + 1;
+        }
+        count[p_t->orig_state]++;
+        num_rows++;
+    }
+    if (num_rows < FSM_INDEX_MIN_TRANSITIONS)
+    {
+        p_index->num_states = 0;
+        return false; /* Tabla pequeña: fsm_fire() es igual de rápido */
+    }
+
+    /* Posición de inicio de cada estado */
+    for (uint32_t s = 0; s < p_index->num_states; s++)
+    {
+        p_index->first[s + 1] = p_index->first[s] + count[s];
+    }
+
+    /* Segunda pasada: se colocan las filas en orden, de modo que se mantiene la prioridad de la tabla */
+    uint16_t next[FSM_INDEX_MAX_STATES];
+    memcpy(next, p_index->first, sizeof(next));
+    for (fsm_trans_t *p_t = p_tt; p_t->orig_state >= 0; p_t++)
+    {
+        p_index->p_rows[next[p_t->orig_state]++] = p_t;
+    }
+    p_index->p_tt = p_tt;
+    return true;
+}
+
+bool fsm_index_is_built(const fsm_index_t *p_index, const fsm_trans_t *p_tt)
+{
+    return p_index->p_tt == p_tt;
+}
+
+int fsm_index_fire(fsm_t *p_fsm, const fsm_index_t *p_index)
+{
+    if (p_index->p_tt != p_fsm->p_tt)
+    {
+        return fsm_fire(p_fsm); /* Tabla sin indexar */
+    }
+    int state = p_fsm->current_state;
+    if ((state < 0) || ((uint32_t)state >= p_index->num_states))
+    {
+        return 0; /* Estado sin transiciones de salida */
+    }
+    for (uint32_t i = p_index->first[state]; i < p_index->first[state + 1]; i++)
+    {
+        fsm_trans_t *p_t = p_index->p_rows[i];
+        if (p_t->in(p_fsm))
+        {
+            p_fsm->current_state = p_t->dest_state;
+            if (p_t->out)
+            {
+                p_t->out(p_fsm);
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file fsm_pool.c
+ * @brief Pools estáticos de objetos para las FSM.
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "fsm_pool.h"
+
+/* Global variables */
+static fsm_pool_t *pools[FSM_POOL_MAX_POOLS]; /*!< Pools registrados (los que se han usado alguna vez) */
+static uint32_t num_pools = 0;                /*!< Número de pools registrados */
+
+/* Private functions */
+/**
+ * @brief Obtiene la cabecera del objeto `idx` del pool.
+ */
+static fsm_pool_header_t *_get_header(const fsm_pool_t *p_pool, uint32_t idx)
+{
+    return (fsm_pool_header_t *)(p_pool->p_storage + idx * p_pool->slot_size);
+}
+
+/**
+ * @brief Obtiene el índice del siguiente objeto libre, guardado en los primeros bytes de un objeto libre.
+ */
+static uint32_t _get_next(const fsm_pool_t *p_pool, uint32_t idx)
+{
+    uint32_t next;
+    memcpy(&next, _get_header(p_pool, idx) + 1, sizeof(next));
+    return next;
+}
+
+/**
+ * @brief Guarda en un objeto libre el índice del siguiente objeto libre.
+ */
+static void _set_next(fsm_pool_t *p_pool, uint32_t idx, uint32_t next)
+{
+    memcpy(_get_header(p_pool, idx) + 1, &next, sizeof(next));
+}
+
+/**
+ * @brief Busca el pool registrado en cuya memoria está el objeto, sin leer nada del objeto.
+ *
+ * @param p_obj Puntero cualquiera.
+ * @param p_idx Puntero donde se guarda el índice del objeto en su pool.
+ * @return El pool, o `NULL` si el puntero no es el de un objeto de un pool (memoria del heap o del llamante).
+ */
+static fsm_pool_t *_find_pool(const void *p_obj, uint32_t *p_idx)
+{
+    uintptr_t addr = (uintptr_t)p_obj;
+    for (uint32_t i = 0; i < num_pools; i++)
+    {
+        fsm_pool_t *p_pool = pools[i];
+        uintptr_t first = (uintptr_t)p_pool->p_storage + sizeof(fsm_pool_header_t);
+        uintptr_t end = (uintptr_t)p_pool->p_storage + p_pool->capacity * p_pool->slot_size;
+        if ((addr >= first) && (addr < end))
+        {
+            if ((addr - first) % p_pool->slot_size != 0)
+            {
+                return NULL; /* Apunta dentro de un objeto, no a su principio */
+            }
+            *p_idx = (uint32_t)((addr - first) / p_pool->slot_size);
+            return p_pool;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Registra el pool y construye su lista de libres la primera vez que se usa.
+ *
+ * @return `false` si ya hay `FSM_POOL_MAX_POOLS` pools registrados: el pool queda rechazado.
+ */
+static bool _prepare(fsm_pool_t *p_pool)
+{
+    if (num_pools >= FSM_POOL_MAX_POOLS)
+    {
+        p_pool->rejected = true; /* Un pool fuera del registro no aparecería en las estadísticas */
+        return false;
+    }
+    pools[num_pools++] = p_pool;
+    for (uint32_t i = 0; i < p_pool->capacity; i++)
+    {
+        _get_header(p_pool, i)->p_owner = NULL;
+        _set_next(p_pool, i, (i + 1 < p_pool->capacity) ? i + 1 : FSM_POOL_NONE);
+    }
+    p_pool->free_head = (p_pool->capacity > 0) ? 0 : FSM_POOL_NONE;
+    p_pool->ready = true;
+    return true;
+}
+
+/* Public functions */
+void *fsm_pool_acquire(fsm_pool_t *p_pool)
+{
+    if (!p_pool->ready && (p_pool->rejected || !_prepare(p_pool)))
+    {
+        p_pool->failures++;
+        return NULL;
+    }
+    uint32_t idx = p_pool->free_head;
+    if (idx == FSM_POOL_NONE)
+    {
+        p_pool->failures++;
+        return NULL;
+    }
+    p_pool->free_head = _get_next(p_pool, idx);
+    p_pool->used++;
+    if (p_pool->used > p_pool->high_water)
+    {
+        p_pool->high_water = p_pool->used;
+    }
+    fsm_pool_header_t *p_header = _get_header(p_pool, idx);
+    p_header->p_owner = p_pool;
+    return p_header + 1;
+}
+
+bool fsm_pool_release(void *p_obj)
+{
+    uint32_t idx;
+    fsm_pool_t *p_pool = _find_pool(p_obj, &idx);
+    if (p_pool == NULL)
+    {
+        return false; /* No es de ningún pool: no tiene cabecera */
+    }
+    fsm_pool_header_t *p_header = _get_header(p_pool, idx);
+    if (p_header->p_owner == NULL)
+    {
+        return false; /* Ya estaba libre */
+    }
+    if (p_pool->on_release != NULL)
+    {
+        p_pool->on_release(p_obj);
+    }
+    p_header->p_owner = NULL;
+    _set_next(p_pool, idx, p_pool->free_head);
+    p_pool->free_head = idx;
+    p_pool->used--;
+    return true;
+}
+
+uint32_t fsm_pool_get_stats(fsm_pool_stats_t *p_stats, uint32_t max_pools)
+{
+    uint32_t n = (num_pools < max_pools) ? num_pools : max_pools;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        p_stats[i] = (fsm_pool_stats_t){.p_name = pools[i]->p_name,
+                                        .obj_size = pools[i]->obj_size,
+                                        .capacity = pools[i]->capacity,
+                                        .used = pools[i]->used,
+                                        .high_water = pools[i]->high_water,
+                                        .failures = pools[i]->failures};
+    }
+    return n;
+}
+
+void fsm_free(void *p)
+{
+    uint32_t idx;
+    if (_find_pool(p, &idx) != NULL)
+    {
+        fsm_pool_release(p);
+    }
+    else
+    {
+        free(p); /* FSM creada con fsm_new(): vuelve al heap, como con la función débil de la librería */
+    }
+}
@@ -0,0 +1,138 @@
+/**
+ * @file fsm_sched.c
+ * @brief Planificador de FSM guiado por eventos.
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "fsm_sched.h"
+#include "port_system.h"
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief FSM registrada en el planificador.
+ */
+typedef struct
+{
+    fsm_t *p_fsm;          /*!< FSM */
+    fsm_sched_fire_t fire; /*!< Función de disparo */
+    uint32_t events;       /*!< Eventos a los que está suscrita */
+} fsm_sched_entry_t;
+
+/* Global variables */
+static fsm_sched_entry_t entries[FSM_SCHED_MAX_FSMS]; /*!< FSM registradas */
+static uint32_t num_entries = 0;                       /*!< Número de FSM registradas */
+static uint32_t ready = 0;                             /*!< Máscara de FSM con trabajo pendiente (bit `i` para la FSM `i`) */
+static fsm_sched_stats_t stats;                        /*!< Contadores */
+
+/* Private functions */
+/**
+ * @brief Dispara una FSM hasta que deja de transitar (o hasta `FSM_SCHED_RUN_LIMIT` transiciones).
+ *
+ * @param id Identificador de la FSM.
+ * @return `true` si la FSM ha ejecutado alguna transición.
+ */
+static bool _run(uint32_t id)
+{
+    fsm_sched_entry_t *p_entry = &entries[id];
+    uint32_t transitions = 0;
+    while (transitions < FSM_SCHED_RUN_LIMIT)
+    {
+        stats.fires++;
+        if (!p_entry->fire(p_entry->p_fsm))
+        {
+            break;
+        }
+        transitions++;
+    }
+    if (transitions == FSM_SCHED_RUN_LIMIT)
+    {
+        ready |= (1U << id); /* Sigue transitando: se deja para el siguiente despacho para no bloquear al resto */
+    }
+    stats.transitions += transitions;
+    return transitions > 0;
+}
+
+/* Public functions */
+void fsm_sched_init(void)
+{
+    memset(entries, 0, sizeof(entries));
+    num_entries = 0;
+    ready = 0;
+    fsm_sched_reset_stats();
+}
+
+int fsm_sched_add(fsm_t *p_fsm, fsm_sched_fire_t fire, uint32_t events)
+{
+    if (num_entries >= FSM_SCHED_MAX_FSMS)
+    {
+        return -1;
+    }
+    uint32_t id = num_entries++;
+    entries[id] = (fsm_sched_entry_t){.p_fsm = p_fsm, .fire = fire, .events = events};
+    ready |= (1U << id);
+    return (int)id;
+}
+
+void fsm_sched_post(int fsm_id)
+{
+    if ((fsm_id >= 0) && ((uint32_t)fsm_id < num_entries))
+    {
+        ready |= (1U << fsm_id);
+    }
+}
+
+bool fsm_sched_dispatch(void)
+{
+    stats.dispatches++;
+    uint32_t events = port_system_take_events();
+    if (events != 0)
+    {
+        for (uint32_t i = 0; i < num_entries; i++)
+        {
+            if (events & entries[i].events)
+            {
+                ready |= (1U << i);
+            }
+        }
+    }
+
+    bool fired = false;
+    uint32_t work = ready;
+    ready = 0;
+    while (work != 0)
+    {
+        uint32_t id = (uint32_t)__builtin_ctz(work);
+        work &= work - 1U;
+        fired |= _run(id);
+    }
+    return fired;
+}
+
+bool fsm_sched_has_work(void)
+{
+    return ready != 0;
+}
+
+void fsm_sched_run(void)
+{
+    if (ready == 0)
+    {
+        stats.sleeps++;
+        port_system_sleep_until_event(); /* Vuelve enseguida si una ISR ha publicado un evento */
+    }
+    fsm_sched_dispatch();
+}
+
+void fsm_sched_get_stats(fsm_sched_stats_t *p_stats)
+{
+    *p_stats = stats;
+}
+
+void fsm_sched_reset_stats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
@@ -7,10 +7,13 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include "port_usart.h"
 #include "fsm_usart.h"
+#include "usart_frame.h"
+#include "fsm_pool.h"
 /* Standard C libraries */
 
 /* Other libraries */
@@ -28,21 +31,123 @@
 void fsm_usart_get_in_data(fsm_t *p_this, char *p_data)
 {
     fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
-    memcpy(p_data, p_fsm->in_data, USART_INPUT_BUFFER_LENGTH);
+    uint32_t length = (p_fsm->in_line_length < USART_INPUT_BUFFER_LENGTH) ? p_fsm->in_line_length : (USART_INPUT_BUFFER_LENGTH - 1);
+    memset(p_data, EMPTY_BUFFER_CONSTANT, USART_INPUT_BUFFER_LENGTH);
+    if (p_fsm->p_in_line != NULL)
+    {
+        memcpy(p_data, p_fsm->p_in_line, length);
+    }
+}
+
+bool fsm_usart_get_in_line(fsm_t *p_this, const char **pp_line, uint32_t *p_length)
+{
+    fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
+    if (!p_fsm->data_received)
+    {
+        return false;
+    }
+    *pp_line = p_fsm->p_in_line;
+    *p_length = p_fsm->in_line_length;
+    return true;
 }
 
-void fsm_usart_set_out_data(fsm_t *p_this, char *p_data)
+bool fsm_usart_send(fsm_t *p_this, const char *p_data, uint32_t length)
 {
     fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
-    // Ensure to reset the output data before setting a new one
-    memset(p_fsm->out_data, EMPTY_BUFFER_CONSTANT, USART_OUTPUT_BUFFER_LENGTH);
-    memcpy(p_fsm->out_data, p_data, USART_OUTPUT_BUFFER_LENGTH);
+    return port_usart_send(p_fsm->usart_id, p_data, length);
+}
+
+bool fsm_usart_send_ref(fsm_t *p_this, const char *p_data, uint32_t length, port_usart_tx_callback_t callback, void *p_arg)
+{
+    fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
+    return port_usart_send_ref(p_fsm->usart_id, p_data, length, callback, p_arg);
+}
+
+bool fsm_usart_set_out_data(fsm_t *p_this, const char *p_data)
+{
+    // The message ends at the first END_CHAR_CONSTANT (included) or at the end of the output buffer
+    uint32_t length = 0;
+    while ((length < USART_OUTPUT_BUFFER_LENGTH) && (p_data[length] != EMPTY_BUFFER_CONSTANT))
+    {
+        if (p_data[length++] == END_CHAR_CONSTANT)
+        {
+            break;
+        }
+    }
+    return fsm_usart_send(p_this, p_data, length);
 }
 
+bool fsm_usart_set_binary(fsm_t *p_this, bool binary)
+{
+    fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
+    if (!port_usart_set_rx_delimiter(p_fsm->usart_id, binary ? USART_FRAME_DELIMITER : END_CHAR_CONSTANT))
+    {
+        return false;
+    }
+    p_fsm->binary = binary;
+    p_fsm->p_in_line = NULL;
+    p_fsm->in_line_length = 0;
+    p_fsm->data_received = false;
+    return true;
+}
+
+bool fsm_usart_get_in_frame(fsm_t *p_this, const usart_frame_t **pp_frame)
+{
+    fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
+    if (!p_fsm->binary || !p_fsm->data_received)
+    {
+        return false;
+    }
+    *pp_frame = &p_fsm->in_frame;
+    return true;
+}
+
+bool fsm_usart_send_frame(fsm_t *p_this, const usart_frame_t *p_frame)
+{
+    uint8_t encoded[USART_FRAME_ENCODED_MAX_LENGTH];
+    uint32_t length = usart_frame_encode(p_frame, encoded);
+    return (length > 0) && fsm_usart_send(p_this, (const char *)encoded, length); /* La cola copia la trama codificada */
+}
+
+uint32_t fsm_usart_get_frames_rejected(fsm_t *p_this)
+{
+    fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
+    return p_fsm->frames_rejected;
+}
+
+uint32_t fsm_usart_cmd_stats(void *p_context, const cmd_args_t *p_args)
+{
+    fsm_usart_t *p_fsm = (fsm_usart_t *)p_context;
+    uint32_t usart_id = (p_args->argc > 0) ? (uint32_t)p_args->argv[0] : p_fsm->usart_id;
+    if (usart_id >= USART_INSTANCES)
+    {
+        return CMD_REGISTRY_BAD_ARGUMENT;
+    }
+    port_usart_stats_t stats;
+    port_usart_get_stats(usart_id, &stats);
+    char line[USART_TX_MESSAGE_MAX_LENGTH];
+    int length = snprintf(line, sizeof(line), "usart %u rx %u frames %u ore %u fe %u ne %u pe %u drop %u\n", (unsigned)usart_id,
+                          (unsigned)stats.rx_bytes, (unsigned)stats.rx_frames, (unsigned)stats.overruns, (unsigned)stats.framing_errors,
+                          (unsigned)stats.noise_errors, (unsigned)stats.parity_errors, (unsigned)stats.rx_dropped);
+    return fsm_usart_send(&p_fsm->f, line, (uint32_t)length) ? CMD_REGISTRY_OK : CMD_REGISTRY_FAILED;
+}
+
+
+FSM_POOL_DEFINE(fsm_usart_pool, fsm_usart_t, FSM_USART_POOL_SIZE, NULL); /*!< Pool estático de USART */
 
 fsm_t *fsm_usart_new(uint32_t usart_id)
 {
-    fsm_t *p_fsm = malloc(sizeof(fsm_usart_t)); /* Do malloc to reserve memory of all other FSM elements, although it is interpreted as fsm_t (the first element of the structure) */
+    fsm_t *p_fsm = fsm_pool_acquire(&fsm_usart_pool); /* Reserve memory of all other FSM elements from the static pool, although it is interpreted as fsm_t (the first element of the structure) */
+    if (p_fsm != NULL)
+    {
+        fsm_usart_init(p_fsm, usart_id);
+    }
+    return p_fsm;
+}
+
+fsm_t *fsm_usart_new_static(fsm_usart_t *p_storage, uint32_t usart_id)
+{
+    fsm_t *p_fsm = (fsm_t *)p_storage;
     fsm_usart_init(p_fsm, usart_id);
     return p_fsm;
 }
@@ -52,16 +157,11 @@ fsm_t *fsm_usart_new(uint32_t usart_id)
 
 static bool check_data_rx	(	fsm_t * p_this	){
     fsm_usart_t * p_fsm = (fsm_usart_t *)(p_this);
-    return port_usart_rx_done(p_fsm->usart_id);
+    return !p_fsm->data_received && port_usart_rx_done(p_fsm->usart_id); /* La línea anterior se libera en fsm_usart_reset_input_data() */
 }
 static bool check_data_tx	(	fsm_t * 	p_this	){
     fsm_usart_t * p_fsm = (fsm_usart_t *)(p_this);
-    if(p_fsm->out_data[0] != EMPTY_BUFFER_CONSTANT){
-        return true;
-    }
-    else{
-        return false;
-    }
+    return !port_usart_tx_done(p_fsm->usart_id); /* Hay mensajes en la cola de transmisión */
 }
 
 static bool check_tx_end	(	fsm_t * p_this	){
@@ -71,34 +171,32 @@ static bool check_tx_end	(	fsm_t * p_this	){
 
 static void do_get_data_rx	(fsm_t * 	p_this)	{
     fsm_usart_t * p_fsm = (fsm_usart_t *)(p_this);
-    port_usart_get_from_input_buffer(p_fsm->usart_id,p_fsm->in_data);
-    port_usart_reset_input_buffer(p_fsm->usart_id);
-    p_fsm->data_received = true;
-}
-
-
-static void do_set_data_tx	(	fsm_t * 	p_this	){
-    fsm_usart_t * p_fsm = (fsm_usart_t *)(p_this);
-    port_usart_reset_output_buffer(p_fsm->usart_id);
-    port_usart_copy_to_output_buffer(p_fsm->usart_id,p_fsm->out_data,USART_OUTPUT_BUFFER_LENGTH);
-    while(!port_usart_get_txr_status(p_fsm -> usart_id)){
+    p_fsm->data_received = port_usart_get_line(p_fsm->usart_id, &p_fsm->p_in_line, &p_fsm->in_line_length);
+    while (p_fsm->binary && p_fsm->data_received)
+    {
+        if (usart_frame_decode((const uint8_t *)p_fsm->p_in_line, p_fsm->in_line_length, &p_fsm->in_frame))
+        {
+            break; /* La trama sigue en el anillo hasta fsm_usart_reset_input_data(), como las líneas */
+        }
+        p_fsm->frames_rejected++; /* Trama dañada: se descarta y se pasa a la siguiente */
+        port_usart_reset_input_buffer(p_fsm->usart_id);
+        p_fsm->data_received = port_usart_get_line(p_fsm->usart_id, &p_fsm->p_in_line, &p_fsm->in_line_length);
     }
-    port_usart_write_data	(p_fsm->usart_id);
-    port_usart_enable_tx_interrupt(p_fsm->usart_id);
 }
 
-static void do_tx_end	(fsm_t * p_this){
-    fsm_usart_t * p_fsm = (fsm_usart_t *)(p_this);
-    port_usart_reset_output_buffer(p_fsm->usart_id);
-    memset(p_fsm -> out_data,EMPTY_BUFFER_CONSTANT,USART_OUTPUT_BUFFER_LENGTH);
 
-}	
 static fsm_trans_t fsm_trans_usart[] = {
-{WAIT_DATA, check_data_tx, SEND_DATA, do_set_data_tx},
- {SEND_DATA,check_tx_end,WAIT_DATA,do_tx_end},
+{WAIT_DATA, check_data_tx, SEND_DATA, NULL}, /* port_usart_send() ya ha habilitado la interrupción TXE, que vacía la cola */
+ {SEND_DATA,check_tx_end,WAIT_DATA,NULL},
  {WAIT_DATA,check_data_rx,WAIT_DATA,do_get_data_rx},
  {-1, NULL, -1, NULL}};
 
+
+int fsm_usart_fire(fsm_t *p_this)
+{
+    return fsm_fire(p_this); /* Tabla de 3 filas: no compensa indexarla (ver fsm_index.h) */
+}
+
 bool fsm_usart_check_data_received	(fsm_t * 	p_this)	{
    fsm_usart_t * p_fsm = (fsm_usart_t *)(p_this);
    return p_fsm->data_received;
@@ -107,7 +205,12 @@ bool fsm_usart_check_data_received	(fsm_t * 	p_this)	{
 
 void fsm_usart_reset_input_data	(fsm_t * p_this	){
     fsm_usart_t * p_fsm = (fsm_usart_t *)(p_this);
-    memset(p_fsm -> in_data,EMPTY_BUFFER_CONSTANT,USART_INPUT_BUFFER_LENGTH);
+    if (p_fsm->data_received)
+    {
+        port_usart_reset_input_buffer(p_fsm->usart_id);
+    }
+    p_fsm->p_in_line = NULL;
+    p_fsm->in_line_length = 0;
     p_fsm->data_received = 0;
 }
 
@@ -137,8 +240,10 @@ void fsm_usart_init(fsm_t *p_this, uint32_t usart_id)
     fsm_init(p_this,fsm_trans_usart);
     p_fsm -> usart_id = usart_id;
     p_fsm -> data_received = false;
-    memset(p_fsm -> in_data,EMPTY_BUFFER_CONSTANT,USART_INPUT_BUFFER_LENGTH);
-    memset(p_fsm -> out_data,EMPTY_BUFFER_CONSTANT,USART_OUTPUT_BUFFER_LENGTH);
+    p_fsm -> p_in_line = NULL;
+    p_fsm -> in_line_length = 0;
+    p_fsm -> binary = false;
+    p_fsm -> frames_rejected = 0;
     port_usart_init(usart_id);
 }
 
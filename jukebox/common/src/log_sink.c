@@ -0,0 +1,176 @@
+/**
+ * @file log_sink.c
+ * @brief Salida de `printf()` con búfer y sin esperas.
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "log_sink.h"
+#include "spsc_ring.h"
+#include "port_system.h"
+#include "port_usart.h"
+
+/* Private variables ------------------------------------------------------------*/
+static uint8_t log_buffer[LOG_SINK_BUFFER_LENGTH]; /*!< Memoria del anillo */
+
+/*!< Anillo de trazas; se inicializa aquí para que `printf()` funcione antes que cualquier otra función */
+static spsc_ring_t log_ring = {.p_buffer = log_buffer, .size = LOG_SINK_BUFFER_LENGTH};
+
+static uint32_t log_output = LOG_SINK_OUTPUT_ITM;         /*!< Destino de las trazas */
+static uint32_t log_usart_id;                             /*!< USART de trazas */
+static uint32_t log_policy = LOG_SINK_POLICY_DROP_NEWEST; /*!< Política con el anillo lleno */
+static log_sink_stats_t log_stats;                        /*!< Estadísticas */
+
+/* Private functions */
+/**
+ * @brief Entrega a la salida el principio de un tramo contiguo de bytes pendientes.
+ *
+ * @param p_data Bytes.
+ * @param length Número de bytes.
+ * @return Bytes aceptados por la salida.
+ */
+static uint32_t _output_write(const uint8_t *p_data, uint32_t length)
+{
+    switch (log_output)
+    {
+    case LOG_SINK_OUTPUT_ITM:
+        return port_system_itm_write(p_data, length);
+    case LOG_SINK_OUTPUT_USART:
+    {
+        uint32_t free = port_usart_get_tx_free(log_usart_id);
+        if (length > free)
+        {
+            length = free;
+        }
+        if (length > USART_TX_MESSAGE_MAX_LENGTH)
+        {
+            length = USART_TX_MESSAGE_MAX_LENGTH;
+        }
+        if ((length == 0) || !port_usart_send(log_usart_id, (const char *)p_data, length))
+        {
+            return 0;
+        }
+        return length;
+    }
+    default:
+        return 0;
+    }
+}
+
+/* Public functions */
+void log_sink_set_output(uint32_t output, uint32_t usart_id)
+{
+    uint32_t state = port_system_enter_critical();
+    log_output = output;
+    log_usart_id = usart_id;
+    port_system_exit_critical(state);
+}
+
+void log_sink_set_policy(uint32_t policy)
+{
+    log_policy = policy;
+}
+
+uint32_t log_sink_write(const char *p_data, uint32_t length)
+{
+    const uint8_t *p_bytes = (const uint8_t *)p_data;
+    /* El programa principal es el único productor y la ISR del SysTick el único consumidor: mientras se copia, el sitio
+       libre sólo puede crecer, así que la copia no necesita enmascarar las interrupciones */
+    uint32_t free = LOG_SINK_BUFFER_LENGTH - spsc_ring_count(&log_ring);
+    if (length > free)
+    {
+        switch (log_policy)
+        {
+        case LOG_SINK_POLICY_TRUNCATE:
+            log_stats.dropped += length - free;
+            length = free;
+            break;
+        case LOG_SINK_POLICY_DROP_OLDEST:
+        {
+            if (length > LOG_SINK_BUFFER_LENGTH)
+            {
+                /* Sólo caben los últimos bytes de la escritura */
+                log_stats.dropped += length - LOG_SINK_BUFFER_LENGTH;
+                p_bytes += length - LOG_SINK_BUFFER_LENGTH;
+                length = LOG_SINK_BUFFER_LENGTH;
+            }
+            /* Descartar los más antiguos mueve `tail`, que también mueve la ISR: sólo eso se hace con las interrupciones enmascaradas */
+            uint32_t state = port_system_enter_critical();
+            uint32_t pending = spsc_ring_count(&log_ring);
+            uint32_t excess = (pending + length > LOG_SINK_BUFFER_LENGTH) ? (pending + length - LOG_SINK_BUFFER_LENGTH) : 0;
+            spsc_ring_consume(&log_ring, excess);
+            port_system_exit_critical(state);
+            log_stats.dropped += excess;
+            break;
+        }
+        default:
+            log_stats.dropped += length;
+            length = 0;
+            break;
+        }
+    }
+    spsc_ring_write(&log_ring, p_bytes, length);
+    log_stats.written += length;
+    uint32_t pending = spsc_ring_count(&log_ring);
+    if (pending > log_stats.high_water)
+    {
+        log_stats.high_water = pending;
+    }
+    return length;
+}
+
+uint32_t log_sink_drain(uint32_t budget)
+{
+    uint32_t drained = 0;
+    uint32_t state = port_system_enter_critical();
+    while (drained < budget)
+    {
+        uint32_t span = spsc_ring_contiguous(&log_ring);
+        if (span > budget - drained)
+        {
+            span = budget - drained;
+        }
+        if (span == 0)
+        {
+            break;
+        }
+        uint32_t sent = _output_write(spsc_ring_peek(&log_ring, span), span);
+        spsc_ring_consume(&log_ring, sent);
+        drained += sent;
+        if (sent < span)
+        {
+            break; /* La salida está llena: se sigue en el siguiente milisegundo */
+        }
+    }
+    log_stats.drained += drained;
+    port_system_exit_critical(state);
+    return drained;
+}
+
+void log_sink_tick(void)
+{
+    log_sink_drain(LOG_SINK_DRAIN_BUDGET);
+}
+
+uint32_t log_sink_get_pending(void)
+{
+    return spsc_ring_count(&log_ring);
+}
+
+void log_sink_get_stats(log_sink_stats_t *p_stats)
+{
+    uint32_t state = port_system_enter_critical();
+    *p_stats = log_stats;
+    port_system_exit_critical(state);
+}
+
+void log_sink_reset(void)
+{
+    uint32_t state = port_system_enter_critical();
+    spsc_ring_consume(&log_ring, spsc_ring_count(&log_ring));
+    memset(&log_stats, 0, sizeof(log_stats));
+    port_system_exit_critical(state);
+}
@@ -0,0 +1,72 @@
+/**
+ * @file melodies.c
+ * @brief Decoder of the packed notes of the melodies. The melodies are generated from `melodies/` in
+ * `melody_library.c`.
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "melodies.h"
+
+/* Public functions ----------------------------------------------------------*/
+void melody_cursor_init(melody_cursor_t *p_cursor, const melody_t *p_melody)
+{
+    p_cursor->p_melody = p_melody;
+    p_cursor->index = 0;
+}
+
+bool melody_cursor_next(melody_cursor_t *p_cursor, melody_note_t *p_note)
+{
+    const melody_t *p_melody = p_cursor->p_melody;
+    if (p_cursor->index >= p_melody->melody_length)
+    {
+        return false;
+    }
+    uint16_t packed = p_melody->p_notes[p_cursor->index++];
+    p_note->note = MELODY_NOTE(packed);
+    p_note->duration_ms = MELODY_CODE(packed) * p_melody->tempo_base_ms;
+    return true;
+}
+
+uint32_t melody_get_duration_ms(const melody_t *p_melody)
+{
+    uint32_t units = 0;
+    for (uint32_t i = 0; i < p_melody->melody_length; i++)
+    {
+        units += MELODY_CODE(p_melody->p_notes[i]);
+    }
+    return units * p_melody->tempo_base_ms;
+}
+
+uint32_t melody_tempo_base(const uint16_t *p_durations, uint32_t length)
+{
+    uint32_t base = 0;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        uint32_t a = base;
+        uint32_t b = p_durations[i];
+        while (b != 0)
+        {
+            uint32_t r = a % b;
+            a = b;
+            b = r;
+        }
+        base = a;
+    }
+    return base;
+}
+
+bool melody_pack(uint16_t *p_packed, const uint8_t *p_notes, const uint16_t *p_durations, uint32_t length, uint32_t tempo_base_ms)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        uint32_t code = (p_durations[i] + tempo_base_ms / 2U) / tempo_base_ms;
+        if ((p_notes[i] >= NOTE_TABLE_LENGTH) || (code > MELODY_DURATION_MAX))
+        {
+            return false;
+        }
+        p_packed[i] = MELODY_PACK(p_notes[i], code);
+    }
+    return true;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file melody_index.c
+ * @brief Índice de metadatos de la biblioteca de melodías.
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <string.h>
+#include "melody_index.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define FNV_OFFSET_BASIS 2166136261U /*!< Valor inicial del hash FNV-1a de 32 bits (el mismo que usa melody_gen) */
+#define FNV_PRIME 16777619U          /*!< Multiplicador del hash FNV-1a de 32 bits */
+
+/* Private functions */
+/**
+ * @brief Obtiene la permutación de un orden.
+ *
+ * @param order Orden (`enum MELODY_ORDER`).
+ * @return Permutación, o `NULL` para el orden de la biblioteca o uno que no existe.
+ */
+static const uint16_t *_permutation(uint32_t order)
+{
+    switch (order)
+    {
+    case MELODY_ORDER_NAME:
+        return melody_by_name;
+    case MELODY_ORDER_DURATION:
+        return melody_by_duration;
+    default:
+        return NULL;
+    }
+}
+
+/* Public functions */
+uint32_t melody_index_count(void)
+{
+    return melody_library_length;
+}
+
+const melody_info_t *melody_index_get(uint32_t melody)
+{
+    if (melody >= melody_library_length)
+    {
+        return NULL;
+    }
+    return &melody_index[melody];
+}
+
+uint32_t melody_index_at(uint32_t order, uint32_t rank)
+{
+    if (rank >= melody_library_length)
+    {
+        return MELODY_INDEX_NOT_FOUND;
+    }
+    const uint16_t *p_permutation = _permutation(order);
+    return (p_permutation != NULL) ? p_permutation[rank] : rank;
+}
+
+uint32_t melody_index_rank(uint32_t order, uint32_t melody)
+{
+    if (melody >= melody_library_length)
+    {
+        return MELODY_INDEX_NOT_FOUND;
+    }
+    switch (order)
+    {
+    case MELODY_ORDER_NAME:
+        return melody_name_rank[melody];
+    case MELODY_ORDER_DURATION:
+        return melody_duration_rank[melody];
+    default:
+        return melody;
+    }
+}
+
+uint32_t melody_index_next(uint32_t order, uint32_t melody)
+{
+    uint32_t rank = melody_index_rank(order, melody);
+    if (rank == MELODY_INDEX_NOT_FOUND)
+    {
+        return MELODY_INDEX_NOT_FOUND;
+    }
+    return melody_index_at(order, (rank + 1U < melody_library_length) ? rank + 1U : 0);
+}
+
+uint32_t melody_index_previous(uint32_t order, uint32_t melody)
+{
+    uint32_t rank = melody_index_rank(order, melody);
+    if (rank == MELODY_INDEX_NOT_FOUND)
+    {
+        return MELODY_INDEX_NOT_FOUND;
+    }
+    return melody_index_at(order, (rank > 0) ? rank - 1U : melody_library_length - 1U);
+}
+
+uint32_t melody_index_longest(void)
+{
+    return melody_by_duration[melody_library_length - 1U];
+}
+
+uint32_t melody_index_shortest(void)
+{
+    return melody_by_duration[0];
+}
+
+uint32_t melody_index_find(const char *p_name, uint32_t length)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ (uint8_t)p_name[i]) * FNV_PRIME;
+    }
+    /* La tabla está como mucho medio llena: el sondeo lineal acaba pronto en una casilla vacía */
+    for (uint32_t slot = (hash ^ (hash >> 16)) & melody_name_mask;; slot = (slot + 1U) & melody_name_mask)
+    {
+        uint32_t melody = melody_name_slots[slot];
+        if (melody == MELODY_INDEX_NOT_FOUND)
+        {
+            return MELODY_INDEX_NOT_FOUND;
+        }
+        const melody_info_t *p_info = &melody_index[melody];
+        if ((p_info->name_hash == hash) && (strnlen(p_info->p_name, length + 1U) == length) && (memcmp(p_info->p_name, p_name, length) == 0))
+        {
+            return melody;
+        }
+    }
+}
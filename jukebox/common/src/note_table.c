@@ -0,0 +1,91 @@
+/**
+ * @file note_table.c
+ * @brief Tabla constante de registros del temporizador para cada nota.
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "note_table.h"
+
+/* Defines -------------------------------------------------------------------*/
+/* Frecuencias de la octava 0 en µHz (LA0 = 27,5 Hz, un cuarto de LA2 = 110 Hz) */
+#define F0_DO 16351598ULL   /*!< DO0 */
+#define F0_DOs 17323914ULL  /*!< DO#0 */
+#define F0_RE 18354048ULL   /*!< RE0 */
+#define F0_REs 19445436ULL  /*!< RE#0 */
+#define F0_MI 20601722ULL   /*!< MI0 */
+#define F0_FA 21826764ULL   /*!< FA0 */
+#define F0_FAs 23124651ULL  /*!< FA#0 */
+#define F0_SOL 24499715ULL  /*!< SOL0 */
+#define F0_SOLs 25956544ULL /*!< SOL#0 */
+#define F0_LA 27500000ULL   /*!< LA0 */
+#define F0_LAs 29135235ULL  /*!< LA#0 */
+#define F0_SI 30867706ULL   /*!< SI0 */
+
+#define TIMER_CLOCK_UHZ ((uint64_t)NOTE_TABLE_TIMER_CLOCK_HZ * 1000000ULL) /*!< Reloj del temporizador en µHz */
+
+/*!< Ticks del reloj del temporizador en un periodo de una frecuencia en µHz, redondeados */
+#define PERIOD_TICKS(f_uhz) ((2ULL * TIMER_CLOCK_UHZ + (f_uhz)) / (2ULL * (f_uhz)))
+
+/*!< Divisor (PSC + 1) más pequeño que deja el ARR en 16 bits */
+#define DIVIDER(ticks) (((ticks) + 0xFFFFULL) / 0x10000ULL)
+
+/*!< Entrada de la tabla para una frecuencia en µHz */
+#define NOTE_ENTRY(f_uhz)                                                                            \
+    {                                                                                                \
+        .psc = (uint16_t)(DIVIDER(PERIOD_TICKS(f_uhz)) - 1U),                                        \
+        .arr = (uint16_t)((PERIOD_TICKS(f_uhz) + DIVIDER(PERIOD_TICKS(f_uhz)) / 2U) /                \
+                              DIVIDER(PERIOD_TICKS(f_uhz)) -                                         \
+                          1U)                                                                        \
+    }
+
+/*!< Las 12 entradas de una octava */
+#define OCTAVE_ENTRIES(o)                                                                            \
+    NOTE_ENTRY(F0_DO << (o)), NOTE_ENTRY(F0_DOs << (o)), NOTE_ENTRY(F0_RE << (o)),                   \
+        NOTE_ENTRY(F0_REs << (o)), NOTE_ENTRY(F0_MI << (o)), NOTE_ENTRY(F0_FA << (o)),               \
+        NOTE_ENTRY(F0_FAs << (o)), NOTE_ENTRY(F0_SOL << (o)), NOTE_ENTRY(F0_SOLs << (o)),            \
+        NOTE_ENTRY(F0_LA << (o)), NOTE_ENTRY(F0_LAs << (o)), NOTE_ENTRY(F0_SI << (o))
+
+/* Comprobaciones en tiempo de compilación */
+_Static_assert(DIVIDER(PERIOD_TICKS(F0_DO)) <= 0x10000ULL, "El reloj del temporizador es demasiado rápido para DO0");
+_Static_assert(PERIOD_TICKS(F0_SI << 8) >= 100ULL, "El reloj del temporizador es demasiado lento para SI8");
+
+/* Global variables */
+const note_timer_t note_table[NOTE_TABLE_LENGTH] = {
+    {.psc = 0, .arr = 0}, /* NOTE_SILENCE */
+    OCTAVE_ENTRIES(0),
+    OCTAVE_ENTRIES(1),
+    OCTAVE_ENTRIES(2),
+    OCTAVE_ENTRIES(3),
+    OCTAVE_ENTRIES(4),
+    OCTAVE_ENTRIES(5),
+    OCTAVE_ENTRIES(6),
+    OCTAVE_ENTRIES(7),
+    OCTAVE_ENTRIES(8)};
+
+/*!< Frecuencias de la octava 0 en µHz; las de otra octava se obtienen desplazando */
+static const uint32_t octave0_uhz[NOTE_TABLE_SEMITONES] = {F0_DO, F0_DOs, F0_RE, F0_REs, F0_MI, F0_FA,
+                                                           F0_FAs, F0_SOL, F0_SOLs, F0_LA, F0_LAs, F0_SI};
+
+/* Public functions */
+const note_timer_t *note_table_get(uint32_t note)
+{
+    if (note >= NOTE_TABLE_LENGTH)
+    {
+        return NULL;
+    }
+    return &note_table[note];
+}
+
+uint32_t note_table_get_frequency_mhz(uint32_t note)
+{
+    if ((note == NOTE_SILENCE) || (note >= NOTE_TABLE_LENGTH))
+    {
+        return 0;
+    }
+    uint64_t uhz = (uint64_t)octave0_uhz[NOTE_SEMITONE(note)] << NOTE_OCTAVE(note);
+    return (uint32_t)((uhz + 500U) / 1000U);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file spsc_ring.c
+ * @brief Búfer circular de bytes sin cerrojos para un productor y un consumidor.
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "spsc_ring.h"
+
+/* Public functions */
+void spsc_ring_init(spsc_ring_t *p_ring, uint8_t *p_buffer, uint32_t size, uint32_t slack)
+{
+    p_ring->p_buffer = p_buffer;
+    p_ring->size = size;
+    p_ring->slack = slack;
+    p_ring->head = 0;
+    p_ring->tail = 0;
+    p_ring->scanned = 0;
+    p_ring->dropped = 0;
+}
+
+bool spsc_ring_push(spsc_ring_t *p_ring, uint8_t byte)
+{
+    uint32_t head = p_ring->head;
+    if ((head - __atomic_load_n(&p_ring->tail, __ATOMIC_ACQUIRE)) >= p_ring->size)
+    {
+        p_ring->dropped++;
+        return false;
+    }
+    p_ring->p_buffer[head & (p_ring->size - 1U)] = byte;
+    __atomic_store_n(&p_ring->head, head + 1U, __ATOMIC_RELEASE); /* El byte es visible antes que el nuevo índice */
+    return true;
+}
+
+bool spsc_ring_write(spsc_ring_t *p_ring, const uint8_t *p_data, uint32_t length)
+{
+    uint32_t head = p_ring->head;
+    if ((p_ring->size - (head - __atomic_load_n(&p_ring->tail, __ATOMIC_ACQUIRE))) < length)
+    {
+        p_ring->dropped += length;
+        return false;
+    }
+    uint32_t offset = head & (p_ring->size - 1U);
+    uint32_t first = p_ring->size - offset;
+    if (first > length)
+    {
+        first = length;
+    }
+    memcpy(&p_ring->p_buffer[offset], p_data, first);
+    memcpy(p_ring->p_buffer, &p_data[first], length - first);
+    __atomic_store_n(&p_ring->head, head + length, __ATOMIC_RELEASE); /* Todo el bloque es visible a la vez */
+    return true;
+}
+
+uint32_t spsc_ring_count(const spsc_ring_t *p_ring)
+{
+    return __atomic_load_n(&p_ring->head, __ATOMIC_ACQUIRE) - p_ring->tail;
+}
+
+uint32_t spsc_ring_contiguous(const spsc_ring_t *p_ring)
+{
+    uint32_t count = spsc_ring_count(p_ring);
+    uint32_t first = p_ring->size - (p_ring->tail & (p_ring->size - 1U));
+    return (count < first) ? count : first;
+}
+
+bool spsc_ring_find(spsc_ring_t *p_ring, uint8_t delimiter, uint32_t *p_length)
+{
+    uint32_t count = spsc_ring_count(p_ring);
+    uint32_t mask = p_ring->size - 1U;
+    while (p_ring->scanned < count)
+    {
+        /* Recorre el tramo contiguo más largo posible: hasta el final de los datos o del anillo */
+        uint32_t offset = (p_ring->tail + p_ring->scanned) & mask;
+        uint32_t span = count - p_ring->scanned;
+        if (span > p_ring->size - offset)
+        {
+            span = p_ring->size - offset;
+        }
+        const uint8_t *p_start = &p_ring->p_buffer[offset];
+        const uint8_t *p_found = memchr(p_start, delimiter, span);
+        if (p_found != NULL)
+        {
+            p_ring->scanned += (uint32_t)(p_found - p_start);
+            *p_length = p_ring->scanned;
+            return true;
+        }
+        p_ring->scanned += span;
+    }
+    return false;
+}
+
+const uint8_t *spsc_ring_peek(spsc_ring_t *p_ring, uint32_t length)
+{
+    uint32_t offset = p_ring->tail & (p_ring->size - 1U);
+    uint32_t first = p_ring->size - offset;
+    if (length > first)
+    {
+        uint32_t wrapped = length - first;
+        if (wrapped > p_ring->slack)
+        {
+            return NULL;
+        }
+        memcpy(&p_ring->p_buffer[p_ring->size], p_ring->p_buffer, wrapped); /* Sólo se copia la parte que da la vuelta */
+    }
+    return &p_ring->p_buffer[offset];
+}
+
+void spsc_ring_consume(spsc_ring_t *p_ring, uint32_t length)
+{
+    p_ring->scanned = (p_ring->scanned > length) ? (p_ring->scanned - length) : 0;
+    __atomic_store_n(&p_ring->tail, p_ring->tail + length, __ATOMIC_RELEASE); /* Los bytes se han leído antes de liberarlos */
+}
@@ -0,0 +1,120 @@
+/**
+ * @file sw_timer.c
+ * @brief Servicio de temporizadores software sobre una rueda (hashed timing wheel).
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "sw_timer.h"
+#include "port_system.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define WHEEL_MASK (SW_TIMER_WHEEL_SLOTS - 1U) /*!< Máscara para obtener la ranura de un tick */
+
+/* Global variables */
+static sw_timer_t *wheel[SW_TIMER_WHEEL_SLOTS]; /*!< Listas de temporizadores de cada ranura */
+
+/* Private functions */
+/**
+ * @brief Inserta un temporizador al principio de la lista de su ranura.
+ * @warning Se debe llamar con las interrupciones deshabilitadas o desde la ISR del SysTick.
+ */
+static void _link(sw_timer_t *p_timer)
+{
+    sw_timer_t **p_slot = &wheel[p_timer->expiry & WHEEL_MASK];
+    p_timer->p_prev = NULL;
+    p_timer->p_next = *p_slot;
+    if (*p_slot != NULL)
+    {
+        (*p_slot)->p_prev = p_timer;
+    }
+    *p_slot = p_timer;
+    p_timer->running = true;
+}
+
+/**
+ * @brief Saca un temporizador de la lista de su ranura.
+ * @warning Se debe llamar con las interrupciones deshabilitadas o desde la ISR del SysTick.
+ */
+static void _unlink(sw_timer_t *p_timer)
+{
+    if (p_timer->p_prev != NULL)
+    {
+        p_timer->p_prev->p_next = p_timer->p_next;
+    }
+    else
+    {
+        wheel[p_timer->expiry & WHEEL_MASK] = p_timer->p_next;
+    }
+    if (p_timer->p_next != NULL)
+    {
+        p_timer->p_next->p_prev = p_timer->p_prev;
+    }
+    p_timer->p_next = NULL;
+    p_timer->p_prev = NULL;
+    p_timer->running = false;
+}
+
+/* Public functions */
+void sw_timer_init(sw_timer_t *p_timer, uint32_t event)
+{
+    p_timer->p_next = NULL;
+    p_timer->p_prev = NULL;
+    p_timer->expiry = 0;
+    p_timer->event = event;
+    p_timer->running = false;
+    p_timer->expired = false;
+}
+
+void sw_timer_start(sw_timer_t *p_timer, uint32_t delay_ms)
+{
+    uint32_t state = port_system_enter_critical();
+    if (p_timer->running)
+    {
+        _unlink(p_timer);
+    }
+    p_timer->expired = false;
+    p_timer->expiry = port_system_get_millis() + delay_ms + 1U;
+    _link(p_timer);
+    port_system_exit_critical(state);
+}
+
+void sw_timer_stop(sw_timer_t *p_timer)
+{
+    uint32_t state = port_system_enter_critical();
+    if (p_timer->running)
+    {
+        _unlink(p_timer);
+    }
+    p_timer->expired = false;
+    port_system_exit_critical(state);
+}
+
+bool sw_timer_has_expired(const sw_timer_t *p_timer)
+{
+    return p_timer->expired;
+}
+
+bool sw_timer_is_running(const sw_timer_t *p_timer)
+{
+    return p_timer->running;
+}
+
+void sw_timer_tick(uint32_t now)
+{
+    sw_timer_t *p_timer = wheel[now & WHEEL_MASK];
+    while (p_timer != NULL)
+    {
+        sw_timer_t *p_next = p_timer->p_next;
+        if (p_timer->expiry == now) /* Los de vueltas posteriores de la rueda se quedan en la ranura */
+        {
+            _unlink(p_timer);
+            p_timer->expired = true;
+            port_system_post_event(p_timer->event);
+        }
+        p_timer = p_next;
+    }
+}
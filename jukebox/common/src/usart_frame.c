@@ -0,0 +1,134 @@
+/**
+ * @file usart_frame.c
+ * @brief Tramas binarias del USART: COBS con CRC16.
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "usart_frame.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define CRC16_INIT 0xFFFFU /*!< Valor inicial del CRC16-CCITT */
+#define COBS_BLOCK_MAX 0xFFU /*!< Código del bloque COBS más largo: 254 bytes sin `0x00` detrás */
+
+/* Private variables ------------------------------------------------------------*/
+/**
+ * @brief CRC del polinomio 0x1021 para cada valor de 4 bits: la tabla de 16 entradas procesa un byte en dos pasos
+ * sin los 512 bytes de la tabla por bytes.
+ */
+static const uint16_t crc16_nibble_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+
+/* Private functions */
+/**
+ * @brief Actualiza el CRC16 con un byte.
+ *
+ * @param crc CRC de los bytes anteriores.
+ * @param byte Byte.
+ * @return CRC actualizado.
+ */
+static inline uint16_t _crc16_byte(uint16_t crc, uint8_t byte)
+{
+    crc = (uint16_t)((crc << 4) ^ crc16_nibble_table[(crc >> 12) ^ (byte >> 4)]);
+    return (uint16_t)((crc << 4) ^ crc16_nibble_table[(crc >> 12) ^ (byte & 0x0FU)]);
+}
+
+/* Public functions */
+uint16_t usart_frame_crc16(uint16_t crc, const uint8_t *p_data, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        crc = _crc16_byte(crc, p_data[i]);
+    }
+    return crc;
+}
+
+uint32_t usart_frame_encode(const usart_frame_t *p_frame, uint8_t *p_buffer)
+{
+    if (p_frame->length > USART_FRAME_PAYLOAD_MAX_LENGTH)
+    {
+        return 0;
+    }
+    uint8_t raw[USART_FRAME_RAW_MAX_LENGTH];
+    uint32_t raw_length = USART_FRAME_HEADER_LENGTH + p_frame->length;
+    raw[0] = p_frame->type;
+    raw[1] = p_frame->seq;
+    raw[2] = p_frame->code;
+    raw[3] = p_frame->length;
+    memcpy(&raw[USART_FRAME_HEADER_LENGTH], p_frame->payload, p_frame->length);
+    uint16_t crc = usart_frame_crc16(CRC16_INIT, raw, raw_length);
+    raw[raw_length++] = (uint8_t)(crc >> 8);
+    raw[raw_length++] = (uint8_t)crc;
+
+    // COBS: cada bloque empieza con la distancia hasta el siguiente 0x00 de la trama, que no se copia
+    uint32_t code_index = 0;
+    uint32_t out = 1;
+    uint8_t code = 1;
+    for (uint32_t i = 0; i < raw_length; i++)
+    {
+        if (raw[i] != USART_FRAME_DELIMITER)
+        {
+            p_buffer[out++] = raw[i];
+            code++;
+        }
+        if ((raw[i] == USART_FRAME_DELIMITER) || (code == COBS_BLOCK_MAX))
+        {
+            p_buffer[code_index] = code;
+            code_index = out++;
+            code = 1;
+        }
+    }
+    p_buffer[code_index] = code;
+    p_buffer[out++] = USART_FRAME_DELIMITER;
+    return out;
+}
+
+bool usart_frame_decode(const uint8_t *p_data, uint32_t length, usart_frame_t *p_frame)
+{
+    uint8_t raw[USART_FRAME_RAW_MAX_LENGTH];
+    uint32_t raw_length = 0;
+    uint16_t crc = CRC16_INIT;
+    uint32_t i = 0;
+    while (i < length)
+    {
+        uint32_t code = p_data[i++];
+        if ((code == USART_FRAME_DELIMITER) || ((i + code - 1) > length) || ((raw_length + code) > USART_FRAME_RAW_MAX_LENGTH + 1))
+        {
+            return false; /* Código imposible o bloque que se sale de la trama */
+        }
+        for (uint32_t end = i + code - 1; i < end; i++)
+        {
+            if (p_data[i] == USART_FRAME_DELIMITER)
+            {
+                return false;
+            }
+            raw[raw_length++] = p_data[i];
+            crc = _crc16_byte(crc, p_data[i]);
+        }
+        if ((code < COBS_BLOCK_MAX) && (i < length)) /* El 0x00 implícito del final del bloque, salvo en el último */
+        {
+            if (raw_length == USART_FRAME_RAW_MAX_LENGTH)
+            {
+                return false;
+            }
+            raw[raw_length++] = USART_FRAME_DELIMITER;
+            crc = _crc16_byte(crc, USART_FRAME_DELIMITER);
+        }
+    }
+    // Con el CRC detrás de los datos, el CRC de todo es 0
+    if ((raw_length < USART_FRAME_HEADER_LENGTH + USART_FRAME_CRC_LENGTH) || (crc != 0) ||
+        (raw[3] != raw_length - USART_FRAME_HEADER_LENGTH - USART_FRAME_CRC_LENGTH))
+    {
+        return false;
+    }
+    p_frame->type = raw[0];
+    p_frame->seq = raw[1];
+    p_frame->code = raw[2];
+    p_frame->length = raw[3];
+    memcpy(p_frame->payload, &raw[USART_FRAME_HEADER_LENGTH], p_frame->length);
+    return true;
+}
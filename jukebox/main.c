@@ -13,6 +13,9 @@
 /* HW libraries */
 #include "port_system.h"
 
+/* Other libraries */
+#include "fsm_sched.h"
+
 
 /* Defines ------------------------------------------------------------------*/
 
@@ -26,11 +29,15 @@ int main(void)
     /* Init board */
     port_system_init();
 
+    /* Init the FSM scheduler: the FSMs are added to it once created */
+    fsm_sched_init();
+
 
     /* Infinite loop */
     while (1)
     {
-
+        /* Sleep until an ISR posts an event and fire only the FSMs that have work */
+        fsm_sched_run();
 
     } // End of while(1)
 
@@ -0,0 +1,541 @@
+/**
+ * @file native_hw.h
+ * @brief Simulated register blocks of the STM32F446RE for the native (host) platform.
+ *
+ * This header replaces `stm32f4xx.h` on the native platform. It exposes the subset of the CMSIS names used by the
+ * project (peripheral structs, instances, bit masks, NVIC and SysTick functions) backed by plain memory, so that
+ * the drivers of `port/stm32f4` compile unchanged on the host (see the native `stm32f4xx.h`). The behaviour of the
+ * peripherals (edges, reception, transmission, DMA, SysTick) is modelled in `native_sim.c` and driven by a virtual
+ * clock (see `native_sim.h`).
+ *
+ * @note Registers with side effects on read or write (`USARTx->DR`, `EXTI->PR`, `GPIOx->BSRR`, `DMAx->LIFCR`, `TIMx->EGR`) must be accessed
+ * through the helpers declared at the end of this file so that the model can react to them. The drivers reach them
+ * through the access layer of `port_hw.h`; the native `port_system.c` calls them directly.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+#ifndef NATIVE_HW_H_
+#define NATIVE_HW_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define __IO volatile        /*!< Read/write register qualifier (as in CMSIS) */
+#define __NVIC_PRIO_BITS 4U  /*!< Number of priority bits implemented in the NVIC of the STM32F4 */
+
+#define NATIVE_CORE_CLOCK_HZ 16000000U /*!< Frequency of the simulated core (HSI, no PLL) */
+#define NATIVE_GPIO_PORTS 8U           /*!< Number of simulated GPIO ports (GPIOA to GPIOH) */
+#define NATIVE_USART_INSTANCES 4U      /*!< Number of simulated USARTs (USART1, USART2, USART3 and USART6) */
+#define NATIVE_DMA_STREAMS 8U          /*!< Number of streams of the simulated DMA1 controller */
+#define NATIVE_TIM_INSTANCES 2U        /*!< Number of simulated general-purpose timers (TIM2 and TIM3) */
+#define NATIVE_IRQ_COUNT 97            /*!< Number of device interrupts of the STM32F446RE */
+#define NATIVE_VECTOR_COUNT (16 + NATIVE_IRQ_COUNT) /*!< Number of entries of the vector table (system + device) */
+
+/**
+ * @brief Interrupt numbers of the STM32F446RE used by the project (same values as in `stm32f446xx.h`).
+ */
+typedef enum
+{
+    SysTick_IRQn = -1,      /*!< Cortex-M4 System Tick interrupt */
+    EXTI0_IRQn = 6,         /*!< EXTI Line0 interrupt */
+    EXTI1_IRQn = 7,         /*!< EXTI Line1 interrupt */
+    EXTI2_IRQn = 8,         /*!< EXTI Line2 interrupt */
+    EXTI3_IRQn = 9,         /*!< EXTI Line3 interrupt */
+    EXTI4_IRQn = 10,        /*!< EXTI Line4 interrupt */
+    DMA1_Stream1_IRQn = 12, /*!< DMA1 Stream 1 global interrupt */
+    DMA1_Stream3_IRQn = 14, /*!< DMA1 Stream 3 global interrupt */
+    DMA1_Stream5_IRQn = 16, /*!< DMA1 Stream 5 global interrupt */
+    DMA1_Stream6_IRQn = 17, /*!< DMA1 Stream 6 global interrupt */
+    EXTI9_5_IRQn = 23,      /*!< External Line[9:5] interrupts */
+    TIM2_IRQn = 28,         /*!< TIM2 global interrupt */
+    TIM3_IRQn = 29,         /*!< TIM3 global interrupt */
+    TIM4_IRQn = 30,         /*!< TIM4 global interrupt */
+    USART1_IRQn = 37,       /*!< USART1 global interrupt */
+    USART2_IRQn = 38,       /*!< USART2 global interrupt */
+    USART3_IRQn = 39,       /*!< USART3 global interrupt */
+    EXTI15_10_IRQn = 40,    /*!< External Line[15:10] interrupts */
+    TIM5_IRQn = 50,         /*!< TIM5 global interrupt */
+    USART6_IRQn = 71        /*!< USART6 global interrupt */
+} IRQn_Type;
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief General Purpose I/O
+ */
+typedef struct
+{
+    __IO uint32_t MODER;   /*!< GPIO port mode register */
+    __IO uint32_t OTYPER;  /*!< GPIO port output type register */
+    __IO uint32_t OSPEEDR; /*!< GPIO port output speed register */
+    __IO uint32_t PUPDR;   /*!< GPIO port pull-up/pull-down register */
+    __IO uint32_t IDR;     /*!< GPIO port input data register */
+    __IO uint32_t ODR;     /*!< GPIO port output data register */
+    __IO uint32_t BSRR;    /*!< GPIO port bit set/reset register */
+    __IO uint32_t LCKR;    /*!< GPIO port configuration lock register */
+    __IO uint32_t AFR[2];  /*!< GPIO alternate function registers */
+} GPIO_TypeDef;
+
+/**
+ * @brief External Interrupt/Event Controller
+ */
+typedef struct
+{
+    __IO uint32_t IMR;   /*!< EXTI Interrupt mask register */
+    __IO uint32_t EMR;   /*!< EXTI Event mask register */
+    __IO uint32_t RTSR;  /*!< EXTI Rising trigger selection register */
+    __IO uint32_t FTSR;  /*!< EXTI Falling trigger selection register */
+    __IO uint32_t SWIER; /*!< EXTI Software interrupt event register */
+    __IO uint32_t PR;    /*!< EXTI Pending register */
+} EXTI_TypeDef;
+
+/**
+ * @brief System configuration controller
+ */
+typedef struct
+{
+    __IO uint32_t MEMRMP;    /*!< SYSCFG memory remap register */
+    __IO uint32_t PMC;       /*!< SYSCFG peripheral mode configuration register */
+    __IO uint32_t EXTICR[4]; /*!< SYSCFG external interrupt configuration registers */
+    __IO uint32_t CMPCR;     /*!< SYSCFG Compensation cell control register */
+} SYSCFG_TypeDef;
+
+/**
+ * @brief Universal Synchronous Asynchronous Receiver Transmitter
+ */
+typedef struct
+{
+    __IO uint32_t SR;   /*!< USART Status register */
+    __IO uint32_t DR;   /*!< USART Data register (last received byte, see native_hw_usart_read_dr()) */
+    __IO uint32_t BRR;  /*!< USART Baud rate register */
+    __IO uint32_t CR1;  /*!< USART Control register 1 */
+    __IO uint32_t CR2;  /*!< USART Control register 2 */
+    __IO uint32_t CR3;  /*!< USART Control register 3 */
+    __IO uint32_t GTPR; /*!< USART Guard time and prescaler register */
+} USART_TypeDef;
+
+/**
+ * @brief DMA stream
+ *
+ * @note `PAR` and `M0AR`/`M1AR` are as wide as a host pointer, so the port code stores `(uintptr_t)` addresses in them.
+ */
+typedef struct
+{
+    __IO uint32_t CR;    /*!< DMA stream x configuration register */
+    __IO uint32_t NDTR;  /*!< DMA stream x number of data register */
+    __IO uintptr_t PAR;  /*!< DMA stream x peripheral address register */
+    __IO uintptr_t M0AR; /*!< DMA stream x memory 0 address register */
+    __IO uintptr_t M1AR; /*!< DMA stream x memory 1 address register */
+    __IO uint32_t FCR;   /*!< DMA stream x FIFO control register */
+} DMA_Stream_TypeDef;
+
+/**
+ * @brief DMA controller
+ */
+typedef struct
+{
+    __IO uint32_t LISR;  /*!< DMA low interrupt status register (streams 0 to 3) */
+    __IO uint32_t HISR;  /*!< DMA high interrupt status register (streams 4 to 7) */
+    __IO uint32_t LIFCR; /*!< DMA low interrupt flag clear register (see native_hw_dma_write_lifcr()) */
+    __IO uint32_t HIFCR; /*!< DMA high interrupt flag clear register (see native_hw_dma_write_hifcr()) */
+} DMA_TypeDef;
+
+/**
+ * @brief General-purpose timer (only the registers used by the project)
+ */
+typedef struct
+{
+    __IO uint32_t CR1;   /*!< TIM control register 1 */
+    __IO uint32_t DIER;  /*!< TIM DMA/interrupt enable register */
+    __IO uint32_t SR;    /*!< TIM status register */
+    __IO uint32_t EGR;   /*!< TIM event generation register (see native_hw_tim_write_egr()) */
+    __IO uint32_t CCMR1; /*!< TIM capture/compare mode register 1 */
+    __IO uint32_t CCER;  /*!< TIM capture/compare enable register */
+    __IO uint32_t CNT;   /*!< TIM counter register (only updated when the counter stops) */
+    __IO uint32_t PSC;   /*!< TIM prescaler */
+    __IO uint32_t ARR;   /*!< TIM auto-reload register (32 bits in TIM2) */
+    __IO uint32_t CCR1;  /*!< TIM capture/compare register 1 */
+} TIM_TypeDef;
+
+/**
+ * @brief Reset and Clock Control (only the registers used by the project)
+ */
+typedef struct
+{
+    __IO uint32_t CR;      /*!< RCC clock control register */
+    __IO uint32_t CFGR;    /*!< RCC clock configuration register */
+    __IO uint32_t AHB1ENR; /*!< RCC AHB1 peripheral clock register */
+    __IO uint32_t APB1ENR; /*!< RCC APB1 peripheral clock enable register */
+    __IO uint32_t APB2ENR; /*!< RCC APB2 peripheral clock enable register */
+} RCC_TypeDef;
+
+/**
+ * @brief FLASH interface (only the access control register)
+ */
+typedef struct
+{
+    __IO uint32_t ACR; /*!< FLASH access control register */
+} FLASH_TypeDef;
+
+/**
+ * @brief Power Control
+ */
+typedef struct
+{
+    __IO uint32_t CR;  /*!< PWR power control register */
+    __IO uint32_t CSR; /*!< PWR power control/status register */
+} PWR_TypeDef;
+
+/**
+ * @brief System Tick timer
+ */
+typedef struct
+{
+    __IO uint32_t CTRL;  /*!< SysTick Control and Status Register */
+    __IO uint32_t LOAD;  /*!< SysTick Reload Value Register */
+    __IO uint32_t VAL;   /*!< SysTick Current Value Register */
+    __IO uint32_t CALIB; /*!< SysTick Calibration Register */
+} SysTick_Type;
+
+/* Register blocks (defined in native_hw.c) ----------------------------------*/
+extern GPIO_TypeDef native_gpio[NATIVE_GPIO_PORTS];      /*!< Simulated GPIO ports */
+extern USART_TypeDef native_usart[NATIVE_USART_INSTANCES]; /*!< Simulated USARTs */
+extern DMA_TypeDef native_dma1;                          /*!< Simulated DMA1 controller */
+extern DMA_Stream_TypeDef native_dma1_stream[NATIVE_DMA_STREAMS]; /*!< Simulated streams of DMA1 */
+extern TIM_TypeDef native_tim[NATIVE_TIM_INSTANCES];     /*!< Simulated timers */
+extern EXTI_TypeDef native_exti;                         /*!< Simulated EXTI controller */
+extern SYSCFG_TypeDef native_syscfg;                     /*!< Simulated SYSCFG */
+extern RCC_TypeDef native_rcc;                           /*!< Simulated RCC */
+extern FLASH_TypeDef native_flash;                       /*!< Simulated FLASH interface */
+extern PWR_TypeDef native_pwr;                           /*!< Simulated PWR */
+extern SysTick_Type native_systick;                      /*!< Simulated SysTick */
+extern uint32_t SystemCoreClock;                         /*!< Frequency of the core clock, as in the CMSIS system_stm32f4xx.h */
+
+#define GPIOA (&native_gpio[0])     /*!< GPIOA register block */
+#define GPIOB (&native_gpio[1])     /*!< GPIOB register block */
+#define GPIOC (&native_gpio[2])     /*!< GPIOC register block */
+#define GPIOD (&native_gpio[3])     /*!< GPIOD register block */
+#define GPIOE (&native_gpio[4])     /*!< GPIOE register block */
+#define GPIOF (&native_gpio[5])     /*!< GPIOF register block */
+#define GPIOG (&native_gpio[6])     /*!< GPIOG register block */
+#define GPIOH (&native_gpio[7])     /*!< GPIOH register block */
+#define USART1 (&native_usart[0])   /*!< USART1 register block */
+#define USART2 (&native_usart[1])   /*!< USART2 register block */
+#define USART3 (&native_usart[2])   /*!< USART3 register block */
+#define USART6 (&native_usart[3])   /*!< USART6 register block */
+#define DMA1 (&native_dma1)         /*!< DMA1 register block */
+#define DMA1_Stream1 (&native_dma1_stream[1]) /*!< DMA1 stream 1 register block */
+#define DMA1_Stream3 (&native_dma1_stream[3]) /*!< DMA1 stream 3 register block */
+#define DMA1_Stream5 (&native_dma1_stream[5]) /*!< DMA1 stream 5 register block */
+#define DMA1_Stream6 (&native_dma1_stream[6]) /*!< DMA1 stream 6 register block */
+#define TIM2 (&native_tim[0])       /*!< TIM2 register block */
+#define TIM3 (&native_tim[1])       /*!< TIM3 register block */
+#define EXTI (&native_exti)         /*!< EXTI register block */
+#define SYSCFG (&native_syscfg)     /*!< SYSCFG register block */
+#define RCC (&native_rcc)           /*!< RCC register block */
+#define FLASH (&native_flash)       /*!< FLASH register block */
+#define PWR (&native_pwr)           /*!< PWR register block */
+#define SysTick (&native_systick)   /*!< SysTick register block */
+
+/* Bit definitions (same values as in stm32f446xx.h and core_cm4.h) -----------*/
+#define GPIO_MODER_MODER0 0x3U /*!< Mask of the mode bits of pin 0 */
+#define GPIO_PUPDR_PUPD0 0x3U  /*!< Mask of the pull-up/pull-down bits of pin 0 */
+
+#define RCC_CR_HSITRIM_Pos 3U                            /*!< Position of the HSITRIM field */
+#define RCC_CR_HSITRIM (0x1FU << RCC_CR_HSITRIM_Pos)     /*!< HSI trimming mask */
+#define RCC_CFGR_SW_Pos 0U                               /*!< Position of the SW field */
+#define RCC_CFGR_SW (0x3U << RCC_CFGR_SW_Pos)            /*!< System clock switch mask */
+#define RCC_CFGR_SW_HSI 0x0U                             /*!< HSI selected as system clock */
+#define RCC_CFGR_HPRE_Pos 4U                             /*!< Position of the HPRE field */
+#define RCC_CFGR_HPRE (0xFU << RCC_CFGR_HPRE_Pos)        /*!< AHB prescaler mask */
+#define RCC_CFGR_PPRE1_Pos 10U                           /*!< Position of the PPRE1 field */
+#define RCC_CFGR_PPRE1 (0x7U << RCC_CFGR_PPRE1_Pos)      /*!< APB1 prescaler mask */
+#define RCC_CFGR_PPRE2_Pos 13U                           /*!< Position of the PPRE2 field */
+#define RCC_CFGR_PPRE2 (0x7U << RCC_CFGR_PPRE2_Pos)      /*!< APB2 prescaler mask */
+#define RCC_AHB1ENR_GPIOAEN (0x1U << 0)                  /*!< GPIOA clock enable */
+#define RCC_AHB1ENR_GPIOBEN (0x1U << 1)                  /*!< GPIOB clock enable */
+#define RCC_AHB1ENR_GPIOCEN (0x1U << 2)                  /*!< GPIOC clock enable */
+#define RCC_AHB1ENR_DMA1EN (0x1U << 21)                  /*!< DMA1 clock enable */
+#define RCC_APB1ENR_TIM2EN (0x1U << 0)                   /*!< TIM2 clock enable */
+#define RCC_APB1ENR_TIM3EN (0x1U << 1)                   /*!< TIM3 clock enable */
+#define RCC_APB1ENR_USART2EN (0x1U << 17)                /*!< USART2 clock enable */
+#define RCC_APB1ENR_USART3EN_Msk (0x1U << 18)            /*!< USART3 clock enable mask */
+#define RCC_APB1ENR_USART3EN RCC_APB1ENR_USART3EN_Msk    /*!< USART3 clock enable */
+#define RCC_APB1ENR_PWREN (0x1U << 28)                   /*!< Power interface clock enable */
+#define RCC_APB2ENR_USART1EN (0x1U << 4)                 /*!< USART1 clock enable */
+#define RCC_APB2ENR_USART6EN (0x1U << 5)                 /*!< USART6 clock enable */
+#define RCC_APB2ENR_SYSCFGEN (0x1U << 14)                /*!< SYSCFG clock enable */
+
+#define FLASH_ACR_LATENCY_2WS 0x2U      /*!< FLASH two wait states */
+#define FLASH_ACR_PRFTEN (0x1U << 8)    /*!< Prefetch enable */
+#define FLASH_ACR_ICEN (0x1U << 9)      /*!< Instruction cache enable */
+#define FLASH_ACR_DCEN (0x1U << 10)     /*!< Data cache enable */
+
+#define PWR_CR_VOS_Pos 14U                    /*!< Position of the VOS field */
+#define PWR_CR_VOS (0x3U << PWR_CR_VOS_Pos)   /*!< Regulator voltage scaling mask */
+
+#define USART_SR_PE (0x1U << 0)   /*!< Parity error */
+#define USART_SR_FE (0x1U << 1)   /*!< Framing error */
+#define USART_SR_NE (0x1U << 2)   /*!< Noise error flag */
+#define USART_SR_ORE (0x1U << 3)  /*!< Overrun error */
+#define USART_SR_IDLE (0x1U << 4) /*!< IDLE line detected */
+#define USART_SR_RXNE (0x1U << 5) /*!< Read data register not empty */
+#define USART_SR_TC (0x1U << 6)   /*!< Transmission complete */
+#define USART_SR_TXE (0x1U << 7)  /*!< Transmit data register empty */
+
+#define USART_CR1_RE_Msk (0x1U << 2)      /*!< Receiver enable mask */
+#define USART_CR1_TE_Msk (0x1U << 3)      /*!< Transmitter enable mask */
+#define USART_CR1_IDLEIE_Msk (0x1U << 4)  /*!< IDLE interrupt enable mask */
+#define USART_CR1_RXNEIE_Msk (0x1U << 5)  /*!< RXNE interrupt enable mask */
+#define USART_CR1_TCIE_Msk (0x1U << 6)    /*!< Transmission complete interrupt enable mask */
+#define USART_CR1_TXEIE_Msk (0x1U << 7)   /*!< TXE interrupt enable mask */
+#define USART_CR1_PEIE_Msk (0x1U << 8)    /*!< PE interrupt enable mask */
+#define USART_CR1_PCE_Msk (0x1U << 10)    /*!< Parity control enable mask */
+#define USART_CR1_M_Msk (0x1U << 12)      /*!< Word length mask */
+#define USART_CR1_UE_Msk (0x1U << 13)     /*!< USART enable mask */
+#define USART_CR1_OVER8_Msk (0x1U << 15)  /*!< Oversampling by 8 mask */
+#define USART_CR1_RE USART_CR1_RE_Msk         /*!< Receiver enable */
+#define USART_CR1_TE USART_CR1_TE_Msk         /*!< Transmitter enable */
+#define USART_CR1_IDLEIE USART_CR1_IDLEIE_Msk /*!< IDLE interrupt enable */
+#define USART_CR1_RXNEIE USART_CR1_RXNEIE_Msk /*!< RXNE interrupt enable */
+#define USART_CR1_TCIE USART_CR1_TCIE_Msk     /*!< Transmission complete interrupt enable */
+#define USART_CR1_TXEIE USART_CR1_TXEIE_Msk   /*!< TXE interrupt enable */
+#define USART_CR1_PEIE USART_CR1_PEIE_Msk     /*!< PE interrupt enable */
+#define USART_CR1_PCE USART_CR1_PCE_Msk       /*!< Parity control enable */
+#define USART_CR1_M USART_CR1_M_Msk           /*!< Word length */
+#define USART_CR1_UE USART_CR1_UE_Msk         /*!< USART enable */
+#define USART_CR1_OVER8 USART_CR1_OVER8_Msk   /*!< Oversampling by 8 */
+#define USART_CR2_STOP (0x3U << 12)           /*!< Stop bits mask */
+#define USART_CR3_EIE (0x1U << 0)             /*!< Error interrupt enable */
+#define USART_CR3_DMAR (0x1U << 6)            /*!< DMA enable receiver */
+#define USART_CR3_DMAT (0x1U << 7)            /*!< DMA enable transmitter */
+#define USART_CR3_RTSE (0x1U << 8)            /*!< RTS enable */
+#define USART_CR3_CTSE (0x1U << 9)            /*!< CTS enable */
+
+#define DMA_SxCR_EN (0x1U << 0)         /*!< Stream enable */
+#define DMA_SxCR_TEIE (0x1U << 2)       /*!< Transfer error interrupt enable */
+#define DMA_SxCR_HTIE (0x1U << 3)       /*!< Half transfer interrupt enable */
+#define DMA_SxCR_TCIE (0x1U << 4)       /*!< Transfer complete interrupt enable */
+#define DMA_SxCR_DIR (0x3U << 6)        /*!< Data transfer direction mask */
+#define DMA_SxCR_DIR_0 (0x1U << 6)      /*!< Direction bit 0 (memory to peripheral) */
+#define DMA_SxCR_CIRC (0x1U << 8)       /*!< Circular mode */
+#define DMA_SxCR_MINC (0x1U << 10)      /*!< Memory increment mode */
+#define DMA_SxCR_CHSEL_Pos 25U          /*!< Position of the channel selection field */
+#define DMA_SxCR_CHSEL (0x7U << DMA_SxCR_CHSEL_Pos) /*!< Channel selection mask */
+
+#define TIM_CR1_CEN (0x1U << 0)       /*!< Counter enable */
+#define TIM_CR1_URS (0x1U << 2)       /*!< Update request source: only overflows raise UIF */
+#define TIM_CR1_ARPE (0x1U << 7)      /*!< Auto-reload preload enable */
+#define TIM_DIER_UIE (0x1U << 0)      /*!< Update interrupt enable */
+#define TIM_SR_UIF (0x1U << 0)        /*!< Update interrupt flag */
+#define TIM_EGR_UG (0x1U << 0)        /*!< Update generation */
+#define TIM_CCMR1_OC1PE (0x1U << 3)   /*!< Output compare 1 preload enable */
+#define TIM_CCMR1_OC1M_Pos 4U         /*!< Position of the OC1M field */
+#define TIM_CCMR1_OC1M (0x7U << TIM_CCMR1_OC1M_Pos)   /*!< Output compare 1 mode mask */
+#define TIM_CCMR1_OC1M_1 (0x2U << TIM_CCMR1_OC1M_Pos) /*!< Output compare 1 mode bit 1 */
+#define TIM_CCMR1_OC1M_2 (0x4U << TIM_CCMR1_OC1M_Pos) /*!< Output compare 1 mode bit 2 */
+#define TIM_CCER_CC1E (0x1U << 0)     /*!< Capture/compare 1 output enable */
+
+#define SysTick_CTRL_ENABLE_Msk (0x1U << 0)    /*!< SysTick counter enable */
+#define SysTick_CTRL_TICKINT_Msk (0x1U << 1)   /*!< SysTick exception request enable */
+#define SysTick_CTRL_CLKSOURCE_Msk (0x1U << 2) /*!< SysTick clock source (processor clock) */
+#define SysTick_LOAD_RELOAD_Msk 0xFFFFFFU      /*!< SysTick reload value mask */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Configure the priority grouping of the simulated NVIC (same semantics as in CMSIS).
+ *
+ * @param priority_group Priority grouping field
+ */
+void NVIC_SetPriorityGrouping(uint32_t priority_group);
+
+/**
+ * @brief Get the priority grouping of the simulated NVIC.
+ *
+ * @return Priority grouping field
+ */
+uint32_t NVIC_GetPriorityGrouping(void);
+
+/**
+ * @brief Set the priority of an interrupt (device or SysTick).
+ *
+ * @param IRQn Interrupt number
+ * @param priority Priority to set (encoded as returned by NVIC_EncodePriority())
+ */
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+
+/**
+ * @brief Get the priority of an interrupt.
+ *
+ * @param IRQn Interrupt number
+ * @return Encoded priority of the interrupt
+ */
+uint32_t NVIC_GetPriority(IRQn_Type IRQn);
+
+/**
+ * @brief Encode the priority of an interrupt (same algorithm as in CMSIS).
+ *
+ * @param PriorityGroup Used priority group
+ * @param PreemptPriority Preemptive priority value (starting from 0)
+ * @param SubPriority Subpriority value (starting from 0)
+ * @return Encoded priority
+ */
+uint32_t NVIC_EncodePriority(uint32_t PriorityGroup, uint32_t PreemptPriority, uint32_t SubPriority);
+
+/**
+ * @brief Decode the priority of an interrupt (same algorithm as in CMSIS).
+ *
+ * @param Priority Encoded priority
+ * @param PriorityGroup Used priority group
+ * @param pPreemptPriority Preemptive priority value (starting from 0)
+ * @param pSubPriority Subpriority value (starting from 0)
+ */
+void NVIC_DecodePriority(uint32_t Priority, uint32_t PriorityGroup, uint32_t *const pPreemptPriority, uint32_t *const pSubPriority);
+
+/**
+ * @brief Enable a device interrupt in the simulated NVIC.
+ *
+ * @param IRQn Device interrupt number (must not be negative)
+ */
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+
+/**
+ * @brief Disable a device interrupt in the simulated NVIC.
+ *
+ * @param IRQn Device interrupt number (must not be negative)
+ */
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+
+/**
+ * @brief Get the enable state of a device interrupt.
+ *
+ * @param IRQn Device interrupt number (must not be negative)
+ * @return 1 if the interrupt is enabled, 0 otherwise
+ */
+uint32_t NVIC_GetEnableIRQ(IRQn_Type IRQn);
+
+/**
+ * @brief Set the pending bit of a device interrupt (software trigger).
+ *
+ * @param IRQn Device interrupt number (must not be negative)
+ */
+void NVIC_SetPendingIRQ(IRQn_Type IRQn);
+
+/**
+ * @brief Clear the pending bit of a device interrupt.
+ *
+ * @param IRQn Device interrupt number (must not be negative)
+ */
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+
+/**
+ * @brief Configure the SysTick timer to raise an interrupt every `ticks` core clock cycles.
+ *
+ * @param ticks Number of ticks between two interrupts
+ * @return 0 if the function succeeded, 1 if the reload value is impossible
+ */
+uint32_t SysTick_Config(uint32_t ticks);
+
+/**
+ * @brief Mask all the interrupts (PRIMASK = 1). Interrupts raised meanwhile stay pending.
+ */
+void __disable_irq(void);
+
+/**
+ * @brief Unmask the interrupts (PRIMASK = 0) and serve the pending ones.
+ */
+void __enable_irq(void);
+
+/**
+ * @brief Read the interrupt mask register.
+ *
+ * @return 1 if the interrupts are masked, 0 otherwise
+ */
+uint32_t __get_PRIMASK(void);
+
+/**
+ * @brief Write the interrupt mask register. Unmasking serves the pending interrupts.
+ *
+ * @param priMask 1 to mask the interrupts, 0 to unmask them
+ */
+void __set_PRIMASK(uint32_t priMask);
+
+/**
+ * @brief Wait for interrupt. The virtual clock jumps to the next peripheral event and the interrupts it raises are served.
+ */
+void __WFI(void);
+
+/**
+ * @brief Send a character through the (simulated) ITM stimulus port 0. On the host it is written to `stdout`.
+ *
+ * @param ch Character to send
+ * @return The character sent
+ */
+uint32_t ITM_SendChar(uint32_t ch);
+
+/* Accessors of registers with side effects -------------------------------------*/
+/**
+ * @brief Read the data register of a USART. Like the SR-then-DR sequence on the device, it clears `RXNE` and
+ * the error flags (`ORE`, `NE`, `FE`, `PE`) and `IDLE`.
+ *
+ * @param p_usart USART register block
+ * @return Received byte
+ */
+uint32_t native_hw_usart_read_dr(USART_TypeDef *p_usart);
+
+/**
+ * @brief Write the data register of a USART. It clears `TXE` and `TC`; the model moves the byte to the shift register
+ * and sends it at the configured baud rate.
+ *
+ * @param p_usart USART register block
+ * @param data Byte to transmit
+ */
+void native_hw_usart_write_dr(USART_TypeDef *p_usart, uint32_t data);
+
+/**
+ * @brief Write the low interrupt flag clear register of a DMA controller: the bits set in the mask clear the same bits
+ * of `LISR` (streams 0 to 3).
+ *
+ * @param p_dma DMA register block
+ * @param mask Flags to clear
+ */
+void native_hw_dma_write_lifcr(DMA_TypeDef *p_dma, uint32_t mask);
+
+/**
+ * @brief Write the high interrupt flag clear register of a DMA controller: the bits set in the mask clear the same
+ * bits of `HISR` (streams 4 to 7).
+ *
+ * @param p_dma DMA register block
+ * @param mask Flags to clear
+ */
+void native_hw_dma_write_hifcr(DMA_TypeDef *p_dma, uint32_t mask);
+
+/**
+ * @brief Clear the pending bits of the EXTI lines given in the mask (write 1 to clear, as on the device).
+ *
+ * @param mask Mask of the lines to clear
+ */
+void native_hw_exti_clear_pending(uint32_t mask);
+
+/**
+ * @brief Apply the value written to `BSRR` of a GPIO port: bits 0..15 set and bits 16..31 reset the outputs.
+ *
+ * @param p_port GPIO port
+ * @param bsrr Value written to `BSRR`
+ */
+void native_hw_gpio_write_bsrr(GPIO_TypeDef *p_port, uint32_t bsrr);
+
+/**
+ * @brief Write the event generation register of a timer. `UG` reloads the prescaler, auto-reload and compare registers
+ * from their preload values and restarts the counter, as on the device; it sets `UIF` unless `URS` is set.
+ *
+ * @param p_tim Timer register block
+ * @param egr Value written to `EGR`
+ */
+void native_hw_tim_write_egr(TIM_TypeDef *p_tim, uint32_t egr);
+
+#endif /* NATIVE_HW_H_ */
@@ -0,0 +1,346 @@
+/**
+ * @file native_sim.h
+ * @brief Virtual clock and peripheral models of the native (host) platform.
+ *
+ * The native platform has no real time base: time only advances when the program waits (`port_system_delay_ms()`,
+ * `__WFI()`) or when a test or benchmark advances the virtual clock explicitly. Every peripheral event (SysTick
+ * period, end of a USART frame, line idle) is scheduled in core clock cycles and processed in order, raising the
+ * same interrupt lines as the device. Hours of button and serial traffic can therefore be replayed in a fraction
+ * of a second, deterministically.
+ *
+ * The streams of DMA1 are modelled for the USARTs only: an enabled stream whose `PAR` is the `DR` of a USART with
+ * `DMAR` or `DMAT` set in `CR3` moves each received byte to memory, or feeds the transmitter from memory whenever
+ * `TXE` is set, with the half and complete transfer flags and circular mode of the device.
+ *
+ * TIM2 and TIM3 are modelled as up-counters: the update event of each period reloads the prescaler, the auto-reload
+ * and the compare register of channel 1 from their preload values and sets `UIF`. The PWM output of channel 1 is not
+ * toggled cycle by cycle; instead, every change of its period or pulse (an update with new values, `UG`, or enabling
+ * and disabling the counter or the output) is logged with its virtual time (see native_sim_tim_read_output()).
+ *
+ * Optionally, the virtual clock can follow the host clock multiplied by a time scale (see native_sim_set_time_scale()).
+ *
+ * A busy-wait on a flag set by an ISR (`while (!flag) {}`) does not call the models, so a host timer (the stall guard)
+ * plays the role of the asynchronous interrupt: if the virtual clock does not advance for a couple of milliseconds of
+ * host time, it is advanced to the next event (see native_sim_set_stall_guard()).
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+#ifndef NATIVE_SIM_H_
+#define NATIVE_SIM_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* HW dependent includes */
+#include "native_hw.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define NATIVE_SIM_NO_EVENT UINT64_MAX         /*!< Value returned when no peripheral event is scheduled */
+#define NATIVE_SIM_USART_FIFO_LENGTH 4096U     /*!< Bytes that the simulated peer can queue in each direction (power of 2) */
+#define NATIVE_SIM_TIM_LOG_LENGTH 1024U      /*!< Changes of the PWM output that each timer model keeps until they are read */
+#define NATIVE_SIM_CYCLES_PER_US (NATIVE_CORE_CLOCK_HZ / 1000000U) /*!< Core clock cycles per microsecond */
+#define NATIVE_SIM_CYCLES_PER_MS (NATIVE_CORE_CLOCK_HZ / 1000U)    /*!< Core clock cycles per millisecond */
+
+/* Enums */
+/**
+ * @brief Flow control honoured by the simulated peer of a USART.
+ */
+enum NATIVE_SIM_FLOW
+{
+    NATIVE_SIM_FLOW_NONE = 0, /*!< The peer sends whenever it has bytes and discards the bytes it cannot hold */
+    NATIVE_SIM_FLOW_RTS_CTS,  /*!< The peer only starts a byte while the RTS pin of the USART is low, and drives CTS high while its FIFO is full */
+    NATIVE_SIM_FLOW_XON_XOFF  /*!< The peer stops after receiving XOFF (0x13) and resumes after XON (0x11); it does not store them */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Counters of the simulated peer of a USART.
+ */
+typedef struct
+{
+    uint32_t rx_bytes;    /*!< Bytes delivered to the receive data register */
+    uint32_t rx_overruns; /*!< Bytes lost because `RXNE` was still set when they arrived (`ORE`) */
+    uint32_t rx_dropped;  /*!< Bytes lost because the receiver was disabled or the peer FIFO was full */
+    uint32_t tx_bytes;    /*!< Bytes shifted out by the transmitter */
+    uint32_t rx_waits;    /*!< Frame times the peer waited with bytes to send because the USART asked it to stop */
+} native_sim_usart_stats_t;
+
+/**
+ * @brief Change of the PWM output of channel 1 of a timer.
+ */
+typedef struct
+{
+    uint64_t at;            /*!< Virtual time of the change in cycles */
+    uint32_t period_cycles; /*!< Period of the output in core clock cycles, or 0 if the output stopped */
+    uint32_t pulse_cycles;  /*!< Time the output is high in each period, in core clock cycles */
+} native_sim_tim_output_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Reset the registers of all the peripherals and the virtual clock to their power-on state.
+ *
+ * @note Inputs that are not driven by native_sim_gpio_set_input() read high (like the pulled-up user button of the board).
+ */
+void native_sim_reset(void);
+
+/**
+ * @brief Get the virtual time in core clock cycles since the last reset.
+ *
+ * @return Virtual time in cycles
+ */
+uint64_t native_sim_get_cycles(void);
+
+/**
+ * @brief Get the virtual time in microseconds since the last reset.
+ *
+ * @return Virtual time in microseconds
+ */
+uint64_t native_sim_get_us(void);
+
+/**
+ * @brief Advance the virtual clock, processing the peripheral events and serving the interrupts they raise.
+ *
+ * @param cycles Number of core clock cycles to advance
+ */
+void native_sim_advance_cycles(uint64_t cycles);
+
+/**
+ * @brief Advance the virtual clock some microseconds.
+ *
+ * @param us Number of microseconds to advance
+ */
+void native_sim_advance_us(uint64_t us);
+
+/**
+ * @brief Advance the virtual clock some milliseconds.
+ *
+ * @param ms Number of milliseconds to advance
+ */
+void native_sim_advance_ms(uint32_t ms);
+
+/**
+ * @brief Advance the virtual clock up to the next scheduled peripheral event (used by `__WFI()`).
+ *
+ * In scaled mode the host thread sleeps until the event is due in host time.
+ *
+ * @return `true` if an event was processed, `false` if no event is scheduled
+ */
+bool native_sim_wait_for_event(void);
+
+/**
+ * @brief Get the virtual time of the next scheduled peripheral event.
+ *
+ * @return Virtual time in cycles, or `NATIVE_SIM_NO_EVENT`
+ */
+uint64_t native_sim_get_next_event(void);
+
+/**
+ * @brief Select how the virtual clock relates to the host clock.
+ *
+ * @param scale 0 (default) for a stepped clock that only advances on waits and explicit calls. N > 0 to make the virtual
+ * clock run N times faster than the host clock (1 is real time).
+ */
+void native_sim_set_time_scale(uint32_t scale);
+
+/**
+ * @brief Synchronization point: catch up with the host clock in scaled mode and serve the pending interrupts.
+ *
+ * It is called by the port functions that read the time or unmask an interrupt source.
+ */
+void native_sim_sync(void);
+
+/**
+ * @brief Enable or disable the stall guard. It is enabled by native_sim_reset().
+ *
+ * Tests that check the exact virtual time of each event disable it, so that the clock only advances on their request.
+ *
+ * @param enable `true` to let the host timer advance a stalled virtual clock
+ */
+void native_sim_set_stall_guard(bool enable);
+
+/**
+ * @brief Drive the external level of a GPIO pin. If the pin is an input, the edge is detected by the EXTI.
+ *
+ * @param p_port Port of the GPIO
+ * @param pin Pin/line of the GPIO (index from 0 to 15)
+ * @param level External level of the pin
+ */
+void native_sim_gpio_set_input(GPIO_TypeDef *p_port, uint8_t pin, bool level);
+
+/**
+ * @brief Queue bytes to be sent by the peer to the receiver of a USART. They arrive one after the other at the baud
+ * rate configured in `BRR`, the first one a frame time after the call (or after the last queued byte).
+ *
+ * @param p_usart USART register block
+ * @param p_data Bytes to send
+ * @param length Number of bytes to send
+ * @return Number of bytes accepted by the peer FIFO
+ */
+uint32_t native_sim_usart_inject_rx(USART_TypeDef *p_usart, const uint8_t *p_data, uint32_t length);
+
+/**
+ * @brief Queue a byte that the USART will receive with line errors, as if the peer sent it over a noisy line.
+ *
+ * When the byte is received the error flags are set in SR together with `RXNE` (or, if the DMA reads it, alone), and
+ * they stay set until the software reads SR and then DR.
+ *
+ * @param p_usart USART register block
+ * @param data Byte to send
+ * @param errors Flags of SR to set: any of `USART_SR_PE`, `USART_SR_FE` and `USART_SR_NE`
+ * @return `true` if the byte was accepted by the peer FIFO
+ */
+bool native_sim_usart_inject_rx_error(USART_TypeDef *p_usart, uint8_t data, uint32_t errors);
+
+/**
+ * @brief Select the flow control honoured by the simulated peer of a USART.
+ *
+ * @param p_usart USART register block
+ * @param flow Flow control (`enum NATIVE_SIM_FLOW`)
+ * @param p_rts_port GPIO port of the RTS pin of the USART (only used with `NATIVE_SIM_FLOW_RTS_CTS`)
+ * @param rts_pin RTS pin of the USART
+ */
+void native_sim_usart_set_peer_flow(USART_TypeDef *p_usart, uint32_t flow, GPIO_TypeDef *p_rts_port, uint8_t rts_pin);
+
+/**
+ * @brief Make the simulated peer of a USART busy or ready, as a host that stops reading. With
+ * `NATIVE_SIM_FLOW_RTS_CTS` a busy peer drives CTS high and the transmitter of the USART waits if `CTSE` is set.
+ *
+ * @param p_usart USART register block
+ * @param ready `false` to make the peer busy
+ */
+void native_sim_usart_set_peer_ready(USART_TypeDef *p_usart, bool ready);
+
+/**
+ * @brief Get the number of bytes that the peer still has to send to a USART.
+ *
+ * @param p_usart USART register block
+ * @return Number of queued bytes
+ */
+uint32_t native_sim_usart_get_rx_pending(USART_TypeDef *p_usart);
+
+/**
+ * @brief Retrieve the bytes transmitted by a USART and received by the peer.
+ *
+ * @param p_usart USART register block
+ * @param p_data Buffer to store the bytes
+ * @param max_length Size of the buffer
+ * @return Number of bytes copied
+ */
+uint32_t native_sim_usart_read_tx(USART_TypeDef *p_usart, uint8_t *p_data, uint32_t max_length);
+
+/**
+ * @brief Get the duration of a frame (start, data, parity and stop bits) of a USART with the current configuration:
+ * BRR, OVER8, word length, stop bits and the prescaler of its APB bus in RCC_CFGR.
+ *
+ * @param p_usart USART register block
+ * @return Duration of a frame in core clock cycles, or 0 if the baud rate is not configured
+ */
+uint32_t native_sim_usart_get_frame_cycles(USART_TypeDef *p_usart);
+
+/**
+ * @brief Get the counters of the simulated peer of a USART.
+ *
+ * @param p_usart USART register block
+ * @param p_stats Pointer to store the counters
+ */
+void native_sim_usart_get_stats(USART_TypeDef *p_usart, native_sim_usart_stats_t *p_stats);
+
+/**
+ * @brief Retrieve the changes of the PWM output of channel 1 of a timer, in order. The output is active while the
+ * counter and `CC1E` are enabled and `OC1M` selects PWM mode 1; every `UG` of an active output is logged, even if the
+ * period does not change, because it restarts the waveform.
+ *
+ * @param p_tim Timer register block
+ * @param p_changes Buffer to store the changes
+ * @param max_length Size of the buffer
+ * @return Number of changes copied. Changes beyond `NATIVE_SIM_TIM_LOG_LENGTH` not yet read are lost.
+ */
+uint32_t native_sim_tim_read_output(TIM_TypeDef *p_tim, native_sim_tim_output_t *p_changes, uint32_t max_length);
+
+/**
+ * @brief Get the number of times an interrupt handler has been entered since the last reset.
+ *
+ * @param IRQn Interrupt number
+ * @return Number of ISR entries
+ */
+uint32_t native_sim_get_irq_count(IRQn_Type IRQn);
+
+/**
+ * @brief Reset the ISR entry counters.
+ */
+void native_sim_reset_irq_counts(void);
+
+/* Functions shared by the native_hw.c and native_sim.c models -------------------------------------------------*/
+/**
+ * @brief Get the level of the interrupt line of a device interrupt, computed from the registers of the peripheral.
+ * @warning This function must be used only by the NVIC model in `native_hw.c`.
+ *
+ * @param IRQn Device interrupt number
+ * @return `true` if the peripheral requests the interrupt
+ */
+bool native_sim_get_irq_line(IRQn_Type IRQn);
+
+/**
+ * @brief Serve the pending and asserted interrupts, in priority order, unless they are masked or a handler is running.
+ * @warning This function must be used only by the models in `native_sim.c` and `native_hw.c`.
+ */
+void native_hw_serve_irqs(void);
+
+/**
+ * @brief Pend the SysTick exception.
+ * @warning This function must be used only by the SysTick model in `native_sim.c`.
+ */
+void native_hw_pend_systick(void);
+
+/**
+ * @brief Reset the registers of all the peripherals and the NVIC to their power-on values.
+ * @warning This function must be used only by native_sim_reset().
+ */
+void native_hw_reset_registers(void);
+
+/**
+ * @brief Recompute the input data register of a port after its mode, outputs or external levels change, and detect
+ * the edges on the EXTI lines.
+ * @warning This function must be used only by the port functions that configure GPIOs and by the models.
+ *
+ * @param p_port Port of the GPIO
+ */
+void native_sim_gpio_update(GPIO_TypeDef *p_port);
+
+/**
+ * @brief Load the transmit data register of the USART model. The byte moves to the shift register as soon as it is free.
+ * @warning This function must be used only by native_hw_usart_write_dr().
+ *
+ * @param p_usart USART register block
+ * @param data Byte to transmit
+ */
+void native_sim_usart_load_tdr(USART_TypeDef *p_usart, uint32_t data);
+
+/**
+ * @brief Generate an update event of a timer by software.
+ * @warning This function must be used only by native_hw_tim_write_egr().
+ *
+ * @param p_tim Timer register block
+ */
+void native_sim_tim_generate_update(TIM_TypeDef *p_tim);
+
+/**
+ * @brief Mark the start of an access to the state of the models. The stall guard does not interrupt it.
+ *
+ * @warning This function must be used only by the models in `native_sim.c` and `native_hw.c`.
+ */
+void native_sim_enter(void);
+
+/**
+ * @brief Mark the end of an access started with native_sim_enter().
+ *
+ * @warning This function must be used only by the models in `native_sim.c` and `native_hw.c`.
+ */
+void native_sim_exit(void);
+
+#endif /* NATIVE_SIM_H_ */
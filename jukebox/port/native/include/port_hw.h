@@ -0,0 +1,93 @@
+/**
+ * @file port_hw.h
+ * @brief Access to the registers with side effects on read or write, for the native platform.
+ *
+ * The native platform compiles the drivers of `port/stm32f4`. Its include directory comes first, so this header
+ * replaces the one of `port/stm32f4`. It routes every access to the simulated peripherals through the helpers of
+ * `native_hw.h`, so that the model can react to them.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+#ifndef PORT_HW_H_
+#define PORT_HW_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* HW dependent includes */
+#include "native_hw.h"
+#include "native_sim.h"
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Read the data register of a USART (see native_hw_usart_read_dr()).
+ * @param p_usart USART register block
+ * @return Received byte
+ */
+static inline uint32_t port_hw_usart_read_dr(USART_TypeDef *p_usart)
+{
+    return native_hw_usart_read_dr(p_usart);
+}
+
+/**
+ * @brief Write the data register of a USART (see native_hw_usart_write_dr()).
+ * @param p_usart USART register block
+ * @param data Byte to transmit
+ */
+static inline void port_hw_usart_write_dr(USART_TypeDef *p_usart, uint32_t data)
+{
+    native_hw_usart_write_dr(p_usart, data);
+}
+
+/**
+ * @brief Write `LIFCR` of a DMA controller (see native_hw_dma_write_lifcr()).
+ * @param p_dma DMA register block
+ * @param mask Flags to clear
+ */
+static inline void port_hw_dma_write_lifcr(DMA_TypeDef *p_dma, uint32_t mask)
+{
+    native_hw_dma_write_lifcr(p_dma, mask);
+}
+
+/**
+ * @brief Write `HIFCR` of a DMA controller (see native_hw_dma_write_hifcr()).
+ * @param p_dma DMA register block
+ * @param mask Flags to clear
+ */
+static inline void port_hw_dma_write_hifcr(DMA_TypeDef *p_dma, uint32_t mask)
+{
+    native_hw_dma_write_hifcr(p_dma, mask);
+}
+
+/**
+ * @brief Clear the pending bits of the EXTI lines of the mask (see native_hw_exti_clear_pending()).
+ * @param mask Lines to clear
+ */
+static inline void port_hw_exti_clear_pending(uint32_t mask)
+{
+    native_hw_exti_clear_pending(mask);
+}
+
+/**
+ * @brief Write `EGR` of a timer (see native_hw_tim_write_egr()).
+ * @param p_tim Timer register block
+ * @param egr Value written to `EGR`
+ */
+static inline void port_hw_tim_write_egr(TIM_TypeDef *p_tim, uint32_t egr)
+{
+    native_hw_tim_write_egr(p_tim, egr);
+}
+
+/**
+ * @brief Synchronization point after unmasking an interrupt source or enabling a DMA stream: the model serves what
+ * became pending at once, as the device would (see native_sim_sync()).
+ */
+static inline void port_hw_sync(void)
+{
+    native_sim_sync();
+}
+
+#endif /* PORT_HW_H_ */
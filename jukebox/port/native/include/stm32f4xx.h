@@ -0,0 +1,19 @@
+/**
+ * @file stm32f4xx.h
+ * @brief Replacement of the CMSIS device header for the native platform.
+ *
+ * The headers of `port/stm32f4` include `stm32f4xx.h`; on the native platform they get the simulated register blocks
+ * of `native_hw.h` and the simulator interface of `native_sim.h` instead.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+#ifndef STM32F4XX_H_
+#define STM32F4XX_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "native_hw.h" /* Simulated register blocks that replace stm32f4xx.h */
+#include "native_sim.h"
+
+#endif /* STM32F4XX_H_ */
@@ -0,0 +1,165 @@
+/**
+ * @file interr.c
+ * @brief Interrupt service routines for the native platform. They are called by the NVIC model of `native_hw.c`.
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+// Include HW dependencies:
+#include "port_system.h"
+#include "port_button.h"
+#include "port_usart.h"
+#include "port_buzzer.h"
+#include "sw_timer.h"
+#include "log_sink.h"
+
+//------------------------------------------------------
+// INTERRUPT SERVICE ROUTINES
+//------------------------------------------------------
+/**
+ * @brief Interrupt service routine for the System tick timer (SysTick).
+ *
+ * @note This ISR is called when the simulated SysTick timer underflows, once every millisecond of virtual time.
+ */
+void SysTick_Handler(void)
+{
+    uint32_t var = port_system_get_millis();
+    var++;
+    port_system_set_millis(var);
+    sw_timer_tick(var);
+    port_button_sample_tick(var);
+    log_sink_tick();
+}
+
+/**
+ * @brief Esta función maneja las interrupciones globales Px10-Px15.
+ *
+ * Todas las ISR de la EXTI delegan en port_button_exti_isr(), que atiende cada línea pendiente de su grupo.
+ */
+void EXTI15_10_IRQHandler(void)
+{
+    port_button_exti_isr(PORT_BUTTON_EXTI_LINES_15_10);
+}
+
+/**
+ * @brief Esta función maneja las interrupciones globales Px5-Px9.
+ */
+void EXTI9_5_IRQHandler(void)
+{
+    port_button_exti_isr(PORT_BUTTON_EXTI_LINES_9_5);
+}
+
+/**
+ * @brief Esta función maneja la interrupción de la línea EXTI0.
+ */
+void EXTI0_IRQHandler(void)
+{
+    port_button_exti_isr(BIT_POS_TO_MASK(0));
+}
+
+/**
+ * @brief Esta función maneja la interrupción de la línea EXTI1.
+ */
+void EXTI1_IRQHandler(void)
+{
+    port_button_exti_isr(BIT_POS_TO_MASK(1));
+}
+
+/**
+ * @brief Esta función maneja la interrupción de la línea EXTI2.
+ */
+void EXTI2_IRQHandler(void)
+{
+    port_button_exti_isr(BIT_POS_TO_MASK(2));
+}
+
+/**
+ * @brief Esta función maneja la interrupción de la línea EXTI3.
+ */
+void EXTI3_IRQHandler(void)
+{
+    port_button_exti_isr(BIT_POS_TO_MASK(3));
+}
+
+/**
+ * @brief Esta función maneja la interrupción de la línea EXTI4.
+ */
+void EXTI4_IRQHandler(void)
+{
+    port_button_exti_isr(BIT_POS_TO_MASK(4));
+}
+
+/**
+ * @brief Esta función maneja la interrupción global USART1.
+ *
+ * Todas las ISR de los USART delegan en port_usart_isr() con el identificador de su entrada en `usart_arr`.
+ */
+void USART1_IRQHandler(void)
+{
+    port_usart_isr(USART_2_ID);
+}
+
+/**
+ * @brief Esta función maneja la interrupción global USART2.
+ */
+void USART2_IRQHandler(void)
+{
+    port_usart_isr(USART_1_ID);
+}
+
+/**
+ * @brief Esta función maneja la interrupción global USART3.
+ */
+void USART3_IRQHandler(void)
+{
+    port_usart_isr(USART_0_ID);
+}
+
+/**
+ * @brief Esta función maneja la interrupción global USART6.
+ */
+void USART6_IRQHandler(void)
+{
+    port_usart_isr(USART_3_ID);
+}
+
+/**
+ * @brief Esta función maneja la interrupción del stream 1 del DMA1 (recepción del USART3 en modo DMA).
+ */
+void DMA1_Stream1_IRQHandler(void)
+{
+    port_usart_dma_rx_isr(USART_0_ID);
+}
+
+/**
+ * @brief Esta función maneja la interrupción del stream 3 del DMA1 (transmisión del USART3 en modo DMA).
+ */
+void DMA1_Stream3_IRQHandler(void)
+{
+    port_usart_dma_tx_isr(USART_0_ID);
+}
+
+/**
+ * @brief Esta función maneja la interrupción del stream 5 del DMA1 (recepción del USART2 en modo DMA).
+ */
+void DMA1_Stream5_IRQHandler(void)
+{
+    port_usart_dma_rx_isr(USART_1_ID);
+}
+
+/**
+ * @brief Esta función maneja la interrupción del stream 6 del DMA1 (transmisión del USART2 en modo DMA).
+ */
+void DMA1_Stream6_IRQHandler(void)
+{
+    port_usart_dma_tx_isr(USART_1_ID);
+}
+
+/**
+ * @brief Esta función maneja la interrupción global TIM2 (fin de la nota del buzzer).
+ *
+ * En modo secuenciador la propia ISR carga la nota siguiente; la FSM sólo se entera del fin de la melodía.
+ */
+void TIM2_IRQHandler(void)
+{
+    port_buzzer_duration_isr(BUZZER_0_ID);
+}
@@ -0,0 +1,410 @@
+/**
+ * @file native_hw.c
+ * @brief Simulated register blocks, NVIC and vector table of the native (host) platform.
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <string.h>
+
+/* HW dependent libraries */
+#include "native_hw.h"
+#include "native_sim.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define IRQN_TO_VECTOR(irqn) ((int32_t)(irqn) + 16)  /*!< Position of an interrupt in the vector table */
+#define VECTOR_TO_IRQN(v) ((IRQn_Type)((v) - 16))     /*!< Interrupt number of a position of the vector table */
+#define SYSTICK_VECTOR IRQN_TO_VECTOR(SysTick_IRQn) /*!< Position of the SysTick exception in the vector table */
+#define IRQ_STORM_LIMIT 100000U                     /*!< Consecutive ISR entries without returning to thread mode considered a storm */
+
+/* Weak declarations of the handlers (defined in interr.c) -------------------*/
+void SysTick_Handler(void) __attribute__((weak));         /*!< SysTick exception handler */
+void EXTI0_IRQHandler(void) __attribute__((weak));        /*!< EXTI line 0 handler */
+void EXTI1_IRQHandler(void) __attribute__((weak));        /*!< EXTI line 1 handler */
+void EXTI2_IRQHandler(void) __attribute__((weak));        /*!< EXTI line 2 handler */
+void EXTI3_IRQHandler(void) __attribute__((weak));        /*!< EXTI line 3 handler */
+void EXTI4_IRQHandler(void) __attribute__((weak));        /*!< EXTI line 4 handler */
+void DMA1_Stream1_IRQHandler(void) __attribute__((weak)); /*!< DMA1 stream 1 handler */
+void DMA1_Stream3_IRQHandler(void) __attribute__((weak)); /*!< DMA1 stream 3 handler */
+void DMA1_Stream5_IRQHandler(void) __attribute__((weak)); /*!< DMA1 stream 5 handler */
+void DMA1_Stream6_IRQHandler(void) __attribute__((weak)); /*!< DMA1 stream 6 handler */
+void EXTI9_5_IRQHandler(void) __attribute__((weak));      /*!< EXTI lines 5 to 9 handler */
+void TIM2_IRQHandler(void) __attribute__((weak));         /*!< TIM2 handler */
+void TIM3_IRQHandler(void) __attribute__((weak));         /*!< TIM3 handler */
+void TIM4_IRQHandler(void) __attribute__((weak));         /*!< TIM4 handler */
+void USART1_IRQHandler(void) __attribute__((weak));       /*!< USART1 handler */
+void USART2_IRQHandler(void) __attribute__((weak));       /*!< USART2 handler */
+void USART3_IRQHandler(void) __attribute__((weak));       /*!< USART3 handler */
+void EXTI15_10_IRQHandler(void) __attribute__((weak));    /*!< EXTI lines 10 to 15 handler */
+void TIM5_IRQHandler(void) __attribute__((weak));         /*!< TIM5 handler */
+void USART6_IRQHandler(void) __attribute__((weak));       /*!< USART6 handler */
+
+/* Global variables ------------------------------------------------------------*/
+GPIO_TypeDef native_gpio[NATIVE_GPIO_PORTS];
+USART_TypeDef native_usart[NATIVE_USART_INSTANCES];
+DMA_TypeDef native_dma1;
+DMA_Stream_TypeDef native_dma1_stream[NATIVE_DMA_STREAMS];
+TIM_TypeDef native_tim[NATIVE_TIM_INSTANCES];
+EXTI_TypeDef native_exti;
+SYSCFG_TypeDef native_syscfg;
+RCC_TypeDef native_rcc;
+FLASH_TypeDef native_flash;
+PWR_TypeDef native_pwr;
+SysTick_Type native_systick;
+
+/**
+ * @brief Vector table. Handlers not defined by the application are NULL (weak references) and are ignored.
+ */
+static void (*const vector_table[NATIVE_VECTOR_COUNT])(void) = {
+    [SYSTICK_VECTOR] = SysTick_Handler,
+    [IRQN_TO_VECTOR(EXTI0_IRQn)] = EXTI0_IRQHandler,
+    [IRQN_TO_VECTOR(EXTI1_IRQn)] = EXTI1_IRQHandler,
+    [IRQN_TO_VECTOR(EXTI2_IRQn)] = EXTI2_IRQHandler,
+    [IRQN_TO_VECTOR(EXTI3_IRQn)] = EXTI3_IRQHandler,
+    [IRQN_TO_VECTOR(EXTI4_IRQn)] = EXTI4_IRQHandler,
+    [IRQN_TO_VECTOR(DMA1_Stream1_IRQn)] = DMA1_Stream1_IRQHandler,
+    [IRQN_TO_VECTOR(DMA1_Stream3_IRQn)] = DMA1_Stream3_IRQHandler,
+    [IRQN_TO_VECTOR(DMA1_Stream5_IRQn)] = DMA1_Stream5_IRQHandler,
+    [IRQN_TO_VECTOR(DMA1_Stream6_IRQn)] = DMA1_Stream6_IRQHandler,
+    [IRQN_TO_VECTOR(EXTI9_5_IRQn)] = EXTI9_5_IRQHandler,
+    [IRQN_TO_VECTOR(TIM2_IRQn)] = TIM2_IRQHandler,
+    [IRQN_TO_VECTOR(TIM3_IRQn)] = TIM3_IRQHandler,
+    [IRQN_TO_VECTOR(TIM4_IRQn)] = TIM4_IRQHandler,
+    [IRQN_TO_VECTOR(USART1_IRQn)] = USART1_IRQHandler,
+    [IRQN_TO_VECTOR(USART2_IRQn)] = USART2_IRQHandler,
+    [IRQN_TO_VECTOR(USART3_IRQn)] = USART3_IRQHandler,
+    [IRQN_TO_VECTOR(EXTI15_10_IRQn)] = EXTI15_10_IRQHandler,
+    [IRQN_TO_VECTOR(TIM5_IRQn)] = TIM5_IRQHandler,
+    [IRQN_TO_VECTOR(USART6_IRQn)] = USART6_IRQHandler,
+};
+
+static uint32_t nvic_priority_group = 0;           /*!< Priority grouping of the NVIC */
+static uint8_t nvic_priority[NATIVE_VECTOR_COUNT]; /*!< Encoded priority of each vector */
+static bool nvic_pending[NATIVE_VECTOR_COUNT];     /*!< Pending bit of each vector (pulse sources and software) */
+static uint32_t irq_count[NATIVE_VECTOR_COUNT];    /*!< Number of ISR entries of each vector */
+static int32_t enabled_vectors[NATIVE_VECTOR_COUNT]; /*!< Enabled device vectors, the only ones checked when serving */
+static uint32_t enabled_count = 0;                 /*!< Number of elements of `enabled_vectors` */
+static bool primask = false;                       /*!< Interrupts masked by __disable_irq() */
+static bool in_handler = false;                    /*!< A handler is running (no preemption is modelled) */
+
+/* Private functions */
+/**
+ * @brief Check whether a vector is requesting service.
+ *
+ * @param vector Position in the vector table
+ * @return `true` if the vector is pending or its interrupt line is asserted
+ */
+static bool _is_requesting(int32_t vector)
+{
+    if (nvic_pending[vector])
+    {
+        return true;
+    }
+    return (vector != SYSTICK_VECTOR) && native_sim_get_irq_line(VECTOR_TO_IRQN(vector));
+}
+
+/**
+ * @brief Find the requesting vector with the highest priority (lowest value, then lowest position).
+ *
+ * @return Position in the vector table, or -1 if none is requesting
+ */
+static int32_t _find_highest_request(void)
+{
+    int32_t best = -1;
+    if (nvic_pending[SYSTICK_VECTOR] && (SysTick->CTRL & SysTick_CTRL_TICKINT_Msk))
+    {
+        best = SYSTICK_VECTOR;
+    }
+    for (uint32_t i = 0; i < enabled_count; i++)
+    {
+        int32_t vector = enabled_vectors[i];
+        if (_is_requesting(vector) &&
+            ((best < 0) || (nvic_priority[vector] < nvic_priority[best]) ||
+             ((nvic_priority[vector] == nvic_priority[best]) && (vector < best))))
+        {
+            best = vector;
+        }
+    }
+    return best;
+}
+
+/* Public functions */
+void native_hw_serve_irqs(void)
+{
+    if (primask || in_handler)
+    {
+        return;
+    }
+    in_handler = true;
+    native_sim_enter();
+    for (uint32_t served = 0; served < IRQ_STORM_LIMIT; served++)
+    {
+        int32_t vector = _find_highest_request();
+        if (vector < 0)
+        {
+            break;
+        }
+        nvic_pending[vector] = false;
+        irq_count[vector]++;
+        if (vector_table[vector] != NULL)
+        {
+            vector_table[vector]();
+        }
+        else if (vector != SYSTICK_VECTOR)
+        {
+            /* Default handler: an enabled interrupt without ISR would hang the device */
+            fprintf(stderr, "native: unhandled interrupt %d\n", (int)VECTOR_TO_IRQN(vector));
+            NVIC_DisableIRQ(VECTOR_TO_IRQN(vector));
+        }
+    }
+    native_sim_exit();
+    in_handler = false;
+}
+
+void native_hw_pend_systick(void)
+{
+    nvic_pending[SYSTICK_VECTOR] = true;
+}
+
+void native_hw_reset_registers(void)
+{
+    memset(native_gpio, 0, sizeof(native_gpio));
+    memset(native_usart, 0, sizeof(native_usart));
+    memset(&native_dma1, 0, sizeof(native_dma1));
+    memset(native_dma1_stream, 0, sizeof(native_dma1_stream));
+    memset(native_tim, 0, sizeof(native_tim));
+    memset(&native_exti, 0, sizeof(native_exti));
+    memset(&native_syscfg, 0, sizeof(native_syscfg));
+    memset(&native_rcc, 0, sizeof(native_rcc));
+    memset(&native_flash, 0, sizeof(native_flash));
+    memset(&native_pwr, 0, sizeof(native_pwr));
+    memset(&native_systick, 0, sizeof(native_systick));
+    for (uint32_t i = 0; i < NATIVE_USART_INSTANCES; i++)
+    {
+        native_usart[i].SR = USART_SR_TXE | USART_SR_TC; /* Reset value 0x00C0 */
+    }
+    memset(nvic_priority, 0, sizeof(nvic_priority));
+    memset(nvic_pending, 0, sizeof(nvic_pending));
+    memset(irq_count, 0, sizeof(irq_count));
+    enabled_count = 0;
+    nvic_priority_group = 0;
+    primask = false;
+    in_handler = false;
+}
+
+uint32_t native_sim_get_irq_count(IRQn_Type IRQn)
+{
+    return irq_count[IRQN_TO_VECTOR(IRQn)];
+}
+
+void native_sim_reset_irq_counts(void)
+{
+    memset(irq_count, 0, sizeof(irq_count));
+}
+
+//------------------------------------------------------
+// NVIC AND CORE FUNCTIONS
+//------------------------------------------------------
+void NVIC_SetPriorityGrouping(uint32_t priority_group)
+{
+    nvic_priority_group = priority_group & 0x07U;
+}
+
+uint32_t NVIC_GetPriorityGrouping(void)
+{
+    return nvic_priority_group;
+}
+
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+    nvic_priority[IRQN_TO_VECTOR(IRQn)] = (uint8_t)(priority & ((1U << __NVIC_PRIO_BITS) - 1U));
+}
+
+uint32_t NVIC_GetPriority(IRQn_Type IRQn)
+{
+    return nvic_priority[IRQN_TO_VECTOR(IRQn)];
+}
+
+uint32_t NVIC_EncodePriority(uint32_t PriorityGroup, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    uint32_t PriorityGroupTmp = (PriorityGroup & 0x07U);
+    uint32_t PreemptPriorityBits = ((7U - PriorityGroupTmp) > __NVIC_PRIO_BITS) ? __NVIC_PRIO_BITS : (7U - PriorityGroupTmp);
+    uint32_t SubPriorityBits = ((PriorityGroupTmp + __NVIC_PRIO_BITS) < 7U) ? 0U : (PriorityGroupTmp - 7U + __NVIC_PRIO_BITS);
+
+    return (((PreemptPriority & ((1UL << PreemptPriorityBits) - 1UL)) << SubPriorityBits) |
+            ((SubPriority & ((1UL << SubPriorityBits) - 1UL))));
+}
+
+void NVIC_DecodePriority(uint32_t Priority, uint32_t PriorityGroup, uint32_t *const pPreemptPriority, uint32_t *const pSubPriority)
+{
+    uint32_t PriorityGroupTmp = (PriorityGroup & 0x07U);
+    uint32_t PreemptPriorityBits = ((7U - PriorityGroupTmp) > __NVIC_PRIO_BITS) ? __NVIC_PRIO_BITS : (7U - PriorityGroupTmp);
+    uint32_t SubPriorityBits = ((PriorityGroupTmp + __NVIC_PRIO_BITS) < 7U) ? 0U : (PriorityGroupTmp - 7U + __NVIC_PRIO_BITS);
+
+    *pPreemptPriority = (Priority >> SubPriorityBits) & ((1UL << PreemptPriorityBits) - 1UL);
+    *pSubPriority = (Priority) & ((1UL << SubPriorityBits) - 1UL);
+}
+
+void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    int32_t vector = IRQN_TO_VECTOR(IRQn);
+    if (NVIC_GetEnableIRQ(IRQn))
+    {
+        return;
+    }
+    enabled_vectors[enabled_count++] = vector;
+    native_sim_sync(); /* The interrupt may already be requested */
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    int32_t vector = IRQN_TO_VECTOR(IRQn);
+    for (uint32_t i = 0; i < enabled_count; i++)
+    {
+        if (enabled_vectors[i] == vector)
+        {
+            enabled_vectors[i] = enabled_vectors[--enabled_count];
+            return;
+        }
+    }
+}
+
+uint32_t NVIC_GetEnableIRQ(IRQn_Type IRQn)
+{
+    int32_t vector = IRQN_TO_VECTOR(IRQn);
+    for (uint32_t i = 0; i < enabled_count; i++)
+    {
+        if (enabled_vectors[i] == vector)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+    nvic_pending[IRQN_TO_VECTOR(IRQn)] = true;
+    native_sim_sync();
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+    nvic_pending[IRQN_TO_VECTOR(IRQn)] = false;
+}
+
+uint32_t SysTick_Config(uint32_t ticks)
+{
+    if ((ticks - 1UL) > SysTick_LOAD_RELOAD_Msk)
+    {
+        return 1UL; /* Reload value impossible */
+    }
+    SysTick->LOAD = (uint32_t)(ticks - 1UL);
+    SysTick->VAL = 0UL;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    return 0UL;
+}
+
+void __disable_irq(void)
+{
+    primask = true;
+}
+
+void __enable_irq(void)
+{
+    primask = false;
+    native_sim_sync();
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return primask ? 1U : 0U;
+}
+
+void __set_PRIMASK(uint32_t priMask)
+{
+    if (priMask & 0x1U)
+    {
+        __disable_irq();
+    }
+    else
+    {
+        __enable_irq();
+    }
+}
+
+void __WFI(void)
+{
+    native_sim_wait_for_event();
+}
+
+uint32_t ITM_SendChar(uint32_t ch)
+{
+    putchar((int)ch);
+    return ch;
+}
+
+//------------------------------------------------------
+// REGISTERS WITH SIDE EFFECTS
+//------------------------------------------------------
+uint32_t native_hw_usart_read_dr(USART_TypeDef *p_usart)
+{
+    native_sim_enter();
+    uint32_t data = p_usart->DR;
+    p_usart->SR &= ~(USART_SR_RXNE | USART_SR_ORE | USART_SR_NE | USART_SR_FE | USART_SR_PE | USART_SR_IDLE);
+    native_sim_exit();
+    return data;
+}
+
+void native_hw_usart_write_dr(USART_TypeDef *p_usart, uint32_t data)
+{
+    native_sim_enter();
+    p_usart->SR &= ~(USART_SR_TXE | USART_SR_TC);
+    native_sim_usart_load_tdr(p_usart, data);
+    native_sim_exit();
+}
+
+void native_hw_dma_write_lifcr(DMA_TypeDef *p_dma, uint32_t mask)
+{
+    native_sim_enter();
+    p_dma->LISR &= ~mask;
+    p_dma->LIFCR = 0; /* Write-only register: it always reads 0 */
+    native_sim_exit();
+}
+
+void native_hw_dma_write_hifcr(DMA_TypeDef *p_dma, uint32_t mask)
+{
+    native_sim_enter();
+    p_dma->HISR &= ~mask;
+    p_dma->HIFCR = 0; /* Write-only register: it always reads 0 */
+    native_sim_exit();
+}
+
+void native_hw_exti_clear_pending(uint32_t mask)
+{
+    native_sim_enter();
+    EXTI->PR &= ~mask;
+    native_sim_exit();
+}
+
+void native_hw_gpio_write_bsrr(GPIO_TypeDef *p_port, uint32_t bsrr)
+{
+    p_port->ODR |= (bsrr & 0xFFFFU);
+    p_port->ODR &= ~(bsrr >> 16);
+    p_port->BSRR = 0; /* Write-only register: it always reads 0 */
+    native_sim_gpio_update(p_port);
+}
+
+void native_hw_tim_write_egr(TIM_TypeDef *p_tim, uint32_t egr)
+{
+    native_sim_enter();
+    p_tim->EGR = 0; /* The bits are cleared by hardware */
+    if (egr & TIM_EGR_UG)
+    {
+        native_sim_tim_generate_update(p_tim);
+    }
+    native_sim_exit();
+}
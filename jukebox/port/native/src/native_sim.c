@@ -0,0 +1,1061 @@
+/**
+ * @file native_sim.c
+ * @brief Virtual clock and behavioural models of the GPIO, EXTI, USART, DMA, timer and SysTick peripherals of the native platform.
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+/* HW dependent libraries */
+#include "native_hw.h"
+#include "native_sim.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define FIFO_MASK (NATIVE_SIM_USART_FIFO_LENGTH - 1U) /*!< Mask to wrap the indexes of the peer FIFOs */
+#define NS_PER_S 1000000000ULL                        /*!< Nanoseconds per second */
+#define STALL_GUARD_PERIOD_US 1000                    /*!< Host period of the stall guard */
+#define DMA_FLAG_TEIF (0x1U << 3) /*!< Transfer error flag of stream 0 */
+#define DMA_FLAG_HTIF (0x1U << 4) /*!< Half transfer flag of stream 0 */
+#define DMA_FLAG_TCIF (0x1U << 5) /*!< Transfer complete flag of stream 0 */
+#define PEER_XON 0x11U  /*!< Software flow control character that resumes the peer */
+#define PEER_XOFF 0x13U /*!< Software flow control character that stops the peer */
+#define STALL_GUARD_TICKS 2                           /*!< Periods without progress of the virtual clock to consider that the program is stalled */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief State of the model of a USART and its peer that is not visible in the registers.
+ */
+typedef struct
+{
+    uint8_t rx_fifo[NATIVE_SIM_USART_FIFO_LENGTH]; /*!< Bytes queued by the peer */
+    uint8_t rx_errors[NATIVE_SIM_USART_FIFO_LENGTH]; /*!< Line error flags (`PE`, `FE`, `NE` of SR) of each queued byte */
+    uint32_t rx_head;                              /*!< Write index of `rx_fifo` */
+    uint32_t rx_tail;                              /*!< Read index of `rx_fifo` */
+    uint64_t rx_next;                              /*!< Virtual time at which the next queued byte is completely received */
+    uint64_t idle_at;                              /*!< Virtual time at which an idle line is detected */
+    uint8_t tx_fifo[NATIVE_SIM_USART_FIFO_LENGTH]; /*!< Bytes transmitted to the peer */
+    uint32_t tx_head;                              /*!< Write index of `tx_fifo` */
+    uint32_t tx_tail;                              /*!< Read index of `tx_fifo` */
+    uint32_t tdr;                                  /*!< Transmit data register */
+    bool tdr_full;                                 /*!< `tdr` holds a byte not yet moved to the shift register */
+    uint32_t shifter;                              /*!< Byte being transmitted */
+    uint64_t tx_done;                              /*!< Virtual time at which the byte in the shift register is sent */
+    native_sim_usart_stats_t stats;                /*!< Counters of the peer */
+    uint32_t peer_flow;                            /*!< Flow control honoured by the peer (`enum NATIVE_SIM_FLOW`) */
+    GPIO_TypeDef *p_rts_port;                      /*!< GPIO port of the RTS pin of the USART */
+    uint8_t rts_pin;                               /*!< RTS pin of the USART */
+    bool peer_xoff;                                /*!< The peer received XOFF */
+    bool peer_busy;                                /*!< The peer does not accept bytes (native_sim_usart_set_peer_ready()) */
+    bool rx_waiting;                               /*!< The peer has bytes but has not started the next one because it was asked to stop */
+} native_sim_usart_t;
+
+/**
+ * @brief State of the model of a DMA stream that is not visible in the registers.
+ */
+typedef struct
+{
+    bool enabled;    /*!< The stream was enabled the last time the model looked at it */
+    uint32_t reload; /*!< Value of `NDTR` when the stream was enabled (reloaded in circular mode) */
+} native_sim_dma_stream_t;
+
+/**
+ * @brief State of the model of a timer that is not visible in the registers.
+ */
+typedef struct
+{
+    bool running;       /*!< The counter was enabled the last time the model looked at it */
+    uint64_t origin;    /*!< Virtual time at which the counter was last 0 */
+    uint64_t update_at; /*!< Virtual time of the next update event (overflow) */
+    uint32_t psc;       /*!< Active prescaler, loaded from `PSC` at each update event */
+    uint32_t arr;       /*!< Active auto-reload, loaded from `ARR` at each update event */
+    uint32_t ccr1;      /*!< Active compare value of channel 1, loaded from `CCR1` at each update event */
+    bool output;        /*!< State of the PWM output in the last logged change */
+    native_sim_tim_output_t log[NATIVE_SIM_TIM_LOG_LENGTH]; /*!< Changes of the PWM output not yet read */
+    uint32_t log_head;  /*!< Write index of `log` */
+    uint32_t log_tail;  /*!< Read index of `log` */
+} native_sim_tim_t;
+
+/* Global variables ------------------------------------------------------------*/
+static uint64_t now = 0;                             /*!< Virtual time in core clock cycles */
+static uint64_t systick_next = NATIVE_SIM_NO_EVENT;  /*!< Virtual time of the next SysTick underflow */
+static uint32_t gpio_ext_level[NATIVE_GPIO_PORTS];   /*!< External level driven on the pins of each port */
+static native_sim_usart_t usart_model[NATIVE_USART_INSTANCES]; /*!< Hidden state of the USARTs */
+static native_sim_dma_stream_t dma_model[NATIVE_DMA_STREAMS]; /*!< Hidden state of the streams of DMA1 */
+static native_sim_tim_t tim_model[NATIVE_TIM_INSTANCES]; /*!< Hidden state of the timers */
+static const uint32_t dma_flag_shift[4] = {0U, 6U, 16U, 22U}; /*!< Position of the flags of a stream in LISR/HISR (streams n and n + 4) */
+static uint32_t time_scale = 0;                      /*!< 0 for stepped time, N for N times the host clock */
+static uint64_t host_origin_ns = 0;                  /*!< Host time when the scaled mode was selected */
+static uint64_t virtual_origin = 0;                  /*!< Virtual time when the scaled mode was selected */
+static bool advancing = false;                       /*!< The clock is being advanced (avoids nested catch-ups) */
+static volatile sig_atomic_t sim_depth = 0;          /*!< Nesting of the calls into the models. The stall guard never interrupts them */
+static volatile sig_atomic_t stall_guard = 1;        /*!< The stall guard is enabled */
+static bool stall_guard_installed = false;           /*!< The host timer of the stall guard is running */
+static uint64_t stall_last_now = 0;                  /*!< Virtual time seen by the last tick of the stall guard */
+static uint32_t stall_ticks = 0;                     /*!< Consecutive ticks of the stall guard without progress of the virtual clock */
+
+/* Private functions */
+/**
+ * @brief Get the host monotonic time.
+ *
+ * @return Host time in nanoseconds
+ */
+static uint64_t _host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_S + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Get the hidden state of a USART.
+ *
+ * @param p_usart USART register block
+ * @return Pointer to the model of the USART
+ */
+static native_sim_usart_t *_usart_model(USART_TypeDef *p_usart)
+{
+    return &usart_model[p_usart - native_usart];
+}
+
+/**
+ * @brief Check whether the receiver or the transmitter of a USART is enabled.
+ *
+ * @param p_usart USART register block
+ * @param mask `USART_CR1_RE` or `USART_CR1_TE`
+ * @return `true` if the USART and the given direction are enabled
+ */
+static bool _usart_enabled(USART_TypeDef *p_usart, uint32_t mask)
+{
+    return (p_usart->CR1 & (USART_CR1_UE | mask)) == (USART_CR1_UE | mask);
+}
+
+/**
+ * @brief Set the flags of a DMA1 stream in `LISR` or `HISR`.
+ *
+ * @param stream Stream number
+ * @param flags Flags of stream 0 (`DMA_FLAG_TCIF`...) to set for the stream
+ */
+static void _dma_set_flags(uint32_t stream, uint32_t flags)
+{
+    if (stream < 4U)
+    {
+        DMA1->LISR |= flags << dma_flag_shift[stream % 4U];
+    }
+    else
+    {
+        DMA1->HISR |= flags << dma_flag_shift[stream % 4U];
+    }
+}
+
+/**
+ * @brief Find the enabled DMA1 stream that serves a USART in a direction. The channel selection is not modelled: the
+ * stream is matched by its peripheral address (`DR` of the USART) and its direction.
+ *
+ * @param p_usart USART register block
+ * @param dir `0` for peripheral to memory (reception), `DMA_SxCR_DIR_0` for memory to peripheral (transmission)
+ * @return Stream number, or -1 if no enabled stream serves the USART in that direction
+ */
+static int32_t _dma_find_stream(USART_TypeDef *p_usart, uint32_t dir)
+{
+    for (uint32_t i = 0; i < NATIVE_DMA_STREAMS; i++)
+    {
+        DMA_Stream_TypeDef *p_stream = &native_dma1_stream[i];
+        bool enabled = (p_stream->CR & DMA_SxCR_EN) != 0;
+        if (enabled && !dma_model[i].enabled)
+        {
+            dma_model[i].reload = p_stream->NDTR; /* Rising edge of EN: the model takes the programmed length */
+        }
+        dma_model[i].enabled = enabled;
+        if (enabled && (p_stream->PAR == (uintptr_t)&p_usart->DR) && ((p_stream->CR & DMA_SxCR_DIR) == dir) && (p_stream->NDTR > 0))
+        {
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Account for one item moved by a DMA1 stream: decrement `NDTR`, raise the half and complete transfer flags and
+ * reload or disable the stream at the end of the transfer.
+ *
+ * @param stream Stream number
+ */
+static void _dma_count_item(uint32_t stream)
+{
+    DMA_Stream_TypeDef *p_stream = &native_dma1_stream[stream];
+    uint32_t ndtr = --p_stream->NDTR;
+    if (ndtr == dma_model[stream].reload / 2U)
+    {
+        _dma_set_flags(stream, DMA_FLAG_HTIF);
+    }
+    if (ndtr == 0)
+    {
+        _dma_set_flags(stream, DMA_FLAG_TCIF);
+        if (p_stream->CR & DMA_SxCR_CIRC)
+        {
+            p_stream->NDTR = dma_model[stream].reload;
+        }
+        else
+        {
+            p_stream->CR &= ~DMA_SxCR_EN;
+            dma_model[stream].enabled = false;
+        }
+    }
+}
+
+/**
+ * @brief Address of the next item of a DMA1 stream in memory.
+ *
+ * @param stream Stream number
+ * @return Host pointer to the byte
+ */
+static uint8_t *_dma_memory(uint32_t stream)
+{
+    DMA_Stream_TypeDef *p_stream = &native_dma1_stream[stream];
+    uint32_t index = (p_stream->CR & DMA_SxCR_MINC) ? (dma_model[stream].reload - p_stream->NDTR) : 0U;
+    return (uint8_t *)p_stream->M0AR + index;
+}
+
+/**
+ * @brief Check if the USART asks its peer to stop sending.
+ *
+ * @param p_model Model of the USART
+ * @return `true` if the peer must not start another byte
+ */
+static bool _peer_stopped(const native_sim_usart_t *p_model)
+{
+    if ((p_model->peer_flow == NATIVE_SIM_FLOW_RTS_CTS) && (p_model->p_rts_port != NULL))
+    {
+        return (p_model->p_rts_port->IDR & (1U << p_model->rts_pin)) != 0; /* RTS is active low */
+    }
+    return (p_model->peer_flow == NATIVE_SIM_FLOW_XON_XOFF) && p_model->peer_xoff;
+}
+
+/**
+ * @brief Check if the peer lets the transmitter of the USART start a byte.
+ *
+ * @param p_usart USART register block
+ * @param p_model Model of the USART
+ * @return `false` if `CTSE` is set and the peer drives CTS high
+ */
+static bool _peer_clear_to_send(const USART_TypeDef *p_usart, const native_sim_usart_t *p_model)
+{
+    if (!(p_usart->CR3 & USART_CR3_CTSE) || (p_model->peer_flow != NATIVE_SIM_FLOW_RTS_CTS))
+    {
+        return true;
+    }
+    return !p_model->peer_busy && ((p_model->tx_head - p_model->tx_tail) < NATIVE_SIM_USART_FIFO_LENGTH);
+}
+
+/**
+ * @brief Move the transmit data register to the shift register if it is free.
+ *
+ * @param p_usart USART register block
+ */
+static void _usart_start_tx(USART_TypeDef *p_usart)
+{
+    native_sim_usart_t *p_model = _usart_model(p_usart);
+    uint32_t frame = native_sim_usart_get_frame_cycles(p_usart);
+    if (!p_model->tdr_full || (p_model->tx_done != NATIVE_SIM_NO_EVENT) || !_usart_enabled(p_usart, USART_CR1_TE) || (frame == 0) ||
+        !_peer_clear_to_send(p_usart, p_model))
+    {
+        return;
+    }
+    p_model->shifter = p_model->tdr;
+    p_model->tdr_full = false;
+    p_model->tx_done = now + frame;
+    p_usart->SR |= USART_SR_TXE;
+}
+
+/**
+ * @brief Serve the DMA requests of a transmitter: while `TXE` is set and a stream is enabled for it, load the next
+ * byte of memory into the transmit data register.
+ *
+ * @param p_usart USART register block
+ */
+static void _usart_dma_tx(USART_TypeDef *p_usart)
+{
+    while ((p_usart->CR3 & USART_CR3_DMAT) && (p_usart->SR & USART_SR_TXE) && _usart_enabled(p_usart, USART_CR1_TE))
+    {
+        int32_t stream = _dma_find_stream(p_usart, DMA_SxCR_DIR_0);
+        if (stream < 0)
+        {
+            return;
+        }
+        uint8_t data = *_dma_memory((uint32_t)stream);
+        _dma_count_item((uint32_t)stream);
+        p_usart->SR &= ~(USART_SR_TXE | USART_SR_TC);
+        native_sim_usart_load_tdr(p_usart, data);
+    }
+}
+
+/**
+ * @brief Process the events of a USART due at the current virtual time.
+ *
+ * @param p_usart USART register block
+ */
+static void _usart_process(USART_TypeDef *p_usart)
+{
+    native_sim_usart_t *p_model = _usart_model(p_usart);
+    uint32_t frame = native_sim_usart_get_frame_cycles(p_usart);
+    int32_t stream;
+
+    if ((p_model->rx_next <= now) && (p_model->rx_waiting || _peer_stopped(p_model)))
+    {
+        /* The peer checks its flow control before starting each byte, and again one frame later while it must wait */
+        p_model->rx_waiting = _peer_stopped(p_model);
+        p_model->stats.rx_waits += p_model->rx_waiting ? 1U : 0U;
+        p_model->rx_next = now + frame;
+    }
+    else if (p_model->rx_next <= now)
+    {
+        uint8_t data = p_model->rx_fifo[p_model->rx_tail & FIFO_MASK];
+        uint32_t errors = p_model->rx_errors[p_model->rx_tail & FIFO_MASK];
+        p_model->rx_tail++;
+        if (!_usart_enabled(p_usart, USART_CR1_RE))
+        {
+            p_model->stats.rx_dropped++;
+        }
+        else if ((p_usart->CR3 & USART_CR3_DMAR) && ((stream = _dma_find_stream(p_usart, 0)) >= 0))
+        {
+            *_dma_memory((uint32_t)stream) = data; /* The DMA request is served at once: RXNE is never seen set */
+            _dma_count_item((uint32_t)stream);
+            p_usart->SR |= errors; /* The errors stay set until the software reads SR and then DR */
+            p_model->stats.rx_bytes++;
+        }
+        else if (p_usart->SR & USART_SR_RXNE)
+        {
+            p_usart->SR |= USART_SR_ORE; /* The new byte is lost, DR keeps the previous one */
+            p_model->stats.rx_overruns++;
+        }
+        else
+        {
+            p_usart->DR = data;
+            p_usart->SR |= USART_SR_RXNE | errors; /* The errors are set together with RXNE */
+            p_model->stats.rx_bytes++;
+        }
+        p_model->rx_next = (p_model->rx_head != p_model->rx_tail) ? now + frame : NATIVE_SIM_NO_EVENT;
+        p_model->idle_at = (p_model->rx_next == NATIVE_SIM_NO_EVENT) ? now + frame : NATIVE_SIM_NO_EVENT;
+        p_model->rx_waiting = (p_model->rx_next != NATIVE_SIM_NO_EVENT) && _peer_stopped(p_model);
+    }
+    if (p_model->idle_at <= now)
+    {
+        p_model->idle_at = NATIVE_SIM_NO_EVENT;
+        if (_usart_enabled(p_usart, USART_CR1_RE))
+        {
+            p_usart->SR |= USART_SR_IDLE;
+        }
+    }
+    if (p_model->tx_done <= now)
+    {
+        if ((p_model->peer_flow == NATIVE_SIM_FLOW_XON_XOFF) && ((p_model->shifter == PEER_XON) || (p_model->shifter == PEER_XOFF)))
+        {
+            p_model->peer_xoff = (p_model->shifter == PEER_XOFF); /* Flow control characters are consumed by the peer */
+        }
+        else if ((p_model->tx_head - p_model->tx_tail) < NATIVE_SIM_USART_FIFO_LENGTH) /* The peer discards bytes it cannot hold */
+        {
+            p_model->tx_fifo[p_model->tx_head & FIFO_MASK] = (uint8_t)p_model->shifter;
+            p_model->tx_head++;
+        }
+        p_model->stats.tx_bytes++;
+        p_model->tx_done = NATIVE_SIM_NO_EVENT;
+        _usart_start_tx(p_usart);
+        _usart_dma_tx(p_usart);
+        if (p_model->tx_done == NATIVE_SIM_NO_EVENT)
+        {
+            p_usart->SR |= USART_SR_TC;
+        }
+    }
+}
+
+/**
+ * @brief Get the hidden state of a timer.
+ *
+ * @param p_tim Timer register block
+ * @return Pointer to the model of the timer
+ */
+static native_sim_tim_t *_tim_model(TIM_TypeDef *p_tim)
+{
+    return &tim_model[p_tim - native_tim];
+}
+
+/**
+ * @brief Get the duration of a tick of the prescaler input of TIM2 and TIM3. They are on APB1, whose timers run at twice
+ * the bus clock when the bus prescaler is not 1.
+ *
+ * @return Core clock cycles per timer clock tick
+ */
+static uint32_t _tim_clock_cycles(void)
+{
+    uint32_t ppre = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+    return (ppre & 0x4U) ? (1U << (ppre & 0x3U)) : 1U;
+}
+
+/**
+ * @brief Get the duration of a counter tick of a timer with its active prescaler.
+ *
+ * @param p_model Model of the timer
+ * @return Core clock cycles per counter tick
+ */
+static uint64_t _tim_tick_cycles(native_sim_tim_t *p_model)
+{
+    return (uint64_t)(p_model->psc + 1U) * _tim_clock_cycles();
+}
+
+/**
+ * @brief Check whether the PWM output of channel 1 of a timer is active.
+ *
+ * @param p_tim Timer register block
+ * @return `true` if the counter and the output are enabled in PWM mode 1
+ */
+static bool _tim_output_active(TIM_TypeDef *p_tim)
+{
+    return (p_tim->CR1 & TIM_CR1_CEN) && (p_tim->CCER & TIM_CCER_CC1E) &&
+           ((p_tim->CCMR1 & TIM_CCMR1_OC1M) == (TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1));
+}
+
+/**
+ * @brief Log a change of the PWM output of a timer at the current virtual time. If the log is full, the oldest change is lost.
+ *
+ * @param p_model Model of the timer
+ * @param active The output is active after the change
+ */
+static void _tim_log(native_sim_tim_t *p_model, bool active)
+{
+    native_sim_tim_output_t *p_change = &p_model->log[p_model->log_head % NATIVE_SIM_TIM_LOG_LENGTH];
+    uint64_t tick = _tim_tick_cycles(p_model);
+    uint32_t high_ticks = (p_model->ccr1 < p_model->arr + 1U) ? p_model->ccr1 : p_model->arr + 1U; /* PWM mode 1: high while CNT < CCR1 */
+    p_change->at = now;
+    p_change->period_cycles = active ? (uint32_t)((p_model->arr + 1ULL) * tick) : 0U;
+    p_change->pulse_cycles = active ? (uint32_t)(high_ticks * tick) : 0U;
+    p_model->log_head++;
+    if ((p_model->log_head - p_model->log_tail) > NATIVE_SIM_TIM_LOG_LENGTH)
+    {
+        p_model->log_tail++;
+    }
+    p_model->output = active;
+}
+
+/**
+ * @brief Start or stop the model of a timer depending on `CEN`, and log a change of its output.
+ *
+ * @param p_tim Timer register block
+ */
+static void _tim_update(TIM_TypeDef *p_tim)
+{
+    native_sim_tim_t *p_model = _tim_model(p_tim);
+    bool enabled = (p_tim->CR1 & TIM_CR1_CEN) != 0;
+    if (enabled && !p_model->running)
+    {
+        /* The counter goes on from the value of CNT */
+        p_model->running = true;
+        p_model->origin = now - (uint64_t)p_tim->CNT * _tim_tick_cycles(p_model);
+        p_model->update_at = p_model->origin + (p_model->arr + 1ULL) * _tim_tick_cycles(p_model);
+    }
+    else if (!enabled && p_model->running)
+    {
+        p_model->running = false;
+        p_tim->CNT = (uint32_t)((now - p_model->origin) / _tim_tick_cycles(p_model));
+        p_model->update_at = NATIVE_SIM_NO_EVENT;
+    }
+    bool active = _tim_output_active(p_tim);
+    if (active != p_model->output)
+    {
+        _tim_log(p_model, active);
+    }
+}
+
+/**
+ * @brief Load the preload registers of a timer into the active ones and restart its period.
+ *
+ * @param p_tim Timer register block
+ * @return `true` if the period or the pulse changed
+ */
+static bool _tim_reload(TIM_TypeDef *p_tim)
+{
+    native_sim_tim_t *p_model = _tim_model(p_tim);
+    bool changed = (p_model->psc != p_tim->PSC) || (p_model->arr != p_tim->ARR) || (p_model->ccr1 != p_tim->CCR1);
+    p_model->psc = p_tim->PSC;
+    p_model->arr = p_tim->ARR;
+    p_model->ccr1 = p_tim->CCR1;
+    p_model->origin = now;
+    p_model->update_at = p_model->running ? now + (p_model->arr + 1ULL) * _tim_tick_cycles(p_model) : NATIVE_SIM_NO_EVENT;
+    return changed;
+}
+
+/**
+ * @brief Process the update event of a timer if it is due: the counter overflows, the preload registers are loaded and
+ * `UIF` is set.
+ *
+ * @param p_tim Timer register block
+ */
+static void _tim_process(TIM_TypeDef *p_tim)
+{
+    native_sim_tim_t *p_model = _tim_model(p_tim);
+    if (!p_model->running || (p_model->update_at > now))
+    {
+        return;
+    }
+    if (_tim_reload(p_tim) && p_model->output)
+    {
+        _tim_log(p_model, true);
+    }
+    p_tim->SR |= TIM_SR_UIF;
+}
+
+/**
+ * @brief Arm or disarm the SysTick model depending on the `CTRL` register.
+ */
+static void _systick_update(void)
+{
+    bool running = (SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) != 0;
+    if (!running)
+    {
+        systick_next = NATIVE_SIM_NO_EVENT;
+    }
+    else if (systick_next == NATIVE_SIM_NO_EVENT)
+    {
+        systick_next = now + (SysTick->LOAD & SysTick_LOAD_RELOAD_Msk) + 1U;
+    }
+}
+
+/**
+ * @brief Process all the events due at the current virtual time.
+ */
+static void _process_events(void)
+{
+    if (systick_next <= now)
+    {
+        systick_next = now + (SysTick->LOAD & SysTick_LOAD_RELOAD_Msk) + 1U;
+        native_hw_pend_systick();
+    }
+    for (uint32_t i = 0; i < NATIVE_USART_INSTANCES; i++)
+    {
+        _usart_process(&native_usart[i]);
+    }
+    for (uint32_t i = 0; i < NATIVE_TIM_INSTANCES; i++)
+    {
+        _tim_process(&native_tim[i]);
+    }
+}
+
+/**
+ * @brief Advance the virtual clock up to a given time, processing the events in order.
+ *
+ * @param target Virtual time to reach
+ */
+static void _advance_to(uint64_t target)
+{
+    bool nested = advancing;
+    advancing = true;
+    native_sim_enter();
+    for (;;)
+    {
+        uint64_t next = native_sim_get_next_event();
+        if ((next == NATIVE_SIM_NO_EVENT) || (next > target))
+        {
+            break;
+        }
+        if (next > now)
+        {
+            now = next;
+        }
+        _process_events();
+        native_hw_serve_irqs();
+    }
+    if (target > now)
+    {
+        now = target;
+    }
+    native_hw_serve_irqs();
+    native_sim_exit();
+    advancing = nested;
+}
+
+/**
+ * @brief Sleep on the host until a given host time. The sleep is resumed if a signal interrupts it.
+ *
+ * @param due_ns Host time in nanoseconds
+ */
+static void _host_sleep_until(uint64_t due_ns)
+{
+    struct timespec ts = {.tv_sec = (time_t)(due_ns / NS_PER_S), .tv_nsec = (long)(due_ns % NS_PER_S)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    {
+    }
+}
+
+/**
+ * @brief Tick of the stall guard, called by the host timer as an asynchronous signal.
+ *
+ * On the device, a loop such as `while (!flag) {}` ends because an interrupt preempts it. On the stepped virtual clock
+ * nothing happens unless the program waits, so such a loop would never end. If the virtual clock has not advanced for
+ * `STALL_GUARD_TICKS` periods, the guard advances it to the next event and serves the interrupts, as `__WFI()` does. In
+ * scaled mode, it catches up with the host clock at every tick. The guard never interrupts a call into the models.
+ *
+ * @param signum Signal number (unused)
+ */
+static void _stall_guard_tick(int signum)
+{
+    (void)signum;
+    if (!stall_guard || (sim_depth > 0))
+    {
+        return;
+    }
+    int saved_errno = errno;
+    if (time_scale > 0)
+    {
+        native_sim_sync();
+    }
+    else if (now != stall_last_now)
+    {
+        stall_ticks = 0;
+    }
+    else if (++stall_ticks >= STALL_GUARD_TICKS)
+    {
+        native_sim_wait_for_event();
+    }
+    stall_last_now = now;
+    errno = saved_errno;
+}
+
+/**
+ * @brief Start the host timer of the stall guard.
+ */
+static void _stall_guard_install(void)
+{
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = _stall_guard_tick;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGALRM, &sa, NULL);
+
+    struct itimerval period = {.it_interval = {.tv_sec = 0, .tv_usec = STALL_GUARD_PERIOD_US},
+                               .it_value = {.tv_sec = 0, .tv_usec = STALL_GUARD_PERIOD_US}};
+    setitimer(ITIMER_REAL, &period, NULL);
+    stall_guard_installed = true;
+}
+
+/* Public functions */
+void native_sim_reset(void)
+{
+    native_sim_enter();
+    native_hw_reset_registers();
+    memset(usart_model, 0, sizeof(usart_model));
+    memset(dma_model, 0, sizeof(dma_model));
+    memset(tim_model, 0, sizeof(tim_model));
+    for (uint32_t i = 0; i < NATIVE_USART_INSTANCES; i++)
+    {
+        usart_model[i].rx_next = NATIVE_SIM_NO_EVENT;
+        usart_model[i].idle_at = NATIVE_SIM_NO_EVENT;
+        usart_model[i].tx_done = NATIVE_SIM_NO_EVENT;
+    }
+    for (uint32_t i = 0; i < NATIVE_TIM_INSTANCES; i++)
+    {
+        tim_model[i].update_at = NATIVE_SIM_NO_EVENT;
+    }
+    for (uint32_t i = 0; i < NATIVE_GPIO_PORTS; i++)
+    {
+        gpio_ext_level[i] = 0xFFFFU;
+        native_gpio[i].IDR = gpio_ext_level[i];
+    }
+    now = 0;
+    systick_next = NATIVE_SIM_NO_EVENT;
+    virtual_origin = 0;
+    host_origin_ns = _host_ns();
+    stall_last_now = 0;
+    stall_ticks = 0;
+    stall_guard = 1;
+    if (!stall_guard_installed)
+    {
+        _stall_guard_install();
+    }
+    native_sim_exit();
+}
+
+void native_sim_set_stall_guard(bool enable)
+{
+    stall_guard = enable ? 1 : 0;
+}
+
+void native_sim_enter(void)
+{
+    sim_depth++;
+}
+
+void native_sim_exit(void)
+{
+    sim_depth--;
+}
+
+uint64_t native_sim_get_cycles(void)
+{
+    return now;
+}
+
+uint64_t native_sim_get_us(void)
+{
+    return now / NATIVE_SIM_CYCLES_PER_US;
+}
+
+void native_sim_advance_cycles(uint64_t cycles)
+{
+    _advance_to(now + cycles);
+}
+
+void native_sim_advance_us(uint64_t us)
+{
+    native_sim_advance_cycles(us * NATIVE_SIM_CYCLES_PER_US);
+}
+
+void native_sim_advance_ms(uint32_t ms)
+{
+    native_sim_advance_cycles((uint64_t)ms * NATIVE_SIM_CYCLES_PER_MS);
+}
+
+uint64_t native_sim_get_next_event(void)
+{
+    _systick_update();
+    uint64_t next = systick_next;
+    for (uint32_t i = 0; i < NATIVE_USART_INSTANCES; i++)
+    {
+        native_sim_usart_t *p_model = &usart_model[i];
+        _usart_start_tx(&native_usart[i]);
+        _usart_dma_tx(&native_usart[i]); /* A stream may have been enabled since the last event */
+        if (p_model->rx_next < next)
+        {
+            next = p_model->rx_next;
+        }
+        if (p_model->idle_at < next)
+        {
+            next = p_model->idle_at;
+        }
+        if (p_model->tx_done < next)
+        {
+            next = p_model->tx_done;
+        }
+    }
+    for (uint32_t i = 0; i < NATIVE_TIM_INSTANCES; i++)
+    {
+        _tim_update(&native_tim[i]); /* A counter or an output may have been enabled since the last event */
+        if (tim_model[i].update_at < next)
+        {
+            next = tim_model[i].update_at;
+        }
+    }
+    return next;
+}
+
+bool native_sim_wait_for_event(void)
+{
+    uint64_t next = native_sim_get_next_event();
+    if (next == NATIVE_SIM_NO_EVENT)
+    {
+        return false;
+    }
+    if (time_scale > 0)
+    {
+        /* Sleep on the host until the event is due in scaled host time */
+        uint64_t due_ns = host_origin_ns + ((next - virtual_origin) * NS_PER_S) / ((uint64_t)NATIVE_CORE_CLOCK_HZ * time_scale);
+        _host_sleep_until(due_ns);
+    }
+    _advance_to(next);
+    return true;
+}
+
+void native_sim_set_time_scale(uint32_t scale)
+{
+    time_scale = scale;
+    host_origin_ns = _host_ns();
+    virtual_origin = now;
+}
+
+void native_sim_sync(void)
+{
+    native_sim_enter();
+    if ((time_scale > 0) && !advancing)
+    {
+        uint64_t elapsed_ns = _host_ns() - host_origin_ns;
+        uint64_t target = virtual_origin + (elapsed_ns * time_scale * (NATIVE_CORE_CLOCK_HZ / 1000000U)) / 1000U;
+        _advance_to(target);
+    }
+    else
+    {
+        native_hw_serve_irqs();
+    }
+    native_sim_exit();
+}
+
+//------------------------------------------------------
+// GPIO AND EXTI MODEL
+//------------------------------------------------------
+void native_sim_gpio_update(GPIO_TypeDef *p_port)
+{
+    native_sim_enter();
+    uint32_t port_index = (uint32_t)(p_port - native_gpio);
+    uint32_t output_mask = 0;
+    for (uint32_t pin = 0; pin < 16; pin++)
+    {
+        if (((p_port->MODER >> (pin * 2U)) & GPIO_MODER_MODER0) == 0x01U)
+        {
+            output_mask |= (1U << pin);
+        }
+    }
+    uint32_t prev = p_port->IDR;
+    uint32_t curr = ((p_port->ODR & output_mask) | (gpio_ext_level[port_index] & ~output_mask)) & 0xFFFFU;
+    p_port->IDR = curr;
+
+    /* Edge detection on the EXTI lines connected to this port */
+    uint32_t changed = prev ^ curr;
+    for (uint32_t line = 0; changed != 0; line++, changed >>= 1)
+    {
+        if (!(changed & 0x1U))
+        {
+            continue;
+        }
+        uint32_t selected_port = (SYSCFG->EXTICR[line / 4] >> ((line % 4) * 4)) & 0xFU;
+        uint32_t mask = 1U << line;
+        bool rising = (curr & mask) != 0;
+        if ((selected_port == port_index) && (EXTI->IMR & mask) &&
+            ((rising && (EXTI->RTSR & mask)) || (!rising && (EXTI->FTSR & mask))))
+        {
+            EXTI->PR |= mask;
+        }
+    }
+    native_sim_sync();
+    native_sim_exit();
+}
+
+void native_sim_gpio_set_input(GPIO_TypeDef *p_port, uint8_t pin, bool level)
+{
+    uint32_t port_index = (uint32_t)(p_port - native_gpio);
+    if (level)
+    {
+        gpio_ext_level[port_index] |= (1U << pin);
+    }
+    else
+    {
+        gpio_ext_level[port_index] &= ~(1U << pin);
+    }
+    native_sim_gpio_update(p_port);
+}
+
+//------------------------------------------------------
+// USART MODEL
+//------------------------------------------------------
+uint32_t native_sim_usart_get_frame_cycles(USART_TypeDef *p_usart)
+{
+    uint32_t brr = p_usart->BRR & 0xFFFFU;
+    uint32_t cycles_per_bit = brr; /* In cycles of the APB clock of the USART */
+    if (p_usart->CR1 & USART_CR1_OVER8)
+    {
+        cycles_per_bit = ((brr >> 4) * 8U) + (brr & 0x7U);
+    }
+    /* USART1 and USART6 are on APB2, USART2 and USART3 on APB1; prescalers 0xx divide by 1 and 1xx by 2 to 16 */
+    uint32_t ppre = ((p_usart == USART1) || (p_usart == USART6)) ? ((RCC->CFGR & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos)
+                                                                 : ((RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos);
+    if (ppre & 0x4U)
+    {
+        cycles_per_bit <<= (ppre & 0x3U) + 1U;
+    }
+    uint32_t data_bits = (p_usart->CR1 & USART_CR1_M) ? 9U : 8U; /* Includes the parity bit if enabled */
+    uint32_t stop_bits = (((p_usart->CR2 & USART_CR2_STOP) >> 12) == 0x2U) ? 2U : 1U;
+    return cycles_per_bit * (1U + data_bits + stop_bits);
+}
+
+uint32_t native_sim_usart_inject_rx(USART_TypeDef *p_usart, const uint8_t *p_data, uint32_t length)
+{
+    native_sim_enter();
+    native_sim_usart_t *p_model = _usart_model(p_usart);
+    uint32_t accepted = 0;
+    bool was_empty = (p_model->rx_head == p_model->rx_tail);
+    while ((accepted < length) && ((p_model->rx_head - p_model->rx_tail) < NATIVE_SIM_USART_FIFO_LENGTH))
+    {
+        p_model->rx_fifo[p_model->rx_head & FIFO_MASK] = p_data[accepted++];
+        p_model->rx_errors[p_model->rx_head & FIFO_MASK] = 0;
+        p_model->rx_head++;
+    }
+    p_model->stats.rx_dropped += length - accepted;
+    if (was_empty && (accepted > 0))
+    {
+        p_model->rx_next = now + native_sim_usart_get_frame_cycles(p_usart);
+        p_model->idle_at = NATIVE_SIM_NO_EVENT;
+        p_model->rx_waiting = _peer_stopped(p_model);
+    }
+    native_sim_exit();
+    return accepted;
+}
+
+bool native_sim_usart_inject_rx_error(USART_TypeDef *p_usart, uint8_t data, uint32_t errors)
+{
+    native_sim_usart_t *p_model = _usart_model(p_usart);
+    if (native_sim_usart_inject_rx(p_usart, &data, 1) == 0)
+    {
+        return false;
+    }
+    p_model->rx_errors[(p_model->rx_head - 1U) & FIFO_MASK] = (uint8_t)(errors & (USART_SR_PE | USART_SR_FE | USART_SR_NE));
+    return true;
+}
+
+void native_sim_usart_set_peer_flow(USART_TypeDef *p_usart, uint32_t flow, GPIO_TypeDef *p_rts_port, uint8_t rts_pin)
+{
+    native_sim_enter();
+    native_sim_usart_t *p_model = _usart_model(p_usart);
+    p_model->peer_flow = flow;
+    p_model->p_rts_port = p_rts_port;
+    p_model->rts_pin = rts_pin;
+    p_model->peer_xoff = false;
+    _usart_start_tx(p_usart);
+    native_sim_exit();
+}
+
+void native_sim_usart_set_peer_ready(USART_TypeDef *p_usart, bool ready)
+{
+    native_sim_enter();
+    _usart_model(p_usart)->peer_busy = !ready;
+    _usart_start_tx(p_usart);
+    native_sim_sync();
+    native_sim_exit();
+}
+
+uint32_t native_sim_usart_get_rx_pending(USART_TypeDef *p_usart)
+{
+    native_sim_usart_t *p_model = _usart_model(p_usart);
+    return p_model->rx_head - p_model->rx_tail;
+}
+
+uint32_t native_sim_usart_read_tx(USART_TypeDef *p_usart, uint8_t *p_data, uint32_t max_length)
+{
+    native_sim_enter();
+    native_sim_usart_t *p_model = _usart_model(p_usart);
+    uint32_t copied = 0;
+    while ((copied < max_length) && (p_model->tx_tail != p_model->tx_head))
+    {
+        p_data[copied++] = p_model->tx_fifo[p_model->tx_tail & FIFO_MASK];
+        p_model->tx_tail++;
+    }
+    _usart_start_tx(p_usart); /* A peer that was full lets the transmitter go on */
+    native_sim_sync();
+    native_sim_exit();
+    return copied;
+}
+
+void native_sim_usart_get_stats(USART_TypeDef *p_usart, native_sim_usart_stats_t *p_stats)
+{
+    *p_stats = _usart_model(p_usart)->stats;
+}
+
+void native_sim_usart_load_tdr(USART_TypeDef *p_usart, uint32_t data)
+{
+    native_sim_usart_t *p_model = _usart_model(p_usart);
+    p_model->tdr = data;
+    p_model->tdr_full = true;
+    native_sim_enter();
+    _usart_start_tx(p_usart);
+    native_sim_exit();
+}
+
+//------------------------------------------------------
+// TIMER MODEL
+//------------------------------------------------------
+void native_sim_tim_generate_update(TIM_TypeDef *p_tim)
+{
+    native_sim_enter();
+    native_sim_tim_t *p_model = _tim_model(p_tim);
+    _tim_update(p_tim);
+    _tim_reload(p_tim);
+    p_tim->CNT = 0;
+    if (!(p_tim->CR1 & TIM_CR1_URS))
+    {
+        p_tim->SR |= TIM_SR_UIF;
+    }
+    if (p_model->output)
+    {
+        _tim_log(p_model, true); /* The waveform restarts even if the period is the same */
+    }
+    native_sim_sync();
+    native_sim_exit();
+}
+
+uint32_t native_sim_tim_read_output(TIM_TypeDef *p_tim, native_sim_tim_output_t *p_changes, uint32_t max_length)
+{
+    native_sim_enter();
+    native_sim_tim_t *p_model = _tim_model(p_tim);
+    _tim_update(p_tim);
+    uint32_t copied = 0;
+    while ((copied < max_length) && (p_model->log_tail != p_model->log_head))
+    {
+        p_changes[copied++] = p_model->log[p_model->log_tail % NATIVE_SIM_TIM_LOG_LENGTH];
+        p_model->log_tail++;
+    }
+    native_sim_exit();
+    return copied;
+}
+
+//------------------------------------------------------
+// INTERRUPT LINES
+//------------------------------------------------------
+bool native_sim_get_irq_line(IRQn_Type IRQn)
+{
+    USART_TypeDef *p_usart;
+    uint32_t stream;
+    switch (IRQn)
+    {
+    case DMA1_Stream1_IRQn:
+    case DMA1_Stream3_IRQn:
+    case DMA1_Stream5_IRQn:
+    case DMA1_Stream6_IRQn:
+    {
+        stream = (uint32_t)(IRQn - DMA1_Stream1_IRQn) + 1U; /* Streams 0 to 6 have consecutive interrupts */
+        uint32_t flags = (((stream < 4U) ? DMA1->LISR : DMA1->HISR) >> dma_flag_shift[stream % 4U]);
+        uint32_t cr = native_dma1_stream[stream].CR;
+        return ((flags & DMA_FLAG_TCIF) && (cr & DMA_SxCR_TCIE)) ||
+               ((flags & DMA_FLAG_HTIF) && (cr & DMA_SxCR_HTIE)) ||
+               ((flags & DMA_FLAG_TEIF) && (cr & DMA_SxCR_TEIE));
+    }
+    case EXTI0_IRQn:
+    case EXTI1_IRQn:
+    case EXTI2_IRQn:
+    case EXTI3_IRQn:
+    case EXTI4_IRQn:
+        return (EXTI->PR & EXTI->IMR & (1U << (IRQn - EXTI0_IRQn))) != 0;
+    case EXTI9_5_IRQn:
+        return (EXTI->PR & EXTI->IMR & 0x03E0U) != 0;
+    case EXTI15_10_IRQn:
+        return (EXTI->PR & EXTI->IMR & 0xFC00U) != 0;
+    case USART1_IRQn:
+        p_usart = USART1;
+        break;
+    case USART2_IRQn:
+        p_usart = USART2;
+        break;
+    case USART3_IRQn:
+        p_usart = USART3;
+        break;
+    case USART6_IRQn:
+        p_usart = USART6;
+        break;
+    case TIM2_IRQn:
+        return (TIM2->SR & TIM2->DIER & TIM_SR_UIF) != 0;
+    case TIM3_IRQn:
+        return (TIM3->SR & TIM3->DIER & TIM_SR_UIF) != 0;
+    default:
+        return false;
+    }
+    uint32_t sr = p_usart->SR;
+    uint32_t cr1 = p_usart->CR1;
+    return ((sr & (USART_SR_RXNE | USART_SR_ORE)) && (cr1 & USART_CR1_RXNEIE)) ||
+           ((sr & USART_SR_TXE) && (cr1 & USART_CR1_TXEIE)) ||
+           ((sr & USART_SR_TC) && (cr1 & USART_CR1_TCIE)) ||
+           ((sr & USART_SR_IDLE) && (cr1 & USART_CR1_IDLEIE)) ||
+           ((sr & USART_SR_PE) && (cr1 & USART_CR1_PEIE)) ||
+           ((sr & (USART_SR_FE | USART_SR_NE | USART_SR_ORE)) && (p_usart->CR3 & USART_CR3_EIE) && (p_usart->CR3 & USART_CR3_DMAR));
+}
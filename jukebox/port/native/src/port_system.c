@@ -0,0 +1,285 @@
+/**
+ * @file port_system.c
+ * @brief File that defines the functions that are related to the access to the (simulated) HW of the microcontroller.
+ *
+ * The functions have the same behaviour as in `port/stm32f4`, but they operate on the register blocks of
+ * `native_hw.h`. Waiting functions put the core to sleep (`__WFI()`), which advances the virtual clock.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "port_system.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define HSI_VALUE ((uint32_t)NATIVE_CORE_CLOCK_HZ) /*!< Value of the Internal oscillator in Hz */
+
+/* GLOBAL VARIABLES */
+static volatile uint32_t events_pending = 0; /*!< Events posted by the ISRs and not yet taken by the main loop */
+static volatile uint32_t msTicks = 0; /*!< Variable to store millisecond ticks. @warning **It must be declared volatile!** Just because it is modified in an ISR. */
+
+uint32_t SystemCoreClock = HSI_VALUE;                                               /*!< Frequency of the System clock */
+const uint8_t AHBPrescTable[16] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 6, 7, 8, 9}; /*!< Prescaler values for AHB bus */
+const uint8_t APBPrescTable[8] = {0, 0, 0, 0, 1, 2, 3, 4};                          /*!< Prescaler values for APB bus */
+
+//------------------------------------------------------
+// SYSTEM CONFIGURATION
+//------------------------------------------------------
+/**
+ * @brief System Clock Configuration
+ *
+ * @attention This function should NOT be accesible from the outside to avoid configuration problems.
+ * @note This function starts a system timer that generates a SysTick every 1 ms.
+ * @retval None
+ */
+static void system_clock_config(void)
+{
+  /* Power controller (PWR) */
+  PWR->CR &= ~PWR_CR_VOS; // Clean and set value
+  PWR->CR |= (PWR_CR_VOS & (POWER_REGULATOR_VOLTAGE_SCALE3 << PWR_CR_VOS_Pos));
+
+  /* Adjusts the Internal High Speed oscillator (HSI) calibration value.*/
+  RCC->CR &= ~RCC_CR_HSITRIM; // Clean and set value
+  RCC->CR |= (RCC_CR_HSITRIM & (RCC_HSI_CALIBRATION_DEFAULT << RCC_CR_HSITRIM_Pos));
+
+  FLASH->ACR = FLASH_ACR_LATENCY_2WS; /* Program the new number of wait states to the LATENCY bits in the FLASH_ACR register */
+
+  RCC->CFGR &= ~RCC_CFGR_SW; // Clean and set value
+  RCC->CFGR |= (RCC_CFGR_SW & (RCC_CFGR_SW_HSI << RCC_CFGR_SW_Pos));
+
+  /* Update the SystemCoreClock global variable */
+  SystemCoreClock = HSI_VALUE >> AHBPrescTable[(RCC->CFGR & RCC_CFGR_HPRE) >> RCC_CFGR_HPRE_Pos];
+
+  /* Configure the source of time base considering new system clocks settings */
+  SysTick_Config(SystemCoreClock / (1000U / TICK_FREQ_1KHZ)); /* Set Systick to 1 ms */
+}
+
+size_t port_system_init()
+{
+  /* Power-on reset of the simulated peripherals and of the virtual clock */
+  native_sim_reset();
+  msTicks = 0;
+
+  /* Configure Flash prefetch, Instruction cache, Data cache */
+  FLASH->ACR |= FLASH_ACR_ICEN;
+  FLASH->ACR |= FLASH_ACR_DCEN;
+  FLASH->ACR |= FLASH_ACR_PRFTEN;
+
+  /* Set Interrupt Group Priority */
+  NVIC_SetPriorityGrouping(NVIC_PRIORITY_GROUP_4);
+
+  /* Configure the SysTick IRQ priority. It must be the highest (lower number: 0)*/
+  NVIC_SetPriority(SysTick_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0U, 0U)); /* Tick interrupt priority */
+
+  RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN; /* Syscfg clock enabling */
+  RCC->APB1ENR |= RCC_APB1ENR_PWREN;    /* PWREN: Power interface clock enable */
+
+  /* Configure the system clock */
+  system_clock_config();
+
+  return 0;
+}
+
+//------------------------------------------------------
+// TIMER RELATED FUNCTIONS
+//------------------------------------------------------
+uint32_t port_system_get_millis()
+{
+  native_sim_sync();
+  return msTicks;
+}
+
+void port_system_set_millis(uint32_t ms)
+{
+  msTicks = ms;
+}
+
+uint32_t port_system_get_apb1_clock(void)
+{
+  return SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+}
+
+uint32_t port_system_get_apb2_clock(void)
+{
+  return SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos];
+}
+
+uint32_t port_system_itm_write(const uint8_t *p_data, uint32_t length)
+{
+  for (uint32_t i = 0; i < length; i++) /* The simulated stimulus port is never full */
+  {
+    ITM_SendChar(p_data[i]);
+  }
+  return length;
+}
+
+void port_system_delay_ms(uint32_t ms)
+{
+  uint32_t tickstart = port_system_get_millis();
+
+  while ((port_system_get_millis() - tickstart) < ms)
+  {
+    __WFI(); /* Advance the virtual clock to the next SysTick */
+  }
+}
+
+void port_system_delay_until_ms(uint32_t *p_t, uint32_t ms)
+{
+  uint32_t until = *p_t + ms;
+  uint32_t now = port_system_get_millis();
+  if (until > now)
+  {
+    port_system_delay_ms(until - now);
+  }
+  *p_t = port_system_get_millis();
+}
+
+//------------------------------------------------------
+// EVENT RELATED FUNCTIONS
+//------------------------------------------------------
+void port_system_post_event(uint32_t event)
+{
+  __atomic_fetch_or(&events_pending, 1U << event, __ATOMIC_RELAXED);
+}
+
+uint32_t port_system_take_events(void)
+{
+  return __atomic_exchange_n(&events_pending, 0U, __ATOMIC_RELAXED);
+}
+
+void port_system_sleep_until_event(void)
+{
+  __disable_irq();
+  if (events_pending == 0)
+  {
+    __WFI(); /* Wakes up on the pending interrupt even if it is masked */
+  }
+  __enable_irq();
+}
+
+uint32_t port_system_enter_critical(void)
+{
+  uint32_t state = __get_PRIMASK();
+  __disable_irq();
+  return state;
+}
+
+void port_system_exit_critical(uint32_t state)
+{
+  __set_PRIMASK(state);
+}
+
+//------------------------------------------------------
+// GPIO RELATED FUNCTIONS
+//------------------------------------------------------
+void port_system_gpio_config(GPIO_TypeDef *p_port, uint8_t pin, uint8_t mode, uint8_t pupd)
+{
+  if (p_port == GPIOA)
+  {
+    RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN; /* GPIOA_CLK_ENABLE */
+  }
+  else if (p_port == GPIOB)
+  {
+    RCC->AHB1ENR |= RCC_AHB1ENR_GPIOBEN; /* GPIOB_CLK_ENABLE */
+  }
+  else if (p_port == GPIOC)
+  {
+    RCC->AHB1ENR |= RCC_AHB1ENR_GPIOCEN; /* GPIOC_CLK_ENABLE */
+  }
+
+  /* Clean ( &=~ ) by displacing the base register and set the configuration ( |= ) */
+  p_port->MODER &= ~(GPIO_MODER_MODER0 << (pin * 2U));
+  p_port->MODER |= (mode << (pin * 2U));
+
+  p_port->PUPDR &= ~(GPIO_PUPDR_PUPD0 << (pin * 2U));
+  p_port->PUPDR |= (pupd << (pin * 2U));
+
+  native_sim_gpio_update(p_port); /* The input data register depends on the mode */
+}
+
+void port_system_gpio_config_exti(GPIO_TypeDef *p_port, uint8_t pin, uint32_t mode)
+{
+  uint32_t port_selector = (uint32_t)(p_port - GPIOA); /* GPIOA: 0, GPIOB: 1, GPIOC: 2, ... */
+
+  RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;
+
+  /* SYSCFG external interrupt configuration register */
+  uint32_t base_mask = 0x0FU;
+  uint32_t displacement = (pin % 4) * 4;
+
+  SYSCFG->EXTICR[pin / 4] &= ~(base_mask << displacement);
+  SYSCFG->EXTICR[pin / 4] |= (port_selector << displacement);
+
+  /* Rising trigger selection register (EXTI_RTSR) */
+  EXTI->RTSR &= ~BIT_POS_TO_MASK(pin);
+  if (mode & TRIGGER_RISING_EDGE)
+  {
+    EXTI->RTSR |= BIT_POS_TO_MASK(pin);
+  }
+
+  /* Falling trigger selection register (EXTI_FTSR) */
+  EXTI->FTSR &= ~BIT_POS_TO_MASK(pin);
+  if (mode & TRIGGER_FALLING_EDGE)
+  {
+    EXTI->FTSR |= BIT_POS_TO_MASK(pin);
+  }
+
+  /* Event mask register (EXTI_EMR) */
+  EXTI->EMR &= ~BIT_POS_TO_MASK(pin);
+  if (mode & TRIGGER_ENABLE_EVENT_REQ)
+  {
+    EXTI->EMR |= BIT_POS_TO_MASK(pin);
+  }
+
+  /* Clear EXTI line configuration */
+  EXTI->IMR &= ~BIT_POS_TO_MASK(pin);
+
+  /* Interrupt mask register (EXTI_IMR) */
+  if (mode & TRIGGER_ENABLE_INTERR_REQ)
+  {
+    EXTI->IMR |= BIT_POS_TO_MASK(pin);
+  }
+}
+
+void port_system_gpio_exti_enable(uint8_t pin, uint8_t priority, uint8_t subpriority)
+{
+  NVIC_SetPriority(GET_PIN_IRQN(pin), NVIC_EncodePriority(NVIC_GetPriorityGrouping(), priority, subpriority));
+  NVIC_EnableIRQ(GET_PIN_IRQN(pin));
+}
+
+void port_system_gpio_exti_disable(uint8_t pin)
+{
+  NVIC_DisableIRQ(GET_PIN_IRQN(pin));
+}
+
+void port_system_gpio_config_alternate(GPIO_TypeDef *p_port, uint8_t pin, uint8_t alternate)
+{
+  uint32_t base_mask = 0x0FU;
+  uint32_t displacement = (pin % 8) * 4;
+
+  p_port->AFR[(uint8_t)(pin / 8)] &= ~(base_mask << displacement);
+  p_port->AFR[(uint8_t)(pin / 8)] |= (alternate << displacement);
+}
+
+bool port_system_gpio_read(GPIO_TypeDef *p_port, uint8_t pin)
+{
+  return (p_port->IDR & BIT_POS_TO_MASK(pin)) != 0;
+}
+
+void port_system_gpio_write(GPIO_TypeDef *p_port, int8_t pin, bool value)
+{
+  if (value == true)
+  {
+    native_hw_gpio_write_bsrr(p_port, BIT_POS_TO_MASK(pin)); /* Set the pin through the bit set/reset register */
+  }
+  else
+  {
+    native_hw_gpio_write_bsrr(p_port, BIT_POS_TO_MASK(pin) << 16); /* Reset the pin through the bit set/reset register */
+  }
+}
+
+void port_system_gpio_toggle(GPIO_TypeDef *p_port, uint8_t pin)
+{
+  port_system_gpio_write(p_port, pin, !port_system_gpio_read(p_port, pin));
+}
@@ -18,11 +18,27 @@
 #define BUTTON_0_GPIO GPIOC
 #define BUTTON_0_PIN 13
 #define BUTTON_0_DEBOUNCE_TIME_MS 150
+#define BUTTON_0_EVENT 1 /*!< Evento que publica la ISR de EXTI cuando cambia el botón */
 
 /* HW dependent includes */
 
 /* Defines and enums ----------------------------------------------------------*/
 /* Defines */
+#define PORT_BUTTON_EXTI_LINES 16 /*!< Número de líneas EXTI de GPIO; como mucho un botón por línea */
+#define PORT_BUTTON_MAX_BUTTONS PORT_BUTTON_EXTI_LINES /*!< Tamaño de la tabla de botones */
+#define PORT_BUTTON_EXTI_LINES_9_5 0x03E0U /*!< Líneas servidas por EXTI9_5_IRQHandler() */
+#define PORT_BUTTON_EXTI_LINES_15_10 0xFC00U /*!< Líneas servidas por EXTI15_10_IRQHandler() */
+#define PORT_BUTTON_SAMPLE_PERIOD_MS 5 /*!< Periodo de muestreo en modo `PORT_BUTTON_DEBOUNCE_SAMPLED` (filtro de 4 muestras: 20 ms) */
+
+/* Enums */
+/**
+ * @brief Modos de detección de los botones.
+ */
+enum PORT_BUTTON_DEBOUNCE_MODE
+{
+    PORT_BUTTON_DEBOUNCE_EXTI = 0, /*!< Una interrupción EXTI por flanco; el anti-rebote lo hace `fsm_button` con su temporizador */
+    PORT_BUTTON_DEBOUNCE_SAMPLED   /*!< Sin interrupciones EXTI; el SysTick muestrea todos los botones y los filtra con contadores verticales */
+};
 
 /* Typedefs --------------------------------------------------------------------*/
 typedef struct
@@ -30,17 +46,24 @@ typedef struct
     GPIO_TypeDef *p_port; /**< Puntero al puerto GPIO del botón */
     uint8_t pin; /**< Número de pin del botón */
     bool flag_pressed; /**< Indicador de si el botón está presionado */
+    bool active_low; /**< El botón está presionado cuando el pin está a nivel bajo */
+    uint32_t edge_tick; /**< Tick del sistema del último cambio, tomado en la ISR */
+    uint8_t event; /**< Evento que se publica cuando el botón necesita atención */
 } port_button_hw_t;
 
 
 /* Global variables */
-extern port_button_hw_t buttons_arr[]; /**< Array de los botones */
+extern port_button_hw_t buttons_arr[PORT_BUTTON_MAX_BUTTONS]; /**< Array de los botones, indexado por su identificador */
 /* Function prototypes and explanation -------------------------------------------------*/
 /**
  * @brief Inicializa el botón especificado.
+ *
+ * Cada línea EXTI sólo puede tener un botón: si otro botón ya usa un pin con el mismo número (de cualquier puerto), el
+ * botón no se inicializa. Volver a inicializar el mismo botón está permitido.
  * @param button_id es el identificador del botón a inicializar.
+ * @return `true` si el botón se ha inicializado, `false` si la línea EXTI de su pin ya es de otro botón.
  */
-void 	port_button_init (uint32_t button_id);
+bool 	port_button_init (uint32_t button_id);
 /**
  * @brief Verifica si el botón especificado está presionado.
  * @param button_id ID del botón a verificar.
@@ -52,4 +75,52 @@ bool 	port_button_is_pressed (uint32_t button_id);
  * @return Valor actual del contador de ticks.
  */
 uint32_t port_button_get_tick ();
+/**
+ * @brief Obtiene el evento que despierta a la FSM del botón (flancos en la EXTI y vencimiento de sus temporizadores).
+ * @param button_id ID del botón.
+ * @return Identificador del evento para `port_system_post_event()`.
+ */
+uint32_t port_button_get_event(uint32_t button_id);
+/**
+ * @brief Obtiene el tick del sistema del último cambio del botón, tomado en la ISR que lo detectó.
+ * @param button_id ID del botón.
+ * @return Tick (en ms) del último flanco (modo EXTI) o del último cambio filtrado (modo muestreado).
+ */
+uint32_t port_button_get_edge_tick(uint32_t button_id);
+/**
+ * @brief Atiende las líneas EXTI de botones pendientes de un grupo de líneas.
+ *
+ * Lee una sola vez el registro pendiente, limpia las líneas que va a atender y las recorre con count-trailing-zeros, de
+ * modo que el coste depende del número de líneas activas y no del número de botones. El nivel de cada pin se toma del
+ * registro `IDR` (una lectura por puerto, no por flanco), no del registro pendiente.
+ * @warning This function must be used only by the EXTI ISRs in file `interr.c`.
+ * @param lines Máscara de líneas EXTI que sirve la ISR que llama.
+ */
+void port_button_exti_isr(uint32_t lines);
+/**
+ * @brief Selecciona el modo de detección de todos los botones inicializados.
+ *
+ * En modo `PORT_BUTTON_DEBOUNCE_SAMPLED` se deshabilitan las peticiones de interrupción de las líneas EXTI de los botones y
+ * el indicador de presionado de cada botón pasa a ser el estado filtrado, que cambia una sola vez por pulsación. En ese
+ * modo la FSM del botón se debe crear con tiempo anti-rebote 0.
+ * @param mode Modo de detección (`PORT_BUTTON_DEBOUNCE_EXTI` o `PORT_BUTTON_DEBOUNCE_SAMPLED`).
+ */
+void port_button_set_debounce_mode(uint32_t mode);
+/**
+ * @brief Muestrea el nivel de todos los botones inicializados, leyendo el registro `IDR` una vez por puerto.
+ * @return Máscara sin filtrar con el bit `button_id` a 1 si el botón está presionado.
+ */
+uint32_t port_button_sample(void);
+/**
+ * @brief Obtiene y borra los flancos filtrados acumulados desde la última llamada (modo `PORT_BUTTON_DEBOUNCE_SAMPLED`).
+ * @param p_pressed Puntero donde se guarda la máscara de botones que se han presionado.
+ * @param p_released Puntero donde se guarda la máscara de botones que se han liberado.
+ */
+void port_button_take_edges(uint32_t *p_pressed, uint32_t *p_released);
+/**
+ * @brief Muestrea y filtra los botones cada `PORT_BUTTON_SAMPLE_PERIOD_MS` milisegundos si el modo es `PORT_BUTTON_DEBOUNCE_SAMPLED`.
+ * @warning This function must be used only by the SysTick_Handler() ISR in file `interr.c`.
+ * @param now Tick del sistema actual.
+ */
+void port_button_sample_tick(uint32_t now);
 #endif
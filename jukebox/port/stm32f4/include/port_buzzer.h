@@ -0,0 +1,168 @@
+/**
+ * @file port_buzzer.h
+ * @brief Header for port_buzzer.c file.
+ *
+ * El buzzer se conecta a PA6, que es el canal 1 de TIM3 (función alternativa 2): TIM3 genera la señal PWM de la nota
+ * y TIM2 mide su duración. Hay dos modos de uso:
+ *
+ * - Nota a nota: la FSM del buzzer fija la nota con port_buzzer_set_note() y su duración con
+ *   port_buzzer_set_note_duration(); la ISR de TIM2 sólo avisa del fin de la nota y la FSM carga la siguiente cuando el
+ *   bucle principal la dispara, con el retraso que tenga el bucle.
+ * - Secuenciador: port_buzzer_play_melody() recorre la melodía entera desde la ISR de TIM2. TIM2 cuenta sin parar y
+ *   recarga por hardware la duración de cada nota, que la ISR dejó en el registro de precarga `ARR` una nota antes; en
+ *   cada fin de nota la ISR aplica a TIM3 el descriptor de la nota siguiente, ya decodificado, y decodifica el de la
+ *   posterior. Las notas no dependen del bucle principal: la FSM sólo recibe un evento al acabar la melodía.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+#ifndef PORT_BUZZER_H_
+#define PORT_BUZZER_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* HW dependent includes */
+#include "port_system.h"
+
+/* Other includes */
+#include "melodies.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define PORT_BUZZER_MAX_BUZZERS 1 /*!< Tamaño de la tabla de buzzers */
+#define BUZZER_0_ID 0
+#define BUZZER_0_GPIO GPIOA
+#define BUZZER_0_PIN 6
+#define BUZZER_0_AF 2 /*!< Función alternativa de PA6: TIM3_CH1 */
+#define BUZZER_0_PWM_TIMER TIM3 /*!< Temporizador de la señal PWM de la nota */
+#define BUZZER_0_DURATION_TIMER TIM2 /*!< Temporizador de la duración de la nota (contador de 32 bits) */
+#define BUZZER_0_DURATION_IRQN TIM2_IRQn /*!< Interrupción de fin de nota */
+#define BUZZER_0_EVENT 10 /*!< Evento que publica la ISR de TIM2 al acabar una nota (nota a nota) o la melodía (secuenciador) */
+#define PORT_BUZZER_DUTY_CYCLE_PERCENT 50 /*!< Ciclo de trabajo de la señal PWM */
+#define PORT_BUZZER_DURATION_TICK_HZ 1000U /*!< Frecuencia del contador de TIM2: un tick por ms */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Descriptor de una nota ya decodificado: los registros que la ISR escribe sin hacer cuentas.
+ */
+typedef struct
+{
+    uint16_t psc;      /*!< Prescaler de TIM3 (de `note_table`) */
+    uint16_t arr;      /*!< Auto-reload de TIM3, 0 para un silencio */
+    uint16_t ccr;      /*!< Comparación del canal 1 de TIM3 (ciclo de trabajo) */
+    uint32_t duration; /*!< Duración en ticks de TIM2, al menos 1 */
+} port_buzzer_step_t;
+
+/**
+ * @brief Estructura con la información de HW y el estado de un buzzer.
+ */
+typedef struct
+{
+    GPIO_TypeDef *p_port;           /*!< Puerto GPIO del buzzer */
+    uint8_t pin;                    /*!< Pin del buzzer */
+    uint8_t alt_func;               /*!< Función alternativa del pin (canal 1 del temporizador PWM) */
+    TIM_TypeDef *p_pwm_timer;       /*!< Temporizador de la señal PWM */
+    TIM_TypeDef *p_duration_timer;  /*!< Temporizador de la duración de las notas */
+    IRQn_Type duration_irqn;        /*!< Interrupción del temporizador de duración */
+    uint8_t event;                  /*!< Evento que se publica cuando la FSM del buzzer tiene trabajo */
+    volatile bool note_end;         /*!< Ha acabado la nota (modo nota a nota) */
+    volatile bool melody_end;       /*!< Ha acabado la melodía (modo secuenciador) */
+    volatile bool sequencing;       /*!< El secuenciador está reproduciendo una melodía */
+    melody_cursor_t cursor;         /*!< Posición del secuenciador en la melodía */
+    port_buzzer_step_t next;        /*!< Descriptor de la nota que empieza en el próximo fin de nota */
+    bool next_valid;                /*!< `next` es una nota; si no, el próximo fin de nota es el de la melodía */
+} port_buzzer_hw_t;
+
+/* Global variables */
+extern port_buzzer_hw_t buzzers_arr[PORT_BUZZER_MAX_BUZZERS]; /*!< Array de los buzzers, indexado por su identificador */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Inicializa el buzzer: pin en función alternativa, TIM3 en modo PWM 1 con precarga y TIM2 con un tick por ms,
+ * precarga de `ARR` e interrupción de actualización. El buzzer queda en silencio.
+ *
+ * `note_table` está calculada para un reloj de los temporizadores de `NOTE_TABLE_TIMER_CLOCK_HZ`: con otro reloj las
+ * notas desafinarían y el prescaler de TIM2 podría no caber en sus 16 bits, así que no se configura nada.
+ * @param buzzer_id Identificador del buzzer.
+ * @return `false` si el reloj de TIM2 y TIM3 no es `NOTE_TABLE_TIMER_CLOCK_HZ`.
+ */
+bool port_buzzer_init(uint32_t buzzer_id);
+
+/**
+ * @brief Fija la nota que suena (modo nota a nota). La nota empieza en ese instante, aunque sea igual que la anterior.
+ * @param buzzer_id Identificador del buzzer.
+ * @param note Índice de la nota en `note_table` (`NOTE_SILENCE` o uno fuera de rango silencian el buzzer).
+ */
+void port_buzzer_set_note(uint32_t buzzer_id, uint32_t note);
+
+/**
+ * @brief Arranca la cuenta de la duración de la nota (modo nota a nota). Al acabar, la ISR de TIM2 marca el fin de la
+ * nota y publica el evento del buzzer.
+ * @param buzzer_id Identificador del buzzer.
+ * @param duration_ms Duración en ms (0 se trata como 1).
+ */
+void port_buzzer_set_note_duration(uint32_t buzzer_id, uint32_t duration_ms);
+
+/**
+ * @brief Obtiene y borra el indicador de fin de nota (modo nota a nota).
+ * @param buzzer_id Identificador del buzzer.
+ * @return `true` si la nota ha acabado desde la última llamada.
+ */
+bool port_buzzer_get_note_timeout(uint32_t buzzer_id);
+
+/**
+ * @brief Reproduce una melodía entera en modo secuenciador.
+ *
+ * Decodifica las dos primeras notas, deja sonando la primera y programa en TIM2 su duración y, en la precarga, la de la
+ * segunda. A partir de ahí cada interrupción de fin de nota aplica la nota siguiente y decodifica la posterior; el bucle
+ * principal no interviene hasta el evento de fin de melodía. Si el buzzer estaba sonando, se para antes.
+ * @param buzzer_id Identificador del buzzer.
+ * @param p_melody Melodía a reproducir.
+ * @return `false` si la melodía no tiene notas.
+ */
+bool port_buzzer_play_melody(uint32_t buzzer_id, const melody_t *p_melody);
+
+/**
+ * @brief Obtiene y borra el indicador de fin de melodía (modo secuenciador).
+ * @param buzzer_id Identificador del buzzer.
+ * @return `true` si la melodía ha acabado desde la última llamada.
+ */
+bool port_buzzer_get_melody_end(uint32_t buzzer_id);
+
+/**
+ * @brief Indica si el secuenciador está reproduciendo una melodía.
+ * @param buzzer_id Identificador del buzzer.
+ * @return `true` desde port_buzzer_play_melody() hasta el fin de la melodía o port_buzzer_stop().
+ */
+bool port_buzzer_is_sequencing(uint32_t buzzer_id);
+
+/**
+ * @brief Para el buzzer en cualquiera de los dos modos: silencia la salida y para los dos temporizadores.
+ * @param buzzer_id Identificador del buzzer.
+ */
+void port_buzzer_stop(uint32_t buzzer_id);
+
+/**
+ * @brief Obtiene el evento que despierta a la FSM del buzzer.
+ * @param buzzer_id Identificador del buzzer.
+ * @return Identificador del evento para `port_system_post_event()`.
+ */
+uint32_t port_buzzer_get_event(uint32_t buzzer_id);
+
+/**
+ * @brief Atiende el fin de nota del temporizador de duración.
+ *
+ * En modo nota a nota para TIM2, marca el fin de la nota y publica el evento. En modo secuenciador aplica a TIM3 el
+ * descriptor decodificado por adelantado, decodifica la nota posterior y escribe su duración en la precarga de TIM2;
+ * después de la última nota para el buzzer, marca el fin de la melodía y publica el evento.
+ * @warning This function must be used only by the TIM2_IRQHandler() ISR in file `interr.c`.
+ * @param buzzer_id Identificador del buzzer.
+ */
+void port_buzzer_duration_isr(uint32_t buzzer_id);
+
+#endif /* PORT_BUZZER_H_ */
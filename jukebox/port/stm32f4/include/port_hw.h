@@ -0,0 +1,92 @@
+/**
+ * @file port_hw.h
+ * @brief Acceso a los registros del STM32F446RE que tienen efectos al leerlos o escribirlos.
+ *
+ * Los drivers de `port/stm32f4` leen y escriben estos registros sólo a través de estas funciones. En el STM32 son
+ * accesos directos; la plataforma nativa tiene su propio `port_hw.h`, que los pasa al modelo de los periféricos, y
+ * compila los mismos drivers.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+#ifndef PORT_HW_H_
+#define PORT_HW_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* HW dependent includes */
+#include "stm32f4xx.h"
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Lee el registro DR de un USART (borra RXNE y, tras leer SR, IDLE y los errores).
+ * @param p_usart Registros del USART.
+ * @return Byte recibido.
+ */
+static inline uint32_t port_hw_usart_read_dr(USART_TypeDef *p_usart)
+{
+    return p_usart->DR;
+}
+
+/**
+ * @brief Escribe el registro DR de un USART (empieza la transmisión del byte).
+ * @param p_usart Registros del USART.
+ * @param data Byte a transmitir.
+ */
+static inline void port_hw_usart_write_dr(USART_TypeDef *p_usart, uint32_t data)
+{
+    p_usart->DR = data;
+}
+
+/**
+ * @brief Borra los indicadores de los streams 0 a 3 de un DMA (`LIFCR`).
+ * @param p_dma Registros del DMA.
+ * @param mask Indicadores a borrar.
+ */
+static inline void port_hw_dma_write_lifcr(DMA_TypeDef *p_dma, uint32_t mask)
+{
+    p_dma->LIFCR = mask;
+}
+
+/**
+ * @brief Borra los indicadores de los streams 4 a 7 de un DMA (`HIFCR`).
+ * @param p_dma Registros del DMA.
+ * @param mask Indicadores a borrar.
+ */
+static inline void port_hw_dma_write_hifcr(DMA_TypeDef *p_dma, uint32_t mask)
+{
+    p_dma->HIFCR = mask;
+}
+
+/**
+ * @brief Borra los pendientes de las líneas EXTI de la máscara (`EXTI->PR` es rc_w1).
+ * @param mask Líneas a borrar.
+ */
+static inline void port_hw_exti_clear_pending(uint32_t mask)
+{
+    EXTI->PR = mask;
+}
+
+/**
+ * @brief Escribe el registro EGR de un temporizador (`UG` carga la precarga y reinicia el contador).
+ * @param p_tim Registros del temporizador.
+ * @param egr Valor a escribir.
+ */
+static inline void port_hw_tim_write_egr(TIM_TypeDef *p_tim, uint32_t egr)
+{
+    p_tim->EGR = egr;
+}
+
+/**
+ * @brief Punto de sincronización tras habilitar una fuente de interrupción o un stream de DMA. En el STM32 el
+ * periférico reacciona solo y no hace nada.
+ */
+static inline void port_hw_sync(void)
+{
+}
+
+#endif /* PORT_HW_H_ */
@@ -77,6 +77,22 @@
  */
 size_t port_system_init(void);
 
+/**
+ * @brief Get the frequency of the APB1 peripheral clock (USART2, USART3, TIM2 to TIM5...), from SystemCoreClock and the
+ * APB1 prescaler configured in RCC_CFGR.
+ *
+ * @return APB1 clock frequency in Hz
+ */
+uint32_t port_system_get_apb1_clock(void);
+
+/**
+ * @brief Get the frequency of the APB2 peripheral clock (USART1, USART6, SYSCFG...), from SystemCoreClock and the APB2
+ * prescaler configured in RCC_CFGR.
+ *
+ * @return APB2 clock frequency in Hz
+ */
+uint32_t port_system_get_apb2_clock(void);
+
 /**
  * @brief Get the count of the System tick in milliseconds
  *
@@ -121,6 +137,56 @@ void port_system_delay_ms(uint32_t ms);
  */
 void port_system_delay_until_ms(uint32_t *p_t, uint32_t ms);
 
+/**
+ * @brief Post an event from an ISR. The event stays pending until the main loop takes it with port_system_take_events().
+ *
+ * @note It is safe to call it from ISRs of any priority (atomic OR).
+ *
+ * @param event Index of the event (from 0 to 31), e.g. `BUTTON_0_EVENT` or `USART_0_EVENT_RX`.
+ */
+void port_system_post_event(uint32_t event);
+
+/**
+ * @brief Take (read and clear atomically) the events posted since the last call.
+ *
+ * @return Mask of pending events (bit `n` set if event `n` was posted)
+ */
+uint32_t port_system_take_events(void);
+
+/**
+ * @brief Put the core to sleep until an interrupt arrives, unless an event is already pending.
+ *
+ * The check and the sleep are done with the interrupts masked, so an event posted in between wakes the core up instead
+ * of being missed (`WFI` wakes up on a pending interrupt even when it is masked).
+ */
+void port_system_sleep_until_event(void);
+
+/**
+ * @brief Send bytes through the ITM stimulus port 0 without waiting: it stops as soon as the stimulus FIFO is full.
+ *
+ * Unlike `ITM_SendChar()`, it never spins. With the ITM or the port disabled (no debugger attached) nobody reads the
+ * port, so the bytes are discarded and reported as sent.
+ *
+ * @param p_data Bytes to send
+ * @param length Number of bytes
+ * @return Number of bytes accepted by the port
+ */
+uint32_t port_system_itm_write(const uint8_t *p_data, uint32_t length);
+
+/**
+ * @brief Enter a critical section: mask the interrupts and return the previous mask, so that sections can be nested.
+ *
+ * @return Previous value of the interrupt mask (PRIMASK)
+ */
+uint32_t port_system_enter_critical(void);
+
+/**
+ * @brief Leave a critical section entered with port_system_enter_critical().
+ *
+ * @param state Value returned by port_system_enter_critical()
+ */
+void port_system_exit_critical(uint32_t state);
+
 /** @verbatim
       ==============================================================================
                               ##### How to use GPIOs #####
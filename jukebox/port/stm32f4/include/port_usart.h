@@ -11,6 +11,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
 #include <stdbool.h>
+#include "spsc_ring.h"
 #include "stm32f4xx.h"
 /* Standard C includes */
 
@@ -18,6 +19,7 @@
 
 /* Defines and enums ----------------------------------------------------------*/
 /* Defines */
+#define USART_INSTANCES 4 /*!< Número de USART de la tabla `usart_arr` */
 #define USART_0_ID 0
 #define USART_0 USART3
 #define USART_0_GPIO_TX GPIOB
@@ -25,13 +27,150 @@
 #define USART_0_PIN_TX 10
 #define USART_0_PIN_RX 11
 #define USART_0_AF_TX 7
+#define USART_0_GPIO_RTS GPIOB /*!< Puerto del pin RTS (salida: se maneja con las marcas del anillo) */
+#define USART_0_PIN_RTS 14
+#define USART_0_GPIO_CTS GPIOB /*!< Puerto del pin CTS (misma función alternativa que TX) */
+#define USART_0_PIN_CTS 13
 #define USART_0_AF_RX 7
-#define USART_INPUT_BUFFER_LENGTH 10
-#define USART_OUTPUT_BUFFER_LENGTH 100
+#define USART_0_BAUDRATE 9600 /*!< Velocidad con la que port_usart_init() configura el USART */
+#define USART_0_EVENT_RX 2 /*!< Evento que publica la ISR del USART cuando se ha recibido un mensaje completo */
+#define USART_0_EVENT_TX 3 /*!< Evento que publica la ISR del USART cuando acaba la transmisión */
+#define USART_0_DMA_RX DMA1_Stream1 /*!< Stream de DMA1 de la recepción del USART3 */
+#define USART_0_DMA_RX_STREAM 1 /*!< Número del stream de DMA1 de la recepción del USART3 */
+#define USART_0_DMA_TX DMA1_Stream3 /*!< Stream de DMA1 de la transmisión del USART3 */
+#define USART_0_DMA_TX_STREAM 3 /*!< Número del stream de DMA1 de la transmisión del USART3 */
+#define USART_0_DMA_CHANNEL 4 /*!< Canal de DMA1 del USART3 en los dos streams */
+#define USART_1_ID 1 /*!< USART2: puerto serie virtual del ST-LINK de la placa Nucleo */
+#define USART_1 USART2
+#define USART_1_GPIO_TX GPIOA
+#define USART_1_GPIO_RX GPIOA
+#define USART_1_PIN_TX 2
+#define USART_1_PIN_RX 3
+#define USART_1_AF_TX 7
+#define USART_1_GPIO_RTS GPIOA /*!< Puerto del pin RTS (salida: se maneja con las marcas del anillo) */
+#define USART_1_PIN_RTS 1
+#define USART_1_GPIO_CTS GPIOA /*!< Puerto del pin CTS (misma función alternativa que TX) */
+#define USART_1_PIN_CTS 0
+#define USART_1_AF_RX 7
+#define USART_1_BAUDRATE 115200 /*!< Velocidad con la que port_usart_init() configura el USART */
+#define USART_1_EVENT_RX 4 /*!< Evento que publica la ISR del USART cuando se ha recibido un mensaje completo */
+#define USART_1_EVENT_TX 5 /*!< Evento que publica la ISR del USART cuando acaba la transmisión */
+#define USART_1_DMA_RX DMA1_Stream5 /*!< Stream de DMA1 de la recepción del USART2 */
+#define USART_1_DMA_RX_STREAM 5 /*!< Número del stream de DMA1 de la recepción del USART2 */
+#define USART_1_DMA_TX DMA1_Stream6 /*!< Stream de DMA1 de la transmisión del USART2 */
+#define USART_1_DMA_TX_STREAM 6 /*!< Número del stream de DMA1 de la transmisión del USART2 */
+#define USART_1_DMA_CHANNEL 4 /*!< Canal de DMA1 del USART2 en los dos streams */
+#define USART_2_ID 2 /*!< USART1 (sin modo DMA: sus streams son de DMA2) */
+#define USART_2 USART1
+#define USART_2_GPIO_TX GPIOA
+#define USART_2_GPIO_RX GPIOA
+#define USART_2_PIN_TX 9
+#define USART_2_PIN_RX 10
+#define USART_2_AF_TX 7
+#define USART_2_GPIO_RTS GPIOA /*!< Puerto del pin RTS (salida: se maneja con las marcas del anillo) */
+#define USART_2_PIN_RTS 12
+#define USART_2_GPIO_CTS GPIOA /*!< Puerto del pin CTS (misma función alternativa que TX) */
+#define USART_2_PIN_CTS 11
+#define USART_2_AF_RX 7
+#define USART_2_BAUDRATE 9600 /*!< Velocidad con la que port_usart_init() configura el USART */
+#define USART_2_EVENT_RX 6 /*!< Evento que publica la ISR del USART cuando se ha recibido un mensaje completo */
+#define USART_2_EVENT_TX 7 /*!< Evento que publica la ISR del USART cuando acaba la transmisión */
+#define USART_3_ID 3 /*!< USART6 (sin modo DMA: sus streams son de DMA2) */
+#define USART_3 USART6
+#define USART_3_GPIO_TX GPIOC
+#define USART_3_GPIO_RX GPIOC
+#define USART_3_PIN_TX 6
+#define USART_3_PIN_RX 7
+#define USART_3_AF_TX 8
+#define USART_3_GPIO_RTS NULL /*!< Sin RTS: los pines de RTS y CTS del USART6 están en GPIOG, que no sale en el encapsulado de 64 pines */
+#define USART_3_PIN_RTS 0
+#define USART_3_GPIO_CTS NULL /*!< Sin CTS (ver `USART_3_GPIO_RTS`) */
+#define USART_3_PIN_CTS 0
+#define USART_3_AF_RX 8
+#define USART_3_BAUDRATE 9600 /*!< Velocidad con la que port_usart_init() configura el USART */
+#define USART_3_EVENT_RX 8 /*!< Evento que publica la ISR del USART cuando se ha recibido un mensaje completo */
+#define USART_3_EVENT_TX 9 /*!< Evento que publica la ISR del USART cuando acaba la transmisión */
+#define USART_RX_RING_LENGTH 256 /*!< Tamaño del anillo de recepción (potencia de 2) */
+#define USART_RX_LINE_MAX_LENGTH 64 /*!< Longitud máxima de una línea que se puede entregar contigua cuando da la vuelta al anillo */
+#define USART_RX_HIGH_WATERMARK 192 /*!< Bytes del anillo de recepción a partir de los que se pide al otro extremo que pare */
+#define USART_RX_LOW_WATERMARK 64 /*!< Bytes del anillo de recepción por debajo de los que se le pide que siga */
+#define USART_XON 0x11 /*!< Carácter de control de flujo por software: seguir */
+#define USART_XOFF 0x13 /*!< Carácter de control de flujo por software: parar */
+#define USART_RX_FRAME_QUEUE_LENGTH 16 /*!< Finales de trama por línea en reposo pendientes de leer (potencia de 2) */
+#define USART_INPUT_BUFFER_LENGTH (USART_RX_LINE_MAX_LENGTH + 1) /*!< Tamaño del búfer de las copias de una línea recibida (con el carácter nulo) */
+#define USART_OUTPUT_BUFFER_LENGTH 100 /*!< Longitud máxima de un mensaje enviado con fsm_usart_set_out_data() */
+#define USART_TX_QUEUE_LENGTH 512 /*!< Tamaño de la cola de transmisión (potencia de 2), con un byte de longitud por mensaje */
+#define USART_DMA_RX_LENGTH 64 /*!< Tamaño del búfer circular de la recepción por DMA; hay una interrupción por cada mitad */
+#define USART_TX_MESSAGE_MAX_LENGTH 255 /*!< Longitud máxima de un mensaje de la cola de transmisión (cabe en el prefijo de un byte) */
+#define USART_TX_REF_QUEUE_LENGTH 8 /*!< Mensajes sin copia que pueden estar encolados a la vez (potencia de 2) */
+#define USART_TX_REF_MAX_LENGTH 0xFFFF /*!< Longitud máxima de un mensaje sin copia (cabe en una transferencia DMA) */
+#define USART_BAUD_ERROR_MAX_PPM 25000 /*!< Error de velocidad máximo que acepta port_usart_set_baudrate() (2,5 %) */
 #define EMPTY_BUFFER_CONSTANT 0x0
 #define END_CHAR_CONSTANT 0xA
+/* Enums */
+/**
+ * @brief Modos de transferencia del USART.
+ */
+enum PORT_USART_MODE
+{
+    PORT_USART_MODE_IRQ = 0, /*!< Una interrupción RXNE o TXE por byte */
+    PORT_USART_MODE_DMA      /*!< Recepción circular por DMA con interrupciones de mitad y fin, y transmisión de cada mensaje en una transferencia DMA */
+};
+/**
+ * @brief Criterios de fin de línea (o trama) en recepción.
+ */
+enum PORT_USART_FRAMING
+{
+    PORT_USART_FRAMING_DELIMITER = 0, /*!< La línea termina en el byte delimitador (`END_CHAR_CONSTANT` por defecto) */
+    PORT_USART_FRAMING_IDLE           /*!< La trama termina cuando la línea queda en reposo (indicador IDLE): puede contener cualquier byte */
+};
+/**
+ * @brief Control de flujo de la recepción y la transmisión.
+ *
+ * En los dos casos se pide al otro extremo que pare cuando el anillo de recepción llega a `USART_RX_HIGH_WATERMARK`
+ * bytes y que siga cuando baja de `USART_RX_LOW_WATERMARK`; el margen entre la marca alta y el tamaño del anillo cubre
+ * los bytes que el otro extremo ya había empezado a enviar.
+ */
+enum PORT_USART_FLOW
+{
+    PORT_USART_FLOW_NONE = 0, /*!< Sin control de flujo */
+    PORT_USART_FLOW_RTS_CTS,  /*!< Por hardware: RTS es una salida activa a nivel bajo que siguen las marcas, y CTS detiene el transmisor (CTSE) */
+    PORT_USART_FLOW_XON_XOFF  /*!< Por software: se envían XON y XOFF, y los recibidos detienen o reanudan la cola de transmisión. Sólo en modo IRQ y con texto */
+};
 /* Typedefs --------------------------------------------------------------------*/
-;
+/**
+ * @brief Función a la que se llama cuando el USART ha terminado de leer un mensaje sin copia y su memoria se puede reutilizar.
+ * @param p_data Puntero a los bytes del mensaje.
+ * @param p_arg Argumento del llamante pasado a port_usart_send_ref().
+ */
+typedef void (*port_usart_tx_callback_t)(const char *p_data, void *p_arg);
+
+/**
+ * @brief Mensaje sin copia: el USART lo envía directamente desde la memoria del llamante.
+ */
+typedef struct
+{
+    const char *p_data; /*!< Bytes del mensaje, propiedad del llamante */
+    uint32_t length; /*!< Longitud del mensaje */
+    port_usart_tx_callback_t callback; /*!< Función que libera la memoria del mensaje (puede ser `NULL`) */
+    void *p_arg; /*!< Argumento de `callback` */
+} port_usart_tx_ref_t;
+
+/**
+ * @brief Contadores de recepción de un USART.
+ */
+typedef struct
+{
+    uint32_t rx_bytes; /*!< Bytes leídos del USART, por la ISR o por el DMA */
+    uint32_t rx_frames; /*!< Líneas o tramas completas recibidas */
+    uint32_t overruns; /*!< Desbordamientos (ORE): llegó un byte sin haber leído el anterior y se perdió al menos uno */
+    uint32_t framing_errors; /*!< Errores de trama (FE): bit de parada incorrecto; el byte se descarta */
+    uint32_t noise_errors; /*!< Ruido (NE): las muestras de algún bit no coinciden; el byte se guarda */
+    uint32_t parity_errors; /*!< Errores de paridad (PE); el byte se descarta */
+    uint32_t rx_dropped; /*!< Bytes descartados por tener el anillo de recepción lleno */
+    uint32_t flow_pauses; /*!< Veces que se ha pedido al otro extremo que pare por llegar a la marca alta */
+} port_usart_stats_t;
+
 /**
  * @brief Estructura para el hardware USART
  */
@@ -44,12 +183,52 @@ typedef struct
     uint8_t pin_rx; /*!< Número de pin de recepción */
     uint8_t alt_func_tx; /*!< Función alternativa del pin de transmisión */
     uint8_t alt_func_rx; /*!< Función alternativa del pin de rececpción */
-    char input_buffer[USART_INPUT_BUFFER_LENGTH]; /*!< Búfer de entrada USART */
-    uint8_t i_idx; /*!< Índice de escritura en el búfer de entrada */
-    bool read_complete; /*!< Indicador de lectura completa */
-    char output_buffer[USART_OUTPUT_BUFFER_LENGTH]; /*!< Búfer de salida USART */
-    uint8_t o_idx; /*!< Índice de lectura en el búfer de salida */
-    bool write_complete; /**< Indicador de si se ha hecho la escritura completa */
+    GPIO_TypeDef *p_port_rts; /*!< Puerto del pin RTS */
+    GPIO_TypeDef *p_port_cts; /*!< Puerto del pin CTS */
+    uint8_t pin_rts; /*!< Número de pin RTS */
+    uint8_t pin_cts; /*!< Número de pin CTS */
+    uint8_t flow; /*!< Control de flujo (`enum PORT_USART_FLOW`) */
+    volatile bool rx_throttled; /*!< Se ha pedido al otro extremo que pare */
+    volatile uint8_t tx_flow_char; /*!< XON o XOFF pendiente de enviar antes que la cola (0: ninguno) */
+    volatile bool tx_paused; /*!< El otro extremo ha enviado XOFF: la cola de transmisión espera a XON */
+    IRQn_Type irqn; /*!< Interrupción global del USART */
+    uint8_t event_rx; /*!< Evento que se publica cuando hay una línea recibida */
+    uint8_t event_tx; /*!< Evento que se publica cuando se vacía la cola de transmisión */
+    uint32_t init_baudrate; /*!< Velocidad con la que port_usart_init() configura el USART */
+    uint32_t baudrate; /*!< Velocidad real configurada, en baudios */
+    int32_t baud_error_ppm; /*!< Error de la velocidad real respecto a la pedida, en partes por millón */
+    spsc_ring_t rx_ring; /*!< Anillo de recepción: lo llena la ISR y lo vacía el programa principal */
+    uint8_t rx_buffer[USART_RX_RING_LENGTH + USART_RX_LINE_MAX_LENGTH]; /*!< Memoria del anillo de recepción */
+    volatile uint32_t rx_lines_in; /*!< Líneas completas recibidas (sólo lo escribe la ISR) */
+    uint32_t rx_lines_out; /*!< Líneas liberadas por el programa principal */
+    uint32_t rx_line_length; /*!< Bytes (con el delimitador) de la línea entregada y aún no liberada; 0 si no hay ninguna */
+    uint32_t rx_lines_dropped; /*!< Líneas descartadas por no caber en el anillo */
+    uint8_t rx_delimiter; /*!< Byte que termina cada línea o trama recibida (`END_CHAR_CONSTANT` por defecto) */
+    uint8_t rx_framing; /*!< Criterio de fin de línea (`enum PORT_USART_FRAMING`) */
+    uint32_t rx_frame_ends[USART_RX_FRAME_QUEUE_LENGTH]; /*!< Posición (sin envolver) del anillo en la que termina cada trama por línea en reposo */
+    uint32_t rx_frame_start; /*!< Posición del anillo en la que empieza la trama en curso (sólo la escribe la ISR) */
+    port_usart_stats_t stats; /*!< Contadores de recepción (sólo los escribe la ISR; `rx_dropped` se toma del anillo) */
+    spsc_ring_t tx_ring; /*!< Cola de transmisión: mensajes `[longitud][bytes]`, o `[0]` para un mensaje sin copia, que encola el programa principal y vacía la ISR */
+    uint8_t tx_buffer[USART_TX_QUEUE_LENGTH]; /*!< Memoria de la cola de transmisión */
+    volatile uint32_t tx_remaining; /*!< Bytes que le quedan al mensaje que está enviando la ISR (0: ninguno en curso) */
+    volatile uint32_t tx_messages_sent; /*!< Mensajes enviados completos (sólo lo escribe la ISR) */
+    uint32_t tx_rejected; /*!< Mensajes rechazados por no caber en la cola */
+    port_usart_tx_ref_t tx_refs[USART_TX_REF_QUEUE_LENGTH]; /*!< Descriptores de los mensajes sin copia, en el orden de sus marcas en la cola */
+    volatile uint32_t tx_ref_head; /*!< Índice (sin envolver) del siguiente descriptor libre (sólo lo escribe el programa principal) */
+    volatile uint32_t tx_ref_tail; /*!< Índice (sin envolver) del descriptor más antiguo sin terminar (sólo lo escribe la ISR) */
+    const port_usart_tx_ref_t *p_tx_ref; /*!< Mensaje sin copia en curso (`NULL` si el mensaje en curso está en la cola) */
+    DMA_TypeDef *p_dma; /*!< Controlador DMA del USART (`NULL` si el USART no tiene modo DMA) */
+    DMA_Stream_TypeDef *p_dma_rx; /*!< Stream de DMA1 de la recepción */
+    DMA_Stream_TypeDef *p_dma_tx; /*!< Stream de DMA1 de la transmisión */
+    IRQn_Type dma_rx_irqn; /*!< Interrupción del stream de la recepción */
+    IRQn_Type dma_tx_irqn; /*!< Interrupción del stream de la transmisión */
+    uint8_t dma_rx_stream; /*!< Número del stream de la recepción (elige sus indicadores en LISR/HISR) */
+    uint8_t dma_tx_stream; /*!< Número del stream de la transmisión */
+    uint8_t dma_channel; /*!< Canal de DMA1 del USART */
+    uint8_t mode; /*!< Modo de transferencia (`enum PORT_USART_MODE`) */
+    uint8_t dma_rx_buffer[USART_DMA_RX_LENGTH]; /*!< Búfer circular que llena el DMA de recepción */
+    uint32_t dma_rx_pos; /*!< Posición del búfer circular hasta la que se han pasado los bytes al anillo de recepción */
+    volatile uint32_t dma_tx_length; /*!< Bytes de la transferencia DMA de transmisión en curso (0: ninguna) */
 
 } port_usart_hw_t;
 
@@ -61,24 +240,149 @@ extern port_usart_hw_t usart_arr[]; /**< Array de USART */
  * @param usart_id ID del USART a inicializar.
  */
 void port_usart_init(uint32_t usart_id);
+/**
+ * @brief Configura la velocidad del USART a partir de la frecuencia real del reloj de APB del USART (APB1 para
+ * USART2/3, APB2 para USART1/6).
+ *
+ * Calcula la mantisa y la fracción de BRR redondeando al divisor más cercano. Se usa sobremuestreo x16 mientras el
+ * divisor lo permite (más tolerancia en recepción) y x8 por encima de `fAPB / 16`, hasta `fAPB / 8`. Con el reloj de
+ * APB a 16 MHz, 1000000 y 2000000 baudios son exactos y 921600 baudios queda a +2,1 %.
+ * @note El USART se deshabilita mientras se cambia la configuración: la transmisión en curso se debe haber terminado.
+ * @param usart_id Identificador del USART.
+ * @param baudrate Velocidad pedida, en baudios.
+ * @return Verdadero si se ha configurado, falso si la velocidad no se alcanza o el error supera
+ * `USART_BAUD_ERROR_MAX_PPM` (la configuración anterior se mantiene).
+ */
+bool port_usart_set_baudrate(uint32_t usart_id, uint32_t baudrate);
+/**
+ * @brief Obtiene la velocidad real configurada y su error.
+ * @param usart_id Identificador del USART.
+ * @param p_error_ppm Puntero donde se guarda el error respecto a la velocidad pedida, en partes por millón (puede ser `NULL`).
+ * @return Velocidad real, en baudios.
+ */
+uint32_t port_usart_get_baudrate(uint32_t usart_id, int32_t *p_error_ppm);
+/**
+ * @brief Selecciona el modo de transferencia del USART.
+ *
+ * En modo DMA, la recepción se habilita con port_usart_enable_rx_interrupt() igual que en modo IRQ, pero los bytes los
+ * escribe el DMA en un búfer circular y sólo hay una interrupción por cada mitad del búfer; la transmisión envía cada
+ * mensaje de la cola en una transferencia DMA (dos si da la vuelta a la cola), con una interrupción al acabar.
+ * @note En modo DMA una línea se entrega al llenarse la mitad del búfer circular en la que acaba; el modo está pensado
+ * para enlaces con tráfico continuo.
+ * @warning Se debe llamar con la recepción deshabilitada y la cola de transmisión vacía.
+ * @param usart_id Identificador del USART.
+ * @param mode Modo (`enum PORT_USART_MODE`).
+ * @return Verdadero si se ha seleccionado el modo, falso si el USART no tiene streams DMA asignados (el modo no cambia).
+ */
+bool port_usart_set_mode(uint32_t usart_id, uint32_t mode);
+/**
+ * @brief Atiende la interrupción global de un USART: recepción (RXNE) y transmisión (TXE).
+ *
+ * Es el cuerpo común de las ISR de todos los USART; publica el evento de recepción del USART si hay alguna línea
+ * completa y el de transmisión cuando se vacía la cola.
+ * @param usart_id Identificador del USART.
+ */
+void port_usart_isr(uint32_t usart_id);
+/**
+ * @brief Atiende la interrupción del stream DMA de recepción: pasa al anillo de recepción los bytes que ha escrito el
+ * DMA desde la última vez, cuenta las líneas completas y publica el evento de recepción si hay alguna.
+ * @param usart_id Identificador del USART.
+ */
+void port_usart_dma_rx_isr(uint32_t usart_id);
+/**
+ * @brief Atiende la interrupción de fin de transferencia del stream DMA de transmisión: libera los bytes enviados,
+ * arranca la transferencia del siguiente mensaje de la cola y publica el evento de transmisión cuando se vacía.
+ * @param usart_id Identificador del USART.
+ */
+void port_usart_dma_tx_isr(uint32_t usart_id);
 /**
  * @brief Verifica si la transmisión USART se ha completado.
  * @param usart_id Identificador del USART a verificar.
- * @return Verdadero si la transmisión está completa, falso en caso contrario.
+ * @return Verdadero si la cola de transmisión está vacía y no hay ningún mensaje en curso, falso en caso contrario.
  */
 bool port_usart_tx_done(uint32_t usart_id);
 /**
  * @brief Verifica si la recepción USART se ha completado.
+ *
+ * También es verdadero cuando el anillo guarda una línea sin delimitador que ya no puede completarse (llega a la marca
+ * alta con control de flujo, o llena el anillo sin él): port_usart_get_line() la descarta y la recepción sigue.
  * @param usart_id Identificador del USART a verificar.
  * @return Verdadero si la recepción está completa, falso en caso contrario.
  */
 bool port_usart_rx_done(uint32_t usart_id);
 /**
- * @brief Obtiene datos del búfer de entrada USART.
+ * @brief Copia la línea recibida más antigua (sin el delimitador) al búfer dado, completado con caracteres nulos.
  * @param usart_id Identificador del USART.
- * @param p_buffer Puntero al búfer donde se almacenarán los datos.
+ * @param p_buffer Puntero al búfer de `USART_INPUT_BUFFER_LENGTH` bytes donde se almacenarán los datos.
  */
 void port_usart_get_from_input_buffer(uint32_t usart_id, char *p_buffer);
+/**
+ * @brief Obtiene una vista sin copia de la línea recibida más antigua, sin el delimitador.
+ *
+ * La vista sigue siendo válida hasta que se libera con port_usart_reset_input_buffer(); llamadas sucesivas devuelven
+ * la misma línea. El delimitador se busca recorriendo índices del anillo, sin copiar los datos. Si no hay ninguna
+ * línea completa y los bytes recibidos ya no pueden formar una (ver port_usart_rx_done()), se descartan y, con control
+ * de flujo, se pide al otro extremo que siga.
+ * @param usart_id Identificador del USART.
+ * @param pp_line Puntero donde se guarda el puntero al primer carácter de la línea.
+ * @param p_length Puntero donde se guarda la longitud de la línea.
+ * @return Verdadero si hay una línea completa, falso en caso contrario.
+ */
+bool port_usart_get_line(uint32_t usart_id, const char **pp_line, uint32_t *p_length);
+/**
+ * @brief Obtiene los bytes descartados en recepción por tener el anillo lleno.
+ * @param usart_id Identificador del USART.
+ * @return Bytes descartados desde la inicialización.
+ */
+uint32_t port_usart_get_rx_dropped(uint32_t usart_id);
+/**
+ * @brief Obtiene una copia de los contadores de recepción.
+ *
+ * Sirven para saber si se pierden datos (desbordamientos, errores de línea o anillo lleno) antes de cambiar la velocidad
+ * o el tamaño de los búferes.
+ * @param usart_id Identificador del USART.
+ * @param p_stats Puntero donde se copian los contadores.
+ */
+void port_usart_get_stats(uint32_t usart_id, port_usart_stats_t *p_stats);
+/**
+ * @brief Pone a cero los contadores de recepción.
+ * @param usart_id Identificador del USART.
+ */
+void port_usart_reset_stats(uint32_t usart_id);
+/**
+ * @brief Cambia el byte que delimita las líneas recibidas y vacía el anillo de recepción.
+ *
+ * Con `END_CHAR_CONSTANT` el USART entrega líneas de texto; con `0x00` entrega tramas COBS, que no contienen ese byte.
+ * @param usart_id Identificador del USART.
+ * @param delimiter Byte delimitador.
+ * @return Verdadero si se ha cambiado; falso si el control de flujo es XON/XOFF y el delimitador no es
+ * `END_CHAR_CONSTANT`.
+ */
+bool port_usart_set_rx_delimiter(uint32_t usart_id, uint8_t delimiter);
+/**
+ * @brief Selecciona el control de flujo.
+ *
+ * Con RTS/CTS configura RTS como salida (a nivel bajo: listo para recibir) y CTS en su función alternativa, y habilita
+ * CTSE. El RTS por hardware (RTSE) no se usa porque sólo protege el registro DR; los bytes se pierden en el anillo.
+ * @param usart_id Identificador del USART.
+ * @param flow Control de flujo (`enum PORT_USART_FLOW`).
+ * @return Verdadero si se ha configurado; falso si se pide XON/XOFF y el USART está en modo DMA o no recibe líneas de
+ * texto (delimitador distinto de `END_CHAR_CONSTANT` o `PORT_USART_FRAMING_IDLE`), o si se pide RTS/CTS y el USART no
+ * tiene esos pines en la placa.
+ */
+bool port_usart_set_flow_control(uint32_t usart_id, uint32_t flow);
+/**
+ * @brief Selecciona cómo termina cada línea recibida y vacía el anillo de recepción.
+ *
+ * Con `PORT_USART_FRAMING_IDLE` la interrupción por byte sólo guarda el byte en el anillo y la interrupción IDLE cierra
+ * la trama cuando la línea lleva un carácter en reposo: un emisor que no envía el delimitador no deja la línea a medias
+ * y las tramas binarias pueden contener cualquier byte. Si ya hay `USART_RX_FRAME_QUEUE_LENGTH` tramas sin leer, los
+ * bytes se unen a la trama siguiente.
+ * @param usart_id Identificador del USART.
+ * @param framing Criterio (`enum PORT_USART_FRAMING`).
+ * @return Verdadero si se ha cambiado; falso si se pide `PORT_USART_FRAMING_IDLE` con control de flujo XON/XOFF.
+ */
+bool port_usart_set_framing(uint32_t usart_id, uint32_t framing);
 /**
  * @brief Obtiene el estado del registro de transmisión USART.
  * @param usart_id Identificador del USART.
@@ -86,19 +390,51 @@ void port_usart_get_from_input_buffer(uint32_t usart_id, char *p_buffer);
  */
 bool port_usart_get_txr_status(uint32_t usart_id);
 /**
- * @brief Copia datos al búfer de salida USART.
+ * @brief Encola un mensaje para enviarlo, sin bloquear.
+ *
+ * El mensaje se copia a la cola de transmisión con un prefijo de longitud y se habilita la interrupción TXE, que envía
+ * los mensajes encolados uno detrás de otro sin intervención del programa principal.
+ * @param usart_id Identificador del USART.
+ * @param p_data Puntero a los bytes del mensaje.
+ * @param length Longitud del mensaje (como mucho `USART_TX_MESSAGE_MAX_LENGTH`).
+ * @return Verdadero si se ha encolado, falso si no cabe en la cola (contrapresión: el mensaje no se encola y se cuenta).
+ */
+bool port_usart_send(uint32_t usart_id, const char *p_data, uint32_t length);
+/**
+ * @brief Encola un mensaje sin copiarlo, sin bloquear.
+ *
+ * El USART lee los bytes directamente de la memoria del llamante (p. ej. una tabla de cadenas constantes en flash), en
+ * orden con el resto de mensajes de la cola. La memoria no se debe modificar hasta que se llama a `callback`.
+ * @note `callback` se llama desde la ISR que carga el último byte (TXE o fin de transferencia DMA), o desde
+ * port_usart_reset_output_buffer() si el mensaje se descarta.
+ * @param usart_id Identificador del USART.
+ * @param p_data Puntero a los bytes del mensaje.
+ * @param length Longitud del mensaje (como mucho `USART_TX_REF_MAX_LENGTH`).
+ * @param callback Función que libera la memoria del mensaje, o `NULL` si la memoria es constante.
+ * @param p_arg Argumento de `callback`.
+ * @return Verdadero si se ha encolado, falso si no quedan descriptores o la cola está llena (el mensaje no se encola y se cuenta).
+ */
+bool port_usart_send_ref(uint32_t usart_id, const char *p_data, uint32_t length, port_usart_tx_callback_t callback, void *p_arg);
+/**
+ * @brief Obtiene el espacio libre en la cola de transmisión.
+ * @param usart_id Identificador del USART.
+ * @return Longitud del mayor mensaje que se puede encolar ahora mismo.
+ */
+uint32_t port_usart_get_tx_free(uint32_t usart_id);
+/**
+ * @brief Obtiene los mensajes rechazados por tener la cola de transmisión llena.
  * @param usart_id Identificador del USART.
- * @param p_data Puntero a los datos a copiar.
- * @param length Longitud de los datos a copiar.
+ * @return Mensajes rechazados desde la inicialización.
  */
-void port_usart_copy_to_output_buffer(uint32_t usart_id, char *p_data, uint32_t length);
+uint32_t port_usart_get_tx_rejected(uint32_t usart_id);
 /**
- * @brief Reinicia el búfer de entrada USART.
+ * @brief Libera la línea recibida más antigua del búfer de entrada USART.
  * @param usart_id Identificador del USART.
  */
 void port_usart_reset_input_buffer(uint32_t usart_id);
 /**
- * @brief Reinicia el búfer de salida USART.
+ * @brief Vacía la cola de transmisión, descartando los mensajes pendientes y el que se esté enviando. Se liberan los
+ * mensajes sin copia descartados llamando a su función.
  * @param usart_id Identificador del USART.
  */
 void port_usart_reset_output_buffer(uint32_t usart_id);
@@ -108,12 +444,14 @@ void port_usart_reset_output_buffer(uint32_t usart_id);
  */
 void port_usart_store_data(uint32_t usart_id);
 /**
- * @brief Escribe los datos desde el búfer de salida USART.
+ * @brief Escribe en DR el siguiente byte de la cola de transmisión; se llama desde la ISR con TXE activo.
+ *
+ * Al acabar un mensaje pasa al siguiente, y deshabilita la interrupción TXE cuando la cola se queda vacía.
  * @param usart_id Identificador del USART.
  */
 void port_usart_write_data(uint32_t usart_id);
 /**
- * @brief Deshabilita la interrupción de recepción USART.
+ * @brief Deshabilita la interrupción de recepción USART; en modo DMA detiene el stream de recepción.
  * @param usart_id Identificador del USART.
  */
 void port_usart_disable_rx_interrupt(uint32_t usart_id);
@@ -123,12 +461,12 @@ void port_usart_disable_rx_interrupt(uint32_t usart_id);
  */
 void port_usart_disable_tx_interrupt(uint32_t usart_id);
 /**
- * @brief habilita la interrupción de recepción USART.
+ * @brief habilita la interrupción de recepción USART; en modo DMA arranca el stream circular de recepción.
  * @param usart_id Identificador del USART.
  */
 void port_usart_enable_rx_interrupt(uint32_t usart_id);
 /**
- * @brief habilita la interrupción de transmisión USART.
+ * @brief habilita la interrupción de transmisión USART; en modo DMA arranca la transferencia del siguiente mensaje si no hay ninguna en curso.
  * @param usart_id Identificadro del USART.
  */
 void port_usart_enable_tx_interrupt(uint32_t usart_id);
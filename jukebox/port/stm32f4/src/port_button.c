@@ -11,27 +11,56 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "port_button.h"
+#include "port_hw.h"
+#include "button_debounce.h"
 
 /* Global variables ------------------------------------------------------------*/
-port_button_hw_t 	buttons_arr [] = {
-     [BUTTON_0_ID]={.p_port=BUTTON_0_GPIO, .pin=BUTTON_0_PIN, .flag_pressed=false}, /*! se inicializa el array*/
+port_button_hw_t 	buttons_arr [PORT_BUTTON_MAX_BUTTONS] = {
+     [BUTTON_0_ID]={.p_port=BUTTON_0_GPIO, .pin=BUTTON_0_PIN, .flag_pressed=false, .active_low=true, .event=BUTTON_0_EVENT}, /*! se inicializa el array*/
 };
+static uint8_t exti_line_button[PORT_BUTTON_EXTI_LINES]; /*!< Identificador del botón conectado a cada línea EXTI */
+static uint32_t exti_button_lines = 0; /*!< Máscara de las líneas EXTI que tienen un botón */
+static uint32_t init_buttons = 0; /*!< Máscara de los botones inicializados, indexada por su identificador */
+static uint32_t debounce_mode = PORT_BUTTON_DEBOUNCE_EXTI; /*!< Modo de detección actual */
+static button_debounce_t debounce; /*!< Filtro de contadores verticales del modo muestreado */
+static uint32_t edges_pressed = 0; /*!< Flancos de presionado filtrados pendientes de leer */
+static uint32_t edges_released = 0; /*!< Flancos de liberado filtrados pendientes de leer */
+
+/**
+ * @brief Obtiene la configuración de la EXTI de un botón en un modo de detección: en el modo muestreado la línea sigue
+ * detectando flancos pero no pide interrupción.
+ * @param mode Modo de detección.
+ * @return Máscara de disparo para port_system_gpio_config_exti().
+ */
+static uint32_t _exti_trigger(uint32_t mode)
+{
+    return (mode == PORT_BUTTON_DEBOUNCE_EXTI) ? (TRIGGER_BOTH_EDGE | TRIGGER_ENABLE_INTERR_REQ) : TRIGGER_BOTH_EDGE;
+}
+
 /**
  * @brief Inicializa el botón especificado.
  * @param button_id es el identificador del botón a inicializar.
+ * @return `false` si la línea EXTI del pin ya es de otro botón.
  */
-void port_button_init(uint32_t button_id)
+bool port_button_init(uint32_t button_id)
 {
     GPIO_TypeDef *p_port = buttons_arr[button_id].p_port; /*se castea*/
     uint8_t pin = buttons_arr[button_id].pin; /*!se crea la variable pin con button_id*/
+    if ((exti_button_lines & BIT_POS_TO_MASK(pin)) && (exti_line_button[pin] != button_id))
+    {
+        return false; /*! los pines con el mismo número comparten línea EXTI: la ISR no sabría a qué botón atribuir el flanco */
+    }
     port_system_gpio_config(p_port,pin,GPIO_MODE_IN,GPIO_PUPDR_NOPULL);  /*!  se llama con los argumentos correctos para configurar el botón como entrada y sin conexión pull up ni pull down*/
 
-    port_system_gpio_config_exti(p_port, pin, TRIGGER_BOTH_EDGE | TRIGGER_ENABLE_INTERR_REQ );/*! se Configura la interrupción EXTI asociada al botón externo para que se active en ambos flancos de la señal 
-     y se habilita la solicitud de interrupción*/
+    port_system_gpio_config_exti(p_port, pin, _exti_trigger(debounce_mode));/*! se Configura la interrupción EXTI asociada al botón externo para que se active en ambos flancos de la señal 
+     y, en el modo EXTI, se habilita la solicitud de interrupción*/
      /*!se Habilita la interrupción NVIC correspondiente al pin GPIO del botón externo*/
     port_system_gpio_exti_enable (pin,1,0);	
-    
-    /* TO-DO alumnos */
+
+    exti_line_button[pin] = (uint8_t)button_id; /*!se registra el botón en la tabla de demultiplexado de la EXTI*/
+    exti_button_lines |= BIT_POS_TO_MASK(pin);
+    init_buttons |= BIT_POS_TO_MASK(button_id);
+    return true;
 }
 /**
  * @brief Verifica si el botón especificado está presionado.
@@ -48,4 +77,119 @@ bool port_button_is_pressed	(uint32_t button_id){
  */
 uint32_t port_button_get_tick(){
       return port_system_get_millis(); /*!se obtiene el valor del contador de milisegundos*/
-}
\ No newline at end of file
+}
+/**
+ * @brief Obtiene el evento que despierta a la FSM del botón.
+ * @param button_id ID del botón.
+ * @return Identificador del evento.
+ */
+uint32_t port_button_get_event(uint32_t button_id){
+      return buttons_arr[button_id].event;
+}
+/**
+ * @brief Obtiene el tick del sistema del último cambio del botón.
+ * @param button_id ID del botón.
+ * @return Tick del último cambio.
+ */
+uint32_t port_button_get_edge_tick(uint32_t button_id){
+      return buttons_arr[button_id].edge_tick;
+}
+
+void port_button_exti_isr(uint32_t lines)
+{
+    uint32_t pending = EXTI->PR & lines & exti_button_lines;
+    port_hw_exti_clear_pending(pending); /* rc_w1: sólo se limpian las líneas que se van a atender */
+
+    uint32_t now = port_system_get_millis();
+    GPIO_TypeDef *p_port = NULL;
+    uint32_t idr = 0;
+    while (pending != 0)
+    {
+        uint32_t line = (uint32_t)__builtin_ctz(pending);
+        pending &= pending - 1U;
+        port_button_hw_t *p_button = &buttons_arr[exti_line_button[line]];
+        if (p_button->p_port != p_port)
+        {
+            p_port = p_button->p_port;
+            idr = p_port->IDR;
+        }
+        bool level = (idr & BIT_POS_TO_MASK(line)) != 0;
+        p_button->flag_pressed = (level != p_button->active_low);
+        p_button->edge_tick = now;
+        port_system_post_event(p_button->event);
+    }
+}
+
+void port_button_set_debounce_mode(uint32_t mode)
+{
+    uint32_t trigger = _exti_trigger(mode);
+    uint32_t buttons = init_buttons;
+    while (buttons != 0)
+    {
+        uint32_t id = (uint32_t)__builtin_ctz(buttons);
+        buttons &= buttons - 1U;
+        port_system_gpio_config_exti(buttons_arr[id].p_port, buttons_arr[id].pin, trigger);
+    }
+
+    uint32_t state = port_system_enter_critical();
+    button_debounce_init(&debounce, port_button_sample()); /* El nivel actual es el estado estable de partida */
+    edges_pressed = 0;
+    edges_released = 0;
+    debounce_mode = mode;
+    port_system_exit_critical(state);
+}
+
+uint32_t port_button_sample(void)
+{
+    uint32_t sample = 0;
+    GPIO_TypeDef *p_port = NULL;
+    uint32_t idr = 0;
+    uint32_t buttons = init_buttons;
+    while (buttons != 0)
+    {
+        uint32_t id = (uint32_t)__builtin_ctz(buttons);
+        buttons &= buttons - 1U;
+        port_button_hw_t *p_button = &buttons_arr[id];
+        if (p_button->p_port != p_port)
+        {
+            p_port = p_button->p_port;
+            idr = p_port->IDR;
+        }
+        bool level = (idr & BIT_POS_TO_MASK(p_button->pin)) != 0;
+        if (level != p_button->active_low)
+        {
+            sample |= BIT_POS_TO_MASK(id);
+        }
+    }
+    return sample;
+}
+
+void port_button_take_edges(uint32_t *p_pressed, uint32_t *p_released)
+{
+    uint32_t state = port_system_enter_critical();
+    *p_pressed = edges_pressed;
+    *p_released = edges_released;
+    edges_pressed = 0;
+    edges_released = 0;
+    port_system_exit_critical(state);
+}
+
+void port_button_sample_tick(uint32_t now)
+{
+    if ((debounce_mode != PORT_BUTTON_DEBOUNCE_SAMPLED) || ((now % PORT_BUTTON_SAMPLE_PERIOD_MS) != 0))
+    {
+        return;
+    }
+    uint32_t pressed, released;
+    uint32_t changed = button_debounce_update(&debounce, port_button_sample(), &pressed, &released);
+    edges_pressed |= pressed;
+    edges_released |= released;
+    while (changed != 0)
+    {
+        uint32_t id = (uint32_t)__builtin_ctz(changed);
+        changed &= changed - 1U;
+        buttons_arr[id].flag_pressed = (pressed & BIT_POS_TO_MASK(id)) != 0;
+        buttons_arr[id].edge_tick = now;
+        port_system_post_event(buttons_arr[id].event);
+    }
+}
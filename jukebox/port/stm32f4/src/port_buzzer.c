@@ -0,0 +1,259 @@
+/**
+ * @file port_buzzer.c
+ * @brief Portable functions to interact with the buzzer FSM library.
+ *
+ * This file defines the table of buzzers, the note by note mode and the sequencer that plays a melody from the ISR of
+ * the duration timer.
+ *
+ * @author alumno1
+ * @author alumno2
+ * @date fecha
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "port_buzzer.h"
+#include "port_hw.h"
+#include "note_table.h"
+
+/* Global variables ------------------------------------------------------------*/
+port_buzzer_hw_t buzzers_arr[PORT_BUZZER_MAX_BUZZERS] = {
+    [BUZZER_0_ID] = {.p_port = BUZZER_0_GPIO,
+                     .pin = BUZZER_0_PIN,
+                     .alt_func = BUZZER_0_AF,
+                     .p_pwm_timer = BUZZER_0_PWM_TIMER,
+                     .p_duration_timer = BUZZER_0_DURATION_TIMER,
+                     .duration_irqn = BUZZER_0_DURATION_IRQN,
+                     .event = BUZZER_0_EVENT},
+};
+
+/* Private functions */
+/**
+ * @brief Obtiene el reloj de los temporizadores de APB1, que es el doble del reloj del bus si su prescaler no es 1.
+ * @return Frecuencia en Hz del reloj de TIM2 y TIM3.
+ */
+static uint32_t _timer_clock(void)
+{
+    uint32_t ppre = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+    return (ppre & 0x4U) ? 2U * port_system_get_apb1_clock() : port_system_get_apb1_clock();
+}
+
+/**
+ * @brief Calcula el descriptor de una nota: registros de TIM3 de `note_table` y duración en ticks de TIM2.
+ * @param note Índice de la nota en `note_table`.
+ * @param duration_ms Duración en ms.
+ * @param p_step Puntero donde se guarda el descriptor.
+ */
+static void _make_step(uint32_t note, uint32_t duration_ms, port_buzzer_step_t *p_step)
+{
+    const note_timer_t *p_timer = note_table_get(note);
+    if ((p_timer == NULL) || (note == NOTE_SILENCE))
+    {
+        p_step->psc = 0;
+        p_step->arr = 0; /*! silencio */
+        p_step->ccr = 0;
+    }
+    else
+    {
+        p_step->psc = p_timer->psc;
+        p_step->arr = p_timer->arr;
+        p_step->ccr = (uint16_t)((((uint32_t)p_timer->arr + 1U) * PORT_BUZZER_DUTY_CYCLE_PERCENT) / 100U);
+    }
+    uint32_t ticks = duration_ms * (PORT_BUZZER_DURATION_TICK_HZ / 1000U);
+    p_step->duration = (ticks > 0) ? ticks : 1U;
+}
+
+/**
+ * @brief Aplica a TIM3 un descriptor: la nota empieza en ese instante, con el contador a 0.
+ * @param p_buzzer Buzzer.
+ * @param p_step Descriptor de la nota.
+ */
+static void _apply_step(port_buzzer_hw_t *p_buzzer, const port_buzzer_step_t *p_step)
+{
+    TIM_TypeDef *p_tim = p_buzzer->p_pwm_timer;
+    if (p_step->arr == 0)
+    {
+        p_tim->CCER &= ~TIM_CCER_CC1E; /*! silencio: la salida se deshabilita */
+        return;
+    }
+    p_tim->PSC = p_step->psc;
+    p_tim->ARR = p_step->arr;
+    p_tim->CCR1 = p_step->ccr;
+    port_hw_tim_write_egr(p_tim, TIM_EGR_UG); /*! UG pasa la precarga a los registros activos sin esperar al fin del periodo */
+    p_tim->CCER |= TIM_CCER_CC1E;
+    p_tim->CR1 |= TIM_CR1_CEN;
+}
+
+/**
+ * @brief Decodifica la siguiente nota de la melodía en el descriptor `next` del buzzer.
+ * @param p_buzzer Buzzer.
+ */
+static void _prefetch(port_buzzer_hw_t *p_buzzer)
+{
+    melody_note_t note;
+    p_buzzer->next_valid = melody_cursor_next(&p_buzzer->cursor, &note);
+    if (p_buzzer->next_valid)
+    {
+        _make_step(note.note, note.duration_ms, &p_buzzer->next);
+    }
+}
+
+/**
+ * @brief Para los dos temporizadores y silencia la salida.
+ * @param p_buzzer Buzzer.
+ */
+static void _stop_timers(port_buzzer_hw_t *p_buzzer)
+{
+    p_buzzer->p_duration_timer->CR1 &= ~TIM_CR1_CEN;
+    p_buzzer->p_duration_timer->SR &= ~TIM_SR_UIF;
+    p_buzzer->p_pwm_timer->CCER &= ~TIM_CCER_CC1E;
+    p_buzzer->p_pwm_timer->CR1 &= ~TIM_CR1_CEN;
+}
+
+/* Public functions */
+bool port_buzzer_init(uint32_t buzzer_id)
+{
+    port_buzzer_hw_t *p_buzzer = &buzzers_arr[buzzer_id];
+    TIM_TypeDef *p_pwm = p_buzzer->p_pwm_timer;
+    TIM_TypeDef *p_duration = p_buzzer->p_duration_timer;
+    if (_timer_clock() != NOTE_TABLE_TIMER_CLOCK_HZ)
+    {
+        return false; /*! `note_table` no vale para este reloj */
+    }
+
+    port_system_gpio_config(p_buzzer->p_port, p_buzzer->pin, GPIO_MODE_ALTERNATE, GPIO_PUPDR_NOPULL);
+    port_system_gpio_config_alternate(p_buzzer->p_port, p_buzzer->pin, p_buzzer->alt_func);
+    RCC->APB1ENR |= RCC_APB1ENR_TIM2EN | RCC_APB1ENR_TIM3EN;
+
+    /*! TIM3: PWM modo 1 en el canal 1, con precarga de ARR y CCR1; UG no activa UIF */
+    p_pwm->CR1 = TIM_CR1_ARPE | TIM_CR1_URS;
+    p_pwm->CCMR1 = (p_pwm->CCMR1 & ~TIM_CCMR1_OC1M) | TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1PE;
+    p_pwm->CCER &= ~TIM_CCER_CC1E;
+
+    /*! TIM2: un tick por ms, precarga de ARR e interrupción en cada desbordamiento */
+    p_duration->CR1 = TIM_CR1_ARPE | TIM_CR1_URS;
+    p_duration->PSC = _timer_clock() / PORT_BUZZER_DURATION_TICK_HZ - 1U;
+    p_duration->DIER |= TIM_DIER_UIE;
+    p_duration->SR &= ~TIM_SR_UIF;
+
+    p_buzzer->note_end = false;
+    p_buzzer->melody_end = false;
+    p_buzzer->sequencing = false;
+    p_buzzer->next_valid = false;
+
+    NVIC_SetPriority(p_buzzer->duration_irqn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 1, 0));
+    NVIC_EnableIRQ(p_buzzer->duration_irqn);
+    return true;
+}
+
+void port_buzzer_set_note(uint32_t buzzer_id, uint32_t note)
+{
+    port_buzzer_step_t step;
+    _make_step(note, 0, &step);
+    _apply_step(&buzzers_arr[buzzer_id], &step);
+}
+
+void port_buzzer_set_note_duration(uint32_t buzzer_id, uint32_t duration_ms)
+{
+    port_buzzer_hw_t *p_buzzer = &buzzers_arr[buzzer_id];
+    TIM_TypeDef *p_duration = p_buzzer->p_duration_timer;
+    port_buzzer_step_t step;
+    _make_step(NOTE_SILENCE, duration_ms, &step);
+
+    p_buzzer->note_end = false;
+    p_duration->CR1 &= ~TIM_CR1_CEN;
+    p_duration->ARR = step.duration - 1U;
+    port_hw_tim_write_egr(p_duration, TIM_EGR_UG); /*! carga PSC y ARR y pone el contador a 0 */
+    p_duration->SR &= ~TIM_SR_UIF;
+    p_duration->CR1 |= TIM_CR1_CEN;
+    port_hw_sync(); /*! la cuenta empieza en cuanto se habilita */
+}
+
+bool port_buzzer_get_note_timeout(uint32_t buzzer_id)
+{
+    return __atomic_exchange_n(&buzzers_arr[buzzer_id].note_end, false, __ATOMIC_RELAXED);
+}
+
+bool port_buzzer_play_melody(uint32_t buzzer_id, const melody_t *p_melody)
+{
+    port_buzzer_hw_t *p_buzzer = &buzzers_arr[buzzer_id];
+    TIM_TypeDef *p_duration = p_buzzer->p_duration_timer;
+    port_buzzer_stop(buzzer_id);
+
+    melody_cursor_init(&p_buzzer->cursor, p_melody);
+    _prefetch(p_buzzer);
+    if (!p_buzzer->next_valid)
+    {
+        return false;
+    }
+    port_buzzer_step_t first = p_buzzer->next;
+    p_duration->ARR = first.duration - 1U;
+    port_hw_tim_write_egr(p_duration, TIM_EGR_UG); /*! la duración de la primera nota pasa a los registros activos */
+    p_duration->SR &= ~TIM_SR_UIF;
+    _prefetch(p_buzzer);
+    if (p_buzzer->next_valid)
+    {
+        p_duration->ARR = p_buzzer->next.duration - 1U; /*! precarga: TIM2 la carga él solo al acabar la primera nota */
+    }
+
+    uint32_t state = port_system_enter_critical();
+    p_buzzer->melody_end = false;
+    p_buzzer->sequencing = true;
+    _apply_step(p_buzzer, &first);
+    p_duration->CR1 |= TIM_CR1_CEN;
+    port_system_exit_critical(state);
+    return true;
+}
+
+bool port_buzzer_get_melody_end(uint32_t buzzer_id)
+{
+    return __atomic_exchange_n(&buzzers_arr[buzzer_id].melody_end, false, __ATOMIC_RELAXED);
+}
+
+bool port_buzzer_is_sequencing(uint32_t buzzer_id)
+{
+    return buzzers_arr[buzzer_id].sequencing;
+}
+
+void port_buzzer_stop(uint32_t buzzer_id)
+{
+    port_buzzer_hw_t *p_buzzer = &buzzers_arr[buzzer_id];
+    uint32_t state = port_system_enter_critical();
+    _stop_timers(p_buzzer);
+    p_buzzer->sequencing = false;
+    p_buzzer->next_valid = false;
+    p_buzzer->note_end = false;
+    port_system_exit_critical(state);
+}
+
+uint32_t port_buzzer_get_event(uint32_t buzzer_id)
+{
+    return buzzers_arr[buzzer_id].event;
+}
+
+void port_buzzer_duration_isr(uint32_t buzzer_id)
+{
+    port_buzzer_hw_t *p_buzzer = &buzzers_arr[buzzer_id];
+    p_buzzer->p_duration_timer->SR &= ~TIM_SR_UIF;
+    if (!p_buzzer->sequencing)
+    {
+        p_buzzer->p_duration_timer->CR1 &= ~TIM_CR1_CEN; /*! nota a nota: la FSM programa la siguiente */
+        p_buzzer->note_end = true;
+        port_system_post_event(p_buzzer->event);
+        return;
+    }
+    if (!p_buzzer->next_valid)
+    {
+        _stop_timers(p_buzzer); /*! fin de la última nota */
+        p_buzzer->sequencing = false;
+        p_buzzer->melody_end = true;
+        port_system_post_event(p_buzzer->event);
+        return;
+    }
+    /*! TIM2 ya ha cargado la duración de esta nota desde la precarga: sólo queda cambiar el tono */
+    _apply_step(p_buzzer, &p_buzzer->next);
+    _prefetch(p_buzzer);
+    if (p_buzzer->next_valid)
+    {
+        p_buzzer->p_duration_timer->ARR = p_buzzer->next.duration - 1U;
+    }
+}
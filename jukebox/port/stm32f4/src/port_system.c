@@ -12,6 +12,7 @@
 #define HSI_VALUE ((uint32_t)16000000) /*!< Value of the Internal oscillator in Hz */
 
 /* GLOBAL VARIABLES */
+static volatile uint32_t events_pending = 0; /*!< Events posted by the ISRs and not yet taken by the main loop */
 static volatile uint32_t msTicks = 0; /*!< Variable to store millisecond ticks. @warning **It must be declared volatile!** Just because it is modified in an ISR. **Add it to the definition** after *static*. */
 
 /* These variables are declared extern in CMSIS (system_stm32f4xx.h) */
@@ -132,6 +133,30 @@ void port_system_set_millis(uint32_t ms)
   msTicks = ms;
 }
 
+uint32_t port_system_get_apb1_clock(void)
+{
+  return SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+}
+
+uint32_t port_system_get_apb2_clock(void)
+{
+  return SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos];
+}
+
+uint32_t port_system_itm_write(const uint8_t *p_data, uint32_t length)
+{
+  if (((ITM->TCR & ITM_TCR_ITMENA_Msk) == 0UL) || ((ITM->TER & 1UL) == 0UL))
+  {
+    return length; /* No debugger: the port is not read */
+  }
+  uint32_t sent = 0;
+  while ((sent < length) && (ITM->PORT[0U].u32 != 0UL)) /* Reading the port gives 0 while its FIFO is full */
+  {
+    ITM->PORT[0U].u8 = p_data[sent++];
+  }
+  return sent;
+}
+
 void port_system_delay_ms(uint32_t ms)
 {
   uint32_t tickstart = port_system_get_millis();
@@ -152,6 +177,41 @@ void port_system_delay_until_ms(uint32_t *p_t, uint32_t ms)
   *p_t = port_system_get_millis();
 }
 
+//------------------------------------------------------
+// EVENT RELATED FUNCTIONS
+//------------------------------------------------------
+void port_system_post_event(uint32_t event)
+{
+  __atomic_fetch_or(&events_pending, 1U << event, __ATOMIC_RELAXED);
+}
+
+uint32_t port_system_take_events(void)
+{
+  return __atomic_exchange_n(&events_pending, 0U, __ATOMIC_RELAXED);
+}
+
+void port_system_sleep_until_event(void)
+{
+  __disable_irq();
+  if (events_pending == 0)
+  {
+    __WFI(); /* Wakes up on the pending interrupt even if it is masked */
+  }
+  __enable_irq();
+}
+
+uint32_t port_system_enter_critical(void)
+{
+  uint32_t state = __get_PRIMASK();
+  __disable_irq();
+  return state;
+}
+
+void port_system_exit_critical(uint32_t state)
+{
+  __set_PRIMASK(state);
+}
+
 //------------------------------------------------------
 // GPIO RELATED FUNCTIONS
 //------------------------------------------------------
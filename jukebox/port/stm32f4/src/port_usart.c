@@ -10,12 +10,17 @@
 #include <stdlib.h>
 #include "port_system.h"
 #include "port_usart.h"
+#include "port_hw.h"
 /* Standard C libraries */
 
 /* HW dependent libraries */
 
+/* Private defines */
+#define DMA_STREAM_FLAGS 0x3DU /*!< Indicadores FEIF, DMEIF, TEIF, HTIF y TCIF del stream 0 */
+#define USART_RX_ERROR_FLAGS (USART_SR_ORE | USART_SR_NE | USART_SR_FE | USART_SR_PE) /*!< Indicadores de error de recepción */
+
 /* Global variables */
-port_usart_hw_t usart_arr[] = { /*! se inicializa el array*/
+port_usart_hw_t usart_arr[USART_INSTANCES] = { /*! se inicializa el array*/
     [USART_0_ID] = {
         .p_usart = USART_0,
         .p_port_tx = USART_0_GPIO_TX,
@@ -24,10 +29,81 @@ port_usart_hw_t usart_arr[] = { /*! se inicializa el array*/
         .pin_rx = USART_0_PIN_RX,
         .alt_func_tx = USART_0_AF_TX,
         .alt_func_rx = USART_0_AF_RX,
-        .i_idx = 0,
-        .read_complete = false,
-        .o_idx = 0,
-        .write_complete = false}};
+        .p_port_rts = USART_0_GPIO_RTS,
+        .p_port_cts = USART_0_GPIO_CTS,
+        .pin_rts = USART_0_PIN_RTS,
+        .pin_cts = USART_0_PIN_CTS,
+        .irqn = USART3_IRQn,
+        .event_rx = USART_0_EVENT_RX,
+        .event_tx = USART_0_EVENT_TX,
+        .init_baudrate = USART_0_BAUDRATE,
+        .p_dma = DMA1,
+        .p_dma_rx = USART_0_DMA_RX,
+        .p_dma_tx = USART_0_DMA_TX,
+        .dma_rx_irqn = DMA1_Stream1_IRQn,
+        .dma_tx_irqn = DMA1_Stream3_IRQn,
+        .dma_rx_stream = USART_0_DMA_RX_STREAM,
+        .dma_tx_stream = USART_0_DMA_TX_STREAM,
+        .dma_channel = USART_0_DMA_CHANNEL},
+    [USART_1_ID] = {
+        .p_usart = USART_1,
+        .p_port_tx = USART_1_GPIO_TX,
+        .p_port_rx = USART_1_GPIO_RX,
+        .pin_tx = USART_1_PIN_TX,
+        .pin_rx = USART_1_PIN_RX,
+        .alt_func_tx = USART_1_AF_TX,
+        .alt_func_rx = USART_1_AF_RX,
+        .p_port_rts = USART_1_GPIO_RTS,
+        .p_port_cts = USART_1_GPIO_CTS,
+        .pin_rts = USART_1_PIN_RTS,
+        .pin_cts = USART_1_PIN_CTS,
+        .irqn = USART2_IRQn,
+        .event_rx = USART_1_EVENT_RX,
+        .event_tx = USART_1_EVENT_TX,
+        .init_baudrate = USART_1_BAUDRATE,
+        .p_dma = DMA1,
+        .p_dma_rx = USART_1_DMA_RX,
+        .p_dma_tx = USART_1_DMA_TX,
+        .dma_rx_irqn = DMA1_Stream5_IRQn,
+        .dma_tx_irqn = DMA1_Stream6_IRQn,
+        .dma_rx_stream = USART_1_DMA_RX_STREAM,
+        .dma_tx_stream = USART_1_DMA_TX_STREAM,
+        .dma_channel = USART_1_DMA_CHANNEL},
+    [USART_2_ID] = {
+        .p_usart = USART_2,
+        .p_port_tx = USART_2_GPIO_TX,
+        .p_port_rx = USART_2_GPIO_RX,
+        .pin_tx = USART_2_PIN_TX,
+        .pin_rx = USART_2_PIN_RX,
+        .alt_func_tx = USART_2_AF_TX,
+        .alt_func_rx = USART_2_AF_RX,
+        .p_port_rts = USART_2_GPIO_RTS,
+        .p_port_cts = USART_2_GPIO_CTS,
+        .pin_rts = USART_2_PIN_RTS,
+        .pin_cts = USART_2_PIN_CTS,
+        .irqn = USART1_IRQn,
+        .event_rx = USART_2_EVENT_RX,
+        .event_tx = USART_2_EVENT_TX,
+        .init_baudrate = USART_2_BAUDRATE},
+    [USART_3_ID] = {
+        .p_usart = USART_3,
+        .p_port_tx = USART_3_GPIO_TX,
+        .p_port_rx = USART_3_GPIO_RX,
+        .pin_tx = USART_3_PIN_TX,
+        .pin_rx = USART_3_PIN_RX,
+        .alt_func_tx = USART_3_AF_TX,
+        .alt_func_rx = USART_3_AF_RX,
+        .p_port_rts = USART_3_GPIO_RTS,
+        .p_port_cts = USART_3_GPIO_CTS,
+        .pin_rts = USART_3_PIN_RTS,
+        .pin_cts = USART_3_PIN_CTS,
+        .irqn = USART6_IRQn,
+        .event_rx = USART_3_EVENT_RX,
+        .event_tx = USART_3_EVENT_TX,
+        .init_baudrate = USART_3_BAUDRATE}};
+
+/* Private variables */
+static const uint8_t dma_flag_shift[4] = {0, 6, 16, 22}; /*!< Posición de los indicadores de los streams n y n + 4 en LISR/HISR y LIFCR/HIFCR */
 
 /* Private functions */
 
@@ -42,6 +118,271 @@ void _reset_buffer(char *buffer, uint32_t length)
 {
     memset(buffer, EMPTY_BUFFER_CONSTANT, length); /*!se usa la función memset*/
 };
+/**
+ * @brief Borra los indicadores de un stream DMA del USART.
+ *
+ * @param p_usart Puntero al USART.
+ * @param stream Número del stream.
+ */
+static void _dma_clear_flags(port_usart_hw_t *p_usart, uint32_t stream)
+{
+    uint32_t mask = DMA_STREAM_FLAGS << dma_flag_shift[stream % 4];
+    if (stream < 4)
+    {
+        port_hw_dma_write_lifcr(p_usart->p_dma, mask);
+    }
+    else
+    {
+        port_hw_dma_write_hifcr(p_usart->p_dma, mask);
+    }
+}
+/**
+ * @brief Pide al otro extremo que pare o que siga enviando.
+ *
+ * Se llama desde la ISR o con las interrupciones deshabilitadas.
+ * @param p_usart Puntero al USART.
+ * @param ready Verdadero para que siga, falso para que pare.
+ */
+static void _rx_flow_signal(port_usart_hw_t *p_usart, bool ready)
+{
+    if (p_usart->flow == PORT_USART_FLOW_RTS_CTS)
+    {
+        port_system_gpio_write(p_usart->p_port_rts, p_usart->pin_rts, !ready); /*!RTS es activa a nivel bajo*/
+    }
+    else if (p_usart->flow == PORT_USART_FLOW_XON_XOFF)
+    {
+        p_usart->tx_flow_char = ready ? USART_XON : USART_XOFF;
+        p_usart->p_usart->CR1 |= USART_CR1_TXEIE; /*!la ISR de TXE lo envía antes que la cola*/
+    }
+}
+/**
+ * @brief Pide al otro extremo que pare si el anillo de recepción ha llegado a la marca alta (lado de la ISR).
+ *
+ * @param p_usart Puntero al USART.
+ */
+static void _rx_flow_check_high(port_usart_hw_t *p_usart)
+{
+    if ((p_usart->flow != PORT_USART_FLOW_NONE) && !p_usart->rx_throttled && (spsc_ring_count(&p_usart->rx_ring) >= USART_RX_HIGH_WATERMARK))
+    {
+        p_usart->rx_throttled = true;
+        p_usart->stats.flow_pauses++;
+        _rx_flow_signal(p_usart, false);
+    }
+}
+/**
+ * @brief Pide al otro extremo que siga si el anillo de recepción ha bajado de la marca baja (lado del programa principal).
+ *
+ * @param p_usart Puntero al USART.
+ */
+static void _rx_flow_check_low(port_usart_hw_t *p_usart)
+{
+    if (!p_usart->rx_throttled || (spsc_ring_count(&p_usart->rx_ring) > USART_RX_LOW_WATERMARK))
+    {
+        return;
+    }
+    uint32_t state = port_system_enter_critical(); /*!la ISR también cambia el estado del control de flujo*/
+    p_usart->rx_throttled = false;
+    _rx_flow_signal(p_usart, true);
+    port_system_exit_critical(state);
+}
+/**
+ * @brief Indica si los bytes del anillo de recepción son una línea sin delimitador que ya no puede completarse.
+ *
+ * Con control de flujo el otro extremo para en la marca alta y el anillo no pasa de ella; sin él, la línea no cabe
+ * cuando el anillo está lleno. En los dos casos hay que descartarla para que la recepción siga.
+ * @param p_usart Puntero al USART.
+ * @param count Bytes en el anillo, leídos antes que el número de líneas.
+ * @return Verdadero si hay que descartar los `count` bytes.
+ */
+static bool _rx_line_overflow(port_usart_hw_t *p_usart, uint32_t count)
+{
+    uint32_t limit = (p_usart->flow == PORT_USART_FLOW_NONE) ? USART_RX_RING_LENGTH : USART_RX_HIGH_WATERMARK;
+    return (p_usart->rx_framing != PORT_USART_FRAMING_IDLE) && (count >= limit) && (__atomic_load_n(&p_usart->rx_lines_in, __ATOMIC_ACQUIRE) == p_usart->rx_lines_out);
+}
+/**
+ * @brief Pasa un bloque de bytes recibidos al anillo de recepción y cuenta las líneas que completa.
+ *
+ * @param p_usart Puntero al USART.
+ * @param p_data Bytes recibidos.
+ * @param length Número de bytes.
+ */
+static void _rx_store_block(port_usart_hw_t *p_usart, const uint8_t *p_data, uint32_t length)
+{
+    uint32_t free = USART_RX_RING_LENGTH - spsc_ring_count(&p_usart->rx_ring);
+    uint32_t stored = (length < free) ? length : free;
+    spsc_ring_write(&p_usart->rx_ring, p_data, stored);
+    p_usart->rx_ring.dropped += length - stored; /*!los bytes que no caben se descartan, como en port_usart_store_data()*/
+    p_usart->stats.rx_bytes += length;
+    _rx_flow_check_high(p_usart);
+    if (p_usart->rx_framing == PORT_USART_FRAMING_IDLE)
+    {
+        return; /*!la trama la cierra la interrupción IDLE*/
+    }
+    uint32_t lines = 0;
+    const uint8_t *p_end = p_data + stored;
+    for (const uint8_t *p = p_data; (p = memchr(p, p_usart->rx_delimiter, (size_t)(p_end - p))) != NULL; p++)
+    {
+        lines++;
+    }
+    if (lines > 0)
+    {
+        __atomic_store_n(&p_usart->rx_lines_in, p_usart->rx_lines_in + lines, __ATOMIC_RELEASE); /*!las líneas ya están en el anillo*/
+        p_usart->stats.rx_frames += lines;
+    }
+}
+/**
+ * @brief Cierra la trama en curso al detectar la línea en reposo.
+ *
+ * @param p_usart Puntero al USART.
+ */
+static void _rx_end_frame(port_usart_hw_t *p_usart)
+{
+    uint32_t head = p_usart->rx_ring.head;
+    uint32_t in = p_usart->rx_lines_in;
+    if ((head == p_usart->rx_frame_start) || ((in - __atomic_load_n(&p_usart->rx_lines_out, __ATOMIC_ACQUIRE)) >= USART_RX_FRAME_QUEUE_LENGTH))
+    {
+        return; /*!trama vacía, o cola de finales llena: los bytes se unen a la trama siguiente*/
+    }
+    p_usart->rx_frame_ends[in & (USART_RX_FRAME_QUEUE_LENGTH - 1U)] = head;
+    p_usart->rx_frame_start = head;
+    __atomic_store_n(&p_usart->rx_lines_in, in + 1U, __ATOMIC_RELEASE); /*!el final ya está en la cola*/
+    p_usart->stats.rx_frames++;
+}
+/**
+ * @brief Pasa al anillo de recepción los bytes que el DMA ha escrito en el búfer circular desde la última vez.
+ *
+ * @param p_usart Puntero al USART.
+ */
+static void _dma_rx_collect(port_usart_hw_t *p_usart)
+{
+    uint32_t pos = (USART_DMA_RX_LENGTH - p_usart->p_dma_rx->NDTR) % USART_DMA_RX_LENGTH; /*! posición de escritura del DMA */
+    while (p_usart->dma_rx_pos != pos)
+    {
+        uint32_t end = (pos > p_usart->dma_rx_pos) ? pos : USART_DMA_RX_LENGTH; /*! si da la vuelta, primero hasta el final del búfer */
+        _rx_store_block(p_usart, &p_usart->dma_rx_buffer[p_usart->dma_rx_pos], end - p_usart->dma_rx_pos);
+        p_usart->dma_rx_pos = end % USART_DMA_RX_LENGTH;
+    }
+}
+/**
+ * @brief Cuenta los errores de recepción indicados en una lectura del registro SR.
+ *
+ * @param p_usart Puntero al USART.
+ * @param sr Valor leído del registro SR.
+ */
+static void _rx_count_errors(port_usart_hw_t *p_usart, uint32_t sr)
+{
+    p_usart->stats.overruns += (sr & USART_SR_ORE) ? 1U : 0U;
+    p_usart->stats.noise_errors += (sr & USART_SR_NE) ? 1U : 0U;
+    p_usart->stats.framing_errors += (sr & USART_SR_FE) ? 1U : 0U;
+    p_usart->stats.parity_errors += (sr & USART_SR_PE) ? 1U : 0U;
+}
+/**
+ * @brief Empieza el siguiente mensaje de la cola de transmisión si no hay ninguno en curso.
+ *
+ * Sólo se empieza un mensaje encolado entero: port_usart_send() publica el prefijo y los datos por separado.
+ * @param p_usart Puntero al USART.
+ * @return Verdadero si hay un mensaje en curso.
+ */
+static bool _tx_take_message(port_usart_hw_t *p_usart)
+{
+    if (p_usart->tx_remaining == 0)
+    {
+        uint32_t count = spsc_ring_count(&p_usart->tx_ring);
+        uint32_t length = (count > 0) ? *spsc_ring_peek(&p_usart->tx_ring, 1) : 0;
+        if ((count == 0) || (count < length + 1))
+        {
+            return false;
+        }
+        spsc_ring_consume(&p_usart->tx_ring, 1);
+        if (length == 0)
+        {
+            /*! marca de mensaje sin copia: su descriptor se publicó antes que la marca */
+            p_usart->p_tx_ref = &p_usart->tx_refs[p_usart->tx_ref_tail & (USART_TX_REF_QUEUE_LENGTH - 1U)];
+            length = p_usart->p_tx_ref->length;
+        }
+        p_usart->tx_remaining = length;
+    }
+    return true;
+}
+/**
+ * @brief Obtiene los bytes pendientes del mensaje en curso que están seguidos en memoria.
+ *
+ * @param p_usart Puntero al USART.
+ * @param p_length Puntero donde se guarda el número de bytes seguidos (no más que `tx_remaining`).
+ * @return Puntero al siguiente byte del mensaje en curso.
+ */
+static const uint8_t *_tx_pending(port_usart_hw_t *p_usart, uint32_t *p_length)
+{
+    if (p_usart->p_tx_ref != NULL)
+    {
+        *p_length = p_usart->tx_remaining;
+        return (const uint8_t *)&p_usart->p_tx_ref->p_data[p_usart->p_tx_ref->length - p_usart->tx_remaining];
+    }
+    uint32_t length = spsc_ring_contiguous(&p_usart->tx_ring); /*!si el mensaje da la vuelta a la cola se envía en dos partes*/
+    *p_length = (length < p_usart->tx_remaining) ? length : p_usart->tx_remaining;
+    return spsc_ring_peek(&p_usart->tx_ring, *p_length);
+}
+/**
+ * @brief Da por leídos los siguientes bytes del mensaje en curso y, si era el último, termina el mensaje.
+ *
+ * @param p_usart Puntero al USART.
+ * @param length Número de bytes leídos.
+ */
+static void _tx_advance(port_usart_hw_t *p_usart, uint32_t length)
+{
+    if (p_usart->p_tx_ref == NULL)
+    {
+        spsc_ring_consume(&p_usart->tx_ring, length);
+    }
+    p_usart->tx_remaining -= length;
+    if (p_usart->tx_remaining > 0)
+    {
+        return;
+    }
+    p_usart->tx_messages_sent++;
+    if (p_usart->p_tx_ref != NULL)
+    {
+        port_usart_tx_ref_t ref = *p_usart->p_tx_ref; /*!se copia antes de devolver el descriptor al programa principal*/
+        p_usart->p_tx_ref = NULL;
+        __atomic_store_n(&p_usart->tx_ref_tail, p_usart->tx_ref_tail + 1U, __ATOMIC_RELEASE);
+        if (ref.callback != NULL)
+        {
+            ref.callback(ref.p_data, ref.p_arg); /*!el USART ya no lee la memoria del mensaje*/
+        }
+    }
+}
+/**
+ * @brief Arranca la transferencia DMA de la parte contigua del mensaje en curso, si no hay ninguna transferencia en marcha.
+ * Se llama desde la ISR del stream o con las interrupciones deshabilitadas.
+ *
+ * @param p_usart Puntero al USART.
+ */
+static void _dma_tx_next(port_usart_hw_t *p_usart)
+{
+    if ((p_usart->dma_tx_length != 0) || !_tx_take_message(p_usart))
+    {
+        return;
+    }
+    uint32_t length;
+    const uint8_t *p_data = _tx_pending(p_usart, &length);
+    DMA_Stream_TypeDef *p_stream = p_usart->p_dma_tx;
+    p_stream->CR &= ~DMA_SxCR_EN;
+    _dma_clear_flags(p_usart, p_usart->dma_tx_stream);
+    p_stream->M0AR = (uintptr_t)p_data; /*!el DMA lee directamente de la cola o de la memoria del llamante*/
+    p_stream->NDTR = length;
+    p_usart->dma_tx_length = length;
+    p_stream->CR |= DMA_SxCR_EN;
+}
+/**
+ * @brief Obtiene la frecuencia del reloj del bus APB de un USART.
+ *
+ * @param p_usart Puntero al periférico USART.
+ * @return Frecuencia en Hz: APB2 para USART1 y USART6, APB1 para USART2 y USART3.
+ */
+static uint32_t _apb_clock(USART_TypeDef *p_usart)
+{
+    return ((p_usart == USART1) || (p_usart == USART6)) ? port_system_get_apb2_clock() : port_system_get_apb1_clock();
+}
 /* Public functions */
 /**
  * @brief  Obtiene el mensaje recibido a través del USART y se guarda en el búfer pasado como argumento.
@@ -52,8 +393,201 @@ void _reset_buffer(char *buffer, uint32_t length)
  */
 void port_usart_get_from_input_buffer(uint32_t usart_id, char *p_buffer)
 {
-    memcpy(p_buffer, usart_arr[usart_id].input_buffer, USART_INPUT_BUFFER_LENGTH);
+    const char *p_line;
+    uint32_t length = 0;
+    _reset_buffer(p_buffer, USART_INPUT_BUFFER_LENGTH);
+    if (port_usart_get_line(usart_id, &p_line, &length))
+    {
+        memcpy(p_buffer, p_line, (length < USART_INPUT_BUFFER_LENGTH) ? length : (USART_INPUT_BUFFER_LENGTH - 1));
+    }
 };
+/**
+ * @brief Obtiene una vista sin copia de la línea recibida más antigua.
+ * @param usart_id Identificador del USART.
+ * @param pp_line Puntero donde se guarda el puntero a la línea.
+ * @param p_length Puntero donde se guarda la longitud de la línea.
+ * @return Verdadero si hay una línea completa.
+ */
+bool port_usart_get_line(uint32_t usart_id, const char **pp_line, uint32_t *p_length)
+{
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    uint32_t length;
+    bool idle = (p_usart->rx_framing == PORT_USART_FRAMING_IDLE);
+    while (p_usart->rx_lines_in != p_usart->rx_lines_out)
+    {
+        if (idle)
+        {
+            length = p_usart->rx_frame_ends[p_usart->rx_lines_out & (USART_RX_FRAME_QUEUE_LENGTH - 1U)] - p_usart->rx_ring.tail; /*!la trama acaba donde la cerró la ISR*/
+        }
+        else
+        {
+            spsc_ring_find(&p_usart->rx_ring, p_usart->rx_delimiter, &length); /*!hay una línea completa: el delimitador está en el anillo*/
+        }
+        uint32_t consumed = length + (idle ? 0U : 1U); /*!con el delimitador, si lo hay*/
+        const uint8_t *p_line = spsc_ring_peek(&p_usart->rx_ring, length);
+        if (p_line != NULL)
+        {
+            p_usart->rx_line_length = consumed;
+            *pp_line = (const char *)p_line;
+            *p_length = length;
+            return true;
+        }
+        spsc_ring_consume(&p_usart->rx_ring, consumed); /*!la línea da la vuelta y es demasiado larga para verla contigua*/
+        p_usart->rx_lines_out++;
+        p_usart->rx_lines_dropped++;
+        _rx_flow_check_low(p_usart);
+    }
+    uint32_t count = spsc_ring_count(&p_usart->rx_ring); /*!antes que las líneas: un delimitador que llegue después no se descarta*/
+    if (_rx_line_overflow(p_usart, count))
+    {
+        spsc_ring_consume(&p_usart->rx_ring, count); /*!línea sin delimitador que ya no cabe: se descarta*/
+        p_usart->rx_lines_dropped++;
+        _rx_flow_check_low(p_usart);
+    }
+    return false;
+}
+/**
+ * @brief Obtiene los bytes descartados en recepción por tener el anillo lleno.
+ * @param usart_id Identificador del USART.
+ * @return Bytes descartados.
+ */
+uint32_t port_usart_get_rx_dropped(uint32_t usart_id)
+{
+    return usart_arr[usart_id].rx_ring.dropped;
+}
+/**
+ * @brief Obtiene una copia de los contadores de recepción.
+ * @param usart_id Identificador del USART.
+ * @param p_stats Puntero donde se copian los contadores.
+ */
+void port_usart_get_stats(uint32_t usart_id, port_usart_stats_t *p_stats)
+{
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    uint32_t state = port_system_enter_critical(); /*! copia coherente: la ISR no cuenta a medias */
+    *p_stats = p_usart->stats;
+    p_stats->rx_dropped = p_usart->rx_ring.dropped;
+    port_system_exit_critical(state);
+}
+/**
+ * @brief Pone a cero los contadores de recepción.
+ * @param usart_id Identificador del USART.
+ */
+void port_usart_reset_stats(uint32_t usart_id)
+{
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    uint32_t state = port_system_enter_critical();
+    memset(&p_usart->stats, 0, sizeof(p_usart->stats));
+    p_usart->rx_ring.dropped = 0;
+    port_system_exit_critical(state);
+}
+/**
+ * @brief Comprueba si el control de flujo es compatible con la forma de delimitar la recepción.
+ * @param flow Control de flujo (`enum PORT_USART_FLOW`).
+ * @param delimiter Byte delimitador.
+ * @param framing Criterio (`enum PORT_USART_FRAMING`).
+ * @return Verdadero si son compatibles: XON/XOFF sólo con líneas de texto terminadas en `END_CHAR_CONSTANT`.
+ */
+static bool _flow_allows_framing(uint32_t flow, uint8_t delimiter, uint32_t framing)
+{
+    return (flow != PORT_USART_FLOW_XON_XOFF) || ((delimiter == END_CHAR_CONSTANT) && (framing != PORT_USART_FRAMING_IDLE)); /*! en binario los bytes 0x11 y 0x13 son datos */
+}
+/**
+ * @brief Cambia el byte que delimita las líneas recibidas y vacía el anillo de recepción.
+ * @param usart_id Identificador del USART.
+ * @param delimiter Byte delimitador.
+ * @return Verdadero si se ha cambiado.
+ */
+bool port_usart_set_rx_delimiter(uint32_t usart_id, uint8_t delimiter)
+{
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    if (!_flow_allows_framing(p_usart->flow, delimiter, p_usart->rx_framing))
+    {
+        return false;
+    }
+    uint32_t state = port_system_enter_critical(); /*! la ISR no cuenta líneas con el delimitador anterior mientras se vacía el anillo */
+    p_usart->rx_delimiter = delimiter;
+    spsc_ring_init(&p_usart->rx_ring, p_usart->rx_buffer, USART_RX_RING_LENGTH, USART_RX_LINE_MAX_LENGTH);
+    p_usart->rx_lines_in = 0;
+    p_usart->rx_lines_out = 0;
+    p_usart->rx_line_length = 0;
+    p_usart->rx_lines_dropped = 0;
+    p_usart->rx_frame_start = 0;
+    if (p_usart->rx_throttled) /*! el anillo está vacío: el otro extremo puede seguir */
+    {
+        p_usart->rx_throttled = false;
+        _rx_flow_signal(p_usart, true);
+    }
+    port_system_exit_critical(state);
+    return true;
+}
+/**
+ * @brief Selecciona el control de flujo.
+ * @param usart_id Identificador del USART.
+ * @param flow Control de flujo (`enum PORT_USART_FLOW`).
+ * @return Verdadero si se ha configurado.
+ */
+bool port_usart_set_flow_control(uint32_t usart_id, uint32_t flow)
+{
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    if ((flow == PORT_USART_FLOW_XON_XOFF) && (p_usart->mode == PORT_USART_MODE_DMA))
+    {
+        return false; /*! el DMA no puede intercalar XON/XOFF en la transmisión ni quitarlos de la recepción */
+    }
+    if (!_flow_allows_framing(flow, p_usart->rx_delimiter, p_usart->rx_framing))
+    {
+        return false; /*! XON/XOFF se confundirían con los bytes de una trama binaria */
+    }
+    if ((flow == PORT_USART_FLOW_RTS_CTS) && ((p_usart->p_port_rts == NULL) || (p_usart->p_port_cts == NULL)))
+    {
+        return false; /*! los pines de RTS y CTS no están disponibles en el encapsulado */
+    }
+    uint32_t state = port_system_enter_critical();
+    p_usart->p_usart->CR3 &= ~USART_CR3_CTSE;
+    p_usart->flow = (uint8_t)flow;
+    p_usart->rx_throttled = false;
+    p_usart->tx_flow_char = 0;
+    p_usart->tx_paused = false;
+    if (flow == PORT_USART_FLOW_RTS_CTS)
+    {
+        port_system_gpio_write(p_usart->p_port_rts, p_usart->pin_rts, LOW); /*! listo para recibir */
+        port_system_gpio_config(p_usart->p_port_rts, p_usart->pin_rts, GPIO_MODE_OUT, GPIO_PUPDR_NOPULL);
+        port_system_gpio_config(p_usart->p_port_cts, p_usart->pin_cts, GPIO_MODE_ALTERNATE, GPIO_PUPDR_PUP);
+        port_system_gpio_config_alternate(p_usart->p_port_cts, p_usart->pin_cts, p_usart->alt_func_tx);
+        p_usart->p_usart->CR3 |= USART_CR3_CTSE; /*! el transmisor espera mientras el otro extremo no esté listo */
+    }
+    port_system_exit_critical(state);
+    _rx_flow_check_high(p_usart); /*! el anillo puede estar ya por encima de la marca alta */
+    if (!port_usart_tx_done(usart_id))
+    {
+        port_usart_enable_tx_interrupt(usart_id); /*! reanuda una cola detenida por un XOFF anterior */
+    }
+    return true;
+}
+/**
+ * @brief Selecciona cómo termina cada línea recibida y vacía el anillo de recepción.
+ * @param usart_id Identificador del USART.
+ * @param framing Criterio (`enum PORT_USART_FRAMING`).
+ * @return Verdadero si se ha cambiado.
+ */
+bool port_usart_set_framing(uint32_t usart_id, uint32_t framing)
+{
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    if (!_flow_allows_framing(p_usart->flow, p_usart->rx_delimiter, framing))
+    {
+        return false;
+    }
+    p_usart->rx_framing = (uint8_t)framing;
+    port_usart_set_rx_delimiter(usart_id, p_usart->rx_delimiter);
+    if ((framing == PORT_USART_FRAMING_IDLE) && (p_usart->p_usart->CR1 & USART_CR1_RXNEIE))
+    {
+        p_usart->p_usart->CR1 |= USART_CR1_IDLEIE; /*! la recepción ya estaba habilitada */
+    }
+    else if ((framing != PORT_USART_FRAMING_IDLE) && (p_usart->mode != PORT_USART_MODE_DMA))
+    {
+        p_usart->p_usart->CR1 &= ~USART_CR1_IDLEIE;
+    }
+    return true;
+}
 /**
  * @brief Copia datos al búfer de salida USART. 
  * @param usart_id Identificador del USART.
@@ -65,33 +599,132 @@ bool port_usart_get_txr_status(uint32_t usart_id)
     return usart_arr[usart_id].p_usart->SR & USART_SR_TXE; /*!Se acceder al SR del usart_id y se hace un AND con el valor del registro SR (TXE)*/
 }
 /**
- * @brief Copia datos al búfer de salida USART.
+ * @brief Encola un mensaje para enviarlo, sin bloquear.
  * @param usart_id Identificador del USART.
- * @param p_data Puntero a los datos a copiar.
- * @param length Longitud de los datos a copiar.
+ * @param p_data Puntero a los bytes del mensaje.
+ * @param length Longitud del mensaje.
+ * @return Verdadero si se ha encolado, falso si no cabe en la cola.
  */
-void port_usart_copy_to_output_buffer(uint32_t usart_id, char *p_data, uint32_t length)
+bool port_usart_send(uint32_t usart_id, const char *p_data, uint32_t length)
 {
-
-    memcpy(usart_arr[usart_id].output_buffer, p_data, length);/*! se utiliza la función memcpy pasando como parámetro la longitud, el dato y el buffer de salida de usart_id*/
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    if (length == 0)
+    {
+        return true;
+    }
+    if ((length > USART_TX_MESSAGE_MAX_LENGTH) || (port_usart_get_tx_free(usart_id) < length))
+    {
+        p_usart->tx_rejected++; /*! contrapresión: el llamante decide si reintenta o descarta */
+        return false;
+    }
+    uint8_t prefix = (uint8_t)length;
+    spsc_ring_write(&p_usart->tx_ring, &prefix, 1);
+    spsc_ring_write(&p_usart->tx_ring, (const uint8_t *)p_data, length);
+    port_usart_enable_tx_interrupt(usart_id); /*! la ISR vacía la cola mensaje a mensaje */
+    return true;
+}
+/**
+ * @brief Encola un mensaje sin copiarlo, sin bloquear.
+ * @param usart_id Identificador del USART.
+ * @param p_data Puntero a los bytes del mensaje.
+ * @param length Longitud del mensaje.
+ * @param callback Función que libera la memoria del mensaje.
+ * @param p_arg Argumento de `callback`.
+ * @return Verdadero si se ha encolado, falso si no quedan descriptores o la cola está llena.
+ */
+bool port_usart_send_ref(uint32_t usart_id, const char *p_data, uint32_t length, port_usart_tx_callback_t callback, void *p_arg)
+{
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    if (length == 0)
+    {
+        if (callback != NULL)
+        {
+            callback(p_data, p_arg);
+        }
+        return true;
+    }
+    uint32_t head = p_usart->tx_ref_head;
+    if ((length > USART_TX_REF_MAX_LENGTH) || ((head - __atomic_load_n(&p_usart->tx_ref_tail, __ATOMIC_ACQUIRE)) >= USART_TX_REF_QUEUE_LENGTH) ||
+        (spsc_ring_count(&p_usart->tx_ring) >= USART_TX_QUEUE_LENGTH))
+    {
+        p_usart->tx_rejected++; /*! contrapresión: el llamante decide si reintenta o descarta */
+        return false;
+    }
+    port_usart_tx_ref_t *p_ref = &p_usart->tx_refs[head & (USART_TX_REF_QUEUE_LENGTH - 1U)];
+    p_ref->p_data = p_data;
+    p_ref->length = length;
+    p_ref->callback = callback;
+    p_ref->p_arg = p_arg;
+    p_usart->tx_ref_head = head + 1U;
+    uint8_t mark = 0;
+    spsc_ring_write(&p_usart->tx_ring, &mark, 1); /*! la marca se publica después del descriptor */
+    port_usart_enable_tx_interrupt(usart_id);
+    return true;
+}
+/**
+ * @brief Obtiene el espacio libre en la cola de transmisión.
+ * @param usart_id Identificador del USART.
+ * @return Longitud del mayor mensaje que se puede encolar.
+ */
+uint32_t port_usart_get_tx_free(uint32_t usart_id)
+{
+    uint32_t free = USART_TX_QUEUE_LENGTH - spsc_ring_count(&usart_arr[usart_id].tx_ring);
+    return (free > 0) ? (free - 1) : 0; /*! un byte es para el prefijo de longitud */
+}
+/**
+ * @brief Obtiene los mensajes rechazados por tener la cola de transmisión llena.
+ * @param usart_id Identificador del USART.
+ * @return Mensajes rechazados.
+ */
+uint32_t port_usart_get_tx_rejected(uint32_t usart_id)
+{
+    return usart_arr[usart_id].tx_rejected;
 }
 /**
- * @brief Reinicia el búfer de entrada USART.
+ * @brief Libera la línea recibida más antigua del búfer de entrada USART.
  * @param usart_id Identificador del USART.
  */
 void port_usart_reset_input_buffer(uint32_t usart_id)
 {
-    _reset_buffer(usart_arr[usart_id].input_buffer, USART_INPUT_BUFFER_LENGTH); /*! se resetea el buffer de entrada */
-    usart_arr[usart_id].read_complete = false; /*! deja haberse leído completamente*/
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    if (p_usart->rx_line_length == 0)
+    {
+        const char *p_line;
+        uint32_t length;
+        if (!port_usart_get_line(usart_id, &p_line, &length)) /*! no se había pedido la línea: se localiza para liberarla */
+        {
+            return;
+        }
+    }
+    spsc_ring_consume(&p_usart->rx_ring, p_usart->rx_line_length); /*! se libera la línea con su delimitador */
+    p_usart->rx_line_length = 0;
+    p_usart->rx_lines_out++;
+    _rx_flow_check_low(p_usart);
+    if (port_usart_rx_done(usart_id))
+    {
+        port_system_post_event(p_usart->event_rx); /*! quedan líneas: la FSM del USART tiene trabajo pendiente */
+    }
 }
 /**
- * @brief Reinicia el búfer de salida USART.
+ * @brief Vacía la cola de transmisión.
  * @param usart_id Identificador del USART.
  */
 void port_usart_reset_output_buffer(uint32_t usart_id)
 {
-    _reset_buffer(usart_arr[usart_id].output_buffer, USART_OUTPUT_BUFFER_LENGTH); /*! se resetea el buffer de salida */
-    usart_arr[usart_id].write_complete = false; /*! deja haberse escrito completamente*/
+    port_usart_disable_tx_interrupt(usart_id); /*! la ISR deja de leer la cola antes de vaciarla */
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    spsc_ring_init(&p_usart->tx_ring, p_usart->tx_buffer, USART_TX_QUEUE_LENGTH, 0);
+    p_usart->tx_remaining = 0;
+    p_usart->p_tx_ref = NULL;
+    while (p_usart->tx_ref_tail != p_usart->tx_ref_head) /*! los mensajes sin copia descartados se devuelven a su dueño */
+    {
+        port_usart_tx_ref_t *p_ref = &p_usart->tx_refs[p_usart->tx_ref_tail & (USART_TX_REF_QUEUE_LENGTH - 1U)];
+        p_usart->tx_ref_tail++;
+        if (p_ref->callback != NULL)
+        {
+            p_ref->callback(p_ref->p_data, p_ref->p_arg);
+        }
+    }
 }
 /**
  * @brief Verifica si la recepción USART se ha completado.
@@ -100,7 +733,9 @@ void port_usart_reset_output_buffer(uint32_t usart_id)
  */
 bool port_usart_rx_done(uint32_t usart_id)
 {
-    return usart_arr[usart_id].read_complete; /*!se devuelve si se ha leído completamente*/
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    uint32_t count = spsc_ring_count(&p_usart->rx_ring);
+    return (p_usart->rx_lines_in != p_usart->rx_lines_out) || _rx_line_overflow(p_usart, count); /*!hay alguna línea completa sin liberar o una línea que descartar*/
 }
 /**
  * @brief Verifica si la transmisión USART se ha completado.
@@ -109,7 +744,7 @@ bool port_usart_rx_done(uint32_t usart_id)
  */
 bool port_usart_tx_done(uint32_t usart_id)
 {
-    return usart_arr[usart_id].write_complete; /*!se devuelve si se ha escrito completamente*/
+    return (usart_arr[usart_id].tx_remaining == 0) && (spsc_ring_count(&usart_arr[usart_id].tx_ring) == 0); /*!no queda ningún mensaje por enviar*/
 }
 /**
  * @brief Almacena los datos en el búfer de entrada USART.
@@ -117,26 +752,28 @@ bool port_usart_tx_done(uint32_t usart_id)
  */
 void port_usart_store_data(uint32_t usart_id)
 {
-    char dato = usart_arr[usart_id].p_usart->DR;  /*! obtiene el valor de dato del registro DR con usart_id*/
-    if (dato != END_CHAR_CONSTANT)
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    p_usart->stats.rx_bytes++;
+    uint8_t dato = (uint8_t)port_hw_usart_read_dr(usart_arr[usart_id].p_usart);  /*! obtiene el valor de dato del registro DR con usart_id*/
+    if ((p_usart->flow == PORT_USART_FLOW_XON_XOFF) && ((dato == USART_XON) || (dato == USART_XOFF)))
     {
-        if (usart_arr[usart_id].i_idx >= USART_INPUT_BUFFER_LENGTH)
+        p_usart->tx_paused = (dato == USART_XOFF); /*! control de flujo del otro extremo: no se guarda */
+        if (!p_usart->tx_paused && !port_usart_tx_done(usart_id))
         {
-            usart_arr[usart_id].i_idx = 0; /*! resetea el valor del índice del buffer de entrada*/
-            usart_arr[usart_id].input_buffer[usart_arr[usart_id].i_idx] = dato; /*!carga el valor de dato en el buffer de entrada*/
-            usart_arr[usart_id].i_idx = usart_arr[usart_id].i_idx + 1;/*!actualiza el valor del ínidce del buffer de entrada*/
-        }
-        else
-        {
-            usart_arr[usart_id].input_buffer[usart_arr[usart_id].i_idx] = dato; /*!carga el valor de dato en el buffer de entrada*/
-            usart_arr[usart_id].i_idx = usart_arr[usart_id].i_idx + 1; /*!actualiza el valor del ínidce del buffer de entrada*/
+            p_usart->p_usart->CR1 |= USART_CR1_TXEIE; /*! reanuda la cola */
         }
+        return;
     }
-    else
+    if (p_usart->rx_framing == PORT_USART_FRAMING_IDLE)
+    {
+        spsc_ring_push(&p_usart->rx_ring, dato); /*! sólo se guarda: la trama la cierra la interrupción IDLE */
+    }
+    else if (spsc_ring_push(&p_usart->rx_ring, dato) && (dato == p_usart->rx_delimiter))
     {
-        usart_arr[usart_id].read_complete = true; /*! se ha leído completamente*/
-         usart_arr[usart_id].i_idx = 0; /*! resetea el valor del índice del buffer de entrada*/
+        __atomic_store_n(&p_usart->rx_lines_in, p_usart->rx_lines_in + 1U, __ATOMIC_RELEASE); /*! línea completa: el delimitador ya está en el anillo*/
+        p_usart->stats.rx_frames++;
     }
+    _rx_flow_check_high(p_usart);
 }
 /**
  * @brief Escribe los datos desde el búfer de salida USART.
@@ -144,31 +781,53 @@ void port_usart_store_data(uint32_t usart_id)
  */
 void port_usart_write_data(uint32_t usart_id)
 {
-    uint8_t indice = usart_arr[usart_id].o_idx; /*! obtiene el valor del índice del usart_id*/
-    char dato = usart_arr[usart_id].output_buffer[indice]; /*! obtiene el valor de índice del buffer de salida*/
-    if ((indice == USART_OUTPUT_BUFFER_LENGTH - 1) || (dato == END_CHAR_CONSTANT))
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    uint8_t flow_char = p_usart->tx_flow_char;
+    if (flow_char != 0)
     {
-        usart_arr[usart_id].p_usart->DR = dato;  /*!carga en el registro DR el valor del dato*/
-        port_usart_disable_tx_interrupt(usart_id); /*!se llama a esta función para deshabilitar la interrupción de transmisión*/
-        usart_arr[usart_id].o_idx = 0; /*!se resetea el valor del índice del buffer de salida*/
-        usart_arr[usart_id].write_complete = true; /*!se confirma que se ha leído completamente*/
-    }
-    else
-    {
-        if (dato != EMPTY_BUFFER_CONSTANT) /*!se mira si dato coincide o no con el valor del buffer vacío*/
+        port_hw_usart_write_dr(p_usart->p_usart, flow_char); /*! XON/XOFF se adelanta a la cola */
+        p_usart->tx_flow_char = 0;
+        if (p_usart->tx_paused || port_usart_tx_done(usart_id))
         {
-            usart_arr[usart_id].p_usart->DR = dato; /*!carga en el registro DR el valor del dato*/
-            usart_arr[usart_id].o_idx = usart_arr[usart_id].o_idx + 1; /*!actualiza el valor del ínidce del buffer de salida*/
+            port_usart_disable_tx_interrupt(usart_id);
         }
+        return;
     }
-};
+    if (p_usart->tx_paused)
+    {
+        port_usart_disable_tx_interrupt(usart_id); /*! XOFF recibido: la cola espera a XON */
+        return;
+    }
+    if (!_tx_take_message(p_usart))
+    {
+        port_usart_disable_tx_interrupt(usart_id); /*! cola vacía o mensaje a medio encolar: port_usart_send() la vuelve a habilitar */
+        return;
+    }
+    uint32_t length;
+    uint8_t byte = *_tx_pending(p_usart, &length);
+    port_hw_usart_write_dr(p_usart->p_usart, byte); /*!carga en el registro DR el siguiente byte*/
+    _tx_advance(p_usart, 1);
+    if ((p_usart->tx_remaining == 0) && (spsc_ring_count(&p_usart->tx_ring) == 0))
+    {
+        port_usart_disable_tx_interrupt(usart_id); /*!cola vacía: no hace falta otra interrupción TXE*/
+    }
+}
 /**
  * @brief habilita la interrupción de transmisión USART.
  * @param usart_id Identificador del USART.
  */
 void port_usart_enable_tx_interrupt(uint32_t usart_id)
 {
-    USART3->CR1 |= USART_CR1_TXEIE; /*! se hace un or del valor del TXEIE(transmisión) del registro CR1 para habilitarlo (este valor viene dado en un define)*/
+    if (usart_arr[usart_id].mode == PORT_USART_MODE_DMA)
+    {
+        uint32_t state = port_system_enter_critical(); /*! la ISR del stream también arranca transferencias */
+        _dma_tx_next(&usart_arr[usart_id]);
+        port_system_exit_critical(state);
+        port_hw_sync(); /*! el stream empieza en cuanto se habilita*/
+        return;
+    }
+    usart_arr[usart_id].p_usart->CR1 |= USART_CR1_TXEIE; /*! se hace un or del valor del TXEIE(transmisión) del registro CR1 para habilitarlo (este valor viene dado en un define)*/
+    port_hw_sync(); /*! la interrupción se atiende en cuanto se habilita si TXE ya está activo*/
 };
 /**
  * @brief habilita la interrupción de recepción USART.
@@ -176,7 +835,27 @@ void port_usart_enable_tx_interrupt(uint32_t usart_id)
  */
 void port_usart_enable_rx_interrupt(uint32_t usart_id)
 {
-    USART3->CR1 |= USART_CR1_RXNEIE; /*! se hace un or del valor del RXNEIE(recepción) del registro CR1 para habilitarlo (este valor viene dado en un define)*/
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    if (p_usart->mode == PORT_USART_MODE_DMA)
+    {
+        DMA_Stream_TypeDef *p_stream = p_usart->p_dma_rx;
+        p_stream->CR &= ~DMA_SxCR_EN;
+        _dma_clear_flags(p_usart, p_usart->dma_rx_stream);
+        p_stream->M0AR = (uintptr_t)p_usart->dma_rx_buffer;
+        p_stream->NDTR = USART_DMA_RX_LENGTH;
+        p_usart->dma_rx_pos = 0;
+        p_stream->CR |= DMA_SxCR_EN;
+        p_usart->p_usart->CR1 |= USART_CR1_IDLEIE; /*! en reposo se recogen los bytes que no llenan media vuelta del búfer */
+        p_usart->p_usart->CR3 |= USART_CR3_EIE; /*! el DMA lee DR: los errores ORE, NE y FE sólo llegan a la ISR con EIE */
+        port_hw_sync(); /*! el stream empieza en cuanto se habilita*/
+        return;
+    }
+    if (p_usart->rx_framing == PORT_USART_FRAMING_IDLE)
+    {
+        usart_arr[usart_id].p_usart->CR1 |= USART_CR1_IDLEIE; /*! la interrupción IDLE cierra cada trama */
+    }
+    usart_arr[usart_id].p_usart->CR1 |= USART_CR1_RXNEIE; /*! se hace un or del valor del RXNEIE(recepción) del registro CR1 para habilitarlo (este valor viene dado en un define)*/
+    port_hw_sync(); /*! la interrupción se atiende en cuanto se habilita si RXNE ya está activo*/
 };
 /**
  * @brief Deshabilita la interrupción de recepción USART.
@@ -184,7 +863,14 @@ void port_usart_enable_rx_interrupt(uint32_t usart_id)
  */
 void port_usart_disable_rx_interrupt(uint32_t usart_id)
 {
-    USART3->CR1 &= ~USART_CR1_RXNEIE; /*! se hace un and negado entre el RXNEIE del registro CR1(este valor viene dado en un define) y el CR1 de la usart */
+    usart_arr[usart_id].p_usart->CR1 &= ~USART_CR1_IDLEIE;
+    if (usart_arr[usart_id].mode == PORT_USART_MODE_DMA)
+    {
+        usart_arr[usart_id].p_dma_rx->CR &= ~DMA_SxCR_EN;
+        usart_arr[usart_id].p_usart->CR3 &= ~USART_CR3_EIE;
+        return;
+    }
+    usart_arr[usart_id].p_usart->CR1 &= ~USART_CR1_RXNEIE; /*! se hace un and negado entre el RXNEIE del registro CR1(este valor viene dado en un define) y el CR1 de la usart */
 };
 /**
  * @brief Deshabilita la interrupción de transmisión USART.
@@ -192,8 +878,197 @@ void port_usart_disable_rx_interrupt(uint32_t usart_id)
  */
 void port_usart_disable_tx_interrupt(uint32_t usart_id)
 {
-    USART3->CR1 &= ~USART_CR1_TXEIE;/*! se hace un and negado entre el TXEIE del registro CR1(este valor viene dado en un define) y el CR1 de la usart */
+    if (usart_arr[usart_id].mode == PORT_USART_MODE_DMA)
+    {
+        usart_arr[usart_id].p_dma_tx->CR &= ~DMA_SxCR_EN; /*! la transferencia en curso se abandona */
+        usart_arr[usart_id].dma_tx_length = 0;
+        return;
+    }
+    usart_arr[usart_id].p_usart->CR1 &= ~USART_CR1_TXEIE;/*! se hace un and negado entre el TXEIE del registro CR1(este valor viene dado en un define) y el CR1 de la usart */
 };
+/**
+ * @brief Configura la velocidad del USART a partir de la frecuencia real del reloj de APB1.
+ * @param usart_id Identificador del USART.
+ * @param baudrate Velocidad pedida, en baudios.
+ * @return Verdadero si se ha configurado.
+ */
+bool port_usart_set_baudrate(uint32_t usart_id, uint32_t baudrate)
+{
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    uint32_t clock = _apb_clock(p_usart->p_usart);
+    if ((baudrate == 0) || (clock / baudrate < 8U))
+    {
+        return false; /*! ni con sobremuestreo x8 se alcanza */
+    }
+    /*! En los dos modos el divisor en ciclos de reloj por bit es fAPB / baudios: BRR = USARTDIV * 16 con x16, y con x8
+     la fracción sólo tiene 3 bits */
+    uint32_t div = (clock + baudrate / 2U) / baudrate;
+    bool over8 = (div < 16U);
+    int64_t actual_x1000 = ((int64_t)clock * 1000) / div;
+    int32_t error_ppm = (int32_t)(((actual_x1000 - (int64_t)baudrate * 1000) * 1000) / ((int64_t)baudrate));
+    if ((error_ppm > USART_BAUD_ERROR_MAX_PPM) || (error_ppm < -USART_BAUD_ERROR_MAX_PPM))
+    {
+        return false;
+    }
+    uint32_t ue = p_usart->p_usart->CR1 & USART_CR1_UE;
+    p_usart->p_usart->CR1 &= ~USART_CR1_UE; /*! OVER8 sólo se puede cambiar con el USART deshabilitado */
+    if (over8)
+    {
+        p_usart->p_usart->CR1 |= USART_CR1_OVER8;
+        p_usart->p_usart->BRR = ((div >> 3) << 4) | (div & 0x7U);
+    }
+    else
+    {
+        p_usart->p_usart->CR1 &= ~USART_CR1_OVER8;
+        p_usart->p_usart->BRR = div;
+    }
+    p_usart->p_usart->CR1 |= ue;
+    p_usart->baudrate = (uint32_t)(actual_x1000 / 1000);
+    p_usart->baud_error_ppm = error_ppm;
+    return true;
+}
+/**
+ * @brief Obtiene la velocidad real configurada y su error.
+ * @param usart_id Identificador del USART.
+ * @param p_error_ppm Puntero donde se guarda el error, en partes por millón.
+ * @return Velocidad real, en baudios.
+ */
+uint32_t port_usart_get_baudrate(uint32_t usart_id, int32_t *p_error_ppm)
+{
+    if (p_error_ppm != NULL)
+    {
+        *p_error_ppm = usart_arr[usart_id].baud_error_ppm;
+    }
+    return usart_arr[usart_id].baudrate;
+}
+/**
+ * @brief Selecciona el modo de transferencia del USART.
+ * @param usart_id Identificador del USART.
+ * @param mode Modo (`enum PORT_USART_MODE`).
+ * @return Verdadero si se ha seleccionado el modo.
+ */
+bool port_usart_set_mode(uint32_t usart_id, uint32_t mode)
+{
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    if ((mode == PORT_USART_MODE_DMA) && ((p_usart->p_dma == NULL) || (p_usart->flow == PORT_USART_FLOW_XON_XOFF)))
+    {
+        return false;
+    }
+    port_usart_disable_rx_interrupt(usart_id); /*! se detiene el modo anterior */
+    port_usart_disable_tx_interrupt(usart_id);
+    p_usart->mode = (uint8_t)mode;
+    if (mode == PORT_USART_MODE_DMA)
+    {
+        RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN; /*!Habilita el reloj del DMA*/
+        uint32_t cr = ((uint32_t)p_usart->dma_channel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MINC;
+        p_usart->p_dma_rx->CR = cr | DMA_SxCR_CIRC | DMA_SxCR_HTIE | DMA_SxCR_TCIE; /*!periférico a memoria, circular*/
+        p_usart->p_dma_rx->PAR = (uintptr_t)&p_usart->p_usart->DR;
+        p_usart->p_dma_tx->CR = cr | DMA_SxCR_DIR_0 | DMA_SxCR_TCIE; /*!memoria a periférico*/
+        p_usart->p_dma_tx->PAR = (uintptr_t)&p_usart->p_usart->DR;
+        p_usart->p_usart->CR3 |= USART_CR3_DMAR | USART_CR3_DMAT;
+    }
+    else
+    {
+        p_usart->p_usart->CR3 &= ~(USART_CR3_DMAR | USART_CR3_DMAT);
+    }
+    return true;
+}
+/**
+ * @brief Atiende la interrupción global de un USART.
+ * @param usart_id Identificador del USART.
+ */
+void port_usart_isr(uint32_t usart_id)
+{
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    USART_TypeDef *p_regs = p_usart->p_usart;
+    uint32_t sr = p_regs->SR; /*! la lectura de DR del byte borra también IDLE y los errores: se atienden con esta copia */
+    if (sr & USART_RX_ERROR_FLAGS)
+    {
+        _rx_count_errors(p_usart, sr); /*! SR ya está leído: la lectura de DR de abajo completa el borrado */
+    }
+    if ((sr & USART_SR_RXNE) && (p_regs->CR1 & USART_CR1_RXNEIE)) /*! indicador RXNE activado y RXNEIE habilitado */
+    {
+        if (sr & (USART_SR_FE | USART_SR_PE))
+        {
+            p_usart->stats.rx_bytes++;
+            (void)port_hw_usart_read_dr(p_regs); /*! byte corrupto: se descarta */
+        }
+        else
+        {
+            port_usart_store_data(usart_id); /*! con ORE, DR aún tiene el último byte bueno */
+            if (port_usart_rx_done(usart_id))
+            {
+                port_system_post_event(p_usart->event_rx); /*!mensaje completo: la FSM del USART tiene trabajo pendiente*/
+            }
+        }
+    }
+    else if ((sr & USART_RX_ERROR_FLAGS) && !(p_regs->SR & USART_SR_RXNE))
+    {
+        (void)port_hw_usart_read_dr(p_regs); /*! error sin byte por leer (modo DMA u ORE tardío): sin la lectura de DR la ISR volvería a entrar */
+    }
+    if ((sr & USART_SR_IDLE) && (p_regs->CR1 & USART_CR1_IDLEIE)) /*! línea en reposo */
+    {
+        if (!(sr & USART_SR_RXNE))
+        {
+            (void)port_hw_usart_read_dr(p_regs); /*! SR y después DR: borra IDLE */
+        }
+        if (p_usart->mode == PORT_USART_MODE_DMA)
+        {
+            _dma_rx_collect(p_usart); /*! los bytes que no llegan a media vuelta del búfer no esperan más */
+        }
+        if (p_usart->rx_framing == PORT_USART_FRAMING_IDLE)
+        {
+            _rx_end_frame(p_usart); /*! con RXNE e IDLE a la vez el byte se guarda antes: lo normal es que sea el último de la trama, que se quedó en DR al servirse tarde la interrupción */
+        }
+        if (port_usart_rx_done(usart_id))
+        {
+            port_system_post_event(p_usart->event_rx);
+        }
+    }
+    if ((p_regs->SR & USART_SR_TXE) && (p_regs->CR1 & USART_CR1_TXEIE)) /*! indicador TXE activado y TXEIE habilitado */
+    {
+        port_usart_write_data(usart_id);
+        if (port_usart_tx_done(usart_id))
+        {
+            port_system_post_event(p_usart->event_tx); /*!fin de la transmisión: la FSM del USART tiene trabajo pendiente*/
+        }
+    }
+}
+/**
+ * @brief Atiende la interrupción del stream DMA de recepción.
+ * @param usart_id Identificador del USART.
+ */
+void port_usart_dma_rx_isr(uint32_t usart_id)
+{
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    _dma_clear_flags(p_usart, p_usart->dma_rx_stream);
+    _dma_rx_collect(p_usart);
+    if (port_usart_rx_done(usart_id))
+    {
+        port_system_post_event(p_usart->event_rx); /*!hay líneas completas: la FSM del USART tiene trabajo pendiente*/
+    }
+}
+/**
+ * @brief Atiende la interrupción de fin de transferencia del stream DMA de transmisión.
+ * @param usart_id Identificador del USART.
+ */
+void port_usart_dma_tx_isr(uint32_t usart_id)
+{
+    port_usart_hw_t *p_usart = &usart_arr[usart_id];
+    _dma_clear_flags(p_usart, p_usart->dma_tx_stream);
+    if ((p_usart->dma_tx_length == 0) || (p_usart->p_dma_tx->CR & DMA_SxCR_EN))
+    {
+        return; /*! la transferencia no ha acabado */
+    }
+    uint32_t length = p_usart->dma_tx_length;
+    p_usart->dma_tx_length = 0;
+    _tx_advance(p_usart, length);
+    _dma_tx_next(p_usart);
+    if (port_usart_tx_done(usart_id))
+    {
+        port_system_post_event(p_usart->event_tx); /*!fin de la transmisión: la FSM del USART tiene trabajo pendiente*/
+    }
+}
 /**
  * @brief Inicializa el USART especificado.
  * @param usart_id ID del USART a inicializar.
@@ -214,32 +1089,59 @@ void port_usart_init(uint32_t usart_id)
     port_system_gpio_config_alternate(p_port_tx, pin_tx, alt_func_tx);
     port_system_gpio_config_alternate(p_port_rx, pin_rx, alt_func_rx);
 
-     
-    RCC->APB1ENR |= RCC_APB1ENR_USART3EN;/*!Habilita el reloj del USART*/  
-    USART3->CR1 &= ~USART_CR1_UE;/*!Deshabilita el USART*/
-    p_usart->BRR = 0x0683; /*!establece la velocidad de transmisión*/
-    p_usart->CR1 &= USART_CR1_M; 
-      /*!Configura tamaño de marco de datos, bit de parada y paridad*/
-    p_usart->CR2 &= USART_CR2_STOP;
-    p_usart->CR1 &= USART_CR1_PCE;
-    USART3->CR1 &= ~USART_CR1_OVER8;
-   
-    USART3->CR1 |= USART_CR1_TE | USART_CR1_RE; /*!Habilit transmisión y recepción*/
-     /*!Deshabilita interrupciones de transmisión y recepción*/
-    USART3->CR1 &= ~USART_CR1_TXEIE;
-    USART3->CR1 &= ~USART_CR1_RXNEIE;
+
+    /*!Habilita el reloj del USART*/
+    if (p_usart == USART1)
+    {
+        RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+    }
+    else if (p_usart == USART2)
+    {
+        RCC->APB1ENR |= RCC_APB1ENR_USART2EN;
+    }
+    else if (p_usart == USART3)
+    {
+        RCC->APB1ENR |= RCC_APB1ENR_USART3EN;
+    }
+    else
+    {
+        RCC->APB2ENR |= RCC_APB2ENR_USART6EN;
+    }
+    p_usart->CR1 &= ~USART_CR1_UE;        /*!Deshabilita el USART*/
+    /*!Configura tamaño de marco de datos, bit de parada y paridad: 8N1*/
+    p_usart->CR1 &= ~(USART_CR1_M | USART_CR1_PCE);
+    p_usart->CR2 &= ~USART_CR2_STOP;
+    port_usart_set_baudrate(usart_id, usart_arr[usart_id].init_baudrate); /*!BRR y sobremuestreo calculados con el reloj real de APB*/
+
+    p_usart->CR1 |= USART_CR1_TE | USART_CR1_RE; /*!Habilita transmisión y recepción*/
+    /*!Deshabilita interrupciones de transmisión y recepción*/
+    p_usart->CR1 &= ~(USART_CR1_TXEIE | USART_CR1_RXNEIE);
     /*! Limpia la bandera RXNE*/
-    USART3->CR1 &= ~USART_SR_RXNE;
+    p_usart->SR &= ~USART_SR_RXNE;
     // Enable USART interrupts globally
-    if (p_usart == USART3)
+    NVIC_SetPriority(usart_arr[usart_id].irqn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 2, 0));
+    NVIC_EnableIRQ(usart_arr[usart_id].irqn);
+    if (usart_arr[usart_id].p_dma != NULL) /*! streams del modo DMA */
     {
-        NVIC_SetPriority(USART3_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 2, 0));
-        NVIC_EnableIRQ(USART3_IRQn);
+        NVIC_SetPriority(usart_arr[usart_id].dma_rx_irqn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 2, 0));
+        NVIC_EnableIRQ(usart_arr[usart_id].dma_rx_irqn);
+        NVIC_SetPriority(usart_arr[usart_id].dma_tx_irqn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 2, 0));
+        NVIC_EnableIRQ(usart_arr[usart_id].dma_tx_irqn);
     }
 
-     /*! Habilita el USART*/
-    USART3->CR1 |= USART_CR1_UE;
+    /*! Habilita el USART*/
+    p_usart->CR1 |= USART_CR1_UE;
+    port_usart_set_mode(usart_id, PORT_USART_MODE_IRQ); /*! el modo DMA se selecciona después de inicializar */
      /*!Reiniciar los buffer de entrada y salida*/
-    _reset_buffer(usart_arr[usart_id].input_buffer, USART_INPUT_BUFFER_LENGTH);
-    _reset_buffer(usart_arr[usart_id].output_buffer, USART_OUTPUT_BUFFER_LENGTH);
+    usart_arr[usart_id].rx_framing = PORT_USART_FRAMING_DELIMITER;
+    port_usart_set_rx_delimiter(usart_id, END_CHAR_CONSTANT);
+    spsc_ring_init(&usart_arr[usart_id].tx_ring, usart_arr[usart_id].tx_buffer, USART_TX_QUEUE_LENGTH, 0);
+    usart_arr[usart_id].tx_remaining = 0;
+    usart_arr[usart_id].tx_ref_head = 0;
+    usart_arr[usart_id].tx_ref_tail = 0;
+    usart_arr[usart_id].p_tx_ref = NULL;
+    usart_arr[usart_id].tx_messages_sent = 0;
+    usart_arr[usart_id].tx_rejected = 0;
+    memset(&usart_arr[usart_id].stats, 0, sizeof(usart_arr[usart_id].stats));
+    port_usart_set_flow_control(usart_id, PORT_USART_FLOW_NONE);
 }
@@ -34,6 +34,7 @@
 #include <sys/times.h>
 
 #include "stm32f4xx.h"
+#include "log_sink.h"
 
 /* Variables */
 #undef errno
@@ -70,6 +71,10 @@ void _exit (int status)
 /**
  * @brief Function able to use printf via SWO:ITM. It prints the messages on a terminal in VSCode.
  *
+ * The bytes are copied into the log ring buffer and sent from the SysTick ISR (see log_sink.h), so printf never waits
+ * for the SWO or the USART. The whole write is always reported as done, even if the overflow policy drops part of it,
+ * because newlib would otherwise retry the rest.
+ *
  * @param file
  * @param ptr
  * @param len
@@ -77,11 +82,7 @@ void _exit (int status)
  */
 int _write(int file, char *ptr, int len)
 {
-    int i = 0;
-    for (i = 0; i < len; i++)
-    {
-        ITM_SendChar((*ptr++));
-    }
+    log_sink_write(ptr, (uint32_t)len);
     return len;
 }
 
@@ -0,0 +1,163 @@
+/**
+ * @file bench_button_debounce.c
+ * @brief Benchmark of the two button debounce modes under a synthetic bounce storm: one EXTI interrupt per edge with
+ * the timer of `fsm_button`, versus periodic sampling filtered with vertical counters.
+ *
+ * Every press and every release of the button is preceded by a burst of contact bounces with pseudo-random gaps. For
+ * each mode it reports the EXTI interrupts and the button FSM fires per press, and whether every press was detected
+ * exactly once. It also measures the host time of one update of the vertical-counter filter (32 buttons at once).
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <time.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_button.h"
+#include "native_sim.h"
+
+/* Other libraries */
+#include "fsm_button.h"
+#include "fsm_sched.h"
+#include "button_debounce.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_PRESSES 200         /*!< Number of presses (each one followed by a release) */
+#define BENCH_BOUNCES 24          /*!< Bounce edges before each press and each release */
+#define BENCH_BOUNCE_MAX_US 400   /*!< Maximum gap between two bounce edges */
+#define BENCH_HOLD_MS 300         /*!< Time the level is stable after the bounces */
+#define BENCH_FILTER_UPDATES 10000000U /*!< Updates of the vertical-counter filter measured */
+
+/* Private variables ------------------------------------------------------------*/
+static uint32_t lcg = 12345; /*!< State of the pseudo-random generator of the bounce gaps */
+
+/* Private functions */
+/**
+ * @brief Host monotonic time in nanoseconds.
+ */
+static uint64_t _host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Pseudo-random gap between two bounce edges, in microseconds.
+ */
+static uint32_t _bounce_gap_us(void)
+{
+    lcg = lcg * 1103515245U + 12345U;
+    return 20U + (lcg >> 16) % BENCH_BOUNCE_MAX_US;
+}
+
+/**
+ * @brief Advance the virtual clock and let the scheduler serve the FSM after the interrupts raised meanwhile.
+ */
+static void _advance_us(uint64_t us)
+{
+    native_sim_advance_us(us);
+    while (fsm_sched_dispatch())
+    {
+    }
+}
+
+/**
+ * @brief Drive a bouncing edge of the button pin that settles at the given level, and hold it.
+ */
+static void _bouncing_edge(bool level)
+{
+    for (uint32_t i = 0; i < BENCH_BOUNCES; i++)
+    {
+        native_sim_gpio_set_input(BUTTON_0_GPIO, BUTTON_0_PIN, (i % 2) ? !level : level);
+        _advance_us(_bounce_gap_us());
+    }
+    native_sim_gpio_set_input(BUTTON_0_GPIO, BUTTON_0_PIN, level);
+    _advance_us(BENCH_HOLD_MS * 1000ULL);
+}
+
+/**
+ * @brief Run the bounce storm in one debounce mode and print one line of results.
+ */
+static void _run(uint32_t mode)
+{
+    port_system_init();
+    native_sim_set_stall_guard(false);
+    uint32_t debounce_ms = (mode == PORT_BUTTON_DEBOUNCE_EXTI) ? BUTTON_0_DEBOUNCE_TIME_MS : 0;
+    fsm_t *p_fsm_button = fsm_button_new(debounce_ms, BUTTON_0_ID);
+    port_button_set_debounce_mode(mode);
+    fsm_sched_init();
+    fsm_sched_add(p_fsm_button, fsm_button_fire, FSM_SCHED_EVENT(BUTTON_0_EVENT));
+    native_sim_reset_irq_counts();
+    fsm_sched_reset_stats();
+
+    uint32_t detected = 0;
+    uint32_t presses = 0;
+    uint32_t releases = 0;
+    for (uint32_t i = 0; i < BENCH_PRESSES; i++)
+    {
+        _bouncing_edge(LOW);
+        _bouncing_edge(HIGH);
+        if (fsm_button_get_duration(p_fsm_button) > 0)
+        {
+            detected++;
+            fsm_button_reset_duration(p_fsm_button);
+        }
+        uint32_t pressed, released;
+        port_button_take_edges(&pressed, &released);
+        presses += (pressed != 0);
+        releases += (released != 0);
+    }
+
+    fsm_sched_stats_t stats;
+    fsm_sched_get_stats(&stats);
+    uint32_t exti = native_sim_get_irq_count(EXTI15_10_IRQn);
+    printf("%-8s %12.1f %12.1f %9u/%u", (mode == PORT_BUTTON_DEBOUNCE_EXTI) ? "exti" : "sampled",
+           (double)exti / BENCH_PRESSES, (double)stats.fires / BENCH_PRESSES, (unsigned)detected, (unsigned)BENCH_PRESSES);
+    if (mode == PORT_BUTTON_DEBOUNCE_SAMPLED)
+    {
+        printf("   (edge masks: %u presses, %u releases)", (unsigned)presses, (unsigned)releases);
+    }
+    printf("\n");
+
+    port_button_set_debounce_mode(PORT_BUTTON_DEBOUNCE_EXTI);
+    fsm_destroy(p_fsm_button);
+}
+
+/**
+ * @brief Host time of one update of the vertical-counter filter with all 32 inputs bouncing.
+ */
+static void _measure_filter(void)
+{
+    button_debounce_t debounce;
+    button_debounce_init(&debounce, 0);
+    uint32_t pressed, released;
+    uint32_t sink = 0;
+    uint64_t start = _host_ns();
+    for (uint32_t i = 0; i < BENCH_FILTER_UPDATES; i++)
+    {
+        sink += button_debounce_update(&debounce, i * 2654435761U, &pressed, &released);
+    }
+    uint64_t ns = _host_ns() - start;
+    printf("Vertical-counter filter: %.2f ns per update of 32 buttons (checksum %u)\n", (double)ns / BENCH_FILTER_UPDATES, (unsigned)sink);
+}
+
+/**
+ * @brief Main function of the benchmark.
+ *
+ * @return int
+ */
+int main(void)
+{
+    printf("Button debounce benchmark (%u presses, %u bounce edges per press and per release)\n", (unsigned)BENCH_PRESSES, (unsigned)BENCH_BOUNCES);
+    printf("%-8s %12s %12s %11s\n", "mode", "EXTI/press", "fires/press", "detected");
+    _run(PORT_BUTTON_DEBOUNCE_EXTI);
+    _run(PORT_BUTTON_DEBOUNCE_SAMPLED);
+    _measure_filter();
+    return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file bench_cmd_dispatch.c
+ * @brief Benchmark of the serial command dispatch: the `if/else if (strcmp(...))` chain of `_execute_command()`
+ * versus the perfect hash of `cmd_registry`.
+ *
+ * Both dispatchers know the same 32 commands. The chain works as the README describes it: the line is copied out of the
+ * receive ring with `fsm_usart_get_in_data()`, split at the first space and compared with each name in turn, and the
+ * argument is converted with `atoi()`. The registry works on the zero-copy view of the line. It reports the host time
+ * per command for the first, a middle and the last command of the table, and for an unknown command.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* HW dependent libraries */
+#include "port_usart.h"
+
+/* Other libraries */
+#include "cmd_registry.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_DISPATCHES 2000000U /*!< Commands dispatched in each measurement */
+#define BENCH_COMMANDS 32U        /*!< Commands of the table */
+
+/* Private variables ------------------------------------------------------------*/
+static volatile int32_t sink; /*!< Keeps the handlers from being optimised away */
+
+/* Private functions */
+static uint32_t do_command(void *p_context, const cmd_args_t *p_args)
+{
+    sink += (p_args->argc > 0) ? p_args->argv[0] : 1;
+    return CMD_REGISTRY_OK;
+}
+
+/*!< Commands of the jukebox console plus the ones a scripted setup adds */
+static const cmd_entry_t cmd_table[BENCH_COMMANDS + 1] = {
+    {"play", do_command, 0, 1}, {"stop", do_command, 0, 1}, {"pause", do_command, 0, 1}, {"next", do_command, 0, 1},
+    {"before", do_command, 0, 1}, {"longest", do_command, 0, 1}, {"shortest", do_command, 0, 1}, {"album", do_command, 0, 1},
+    {"select", do_command, 0, 1}, {"speed", do_command, 0, 1}, {"volume", do_command, 0, 1}, {"info", do_command, 0, 1},
+    {"status", do_command, 0, 1}, {"repeat", do_command, 0, 1}, {"shuffle", do_command, 0, 1}, {"seek", do_command, 0, 1},
+    {"tone", do_command, 0, 1}, {"rest", do_command, 0, 1}, {"tempo", do_command, 0, 1}, {"octave", do_command, 0, 1},
+    {"reg", do_command, 0, 1}, {"reset", do_command, 0, 1}, {"help", do_command, 0, 1}, {"version", do_command, 0, 1},
+    {"baud", do_command, 0, 1}, {"binary", do_command, 0, 1}, {"echo", do_command, 0, 1}, {"stats", do_command, 0, 1},
+    {"led", do_command, 0, 1}, {"button", do_command, 0, 1}, {"first", do_command, 0, 1}, {"volume_up", do_command, 0, 1},
+    {NULL, NULL, 0, 0}};
+
+/**
+ * @brief Host monotonic time in nanoseconds.
+ */
+static uint64_t _host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Dispatch as `_execute_command()` does: null-terminated copy of the line and one `strcmp()` per command.
+ */
+static uint32_t _dispatch_chain(const char *p_line, uint32_t length)
+{
+    char command[USART_INPUT_BUFFER_LENGTH];
+    memset(command, EMPTY_BUFFER_CONSTANT, sizeof(command));
+    memcpy(command, p_line, (length < USART_INPUT_BUFFER_LENGTH) ? length : (USART_INPUT_BUFFER_LENGTH - 1));
+    char *p_arg = strchr(command, ' ');
+    if (p_arg != NULL)
+    {
+        *p_arg++ = EMPTY_BUFFER_CONSTANT;
+    }
+    for (const cmd_entry_t *p_entry = cmd_table; p_entry->p_name != NULL; p_entry++)
+    {
+        if (strcmp(command, p_entry->p_name) == 0)
+        {
+            cmd_args_t args = {.argc = (p_arg != NULL), .argv = {(p_arg != NULL) ? atoi(p_arg) : 0}};
+            return p_entry->handler(NULL, &args);
+        }
+    }
+    return CMD_REGISTRY_UNKNOWN;
+}
+
+/**
+ * @brief Measure both dispatchers with one line and print one row of results.
+ */
+static void _run(const cmd_registry_t *p_registry, const char *p_label, const char *p_line)
+{
+    uint32_t length = (uint32_t)strlen(p_line);
+    uint64_t start = _host_ns();
+    for (uint32_t i = 0; i < BENCH_DISPATCHES; i++)
+    {
+        sink += (int32_t)_dispatch_chain(p_line, length);
+    }
+    uint64_t chain_ns = _host_ns() - start;
+    start = _host_ns();
+    for (uint32_t i = 0; i < BENCH_DISPATCHES; i++)
+    {
+        sink += (int32_t)cmd_registry_dispatch(p_registry, p_line, length, NULL);
+    }
+    uint64_t registry_ns = _host_ns() - start;
+    printf("%-10s %-16s %12.1f %12.1f\n", p_label, p_line, (double)chain_ns / BENCH_DISPATCHES, (double)registry_ns / BENCH_DISPATCHES);
+}
+
+/**
+ * @brief Main function of the benchmark.
+ *
+ * @return int
+ */
+int main(void)
+{
+    static cmd_registry_t registry;
+    if (!cmd_registry_build(&registry, cmd_table))
+    {
+        printf("ERROR: the perfect hash of the command table could not be built\n");
+        return 1;
+    }
+    printf("Command dispatch benchmark (%u commands, %u slots, seed %u)\n", (unsigned)BENCH_COMMANDS, (unsigned)(registry.mask + 1), (unsigned)registry.seed);
+    printf("%-10s %-16s %12s %12s\n", "position", "line", "strcmp ns", "hash ns");
+    _run(&registry, "first", "play 1");
+    _run(&registry, "middle", "shuffle 1");
+    _run(&registry, "last", "volume_up 5");
+    _run(&registry, "unknown", "rewind 3");
+    return 0;
+}
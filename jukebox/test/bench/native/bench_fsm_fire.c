@@ -0,0 +1,141 @@
+/**
+ * @file bench_fsm_fire.c
+ * @brief Benchmark of the transition dispatch of the FSMs: `fsm_fire()` (linear scan of the table) versus
+ * `fsm_index_fire()` (transitions of the current state only).
+ *
+ * Each FSM is fired in every state with all the input conditions false, which is what the super-loop does most of the
+ * time. The button and USART FSMs use their real tables, which are below `FSM_INDEX_MIN_TRANSITIONS` and are fired with
+ * `fsm_fire()` by fsm_button_fire() and fsm_usart_fire(); the synthetic FSM has 64 states and 2 transitions per state.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_button.h"
+#include "port_usart.h"
+#include "native_sim.h"
+
+/* Other libraries */
+#include "fsm_index.h"
+#include "fsm_button.h"
+#include "fsm_usart.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_FIRES 4000000U  /*!< Number of fires of each measurement */
+#define SYNTH_STATES 64       /*!< States of the synthetic FSM */
+
+/* Private variables ------------------------------------------------------------*/
+static fsm_trans_t fsm_trans_synth[2 * SYNTH_STATES + 1]; /*!< Table of the synthetic FSM */
+static fsm_index_t fsm_index_synth;                       /*!< Index of the synthetic table */
+static volatile bool synth_event = false;                 /*!< Input of the synthetic FSM (never true in the benchmark) */
+
+/* Private functions */
+static bool check_synth_event(fsm_t *p_this)
+{
+    return synth_event;
+}
+
+static int fire_synth(fsm_t *p_this)
+{
+    return fsm_index_fire(p_this, &fsm_index_synth);
+}
+
+/**
+ * @brief Build the synthetic table: from each state, one transition to the next state and one back to state 0.
+ * The rows are ordered as a student would write them, state by state.
+ */
+static void _build_synth(void)
+{
+    for (int s = 0; s < SYNTH_STATES; s++)
+    {
+        fsm_trans_synth[2 * s] = (fsm_trans_t){s, check_synth_event, (s + 1) % SYNTH_STATES, NULL};
+        fsm_trans_synth[2 * s + 1] = (fsm_trans_t){s, check_synth_event, 0, NULL};
+    }
+    fsm_trans_synth[2 * SYNTH_STATES] = (fsm_trans_t){-1, NULL, -1, NULL};
+    fsm_index_build(&fsm_index_synth, fsm_trans_synth);
+}
+
+/**
+ * @brief Host time in nanoseconds.
+ */
+static uint64_t _host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Fire an FSM `BENCH_FIRES` times, sweeping all its states.
+ *
+ * @param p_fsm FSM to fire
+ * @param fire Fire function
+ * @param num_states Number of states to sweep
+ * @return Fires per second
+ */
+static double _measure(fsm_t *p_fsm, int (*fire)(fsm_t *), int num_states)
+{
+    uint32_t fired = 0;
+    uint64_t start = _host_ns();
+    for (uint32_t i = 0; i < BENCH_FIRES; i++)
+    {
+        fsm_set_state(p_fsm, (int)(i % (uint32_t)num_states));
+        fired += (uint32_t)fire(p_fsm);
+    }
+    uint64_t elapsed = _host_ns() - start;
+    if (fired != 0)
+    {
+        printf("WARNING: %u unexpected transitions\n", (unsigned)fired);
+    }
+    return (double)BENCH_FIRES * 1e9 / (double)elapsed;
+}
+
+/**
+ * @brief Print one line of results.
+ */
+static void _report(const char *p_name, int rows, double linear, double indexed)
+{
+    printf("%-18s %5d %16.0f %16.0f %8.2fx\n", p_name, rows, linear, indexed, indexed / linear);
+}
+
+/**
+ * @brief Benchmark entry point.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    native_sim_set_stall_guard(false); /* Only the CPU time of the dispatch is measured */
+
+    fsm_t *p_fsm_button = fsm_button_new(BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
+    fsm_t *p_fsm_usart = fsm_usart_new(USART_0_ID);
+    fsm_t fsm_synth;
+    _build_synth();
+    fsm_init(&fsm_synth, fsm_trans_synth);
+
+    /* All the conditions false: button released and debounce timer not started, no USART traffic */
+    port_system_gpio_exti_disable(BUTTON_0_PIN);
+    buttons_arr[BUTTON_0_ID].flag_pressed = false;
+
+    printf("FSM dispatch benchmark (%u fires per measurement, all states swept)\n", (unsigned)BENCH_FIRES);
+    printf("%-18s %5s %16s %16s %9s\n", "FSM", "rows", "fsm_fire/s", "own fire/s", "speedup");
+
+    /* BUTTON_PRESSED fires when the button is released: only BUTTON_RELEASED and BUTTON_RELEASED_WAIT are swept */
+    _report("button", 4, _measure(p_fsm_button, fsm_fire, 2), _measure(p_fsm_button, fsm_button_fire, 2));
+    /* SEND_DATA fires when the transmit queue is empty: only WAIT_DATA is swept */
+    _report("usart", 3, _measure(p_fsm_usart, fsm_fire, 1), _measure(p_fsm_usart, fsm_usart_fire, 1));
+    _report("synthetic 64", 2 * SYNTH_STATES, _measure(&fsm_synth, fsm_fire, SYNTH_STATES), _measure(&fsm_synth, fire_synth, SYNTH_STATES));
+
+    fsm_destroy(p_fsm_button);
+    fsm_destroy(p_fsm_usart);
+    return 0;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file bench_fsm_sched.c
+ * @brief Benchmark of the main loop: polling (`fsm_fire()` on every FSM in every iteration) versus the event-driven
+ * scheduler (`fsm_sched_run()`), with the line idle and with a continuous stream of serial messages.
+ *
+ * The virtual clock follows the host clock (time scale 1), so the polling loop runs as fast as the host allows, as it
+ * would on the board, while the scheduler sleeps between interrupts. For each case it reports the FSM fires per second,
+ * the fires that were useful (they executed a transition) and the host CPU time used per second of run time.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_button.h"
+#include "port_usart.h"
+#include "native_sim.h"
+
+/* Other libraries */
+#include "fsm_button.h"
+#include "fsm_usart.h"
+#include "fsm_sched.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_RUN_MS 500   /*!< Duration of each case in milliseconds */
+#define BENCH_MESSAGE "play\n" /*!< Message sent continuously by the peer in the busy case */
+
+/* Private variables ------------------------------------------------------------*/
+static fsm_t *p_fsm_button; /*!< Button FSM */
+static fsm_t *p_fsm_usart;  /*!< USART FSM */
+static uint32_t fires;       /*!< Fires in the polling loop */
+static uint32_t transitions; /*!< Transitions in the polling loop */
+
+/* Private functions */
+/**
+ * @brief CPU time used by the process in nanoseconds.
+ */
+static uint64_t _cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Reset the board, create the FSMs and optionally queue the serial traffic for the whole run.
+ *
+ * @param busy Queue messages at the maximum rate of the line
+ */
+static void _setup(bool busy)
+{
+    port_system_init();
+    p_fsm_button = fsm_button_new(BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
+    p_fsm_usart = fsm_usart_new(USART_0_ID);
+    fsm_usart_enable_rx_interrupt(p_fsm_usart);
+    if (busy)
+    {
+        uint32_t bytes = (BENCH_RUN_MS * NATIVE_SIM_CYCLES_PER_MS) / native_sim_usart_get_frame_cycles(USART_0);
+        for (uint32_t i = 0; i < bytes / strlen(BENCH_MESSAGE); i++)
+        {
+            native_sim_usart_inject_rx(USART_0, (const uint8_t *)BENCH_MESSAGE, strlen(BENCH_MESSAGE));
+        }
+    }
+    native_sim_set_time_scale(1);
+}
+
+/**
+ * @brief Consume the messages received, as the application does.
+ *
+ * @return Number of messages consumed (0 or 1)
+ */
+static uint32_t _consume_message(void)
+{
+    if (!fsm_usart_check_data_received(p_fsm_usart))
+    {
+        return 0;
+    }
+    fsm_usart_reset_input_data(p_fsm_usart);
+    return 1;
+}
+
+/**
+ * @brief Print one line of results.
+ */
+static void _report(const char *p_loop, const char *p_load, uint32_t n_fires, uint32_t n_transitions, uint32_t messages, uint64_t cpu_ns)
+{
+    double seconds = BENCH_RUN_MS / 1000.0;
+    printf("%-10s %-6s %14.0f %12.0f %9u %8.1f%%\n", p_loop, p_load, n_fires / seconds, n_transitions / seconds,
+           (unsigned)messages, 100.0 * (double)cpu_ns / (BENCH_RUN_MS * 1e6));
+}
+
+/**
+ * @brief Polling super-loop: every FSM is fired in every iteration.
+ */
+static void _run_polling(bool busy)
+{
+    _setup(busy);
+    fires = 0;
+    transitions = 0;
+    uint32_t messages = 0;
+    uint32_t end = port_system_get_millis() + BENCH_RUN_MS;
+    uint64_t cpu_start = _cpu_ns();
+    while ((int32_t)(port_system_get_millis() - end) < 0)
+    {
+        transitions += (uint32_t)fsm_fire(p_fsm_button);
+        transitions += (uint32_t)fsm_fire(p_fsm_usart);
+        fires += 2;
+        messages += _consume_message();
+    }
+    _report("polling", busy ? "busy" : "idle", fires, transitions, messages, _cpu_ns() - cpu_start);
+    fsm_destroy(p_fsm_button);
+    fsm_destroy(p_fsm_usart);
+}
+
+/**
+ * @brief Event-driven loop: the FSMs are fired only when an ISR or a timer posts work for them.
+ */
+static void _run_scheduler(bool busy)
+{
+    _setup(busy);
+    fsm_sched_init();
+    fsm_sched_add(p_fsm_button, fsm_button_fire, FSM_SCHED_EVENT(BUTTON_0_EVENT));
+    fsm_sched_add(p_fsm_usart, fsm_usart_fire, FSM_SCHED_EVENT(USART_0_EVENT_RX) | FSM_SCHED_EVENT(USART_0_EVENT_TX));
+    uint32_t messages = 0;
+    uint32_t end = port_system_get_millis() + BENCH_RUN_MS;
+    uint64_t cpu_start = _cpu_ns();
+    while ((int32_t)(port_system_get_millis() - end) < 0)
+    {
+        fsm_sched_run();
+        messages += _consume_message();
+    }
+    uint64_t cpu_ns = _cpu_ns() - cpu_start;
+    fsm_sched_stats_t stats;
+    fsm_sched_get_stats(&stats);
+    _report("scheduler", busy ? "busy" : "idle", stats.fires, stats.transitions, messages, cpu_ns);
+    fsm_destroy(p_fsm_button);
+    fsm_destroy(p_fsm_usart);
+}
+
+/**
+ * @brief Benchmark entry point.
+ *
+ * @return int
+ */
+int main(void)
+{
+    printf("Main loop benchmark (%d ms per case, virtual clock = host clock, USART at 9600 bauds)\n", BENCH_RUN_MS);
+    printf("%-10s %-6s %14s %12s %9s %9s\n", "loop", "load", "fires/s", "useful/s", "messages", "CPU");
+    _run_polling(false);
+    _run_scheduler(false);
+    _run_polling(true);
+    _run_scheduler(true);
+    return 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file bench_note_change.c
+ * @brief Benchmark of a note change of the buzzer: PSC/ARR computed from a `double` frequency, as `melodies.h` stored
+ * the notes, versus the compile-time `note_table`.
+ *
+ * The double path is the one the README describes for `port_buzzer_set_note_frequency()`: two `double` divisions to
+ * choose the prescaler, a third one for the auto-reload and a retry when the auto-reload does not fit in 16 bits. The
+ * table path reads the entry of the note index. Both write the two registers of a timer block. It walks every note of
+ * octaves 0 to 8 and reports the host time and the time-stamp counter cycles per note change.
+ *
+ * @note The host has a double-precision FPU. On the Cortex-M4F every `double` division of the first path is a call to
+ * the soft-float library (`__aeabi_ddiv`, some hundred cycles each), so the difference on the board is much larger than
+ * the one measured here.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/* Other libraries */
+#include "note_table.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_ROUNDS 200000U /*!< Walks through the whole table in each measurement */
+
+/* Private variables ------------------------------------------------------------*/
+/**
+ * @brief Registers of the timer that plays the note.
+ */
+static volatile struct
+{
+    uint32_t PSC; /*!< Prescaler */
+    uint32_t ARR; /*!< Auto-reload */
+} tim;
+
+static double frequencies[NOTE_TABLE_LENGTH]; /*!< Frequency in Hz of each note, as `melodies.h` stored them before the note indices */
+static volatile uint32_t timer_clock = NOTE_TABLE_TIMER_CLOCK_HZ; /*!< Clock of the timer, read at run time as SystemCoreClock */
+
+/* Private functions */
+/**
+ * @brief Host monotonic time in nanoseconds.
+ */
+static uint64_t _host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Time-stamp counter of the host CPU, or 0 where there is none.
+ */
+static uint64_t _host_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Note change from a `double` frequency, as `port_buzzer_set_note_frequency()` does.
+ */
+static void _set_note_double(double frequency)
+{
+    if (frequency == 0)
+    {
+        tim.ARR = 0;
+        return;
+    }
+    double clock = (double)timer_clock;
+    double psc = (double)(uint32_t)((clock / frequency) / 65536.0 + 0.5);
+    double arr = (double)(uint32_t)(clock / ((psc + 1.0) * frequency) + 0.5) - 1.0;
+    if (arr > 65535.0)
+    {
+        psc += 1.0;
+        arr = (double)(uint32_t)(clock / ((psc + 1.0) * frequency) + 0.5) - 1.0;
+    }
+    tim.PSC = (uint32_t)psc;
+    tim.ARR = (uint32_t)arr;
+}
+
+/**
+ * @brief Note change from a note index, reading the precomputed registers.
+ */
+static void _set_note_table(uint32_t note)
+{
+    const note_timer_t *p_timer = &note_table[note];
+    tim.PSC = p_timer->psc;
+    tim.ARR = p_timer->arr;
+}
+
+/**
+ * @brief Print one row of results.
+ */
+static void _report(const char *p_label, uint64_t ns, uint64_t cycles)
+{
+    double changes = (double)BENCH_ROUNDS * (NOTE_TABLE_LENGTH - 1);
+    printf("%-8s %12.2f %12.1f\n", p_label, (double)ns / changes, (double)cycles / changes);
+}
+
+/**
+ * @brief Main function of the benchmark.
+ *
+ * @return int
+ */
+int main(void)
+{
+    for (uint32_t note = 1; note < NOTE_TABLE_LENGTH; note++)
+    {
+        frequencies[note] = note_table_get_frequency_mhz(note) / 1000.0;
+    }
+
+    uint64_t start_ns = _host_ns();
+    uint64_t start_cycles = _host_cycles();
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (uint32_t note = 1; note < NOTE_TABLE_LENGTH; note++)
+        {
+            _set_note_double(frequencies[note]);
+        }
+    }
+    uint64_t double_cycles = _host_cycles() - start_cycles;
+    uint64_t double_ns = _host_ns() - start_ns;
+
+    start_ns = _host_ns();
+    start_cycles = _host_cycles();
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (uint32_t note = 1; note < NOTE_TABLE_LENGTH; note++)
+        {
+            _set_note_table(note);
+        }
+    }
+    uint64_t table_cycles = _host_cycles() - start_cycles;
+    uint64_t table_ns = _host_ns() - start_ns;
+
+    printf("Note change benchmark (%u notes, timer clock %u Hz)\n", (unsigned)(NOTE_TABLE_LENGTH - 1), (unsigned)NOTE_TABLE_TIMER_CLOCK_HZ);
+    printf("%-8s %12s %12s\n", "path", "ns/change", "cycles/change");
+    _report("double", double_ns, double_cycles);
+    _report("table", table_ns, table_cycles);
+    return 0;
+}
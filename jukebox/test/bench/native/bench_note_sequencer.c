@@ -0,0 +1,203 @@
+/**
+ * @file bench_note_sequencer.c
+ * @brief Benchmark of the note timing of the buzzer under a heavy main loop: notes loaded by the main loop after each
+ * end of note interrupt (note by note mode, as the buzzer FSM of the README does) versus the sequencer that loads them
+ * in the TIM2 ISR from a prefetched descriptor.
+ *
+ * Every melody of the library is played in both modes with the same synthetic load in the main loop: busy work of 0.2 to
+ * 4.3 ms, a blocking `port_system_delay_ms()` of 20 ms one iteration out of sixteen and a critical section of 250 us in
+ * every iteration. The onsets are taken from the log of the PWM output of TIM3 in the virtual clock, so the results are
+ * exact and reproducible. For each case it reports the worst and mean error of the note lengths, the worst delay of an
+ * onset with respect to the nominal grid, the drift at the end of the melody and the times the main loop was woken up.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <stdint.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_buzzer.h"
+#include "native_sim.h"
+
+/* Other libraries */
+#include "melodies.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_CRITICAL_US 250U  /*!< Critical section of each iteration of the main loop */
+#define BENCH_DELAY_MS 20U      /*!< Blocking delay of one iteration out of sixteen */
+#define BENCH_SEED 20240101U    /*!< Seed of the load, the same for both modes */
+
+/* Private variables ------------------------------------------------------------*/
+static native_sim_tim_output_t changes[NATIVE_SIM_TIM_LOG_LENGTH]; /*!< Changes of the output of TIM3 */
+static uint64_t grid[NATIVE_SIM_TIM_LOG_LENGTH];                   /*!< Nominal time of each change */
+static uint32_t seed;                                              /*!< State of the generator of the load */
+static uint32_t wakeups;                                           /*!< Buzzer events seen by the main loop */
+
+/* Private functions */
+/**
+ * @brief One iteration of the synthetic load of the main loop.
+ */
+static void _load(void)
+{
+    seed = seed * 1664525U + 1013904223U;
+    if ((seed >> 28) == 0)
+    {
+        port_system_delay_ms(BENCH_DELAY_MS);
+    }
+    else
+    {
+        native_sim_advance_us(200U + ((seed >> 8) & 0xFFFU));
+    }
+    uint32_t state = port_system_enter_critical();
+    native_sim_advance_us(BENCH_CRITICAL_US);
+    port_system_exit_critical(state);
+    if (port_system_take_events() & (1U << BUZZER_0_EVENT))
+    {
+        wakeups++;
+    }
+}
+
+/**
+ * @brief Play a melody loading each note from the main loop after the end of the previous one.
+ */
+static void _play_note_by_note(const melody_t *p_melody)
+{
+    melody_cursor_t cursor;
+    melody_note_t note;
+    melody_cursor_init(&cursor, p_melody);
+    melody_cursor_next(&cursor, &note);
+    port_buzzer_set_note(BUZZER_0_ID, note.note);
+    port_buzzer_set_note_duration(BUZZER_0_ID, note.duration_ms);
+    for (;;)
+    {
+        _load();
+        if (port_buzzer_get_note_timeout(BUZZER_0_ID))
+        {
+            if (!melody_cursor_next(&cursor, &note))
+            {
+                port_buzzer_stop(BUZZER_0_ID);
+                return;
+            }
+            port_buzzer_set_note(BUZZER_0_ID, note.note);
+            port_buzzer_set_note_duration(BUZZER_0_ID, note.duration_ms);
+        }
+    }
+}
+
+/**
+ * @brief Play a melody with the sequencer; the main loop only waits for the end.
+ */
+static void _play_sequencer(const melody_t *p_melody)
+{
+    port_buzzer_play_melody(BUZZER_0_ID, p_melody);
+    while (!port_buzzer_get_melody_end(BUZZER_0_ID))
+    {
+        _load();
+    }
+}
+
+/**
+ * @brief Compute the nominal time of each change of the output: a note starts it or restarts it, a rest after a note
+ * and the end of a melody that ends with a note stop it.
+ *
+ * @return Number of changes
+ */
+static uint32_t _make_grid(const melody_t *p_melody, uint64_t start)
+{
+    melody_cursor_t cursor;
+    melody_note_t note;
+    uint32_t count = 0;
+    bool sounding = false;
+    uint64_t at = start;
+    melody_cursor_init(&cursor, p_melody);
+    while (melody_cursor_next(&cursor, &note))
+    {
+        bool silence = (note.note == NOTE_SILENCE);
+        if (!silence || sounding)
+        {
+            grid[count++] = at;
+        }
+        sounding = !silence;
+        at += (uint64_t)note.duration_ms * NATIVE_SIM_CYCLES_PER_MS;
+    }
+    if (sounding)
+    {
+        grid[count++] = at;
+    }
+    return count;
+}
+
+/**
+ * @brief Play a melody in one mode and print one row of results.
+ */
+static void _run(const melody_t *p_melody, bool sequencer)
+{
+    port_system_init();
+    if (!port_buzzer_init(BUZZER_0_ID))
+    {
+        printf("%-16s %-12s the timer clock does not match the note table\n", p_melody->p_name, sequencer ? "sequencer" : "note by note");
+        return;
+    }
+    port_system_take_events();
+    seed = BENCH_SEED;
+    wakeups = 0;
+    uint64_t start = native_sim_get_cycles();
+    if (sequencer)
+    {
+        _play_sequencer(p_melody);
+    }
+    else
+    {
+        _play_note_by_note(p_melody);
+    }
+    uint32_t count = native_sim_tim_read_output(TIM3, changes, NATIVE_SIM_TIM_LOG_LENGTH);
+    uint32_t expected = _make_grid(p_melody, start);
+    if (count != expected)
+    {
+        printf("%-16s %-12s wrong number of output changes: %u instead of %u\n", p_melody->p_name, sequencer ? "sequencer" : "note by note", (unsigned)count, (unsigned)expected);
+        return;
+    }
+
+    uint64_t worst_length = 0;
+    uint64_t total_length = 0;
+    uint64_t worst_late = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint64_t late = changes[i].at - grid[i];
+        worst_late = (late > worst_late) ? late : worst_late;
+        if (i > 0)
+        {
+            int64_t error = (int64_t)(changes[i].at - changes[i - 1].at) - (int64_t)(grid[i] - grid[i - 1]);
+            uint64_t magnitude = (uint64_t)((error < 0) ? -error : error);
+            worst_length = (magnitude > worst_length) ? magnitude : worst_length;
+            total_length += magnitude;
+        }
+    }
+    double drift_ms = (double)(changes[count - 1].at - grid[count - 1]) / NATIVE_SIM_CYCLES_PER_MS;
+    printf("%-16s %-12s %6u %12.1f %12.1f %12.1f %10.1f %8u\n", p_melody->p_name, sequencer ? "sequencer" : "note by note",
+           (unsigned)p_melody->melody_length, (double)worst_length / NATIVE_SIM_CYCLES_PER_US,
+           (count > 1) ? (double)total_length / (count - 1) / NATIVE_SIM_CYCLES_PER_US : 0.0,
+           (double)worst_late / NATIVE_SIM_CYCLES_PER_US, drift_ms, (unsigned)wakeups);
+}
+
+/**
+ * @brief Main function of the benchmark.
+ *
+ * @return int
+ */
+int main(void)
+{
+    printf("Note sequencer benchmark (busy work 0.2-4.3 ms, %u ms delay 1/16, %u us critical section per iteration)\n", (unsigned)BENCH_DELAY_MS, (unsigned)BENCH_CRITICAL_US);
+    printf("%-16s %-12s %6s %12s %12s %12s %10s %8s\n", "melody", "mode", "notes", "max len us", "mean len us", "max late us", "drift ms", "wakeups");
+    for (uint32_t i = 0; i < melody_library_length; i++)
+    {
+        _run(melody_library[i], false);
+        _run(melody_library[i], true);
+    }
+    return 0;
+}
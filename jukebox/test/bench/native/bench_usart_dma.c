@@ -0,0 +1,147 @@
+/**
+ * @file bench_usart_dma.c
+ * @brief Benchmark of the two transfer modes of the USART driver: one interrupt per byte (RXNE/TXE) versus DMA1
+ * streams (half/full transfer of the circular RX buffer and one transfer complete per TX message).
+ *
+ * For each mode the peer sends a stream of command lines at 921600 bauds and, in a second run, the board sends messages
+ * of the same length to the peer. It reports the interrupt entries per kilobyte in each direction and checks that every line and
+ * every message got through.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <string.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_usart.h"
+#include "native_sim.h"
+
+/* Private defines ------------------------------------------------------------*/
+#define BENCH_BYTES 16384U          /*!< Bytes sent in each direction */
+#define BENCH_LINE_LENGTH 32U       /*!< Length of each line and each message, including END_CHAR_CONSTANT */
+#define BENCH_BAUDRATE 921600U      /*!< Baud rate of the line */
+
+/* Private functions */
+/**
+ * @brief Fill a line of the given number, padded to BENCH_LINE_LENGTH and terminated by END_CHAR_CONSTANT.
+ */
+static void _make_line(char *p_line, uint32_t number)
+{
+    memset(p_line, '.', BENCH_LINE_LENGTH);
+    int length = snprintf(p_line, BENCH_LINE_LENGTH, "line %u", (unsigned)number);
+    p_line[length] = '.';
+    p_line[BENCH_LINE_LENGTH - 1] = END_CHAR_CONSTANT;
+}
+
+/**
+ * @brief Receive BENCH_BYTES of lines in one mode and print the interrupt entries per kilobyte.
+ */
+static void _run_rx(uint32_t mode)
+{
+    port_system_init();
+    native_sim_set_stall_guard(false);
+    port_usart_init(USART_0_ID);
+    port_usart_set_baudrate(USART_0_ID, BENCH_BAUDRATE);
+    port_usart_set_mode(USART_0_ID, mode);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    native_sim_reset_irq_counts();
+
+    char line[BENCH_LINE_LENGTH];
+    uint32_t lines = BENCH_BYTES / BENCH_LINE_LENGTH;
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    uint32_t idle_ms = 0;
+    while ((received < lines) && (idle_ms < 10))
+    {
+        while ((sent < lines) && (native_sim_usart_get_rx_pending(USART_0) < NATIVE_SIM_USART_FIFO_LENGTH - BENCH_LINE_LENGTH))
+        {
+            _make_line(line, sent++);
+            native_sim_usart_inject_rx(USART_0, (const uint8_t *)line, BENCH_LINE_LENGTH);
+        }
+        native_sim_advance_ms(1);
+        idle_ms++;
+        const char *p_line;
+        uint32_t length;
+        while (port_usart_get_line(USART_0_ID, &p_line, &length))
+        {
+            _make_line(line, received);
+            received += (length == BENCH_LINE_LENGTH - 1) && (memcmp(line, p_line, length) == 0);
+            port_usart_reset_input_buffer(USART_0_ID);
+            idle_ms = 0;
+        }
+    }
+
+    uint32_t isr = native_sim_get_irq_count(USART3_IRQn) + native_sim_get_irq_count(DMA1_Stream1_IRQn);
+    printf("%-4s %-3s %14.1f %9u/%u\n", (mode == PORT_USART_MODE_DMA) ? "dma" : "irq", "rx",
+           (double)isr * 1024.0 / BENCH_BYTES, (unsigned)received, (unsigned)lines);
+    port_usart_disable_rx_interrupt(USART_0_ID);
+}
+
+/**
+ * @brief Send BENCH_BYTES of messages in one mode and print the interrupt entries per kilobyte.
+ */
+static void _run_tx(uint32_t mode)
+{
+    port_system_init();
+    native_sim_set_stall_guard(false);
+    port_usart_init(USART_0_ID);
+    port_usart_set_baudrate(USART_0_ID, BENCH_BAUDRATE);
+    port_usart_set_mode(USART_0_ID, mode);
+    native_sim_reset_irq_counts();
+
+    char line[BENCH_LINE_LENGTH];
+    uint8_t peer[BENCH_LINE_LENGTH];
+    uint32_t messages = BENCH_BYTES / BENCH_LINE_LENGTH;
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    uint32_t peer_length = 0;
+    uint32_t idle_ms = 0;
+    while ((received < messages) && (idle_ms < 10))
+    {
+        _make_line(line, sent); /* The queue is refilled until it pushes back */
+        while ((sent < messages) && port_usart_send(USART_0_ID, line, BENCH_LINE_LENGTH))
+        {
+            _make_line(line, ++sent);
+        }
+        native_sim_advance_ms(1);
+        idle_ms++;
+        uint32_t length;
+        while ((length = native_sim_usart_read_tx(USART_0, &peer[peer_length], BENCH_LINE_LENGTH - peer_length)) > 0)
+        {
+            peer_length += length;
+            if (peer_length == BENCH_LINE_LENGTH)
+            {
+                _make_line(line, received);
+                received += (memcmp(line, peer, BENCH_LINE_LENGTH) == 0);
+                peer_length = 0;
+                idle_ms = 0;
+            }
+        }
+    }
+
+    uint32_t isr = native_sim_get_irq_count(USART3_IRQn) + native_sim_get_irq_count(DMA1_Stream3_IRQn);
+    printf("%-4s %-3s %14.1f %9u/%u\n", (mode == PORT_USART_MODE_DMA) ? "dma" : "irq", "tx",
+           (double)isr * 1024.0 / BENCH_BYTES, (unsigned)received, (unsigned)messages);
+    port_usart_disable_tx_interrupt(USART_0_ID);
+}
+
+/**
+ * @brief Main function of the benchmark.
+ *
+ * @return int
+ */
+int main(void)
+{
+    printf("USART transfer mode benchmark (%u bytes per direction at 921600 bauds, %u-byte lines)\n", (unsigned)BENCH_BYTES, (unsigned)BENCH_LINE_LENGTH);
+    printf("%-4s %-3s %14s %11s\n", "mode", "dir", "ISR entries/KB", "lines");
+    _run_rx(PORT_USART_MODE_IRQ);
+    _run_rx(PORT_USART_MODE_DMA);
+    _run_tx(PORT_USART_MODE_IRQ);
+    _run_tx(PORT_USART_MODE_DMA);
+    return 0;
+}
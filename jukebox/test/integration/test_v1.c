@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <inttypes.h>
 
 #include "fsm_button.h"
 #include "port_button.h"
@@ -21,7 +22,7 @@ int main(void)
         uint32_t duration = fsm_button_get_duration(p_fsm_button);
         if (duration > 0)
         {
-            printf("Button %d pressed for %ld ms", BUTTON_0_ID, duration);
+            printf("Button %d pressed for %" PRIu32 " ms", BUTTON_0_ID, duration);
             // If the button is pressed for more than CHANGE_MODE_BUTTON_TIME, we toggle the LED
             if (duration >= CHANGE_MODE_BUTTON_TIME) {
                 printf(" (long press detected)");
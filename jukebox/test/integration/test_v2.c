@@ -17,6 +17,7 @@
 /* Other libraries */
 #include "fsm_button.h"
 #include "fsm_usart.h"
+#include "fsm_sched.h"
 
 /* Private defines ------------------------------------------------------------*/
 #define TEST_BUTTON_TIME 1000
@@ -25,6 +26,9 @@
 #define LD2_PIN 5
 #define LD2_DELAY_MS 100
 
+/* Private variables ------------------------------------------------------------*/
+static const char hello_msg[] = "Hello I'm the microcontroller!\n"; /*!< Sent from flash, without copying it */
+
 /**
  * @brief Main test function. Read the terminal for instructions.
  *
@@ -44,6 +48,11 @@ int main(void)
 
     fsm_usart_enable_rx_interrupt(p_fsm_usart);
 
+    // Register the FSMs in the scheduler: they are fired only when their ISRs or timers post work
+    fsm_sched_init();
+    fsm_sched_add(p_fsm_button, fsm_button_fire, FSM_SCHED_EVENT(BUTTON_0_EVENT));
+    int usart_sched_id = fsm_sched_add(p_fsm_usart, fsm_usart_fire, FSM_SCHED_EVENT(USART_0_EVENT_RX) | FSM_SCHED_EVENT(USART_0_EVENT_TX));
+
     printf("1. Ensure that the USART TX and RX pins are connected to the RX and TX pins of the converter\n");
     printf("2. Ensure that the converter is connected to the PC.\n");
     printf("3. Open a serial terminal and configure it to %d bauds, 8N1.\n", TEST_USART_BAUDRATE);
@@ -56,7 +65,8 @@ int main(void)
 
     while (1)
     {
-        fsm_fire(p_fsm_button);
+        // Sleep until an ISR posts an event and fire the FSMs that have work
+        fsm_sched_run();
 
         uint32_t duration = fsm_button_get_duration(p_fsm_button);
 
@@ -64,7 +74,8 @@ int main(void)
         {
             if (duration >= TEST_BUTTON_TIME)
             {
-                fsm_usart_set_out_data(p_fsm_usart, "Hello I'm the microcontroller!\n");
+                fsm_usart_send_ref(p_fsm_usart, hello_msg, sizeof(hello_msg) - 1, NULL, NULL);
+                fsm_sched_post(usart_sched_id);
                 port_system_gpio_write(LD2_PORT, LD2_PIN, HIGH);
                 port_system_delay_ms(LD2_DELAY_MS);
                 port_system_gpio_write(LD2_PORT, LD2_PIN, LOW);
@@ -82,8 +93,6 @@ int main(void)
             port_system_delay_ms(LD2_DELAY_MS);
             port_system_gpio_write(LD2_PORT, LD2_PIN, LOW);
         }
-
-        fsm_fire(p_fsm_usart);
     }
 
     // We should never reach this point
@@ -0,0 +1,35 @@
+# Test of melody_gen: run with -DMELODY_GEN=<tool> -DFIXTURES=<this directory> -DOUTPUT_DIR=<scratch directory>
+
+# Good melodies: identical notes share an array, names become identifiers, a long note widens the tempo base and the
+# index sorts the melodies by name and by duration (equal durations by name)
+EXECUTE_PROCESS(COMMAND ${MELODY_GEN} ${OUTPUT_DIR}/good.c ${FIXTURES}/good.rtttl RESULT_VARIABLE RESULT)
+IF(NOT RESULT EQUAL 0)
+    MESSAGE(FATAL_ERROR "ERROR: good.rtttl was rejected")
+ENDIF()
+FILE(READ ${OUTPUT_DIR}/good.c OUTPUT)
+FOREACH(EXPECTED
+        "const melody_t same_notes_melody = {.p_name = \"same_notes\", .p_notes = same_notes_melody_notes, .melody_length = 5, .tempo_base_ms = 500}"
+        "const melody_t copy_melody = {.p_name = \"copy\", .p_notes = same_notes_melody_notes, .melody_length = 5, .tempo_base_ms = 500}"
+        "static const uint16_t same_notes_melody_notes[5] = {\n    0x6201, 0x6601, 0x6A01, 0x0002, 0x6A02}"
+        "const melody_t m_2nd_song_melody = {.p_name = \"m_2nd_song\", .p_notes = m_2nd_song_melody_notes, .melody_length = 2, .tempo_base_ms = 68}"
+        "&same_notes_melody,\n    &copy_melody,\n    &m_2nd_song_melody}"
+        "const uint16_t melody_by_name[3] = {\n    1, 2, 0}"
+        "const uint16_t melody_name_rank[3] = {\n    2, 0, 1}"
+        "const uint16_t melody_by_duration[3] = {\n    1, 0, 2}"
+        "const uint16_t melody_duration_rank[3] = {\n    1, 0, 2}"
+        "const uint32_t melody_name_mask = 0x7;")
+    STRING(FIND "${OUTPUT}" "${EXPECTED}" POSITION)
+    IF(POSITION EQUAL -1)
+        MESSAGE(FATAL_ERROR "ERROR: the output of good.rtttl does not contain:\n${EXPECTED}\n\n${OUTPUT}")
+    ENDIF()
+ENDFOREACH()
+
+# Bad melodies: the tool fails and does not write its output
+FOREACH(BAD bad_note.rtttl bad_duplicate.rtttl bad_syntax.rtttl bad_format.mid)
+    FILE(REMOVE ${OUTPUT_DIR}/bad.c)
+    EXECUTE_PROCESS(COMMAND ${MELODY_GEN} ${OUTPUT_DIR}/bad.c ${FIXTURES}/${BAD} RESULT_VARIABLE RESULT ERROR_VARIABLE ERRORS)
+    IF((RESULT EQUAL 0) OR (EXISTS ${OUTPUT_DIR}/bad.c))
+        MESSAGE(FATAL_ERROR "ERROR: ${BAD} was accepted")
+    ENDIF()
+    MESSAGE(STATUS "${BAD}: ${ERRORS}")
+ENDFOREACH()
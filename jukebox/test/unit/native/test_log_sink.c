@@ -0,0 +1,183 @@
+/**
+ * @file test_log_sink.c
+ * @brief Unit test for the buffered log sink behind `printf()` on the native platform.
+ *
+ * It checks the three overflow policies and the drop counter with the output disabled, that writing never advances
+ * the virtual clock, and that the SysTick ISR drains the ring to a USART dedicated to the log.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <string.h>
+
+/* HW dependent libraries */
+#include "port_usart.h"
+#include "port_system.h"
+#include "native_sim.h"
+
+/* Other libraries */
+#include "log_sink.h"
+
+/* Test dependencies */
+#include <unity.h>
+
+/* Private defines ------------------------------------------------------------*/
+#define FIRST_WRITE 600  /*!< Length of the first write of the overflow tests */
+#define SECOND_WRITE 600 /*!< Length of the write that does not fit */
+
+/* Private variables ------------------------------------------------------------*/
+static char first[FIRST_WRITE];   /*!< Bytes of the first write */
+static char second[SECOND_WRITE]; /*!< Bytes of the second write */
+static uint8_t received[LOG_SINK_BUFFER_LENGTH + 1]; /*!< Bytes read by the simulated peer */
+
+/**
+ * @brief Set the Up object. The simulated board and the log sink are reset before each test, and the log has no output.
+ *
+ */
+void setUp(void)
+{
+    port_system_init();
+    native_sim_set_stall_guard(false);
+    port_usart_init(USART_0_ID);
+    log_sink_set_output(LOG_SINK_OUTPUT_NONE, 0);
+    log_sink_set_policy(LOG_SINK_POLICY_DROP_NEWEST);
+    log_sink_reset();
+    for (uint32_t i = 0; i < FIRST_WRITE; i++)
+    {
+        first[i] = (char)('a' + (i % 26));
+    }
+    for (uint32_t i = 0; i < SECOND_WRITE; i++)
+    {
+        second[i] = (char)('0' + (i % 10));
+    }
+}
+
+/**
+ * @brief Tear down the test. It is called after a test function is called.
+ *
+ */
+void tearDown(void)
+{
+    log_sink_set_output(LOG_SINK_OUTPUT_NONE, 0);
+    port_usart_disable_rx_interrupt(USART_0_ID);
+    port_usart_disable_tx_interrupt(USART_0_ID);
+}
+
+/**
+ * @brief Test that a write that does not fit is dropped whole by default.
+ *
+ */
+void test_drop_newest(void)
+{
+    log_sink_stats_t stats;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FIRST_WRITE, log_sink_write(first, FIRST_WRITE), __LINE__, "ERROR: A write that fits was not stored");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, log_sink_write(second, SECOND_WRITE), __LINE__, "ERROR: A write that does not fit was stored");
+    log_sink_get_stats(&stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FIRST_WRITE, stats.written, __LINE__, "ERROR: Wrong number of written bytes");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(SECOND_WRITE, stats.dropped, __LINE__, "ERROR: The dropped write was not counted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FIRST_WRITE, stats.high_water, __LINE__, "ERROR: Wrong high water mark");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FIRST_WRITE, log_sink_get_pending(), __LINE__, "ERROR: Wrong number of pending bytes");
+
+    native_sim_advance_ms(10);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FIRST_WRITE, log_sink_get_pending(), __LINE__, "ERROR: Bytes were drained with no output");
+}
+
+/**
+ * @brief Test that the truncate policy keeps the beginning of the write that does not fit.
+ *
+ */
+void test_truncate(void)
+{
+    log_sink_stats_t stats;
+    log_sink_set_policy(LOG_SINK_POLICY_TRUNCATE);
+    log_sink_write(first, FIRST_WRITE);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(LOG_SINK_BUFFER_LENGTH - FIRST_WRITE, log_sink_write(second, SECOND_WRITE), __LINE__, "ERROR: The write was not truncated to the free space");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, log_sink_write(second, 1), __LINE__, "ERROR: A byte was stored in a full ring");
+    log_sink_get_stats(&stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FIRST_WRITE + SECOND_WRITE + 1 - LOG_SINK_BUFFER_LENGTH, stats.dropped, __LINE__, "ERROR: Wrong number of dropped bytes");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(LOG_SINK_BUFFER_LENGTH, stats.high_water, __LINE__, "ERROR: Wrong high water mark");
+}
+
+/**
+ * @brief Test that the drop-oldest policy keeps the newest bytes and drains them in order to the log USART.
+ *
+ */
+void test_drop_oldest(void)
+{
+    log_sink_stats_t stats;
+    uint32_t lost = FIRST_WRITE + SECOND_WRITE - LOG_SINK_BUFFER_LENGTH;
+    log_sink_set_policy(LOG_SINK_POLICY_DROP_OLDEST);
+    log_sink_write(first, FIRST_WRITE);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(SECOND_WRITE, log_sink_write(second, SECOND_WRITE), __LINE__, "ERROR: The newest write was not stored");
+    log_sink_get_stats(&stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(lost, stats.dropped, __LINE__, "ERROR: Wrong number of dropped bytes");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(LOG_SINK_BUFFER_LENGTH, log_sink_get_pending(), __LINE__, "ERROR: The ring is not full");
+
+    log_sink_set_output(LOG_SINK_OUTPUT_USART, USART_0_ID);
+    native_sim_advance_ms(1500); /* 1024 bytes at 9600 bauds */
+    UNITY_TEST_ASSERT_EQUAL_UINT32(LOG_SINK_BUFFER_LENGTH, native_sim_usart_read_tx(USART_0, received, sizeof(received)), __LINE__, "ERROR: Wrong number of bytes sent");
+    UNITY_TEST_ASSERT_EQUAL_MEMORY(&first[lost], received, FIRST_WRITE - lost, __LINE__, "ERROR: The oldest kept bytes are wrong");
+    UNITY_TEST_ASSERT_EQUAL_MEMORY(second, &received[FIRST_WRITE - lost], SECOND_WRITE, __LINE__, "ERROR: The newest bytes are wrong");
+}
+
+/**
+ * @brief Test that writing never waits for the output, even with the log USART busy.
+ *
+ */
+void test_write_never_blocks(void)
+{
+    log_sink_stats_t stats;
+    log_sink_set_output(LOG_SINK_OUTPUT_USART, USART_0_ID);
+    uint64_t start = native_sim_get_cycles();
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        log_sink_write(first, 64);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)(native_sim_get_cycles() - start), __LINE__, "ERROR: Writing advanced the clock");
+    log_sink_get_stats(&stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(LOG_SINK_BUFFER_LENGTH, stats.written, __LINE__, "ERROR: Wrong number of written bytes");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(64 * 64 - LOG_SINK_BUFFER_LENGTH, stats.dropped, __LINE__, "ERROR: Wrong number of dropped bytes");
+}
+
+/**
+ * @brief Test that the SysTick ISR drains the ring to the log USART a budget at a time.
+ *
+ */
+void test_usart_drain(void)
+{
+    log_sink_stats_t stats;
+    log_sink_set_output(LOG_SINK_OUTPUT_USART, USART_0_ID);
+    log_sink_write(first, 300);
+
+    native_sim_advance_ms(1);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(300 - LOG_SINK_DRAIN_BUDGET, log_sink_get_pending(), __LINE__, "ERROR: One tick did not drain one budget");
+    native_sim_advance_ms(400);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, log_sink_get_pending(), __LINE__, "ERROR: The ring was not drained");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(300, native_sim_usart_read_tx(USART_0, received, sizeof(received)), __LINE__, "ERROR: Wrong number of bytes sent");
+    UNITY_TEST_ASSERT_EQUAL_MEMORY(first, received, 300, __LINE__, "ERROR: Wrong bytes sent");
+    log_sink_get_stats(&stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(300, stats.drained, __LINE__, "ERROR: Wrong number of drained bytes");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, stats.dropped, __LINE__, "ERROR: Bytes were dropped");
+}
+
+/**
+ * @brief Main function of the test.
+ *
+ * @return int
+ */
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_drop_newest);
+    RUN_TEST(test_truncate);
+    RUN_TEST(test_drop_oldest);
+    RUN_TEST(test_write_never_blocks);
+    RUN_TEST(test_usart_drain);
+
+    return UNITY_END();
+}
@@ -0,0 +1,223 @@
+/**
+ * @file test_port_button.c
+ * @brief Unit test for the button port driver on the native platform.
+ *
+ * It drives the level of the button pin through the simulated GPIO and checks that the EXTI model raises the
+ * interrupt, that the ISR updates the button flag, and that the virtual clock advances the System tick.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* HW dependent libraries */
+#include "port_button.h"
+#include "port_system.h"
+#include "native_sim.h"
+#include "button_debounce.h"
+
+/* Test dependencies */
+#include <unity.h>
+
+/**
+ * @brief Set the Up object. The simulated board is reset before each test and the virtual clock only advances on request.
+ *
+ */
+void setUp(void)
+{
+    port_system_init();
+    native_sim_set_stall_guard(false);
+    buttons_arr[BUTTON_0_ID].flag_pressed = false;
+    port_button_init(BUTTON_0_ID);
+}
+
+/**
+ * @brief Tear down the test. It is called after a test function is called.
+ *
+ */
+void tearDown(void)
+{
+    native_sim_gpio_set_input(BUTTON_0_GPIO, BUTTON_0_PIN, HIGH);
+    native_sim_gpio_set_input(GPIOB, 11, HIGH);
+    native_sim_gpio_set_input(GPIOA, 14, HIGH);
+    native_sim_gpio_set_input(GPIOB, 5, HIGH);
+}
+
+/**
+ * @brief Test that the button is configured as input with interrupts on both edges.
+ *
+ */
+void test_regs(void)
+{
+    uint32_t button_mode = ((BUTTON_0_GPIO->MODER) >> (BUTTON_0_PIN * 2)) & 0x3;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(GPIO_MODE_IN, button_mode, __LINE__, "ERROR: Button mode is not configured as input");
+
+    uint32_t button_exticr = ((SYSCFG->EXTICR[BUTTON_0_PIN / 4]) >> ((BUTTON_0_PIN % 4) * 4)) & 0xF;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x2, button_exticr, __LINE__, "ERROR: Button EXTI CR is not configured correctly");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, (EXTI->RTSR >> BUTTON_0_PIN) & 0x1, __LINE__, "ERROR: Button EXTI RTSR is not configured correctly");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, (EXTI->FTSR >> BUTTON_0_PIN) & 0x1, __LINE__, "ERROR: Button EXTI FTSR is not configured correctly");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, (EXTI->IMR >> BUTTON_0_PIN) & 0x1, __LINE__, "ERROR: Button EXTI IMR is not configured correctly");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, NVIC_GetEnableIRQ(EXTI15_10_IRQn), __LINE__, "ERROR: EXTI15_10 interrupt is not enabled");
+}
+
+/**
+ * @brief Test that pressing and releasing the button raises the EXTI interrupt and updates the flag.
+ *
+ */
+void test_press_release(void)
+{
+    TEST_ASSERT_FALSE(port_button_is_pressed(BUTTON_0_ID));
+
+    native_sim_gpio_set_input(BUTTON_0_GPIO, BUTTON_0_PIN, LOW);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, native_sim_get_irq_count(EXTI15_10_IRQn), __LINE__, "ERROR: The falling edge did not raise the EXTI interrupt");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, EXTI->PR, __LINE__, "ERROR: The ISR did not clear the pending register");
+    TEST_ASSERT_TRUE(port_button_is_pressed(BUTTON_0_ID));
+
+    native_sim_gpio_set_input(BUTTON_0_GPIO, BUTTON_0_PIN, HIGH);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, native_sim_get_irq_count(EXTI15_10_IRQn), __LINE__, "ERROR: The rising edge did not raise the EXTI interrupt");
+    TEST_ASSERT_FALSE(port_button_is_pressed(BUTTON_0_ID));
+}
+
+/**
+ * @brief Test that no interrupt is served while the EXTI line is disabled in the NVIC, and that it is served when enabled.
+ *
+ */
+void test_exti_disabled(void)
+{
+    port_system_gpio_exti_disable(BUTTON_0_PIN);
+    native_sim_gpio_set_input(BUTTON_0_GPIO, BUTTON_0_PIN, LOW);
+    TEST_ASSERT_FALSE(port_button_is_pressed(BUTTON_0_ID));
+
+    port_system_gpio_exti_enable(BUTTON_0_PIN, 1, 0);
+    TEST_ASSERT_TRUE(port_button_is_pressed(BUTTON_0_ID));
+}
+
+/**
+ * @brief Test that one EXTI interrupt serves every pending button line of its group, with the level read from `IDR`.
+ *
+ */
+void test_multi_button(void)
+{
+    buttons_arr[1] = (port_button_hw_t){.p_port = GPIOB, .pin = 11, .active_low = true, .event = BUTTON_0_EVENT};
+    buttons_arr[2] = (port_button_hw_t){.p_port = GPIOA, .pin = 14, .active_low = true, .event = BUTTON_0_EVENT};
+    buttons_arr[3] = (port_button_hw_t){.p_port = GPIOB, .pin = 5, .active_low = true, .event = BUTTON_0_EVENT};
+    for (uint32_t id = 1; id <= 3; id++)
+    {
+        port_button_init(id);
+    }
+    native_sim_reset_irq_counts();
+
+    // Both edges of lines 11 and 14 are pending when the interrupts are enabled again
+    __disable_irq();
+    native_sim_gpio_set_input(GPIOB, 11, LOW);
+    native_sim_gpio_set_input(GPIOA, 14, LOW);
+    __enable_irq();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, native_sim_get_irq_count(EXTI15_10_IRQn), __LINE__, "ERROR: The pending lines of the group must be served by a single interrupt");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, EXTI->PR, __LINE__, "ERROR: The ISR did not clear the pending register");
+    TEST_ASSERT_TRUE(port_button_is_pressed(1));
+    TEST_ASSERT_TRUE(port_button_is_pressed(2));
+    TEST_ASSERT_FALSE(port_button_is_pressed(BUTTON_0_ID));
+    TEST_ASSERT_FALSE(port_button_is_pressed(3));
+
+    native_sim_gpio_set_input(GPIOB, 5, LOW);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, native_sim_get_irq_count(EXTI9_5_IRQn), __LINE__, "ERROR: Line 5 must be served by EXTI9_5");
+    TEST_ASSERT_TRUE(port_button_is_pressed(3));
+
+    native_sim_gpio_set_input(GPIOB, 11, HIGH);
+    TEST_ASSERT_FALSE(port_button_is_pressed(1));
+    TEST_ASSERT_TRUE(port_button_is_pressed(2));
+}
+
+/**
+ * @brief Test that a button on a pin whose EXTI line already belongs to another button is rejected.
+ *
+ */
+void test_exti_line_taken(void)
+{
+    buttons_arr[4] = (port_button_hw_t){.p_port = GPIOA, .pin = BUTTON_0_PIN, .active_low = true, .event = BUTTON_0_EVENT};
+    TEST_ASSERT_FALSE(port_button_init(4));
+    TEST_ASSERT_TRUE(port_button_init(BUTTON_0_ID));
+
+    // The EXTI line still belongs to the first button
+    native_sim_gpio_set_input(BUTTON_0_GPIO, BUTTON_0_PIN, LOW);
+    TEST_ASSERT_TRUE(port_button_is_pressed(BUTTON_0_ID));
+    TEST_ASSERT_FALSE(port_button_is_pressed(4));
+}
+
+/**
+ * @brief Test that in sampled mode a bouncing press raises no EXTI interrupt and changes the button once.
+ *
+ */
+void test_sampled_debounce(void)
+{
+    port_button_set_debounce_mode(PORT_BUTTON_DEBOUNCE_SAMPLED);
+    native_sim_reset_irq_counts();
+
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        native_sim_gpio_set_input(BUTTON_0_GPIO, BUTTON_0_PIN, i % 2);
+        native_sim_advance_us(700);
+    }
+    native_sim_gpio_set_input(BUTTON_0_GPIO, BUTTON_0_PIN, LOW);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, native_sim_get_irq_count(EXTI15_10_IRQn), __LINE__, "ERROR: The EXTI interrupt must be disabled in sampled mode");
+    TEST_ASSERT_FALSE(port_button_is_pressed(BUTTON_0_ID));
+
+    native_sim_advance_ms(BUTTON_DEBOUNCE_SAMPLES * PORT_BUTTON_SAMPLE_PERIOD_MS);
+    TEST_ASSERT_TRUE(port_button_is_pressed(BUTTON_0_ID));
+    uint32_t pressed, released;
+    port_button_take_edges(&pressed, &released);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(BIT_POS_TO_MASK(BUTTON_0_ID), pressed, __LINE__, "ERROR: Wrong press edges");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, released, __LINE__, "ERROR: Wrong release edges");
+
+    native_sim_gpio_set_input(BUTTON_0_GPIO, BUTTON_0_PIN, HIGH);
+    native_sim_advance_ms(BUTTON_DEBOUNCE_SAMPLES * PORT_BUTTON_SAMPLE_PERIOD_MS);
+    TEST_ASSERT_FALSE(port_button_is_pressed(BUTTON_0_ID));
+    port_button_take_edges(&pressed, &released);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(BIT_POS_TO_MASK(BUTTON_0_ID), released, __LINE__, "ERROR: Wrong release edges");
+
+    // A button initialised while in sampled mode must not request the EXTI interrupt either
+    port_button_init(BUTTON_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, EXTI->IMR & BIT_POS_TO_MASK(BUTTON_0_PIN), __LINE__, "ERROR: port_button_init() enabled the EXTI interrupt in sampled mode");
+    native_sim_gpio_set_input(BUTTON_0_GPIO, BUTTON_0_PIN, LOW);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, native_sim_get_irq_count(EXTI15_10_IRQn), __LINE__, "ERROR: The EXTI interrupt must be disabled in sampled mode");
+    native_sim_gpio_set_input(BUTTON_0_GPIO, BUTTON_0_PIN, HIGH);
+
+    port_button_set_debounce_mode(PORT_BUTTON_DEBOUNCE_EXTI);
+}
+
+/**
+ * @brief Test that the virtual clock drives the System tick: one SysTick interrupt per millisecond.
+ *
+ */
+void test_virtual_clock(void)
+{
+    uint32_t start = port_button_get_tick();
+    native_sim_reset_irq_counts();
+
+    port_system_delay_ms(1000);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(start + 1000, port_button_get_tick(), __LINE__, "ERROR: The delay did not advance the System tick 1000 ms");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1000, native_sim_get_irq_count(SysTick_IRQn), __LINE__, "ERROR: SysTick must be entered once per millisecond");
+
+    // One hour of virtual time
+    native_sim_advance_ms(3600000);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(start + 3601000, port_button_get_tick(), __LINE__, "ERROR: The virtual clock did not advance one hour");
+}
+
+/**
+ * @brief Main function to run the unit tests.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_regs);
+    RUN_TEST(test_press_release);
+    RUN_TEST(test_exti_disabled);
+    RUN_TEST(test_multi_button);
+    RUN_TEST(test_exti_line_taken);
+    RUN_TEST(test_sampled_debounce);
+    RUN_TEST(test_virtual_clock);
+    return UNITY_END();
+}
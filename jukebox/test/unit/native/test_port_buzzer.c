@@ -0,0 +1,252 @@
+/**
+ * @file test_port_buzzer.c
+ * @brief Unit test for the buzzer port driver on the native platform.
+ *
+ * It checks the configuration of TIM2 and TIM3, the note by note mode, and that the sequencer plays a whole melody from
+ * the TIM2 ISR: every note starts exactly on its time grid with an idle main loop, at most one critical section late
+ * under a heavy main loop (blocking delays, busy work and critical sections) without accumulating drift, and the buzzer
+ * event is posted only once, at the end of the melody.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* HW dependent libraries */
+#include "port_buzzer.h"
+#include "port_system.h"
+#include "native_sim.h"
+
+/* Other libraries */
+#include "note_table.h"
+#include "melodies.h"
+
+/* Test dependencies */
+#include <unity.h>
+
+/* Private defines ------------------------------------------------------------*/
+#define TEST_TEMPO_BASE_MS 10U      /*!< Tempo base of the test melody */
+#define TEST_CRITICAL_US 300U       /*!< Length of the critical sections of the synthetic load */
+#define TEST_MAX_CHANGES 64U        /*!< Changes of the PWM output read from the model */
+#define TEST_NOTE_A4 NOTE_INDEX(NOTE_LA, 4) /*!< Note A4 */
+#define TEST_NOTE_C5 NOTE_INDEX(NOTE_DO, 5) /*!< Note C5 */
+#define TEST_NOTE_E5 NOTE_INDEX(NOTE_MI, 5) /*!< Note E5 */
+
+/* Private variables ------------------------------------------------------------*/
+/**
+ * @brief Test melody: a rest in the middle, the same note twice in a row and durations that are not multiples of 1 ms.
+ */
+static const uint16_t test_notes[] = {
+    MELODY_PACK(TEST_NOTE_A4, 25),
+    MELODY_PACK(NOTE_SILENCE, 5),
+    MELODY_PACK(TEST_NOTE_C5, 10),
+    MELODY_PACK(TEST_NOTE_C5, 10),
+    MELODY_PACK(TEST_NOTE_E5, 37),
+    MELODY_PACK(TEST_NOTE_A4, 3),
+};
+static const melody_t test_melody = {.p_name = "test", .p_notes = test_notes, .melody_length = sizeof(test_notes) / sizeof(test_notes[0]), .tempo_base_ms = TEST_TEMPO_BASE_MS};
+static const melody_t empty_melody = {.p_name = "empty", .p_notes = test_notes, .melody_length = 0, .tempo_base_ms = TEST_TEMPO_BASE_MS};
+
+static native_sim_tim_output_t changes[TEST_MAX_CHANGES]; /*!< Changes of the output of TIM3 */
+
+/* Private functions */
+/**
+ * @brief Period of a note in core clock cycles, as TIM3 generates it.
+ */
+static uint32_t _period_cycles(uint32_t note)
+{
+    const note_timer_t *p_timer = note_table_get(note);
+    return ((uint32_t)p_timer->psc + 1U) * ((uint32_t)p_timer->arr + 1U);
+}
+
+/**
+ * @brief Check the changes of the output of TIM3 against the test melody: one change per note (the rest stops the
+ * output) and a last one that stops it, each one at most `late_us` after the grid that starts at `start`.
+ */
+static void _check_onsets(uint64_t start, uint32_t late_us, uint32_t count)
+{
+    uint32_t expected = test_melody.melody_length + 1U;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(expected, count, __LINE__, "ERROR: The output of TIM3 did not change once per note");
+    uint64_t at = start;
+    for (uint32_t i = 0; i < expected; i++)
+    {
+        uint32_t note = (i < test_melody.melody_length) ? MELODY_NOTE(test_notes[i]) : NOTE_SILENCE;
+        uint32_t period = (note == NOTE_SILENCE) ? 0U : _period_cycles(note);
+        UNITY_TEST_ASSERT(changes[i].at >= at, __LINE__, "ERROR: A note started before its time");
+        UNITY_TEST_ASSERT(changes[i].at - at <= (uint64_t)late_us * NATIVE_SIM_CYCLES_PER_US, __LINE__, "ERROR: A note started too late");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(period, changes[i].period_cycles, __LINE__, "ERROR: Wrong period of a note");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(period / 2U, changes[i].pulse_cycles, __LINE__, "ERROR: The duty cycle is not 50 %");
+        if (i < test_melody.melody_length)
+        {
+            at += (uint64_t)MELODY_CODE(test_notes[i]) * TEST_TEMPO_BASE_MS * NATIVE_SIM_CYCLES_PER_MS; /* The grid does not depend on the previous onset */
+        }
+    }
+}
+
+/**
+ * @brief Set the Up object. The simulated board is reset before each test and the virtual clock only advances on request.
+ *
+ */
+void setUp(void)
+{
+    port_system_init();
+    native_sim_set_stall_guard(false);
+    port_buzzer_init(BUZZER_0_ID);
+    port_system_take_events();
+}
+
+/**
+ * @brief Tear down the test. It is called after a test function is called.
+ *
+ */
+void tearDown(void)
+{
+    port_buzzer_stop(BUZZER_0_ID);
+}
+
+/**
+ * @brief Test the configuration of the pin and of the two timers.
+ *
+ */
+void test_regs(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_UINT32(GPIO_MODE_ALTERNATE, (BUZZER_0_GPIO->MODER >> (BUZZER_0_PIN * 2)) & 0x3, __LINE__, "ERROR: Buzzer pin is not in alternate mode");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(BUZZER_0_AF, (BUZZER_0_GPIO->AFR[BUZZER_0_PIN / 8] >> ((BUZZER_0_PIN % 8) * 4)) & 0xF, __LINE__, "ERROR: Buzzer pin is not TIM3_CH1");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(RCC_APB1ENR_TIM2EN | RCC_APB1ENR_TIM3EN, RCC->APB1ENR & (RCC_APB1ENR_TIM2EN | RCC_APB1ENR_TIM3EN), __LINE__, "ERROR: Timer clocks are not enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1, TIM3->CCMR1 & TIM_CCMR1_OC1M, __LINE__, "ERROR: TIM3 channel 1 is not in PWM mode 1");
+    UNITY_TEST_ASSERT(TIM3->CCMR1 & TIM_CCMR1_OC1PE, __LINE__, "ERROR: TIM3 CCR1 preload is not enabled");
+    UNITY_TEST_ASSERT(!(TIM3->CCER & TIM_CCER_CC1E), __LINE__, "ERROR: The buzzer is not silent after init");
+    UNITY_TEST_ASSERT(TIM2->CR1 & TIM_CR1_ARPE, __LINE__, "ERROR: TIM2 ARR preload is not enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(NATIVE_CORE_CLOCK_HZ / PORT_BUZZER_DURATION_TICK_HZ - 1U, TIM2->PSC, __LINE__, "ERROR: TIM2 does not count milliseconds");
+    UNITY_TEST_ASSERT(TIM2->DIER & TIM_DIER_UIE, __LINE__, "ERROR: TIM2 update interrupt is not enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, NVIC_GetEnableIRQ(TIM2_IRQn), __LINE__, "ERROR: TIM2 interrupt is not enabled");
+}
+
+/**
+ * @brief Test that the buzzer is not configured with a timer clock other than the one of `note_table`.
+ *
+ */
+void test_wrong_timer_clock(void)
+{
+    port_system_init();
+    SystemCoreClock = 84000000U; // 84 MHz: the notes would be out of tune and the TIM2 prescaler would not fit in 16 bits
+    UNITY_TEST_ASSERT_EQUAL_INT(false, port_buzzer_init(BUZZER_0_ID), __LINE__, "ERROR: The buzzer was initialized with a wrong timer clock");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM2->PSC, __LINE__, "ERROR: TIM2 was configured with a wrong timer clock");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, NVIC_GetEnableIRQ(TIM2_IRQn), __LINE__, "ERROR: TIM2 interrupt was enabled with a wrong timer clock");
+    SystemCoreClock = NATIVE_CORE_CLOCK_HZ;
+    RCC->CFGR |= (0x4U << RCC_CFGR_PPRE1_Pos); // APB1 = HCLK / 2: the timers still run at twice the bus clock
+    UNITY_TEST_ASSERT_EQUAL_INT(true, port_buzzer_init(BUZZER_0_ID), __LINE__, "ERROR: The buzzer was not initialized with the APB1 prescaler");
+    RCC->CFGR &= ~RCC_CFGR_PPRE1;
+}
+
+/**
+ * @brief Test the note by note mode: the ISR only reports the end of the note.
+ *
+ */
+void test_note_by_note(void)
+{
+    uint64_t start = native_sim_get_cycles();
+    port_buzzer_set_note(BUZZER_0_ID, TEST_NOTE_A4);
+    port_buzzer_set_note_duration(BUZZER_0_ID, 50);
+    native_sim_advance_ms(49);
+    UNITY_TEST_ASSERT(!port_buzzer_get_note_timeout(BUZZER_0_ID), __LINE__, "ERROR: The note ended too early");
+    native_sim_advance_ms(1);
+    UNITY_TEST_ASSERT(port_buzzer_get_note_timeout(BUZZER_0_ID), __LINE__, "ERROR: The note did not end after its duration");
+    UNITY_TEST_ASSERT(!port_buzzer_get_note_timeout(BUZZER_0_ID), __LINE__, "ERROR: The end of note flag was not cleared");
+    UNITY_TEST_ASSERT(port_system_take_events() & (1U << BUZZER_0_EVENT), __LINE__, "ERROR: The end of the note was not posted");
+    native_sim_advance_ms(200);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, native_sim_get_irq_count(TIM2_IRQn), __LINE__, "ERROR: TIM2 did not stop after the note");
+
+    uint32_t count = native_sim_tim_read_output(TIM3, changes, TEST_MAX_CHANGES);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, count, __LINE__, "ERROR: Wrong number of changes of the output");
+    UNITY_TEST_ASSERT(changes[0].at == start, __LINE__, "ERROR: The note did not start when it was set");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(_period_cycles(TEST_NOTE_A4), changes[0].period_cycles, __LINE__, "ERROR: Wrong period of the note");
+}
+
+/**
+ * @brief Test that the sequencer plays every note on its grid with an idle main loop and only posts the end of the melody.
+ *
+ */
+void test_sequencer_exact(void)
+{
+    uint64_t start = native_sim_get_cycles();
+    UNITY_TEST_ASSERT(port_buzzer_play_melody(BUZZER_0_ID, &test_melody), __LINE__, "ERROR: The melody did not start");
+    UNITY_TEST_ASSERT(port_buzzer_is_sequencing(BUZZER_0_ID), __LINE__, "ERROR: The sequencer is not running");
+    native_sim_advance_ms(melody_get_duration_ms(&test_melody) - 1U);
+    UNITY_TEST_ASSERT(!port_buzzer_get_melody_end(BUZZER_0_ID), __LINE__, "ERROR: The melody ended too early");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_system_take_events(), __LINE__, "ERROR: The main loop was woken up before the end of the melody");
+    native_sim_advance_ms(1);
+    UNITY_TEST_ASSERT(port_buzzer_get_melody_end(BUZZER_0_ID), __LINE__, "ERROR: The end of the melody was not reported");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1U << BUZZER_0_EVENT, port_system_take_events(), __LINE__, "ERROR: The end of the melody was not posted");
+    UNITY_TEST_ASSERT(!port_buzzer_is_sequencing(BUZZER_0_ID), __LINE__, "ERROR: The sequencer did not stop");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(test_melody.melody_length, native_sim_get_irq_count(TIM2_IRQn), __LINE__, "ERROR: TIM2 did not interrupt once per note");
+
+    _check_onsets(start, 0, native_sim_tim_read_output(TIM3, changes, TEST_MAX_CHANGES));
+    native_sim_advance_ms(100);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(test_melody.melody_length, native_sim_get_irq_count(TIM2_IRQn), __LINE__, "ERROR: TIM2 did not stop after the melody");
+}
+
+/**
+ * @brief Test that a heavy main loop delays each note by at most one critical section and that the delay does not
+ * accumulate: blocking delays and busy work do not delay the ISR at all.
+ *
+ */
+void test_sequencer_under_load(void)
+{
+    uint64_t start = native_sim_get_cycles();
+    uint32_t wakeups = 0;
+    uint32_t seed = 12345U;
+    port_buzzer_play_melody(BUZZER_0_ID, &test_melody);
+    while (!port_buzzer_get_melody_end(BUZZER_0_ID))
+    {
+        seed = seed * 1664525U + 1013904223U;
+        port_system_delay_ms(1U + (seed >> 28)); /* Blocking delay of 1 to 16 ms */
+        native_sim_advance_us((seed >> 8) & 0x7FFU); /* Busy work of up to 2 ms */
+        uint32_t state = port_system_enter_critical();
+        native_sim_advance_us(TEST_CRITICAL_US);
+        port_system_exit_critical(state);
+        wakeups += (port_system_take_events() & (1U << BUZZER_0_EVENT)) ? 1U : 0U;
+    }
+    wakeups += (port_system_take_events() & (1U << BUZZER_0_EVENT)) ? 1U : 0U;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, wakeups, __LINE__, "ERROR: The buzzer event was posted more than once");
+    _check_onsets(start, TEST_CRITICAL_US, native_sim_tim_read_output(TIM3, changes, TEST_MAX_CHANGES));
+}
+
+/**
+ * @brief Test that stopping the buzzer cancels the melody without posting its end.
+ *
+ */
+void test_sequencer_stop(void)
+{
+    port_buzzer_play_melody(BUZZER_0_ID, &test_melody);
+    native_sim_advance_ms(100);
+    port_buzzer_stop(BUZZER_0_ID);
+    UNITY_TEST_ASSERT(!port_buzzer_is_sequencing(BUZZER_0_ID), __LINE__, "ERROR: The sequencer did not stop");
+    uint32_t interrupts = native_sim_get_irq_count(TIM2_IRQn);
+    native_sim_advance_ms(melody_get_duration_ms(&test_melody));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(interrupts, native_sim_get_irq_count(TIM2_IRQn), __LINE__, "ERROR: TIM2 did not stop");
+    UNITY_TEST_ASSERT(!port_buzzer_get_melody_end(BUZZER_0_ID), __LINE__, "ERROR: A stopped melody reported its end");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_system_take_events(), __LINE__, "ERROR: A stopped melody posted an event");
+
+    uint32_t count = native_sim_tim_read_output(TIM3, changes, TEST_MAX_CHANGES);
+    UNITY_TEST_ASSERT(count > 0, __LINE__, "ERROR: The melody did not play");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, changes[count - 1].period_cycles, __LINE__, "ERROR: The output was not silenced");
+    UNITY_TEST_ASSERT(!port_buzzer_play_melody(BUZZER_0_ID, &empty_melody), __LINE__, "ERROR: A melody without notes started");
+}
+
+/**
+ * @brief Main function of the test.
+ *
+ * @return int
+ */
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_regs);
+    RUN_TEST(test_wrong_timer_clock);
+    RUN_TEST(test_note_by_note);
+    RUN_TEST(test_sequencer_exact);
+    RUN_TEST(test_sequencer_under_load);
+    RUN_TEST(test_sequencer_stop);
+    return UNITY_END();
+}
@@ -0,0 +1,915 @@
+/**
+ * @file test_port_uart.c
+ * @brief Unit test for the USART port driver on the native platform.
+ *
+ * It sends bytes from the simulated peer and checks that they are received through the USART3 ISR, and it checks
+ * that the transmitted bytes reach the peer at the configured baud rate. The DMA mode is checked against the DMA1
+ * model of the simulator.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <string.h>
+
+/* HW dependent libraries */
+#include "port_usart.h"
+#include "port_system.h"
+#include "native_sim.h"
+
+/* Other libraries */
+#include "fsm_usart.h"
+#include "cmd_registry.h"
+
+/* Test dependencies */
+#include <unity.h>
+
+/* Private defines ------------------------------------------------------------*/
+#define FRAME_CYCLES_9600 (0x0683 * 10) /*!< Duration of a 8N1 frame at 9600 bauds with a 16 MHz clock */
+#define THROUGHPUT_LINES 4000            /*!< Lines sent back to back by the peer in the throughput test */
+
+/**
+ * @brief Set the Up object. The simulated board is reset before each test and the virtual clock only advances on request.
+ *
+ */
+void setUp(void)
+{
+    port_system_init();
+    native_sim_set_stall_guard(false);
+    port_usart_init(USART_0_ID);
+}
+
+/**
+ * @brief Tear down the test. It is called after a test function is called.
+ *
+ */
+void tearDown(void)
+{
+    port_usart_disable_rx_interrupt(USART_0_ID);
+    port_usart_disable_tx_interrupt(USART_0_ID);
+}
+
+/**
+ * @brief Test the configuration of the USART registers.
+ *
+ */
+void test_usart_config(void)
+{
+    uint32_t cr1 = USART_0->CR1;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(USART_CR1_UE | USART_CR1_TE | USART_CR1_RE, cr1, __LINE__, "ERROR: USART must be enabled in 8N1 with TX and RX and no interrupts");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x0683, USART_0->BRR, __LINE__, "ERROR: USART baud rate is not configured as 9600 bauds");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FRAME_CYCLES_9600, native_sim_usart_get_frame_cycles(USART_0), __LINE__, "ERROR: Wrong frame duration");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(USART_SR_TXE | USART_SR_TC, USART_0->SR, __LINE__, "ERROR: Only TXE and TC must be set after configuration");
+}
+
+/**
+ * @brief Test the BRR and the baud error computed for the standard profiles with the 16 MHz APB1 clock.
+ *
+ */
+void test_baudrate_profiles(void)
+{
+    const struct
+    {
+        uint32_t baudrate;
+        uint32_t brr;
+        uint32_t over8;
+        int32_t error_ppm;
+    } profiles[] = {
+        {9600, 0x0683, 0, -200},
+        {115200, 0x008B, 0, -799},
+        {460800, 0x0023, 0, -7936},
+        {921600, 0x0011, 0, 21241},
+        {1000000, 0x0010, 0, 0},
+        {2000000, 0x0010, USART_CR1_OVER8, 0},
+    };
+    for (uint32_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++)
+    {
+        int32_t error_ppm;
+        TEST_ASSERT_TRUE(port_usart_set_baudrate(USART_0_ID, profiles[i].baudrate));
+        UNITY_TEST_ASSERT_EQUAL_UINT32(profiles[i].brr, USART_0->BRR, __LINE__, "ERROR: Wrong BRR");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(profiles[i].over8, USART_0->CR1 & USART_CR1_OVER8, __LINE__, "ERROR: Wrong oversampling");
+        port_usart_get_baudrate(USART_0_ID, &error_ppm);
+        UNITY_TEST_ASSERT_EQUAL_INT(profiles[i].error_ppm, error_ppm, __LINE__, "ERROR: Wrong baud error");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(USART_CR1_UE, USART_0->CR1 & USART_CR1_UE, __LINE__, "ERROR: The USART must be enabled again");
+
+        // The bit time of the simulated line follows the real baud rate
+        uint32_t frame_cycles = native_sim_usart_get_frame_cycles(USART_0);
+        uint32_t expected_cycles = (uint32_t)((10ULL * port_system_get_apb1_clock() + profiles[i].baudrate / 2) / port_usart_get_baudrate(USART_0_ID, NULL));
+        UNITY_TEST_ASSERT(frame_cycles + 10 >= expected_cycles && frame_cycles <= expected_cycles + 10, __LINE__, "ERROR: The frame does not last 10 bits of the real baud rate");
+    }
+
+    // Out of reach with oversampling by 8, and too far from any divider: the configuration is kept
+    TEST_ASSERT_FALSE(port_usart_set_baudrate(USART_0_ID, 3000000));
+    TEST_ASSERT_FALSE(port_usart_set_baudrate(USART_0_ID, 1500000));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2000000, port_usart_get_baudrate(USART_0_ID, NULL), __LINE__, "ERROR: A rejected baud rate changed the configuration");
+}
+
+/**
+ * @brief Test that the BRR follows the APB1 prescaler.
+ *
+ */
+void test_baudrate_apb1_prescaler(void)
+{
+    RCC->CFGR |= (0x4U << RCC_CFGR_PPRE1_Pos); // APB1 = HCLK / 2
+    TEST_ASSERT_TRUE(port_usart_set_baudrate(USART_0_ID, 9600));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x0341, USART_0->BRR, __LINE__, "ERROR: BRR must be computed with the 8 MHz APB1 clock");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x0341 * 2 * 10, native_sim_usart_get_frame_cycles(USART_0), __LINE__, "ERROR: The USART must be clocked by APB1");
+    RCC->CFGR &= ~RCC_CFGR_PPRE1;
+}
+
+/**
+ * @brief Test the reception of a message terminated by END_CHAR_CONSTANT.
+ *
+ */
+void test_rx_message(void)
+{
+    const char *p_msg = "play\n";
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)p_msg, strlen(p_msg));
+
+    // Nothing arrives before the first frame is complete
+    native_sim_advance_cycles(FRAME_CYCLES_9600 - 1);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, native_sim_get_irq_count(USART3_IRQn), __LINE__, "ERROR: A byte cannot arrive before its frame is complete");
+
+    native_sim_advance_cycles(1 + (strlen(p_msg) - 1) * FRAME_CYCLES_9600);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(strlen(p_msg), native_sim_get_irq_count(USART3_IRQn), __LINE__, "ERROR: One RXNE interrupt is expected per byte");
+    TEST_ASSERT_TRUE(port_usart_rx_done(USART_0_ID));
+
+    char msg[USART_INPUT_BUFFER_LENGTH];
+    port_usart_get_from_input_buffer(USART_0_ID, msg);
+    TEST_ASSERT_EQUAL_STRING_LEN("play", msg, 4);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, USART_0->SR & USART_SR_RXNE, __LINE__, "ERROR: Reading DR must clear RXNE");
+}
+
+/**
+ * @brief Send lines back to back at the given baud rate while the main loop drains the ring once per millisecond.
+ *
+ * @param baudrate Baud rate
+ */
+static void _rx_throughput(uint32_t baudrate)
+{
+    TEST_ASSERT_TRUE(port_usart_set_baudrate(USART_0_ID, baudrate));
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    char line[32];
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    uint32_t idle_ms = 0;
+    while ((received < THROUGHPUT_LINES) && (idle_ms < 10))
+    {
+        // The peer always has bytes queued, so the line never goes idle
+        while ((sent < THROUGHPUT_LINES) && (native_sim_usart_get_rx_pending(USART_0) < NATIVE_SIM_USART_FIFO_LENGTH - sizeof(line)))
+        {
+            uint32_t length = (uint32_t)snprintf(line, sizeof(line), "play song %u\n", (unsigned)sent++);
+            native_sim_usart_inject_rx(USART_0, (const uint8_t *)line, length);
+        }
+        native_sim_advance_ms(1);
+        const char *p_line;
+        uint32_t length;
+        idle_ms++;
+        while (port_usart_get_line(USART_0_ID, &p_line, &length))
+        {
+            uint32_t expected_length = (uint32_t)snprintf(line, sizeof(line), "play song %u", (unsigned)received);
+            UNITY_TEST_ASSERT_EQUAL_UINT32(expected_length, length, __LINE__, "ERROR: Wrong length of a received line");
+            UNITY_TEST_ASSERT_EQUAL_MEMORY(line, p_line, length, __LINE__, "ERROR: Wrong content of a received line");
+            port_usart_reset_input_buffer(USART_0_ID);
+            received++;
+            idle_ms = 0;
+        }
+    }
+
+    native_sim_usart_stats_t stats;
+    native_sim_usart_get_stats(USART_0, &stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(THROUGHPUT_LINES, received, __LINE__, "ERROR: Not all the lines were received");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_usart_get_rx_dropped(USART_0_ID), __LINE__, "ERROR: The ring dropped bytes");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, stats.rx_overruns, __LINE__, "ERROR: The USART overran");
+}
+
+/**
+ * @brief Test continuous reception at 115200 bauds without drops, with the lines wrapping around the ring.
+ *
+ */
+void test_rx_throughput_115200(void)
+{
+    _rx_throughput(115200);
+}
+
+/**
+ * @brief Test continuous reception at 921600 bauds without drops.
+ *
+ */
+void test_rx_throughput_921600(void)
+{
+    _rx_throughput(921600);
+}
+
+/**
+ * @brief Test that a byte arriving while RXNE is set is lost and raises the overrun flag.
+ *
+ */
+void test_rx_overrun(void)
+{
+    const uint8_t data[] = {'a', 'b'};
+    native_sim_usart_inject_rx(USART_0, data, sizeof(data));
+    native_sim_advance_cycles(2 * FRAME_CYCLES_9600);
+
+    native_sim_usart_stats_t stats;
+    native_sim_usart_get_stats(USART_0, &stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, stats.rx_overruns, __LINE__, "ERROR: The second byte must overrun the first one");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(USART_SR_ORE, USART_0->SR & USART_SR_ORE, __LINE__, "ERROR: ORE must be set");
+    UNITY_TEST_ASSERT_EQUAL_UINT32('a', native_hw_usart_read_dr(USART_0), __LINE__, "ERROR: DR must keep the first byte");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, USART_0->SR & (USART_SR_ORE | USART_SR_RXNE), __LINE__, "ERROR: Reading DR must clear ORE and RXNE");
+}
+
+/**
+ * @brief Test the line error counters in interrupt mode: bytes with framing or parity errors are discarded, noisy bytes
+ * are kept, an overrun keeps the byte in DR, and every flag is cleared by the ISR so that it is entered once per byte.
+ *
+ */
+void test_rx_line_errors(void)
+{
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    native_sim_reset_irq_counts();
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)"ab", 2);
+    native_sim_usart_inject_rx_error(USART_0, 'x', USART_SR_FE);
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)"c", 1);
+    native_sim_usart_inject_rx_error(USART_0, 'd', USART_SR_NE);
+    native_sim_usart_inject_rx_error(USART_0, 'y', USART_SR_PE);
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)"\n", 1);
+    native_sim_advance_cycles(7 * FRAME_CYCLES_9600);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(7, native_sim_get_irq_count(USART3_IRQn), __LINE__, "ERROR: The ISR must be entered once per byte");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, USART_0->SR & (USART_SR_ORE | USART_SR_NE | USART_SR_FE | USART_SR_PE), __LINE__, "ERROR: The error flags were not cleared");
+
+    const char *p_line;
+    uint32_t length;
+    TEST_ASSERT_TRUE(port_usart_get_line(USART_0_ID, &p_line, &length));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, length, __LINE__, "ERROR: Wrong length of the line with errors");
+    TEST_ASSERT_EQUAL_MEMORY("abcd", p_line, 4);
+    port_usart_reset_input_buffer(USART_0_ID);
+
+    // Two bytes overrun the first one while the interrupt is disabled: one overrun is seen when it is enabled again
+    port_usart_disable_rx_interrupt(USART_0_ID);
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)"ef\n", 3);
+    native_sim_advance_cycles(3 * FRAME_CYCLES_9600);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, USART_0->SR & (USART_SR_ORE | USART_SR_RXNE), __LINE__, "ERROR: The overrun was not cleared");
+
+    port_usart_stats_t stats;
+    port_usart_get_stats(USART_0_ID, &stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(8, stats.rx_bytes, __LINE__, "ERROR: Wrong number of bytes read");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, stats.rx_frames, __LINE__, "ERROR: Wrong number of lines");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, stats.overruns, __LINE__, "ERROR: Wrong number of overruns");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, stats.framing_errors, __LINE__, "ERROR: Wrong number of framing errors");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, stats.noise_errors, __LINE__, "ERROR: Wrong number of noise errors");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, stats.parity_errors, __LINE__, "ERROR: Wrong number of parity errors");
+
+    port_usart_reset_stats(USART_0_ID);
+    port_usart_get_stats(USART_0_ID, &stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, stats.rx_bytes + stats.overruns + stats.framing_errors, __LINE__, "ERROR: The counters were not reset");
+}
+
+/**
+ * @brief Test the line errors in DMA mode, which reach the ISR through EIE, and the console command that reports the
+ * counters.
+ *
+ */
+void test_dma_line_errors(void)
+{
+    static const cmd_entry_t commands[] = {{"usart", fsm_usart_cmd_stats, 0, 1}, {NULL, NULL, 0, 0}};
+    static cmd_registry_t registry;
+    static fsm_usart_t console;
+    TEST_ASSERT_TRUE(cmd_registry_build(&registry, commands));
+    fsm_usart_new_static(&console, USART_0_ID);
+
+    port_usart_set_mode(USART_0_ID, PORT_USART_MODE_DMA);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(USART_CR3_EIE, USART_0->CR3 & USART_CR3_EIE, __LINE__, "ERROR: The error interrupt is not enabled in DMA mode");
+    native_sim_reset_irq_counts();
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)"ok", 2);
+    native_sim_usart_inject_rx_error(USART_0, 'z', USART_SR_FE);
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)"\n", 1);
+    native_sim_advance_cycles(5 * FRAME_CYCLES_9600);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, native_sim_get_irq_count(USART3_IRQn), __LINE__, "ERROR: Expected one error interrupt and one idle interrupt");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, USART_0->SR & USART_SR_FE, __LINE__, "ERROR: The framing error was not cleared");
+    TEST_ASSERT_TRUE(port_usart_rx_done(USART_0_ID));
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_OK, cmd_registry_dispatch(&registry, "usart", 5, &console), __LINE__, "ERROR: The stats command failed");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_BAD_ARGUMENT, cmd_registry_dispatch(&registry, "usart 9", 7, &console), __LINE__, "ERROR: A USART that does not exist was accepted");
+    const char *p_expected = "usart 0 rx 4 frames 1 ore 0 fe 1 ne 0 pe 0 drop 0\n";
+    uint8_t reply[64];
+    native_sim_advance_cycles((strlen(p_expected) + 1) * FRAME_CYCLES_9600);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(strlen(p_expected), native_sim_usart_read_tx(USART_0, reply, sizeof(reply)), __LINE__, "ERROR: Wrong length of the reply");
+    UNITY_TEST_ASSERT_EQUAL_MEMORY(p_expected, reply, strlen(p_expected), __LINE__, "ERROR: Wrong reply");
+
+    port_usart_disable_rx_interrupt(USART_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, USART_0->CR3 & USART_CR3_EIE, __LINE__, "ERROR: The error interrupt was not disabled");
+    port_usart_set_mode(USART_0_ID, PORT_USART_MODE_IRQ);
+}
+
+/**
+ * @brief Let the peer send `lines` lines of 10 bytes while the main loop does not read them, then read them all.
+ *
+ * @param lines Number of lines
+ * @param p_read Pointer to store the number of lines read
+ */
+static void _flow_bulk(uint32_t lines, uint32_t *p_read)
+{
+    char line[24];
+    for (uint32_t i = 0; i < lines; i++)
+    {
+        snprintf(line, sizeof(line), "line %04u\n", (unsigned)i);
+        native_sim_usart_inject_rx(USART_0, (const uint8_t *)line, 10);
+    }
+    // The main loop is busy for the time of the whole transfer: the ring alone could not hold it
+    native_sim_advance_cycles(lines * 10 * FRAME_CYCLES_9600);
+    UNITY_TEST_ASSERT(native_sim_usart_get_rx_pending(USART_0) > 0, __LINE__, "ERROR: The peer did not stop");
+    UNITY_TEST_ASSERT(spsc_ring_count(&usart_arr[USART_0_ID].rx_ring) < USART_RX_RING_LENGTH, __LINE__, "ERROR: The ring filled up");
+
+    *p_read = 0;
+    for (uint32_t idle_ms = 0; (*p_read < lines) && (idle_ms < 100); idle_ms++)
+    {
+        const char *p_line;
+        uint32_t length;
+        while (port_usart_get_line(USART_0_ID, &p_line, &length))
+        {
+            snprintf(line, sizeof(line), "line %04u", (unsigned)*p_read);
+            UNITY_TEST_ASSERT_EQUAL_MEMORY(line, p_line, 9, __LINE__, "ERROR: Wrong content of a received line");
+            port_usart_reset_input_buffer(USART_0_ID);
+            (*p_read)++;
+            idle_ms = 0;
+        }
+        native_sim_advance_ms(1);
+    }
+    port_usart_stats_t stats;
+    port_usart_get_stats(USART_0_ID, &stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(lines, *p_read, __LINE__, "ERROR: Not all the lines were received");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, stats.rx_dropped, __LINE__, "ERROR: The ring dropped bytes");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, stats.overruns, __LINE__, "ERROR: The USART overran");
+    UNITY_TEST_ASSERT(stats.flow_pauses > 0, __LINE__, "ERROR: The peer was never asked to stop");
+}
+
+/**
+ * @brief Test the hardware flow control: RTS follows the watermarks of the ring, so a bulk transfer that the main loop
+ * does not read in time pauses the peer instead of losing bytes, and CTS holds the transmitter while the peer is busy.
+ *
+ */
+void test_flow_rts_cts(void)
+{
+    TEST_ASSERT_TRUE(port_usart_set_flow_control(USART_0_ID, PORT_USART_FLOW_RTS_CTS));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(USART_CR3_CTSE, USART_0->CR3 & USART_CR3_CTSE, __LINE__, "ERROR: CTSE is not enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(GPIO_MODE_OUT, (USART_0_GPIO_RTS->MODER >> (USART_0_PIN_RTS * 2)) & 0x3U, __LINE__, "ERROR: RTS is not an output");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(GPIO_MODE_ALTERNATE, (USART_0_GPIO_CTS->MODER >> (USART_0_PIN_CTS * 2)) & 0x3U, __LINE__, "ERROR: CTS is not in alternate mode");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(USART_0_AF_TX, (USART_0_GPIO_CTS->AFR[USART_0_PIN_CTS / 8] >> ((USART_0_PIN_CTS % 8) * 4)) & 0xFU, __LINE__, "ERROR: Wrong alternate function of CTS");
+    TEST_ASSERT_FALSE(port_system_gpio_read(USART_0_GPIO_RTS, USART_0_PIN_RTS));
+
+    native_sim_usart_set_peer_flow(USART_0, NATIVE_SIM_FLOW_RTS_CTS, USART_0_GPIO_RTS, USART_0_PIN_RTS);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    uint32_t read;
+    _flow_bulk(100, &read);
+    TEST_ASSERT_FALSE(port_system_gpio_read(USART_0_GPIO_RTS, USART_0_PIN_RTS));
+    native_sim_usart_stats_t peer;
+    native_sim_usart_get_stats(USART_0, &peer);
+    UNITY_TEST_ASSERT(peer.rx_waits > 0, __LINE__, "ERROR: The peer never waited");
+
+    // CTS: nothing leaves the transmitter while the peer is busy
+    native_sim_usart_set_peer_ready(USART_0, false);
+    TEST_ASSERT_TRUE(port_usart_send(USART_0_ID, "hello\n", 6));
+    native_sim_advance_cycles(20 * FRAME_CYCLES_9600);
+    uint8_t data[8];
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, native_sim_usart_read_tx(USART_0, data, sizeof(data)), __LINE__, "ERROR: A byte was sent with CTS high");
+    native_sim_usart_set_peer_ready(USART_0, true);
+    native_sim_advance_cycles(7 * FRAME_CYCLES_9600);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(6, native_sim_usart_read_tx(USART_0, data, sizeof(data)), __LINE__, "ERROR: The message was not sent after CTS went low");
+    TEST_ASSERT_EQUAL_MEMORY("hello\n", data, 6);
+}
+
+/**
+ * @brief Test that a run of bytes without a delimiter does not stall the hardware flow control: once it reaches the
+ * high watermark the ring can not complete a line, so the run is discarded and RTS is released.
+ *
+ */
+void test_flow_rts_cts_long_line(void)
+{
+    uint8_t run[200];
+    memset(run, 'x', sizeof(run));
+    TEST_ASSERT_TRUE(port_usart_set_flow_control(USART_0_ID, PORT_USART_FLOW_RTS_CTS));
+    native_sim_usart_set_peer_flow(USART_0, NATIVE_SIM_FLOW_RTS_CTS, USART_0_GPIO_RTS, USART_0_PIN_RTS);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    native_sim_usart_inject_rx(USART_0, run, sizeof(run));
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)"ok\n", 3);
+    native_sim_advance_cycles((sizeof(run) + 3) * FRAME_CYCLES_9600);
+    TEST_ASSERT_TRUE(port_system_gpio_read(USART_0_GPIO_RTS, USART_0_PIN_RTS));
+    UNITY_TEST_ASSERT(native_sim_usart_get_rx_pending(USART_0) > 0, __LINE__, "ERROR: The peer did not stop");
+    UNITY_TEST_ASSERT_EQUAL_INT(true, port_usart_rx_done(USART_0_ID), __LINE__, "ERROR: The main loop is not told to discard the run");
+
+    const char *p_line;
+    uint32_t length;
+    TEST_ASSERT_FALSE(port_usart_get_line(USART_0_ID, &p_line, &length));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, usart_arr[USART_0_ID].rx_lines_dropped, __LINE__, "ERROR: The run was not discarded");
+    UNITY_TEST_ASSERT_EQUAL_INT(false, port_system_gpio_read(USART_0_GPIO_RTS, USART_0_PIN_RTS), __LINE__, "ERROR: RTS was not released");
+
+    // The peer resumes and the next line arrives, after the tail of the run that was sent past the watermark
+    native_sim_advance_cycles((sizeof(run) + 3) * FRAME_CYCLES_9600);
+    TEST_ASSERT_TRUE(port_usart_get_line(USART_0_ID, &p_line, &length));
+    UNITY_TEST_ASSERT(length >= 2, __LINE__, "ERROR: The line is too short");
+    UNITY_TEST_ASSERT_EQUAL_MEMORY("ok", p_line + length - 2, 2, __LINE__, "ERROR: Wrong end of the received line");
+    port_usart_reset_input_buffer(USART_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, native_sim_usart_get_rx_pending(USART_0), __LINE__, "ERROR: The peer did not send everything");
+}
+
+/**
+ * @brief Test the software flow control: XOFF and XON are sent at the watermarks of the ring, and the ones received
+ * stop and resume the transmission without reaching the ring.
+ *
+ */
+void test_flow_xon_xoff(void)
+{
+    TEST_ASSERT_TRUE(port_usart_set_mode(USART_0_ID, PORT_USART_MODE_DMA));
+    TEST_ASSERT_FALSE(port_usart_set_flow_control(USART_0_ID, PORT_USART_FLOW_XON_XOFF));
+    TEST_ASSERT_TRUE(port_usart_set_mode(USART_0_ID, PORT_USART_MODE_IRQ));
+    TEST_ASSERT_TRUE(port_usart_set_flow_control(USART_0_ID, PORT_USART_FLOW_XON_XOFF));
+    TEST_ASSERT_FALSE(port_usart_set_mode(USART_0_ID, PORT_USART_MODE_DMA));
+
+    native_sim_usart_set_peer_flow(USART_0, NATIVE_SIM_FLOW_XON_XOFF, NULL, 0);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    uint32_t read;
+    _flow_bulk(100, &read);
+    native_sim_usart_stats_t peer;
+    native_sim_usart_get_stats(USART_0, &peer);
+    UNITY_TEST_ASSERT(peer.rx_waits > 0, __LINE__, "ERROR: The peer never waited");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2 * usart_arr[USART_0_ID].stats.flow_pauses, peer.tx_bytes, __LINE__, "ERROR: Expected one XOFF and one XON per pause");
+
+    // The peer stops the transmission with XOFF and resumes it with XON
+    const uint8_t xoff = USART_XOFF;
+    const uint8_t xon = USART_XON;
+    native_sim_usart_inject_rx(USART_0, &xoff, 1);
+    native_sim_advance_cycles(2 * FRAME_CYCLES_9600);
+    TEST_ASSERT_TRUE(port_usart_send(USART_0_ID, "hello\n", 6));
+    native_sim_advance_cycles(20 * FRAME_CYCLES_9600);
+    uint8_t data[8];
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, native_sim_usart_read_tx(USART_0, data, sizeof(data)), __LINE__, "ERROR: A byte was sent after XOFF");
+    native_sim_usart_inject_rx(USART_0, &xon, 1);
+    native_sim_advance_cycles(9 * FRAME_CYCLES_9600);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(6, native_sim_usart_read_tx(USART_0, data, sizeof(data)), __LINE__, "ERROR: The message was not sent after XON");
+    TEST_ASSERT_EQUAL_MEMORY("hello\n", data, 6);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&usart_arr[USART_0_ID].rx_ring), __LINE__, "ERROR: XON or XOFF reached the ring");
+}
+
+/**
+ * @brief Test that the software flow control is only accepted with text lines: in binary or idle-line frames the bytes
+ * XON and XOFF are data.
+ *
+ */
+void test_flow_xon_xoff_text_only(void)
+{
+    TEST_ASSERT_TRUE(port_usart_set_flow_control(USART_0_ID, PORT_USART_FLOW_XON_XOFF));
+    TEST_ASSERT_FALSE(port_usart_set_framing(USART_0_ID, PORT_USART_FRAMING_IDLE));
+    TEST_ASSERT_FALSE(port_usart_set_rx_delimiter(USART_0_ID, 0x00));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_USART_FRAMING_DELIMITER, usart_arr[USART_0_ID].rx_framing, __LINE__, "ERROR: The framing changed with XON/XOFF");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(END_CHAR_CONSTANT, usart_arr[USART_0_ID].rx_delimiter, __LINE__, "ERROR: The delimiter changed with XON/XOFF");
+    TEST_ASSERT_TRUE(port_usart_set_framing(USART_0_ID, PORT_USART_FRAMING_DELIMITER));
+
+    TEST_ASSERT_TRUE(port_usart_set_flow_control(USART_0_ID, PORT_USART_FLOW_NONE));
+    TEST_ASSERT_TRUE(port_usart_set_framing(USART_0_ID, PORT_USART_FRAMING_IDLE));
+    TEST_ASSERT_FALSE(port_usart_set_flow_control(USART_0_ID, PORT_USART_FLOW_XON_XOFF));
+    TEST_ASSERT_TRUE(port_usart_set_framing(USART_0_ID, PORT_USART_FRAMING_DELIMITER));
+    TEST_ASSERT_TRUE(port_usart_set_rx_delimiter(USART_0_ID, 0x00));
+    TEST_ASSERT_FALSE(port_usart_set_flow_control(USART_0_ID, PORT_USART_FLOW_XON_XOFF));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_USART_FLOW_NONE, usart_arr[USART_0_ID].flow, __LINE__, "ERROR: XON/XOFF was set with binary frames");
+    TEST_ASSERT_TRUE(port_usart_set_rx_delimiter(USART_0_ID, END_CHAR_CONSTANT));
+    TEST_ASSERT_TRUE(port_usart_set_flow_control(USART_0_ID, PORT_USART_FLOW_XON_XOFF));
+}
+
+/**
+ * @brief Test the transmission of a message through the TXE interrupt.
+ *
+ */
+void test_tx_message(void)
+{
+    const char *p_msg = "Hello!\n";
+    TEST_ASSERT_TRUE(port_usart_send(USART_0_ID, p_msg, strlen(p_msg)));
+
+    native_sim_advance_cycles(strlen(p_msg) * FRAME_CYCLES_9600);
+    TEST_ASSERT_TRUE(port_usart_tx_done(USART_0_ID));
+
+    uint8_t received[16] = {0};
+    uint32_t length = native_sim_usart_read_tx(USART_0, received, sizeof(received));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(strlen(p_msg), length, __LINE__, "ERROR: The peer did not receive the whole message");
+    TEST_ASSERT_EQUAL_MEMORY(p_msg, received, strlen(p_msg));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, USART_0->CR1 & USART_CR1_TXEIE, __LINE__, "ERROR: TXEIE must be disabled at the end of the message");
+}
+
+/**
+ * @brief Test that a burst of messages queued back to back is sent in order by the TXE interrupt alone.
+ *
+ */
+void test_tx_burst(void)
+{
+    const char *messages[] = {"status: idle\n", "melody: 3\n", "volume: 7\n", "ok\n"};
+    char expected[64] = "";
+    for (uint32_t i = 0; i < sizeof(messages) / sizeof(messages[0]); i++)
+    {
+        TEST_ASSERT_TRUE(port_usart_send(USART_0_ID, messages[i], strlen(messages[i])));
+        strcat(expected, messages[i]);
+    }
+
+    // The first two bytes fill DR and the shift register as soon as the first message is queued; the rest take one
+    // TXE interrupt per byte, with no extra interrupt to go from one message to the next
+    native_sim_reset_irq_counts();
+    native_sim_advance_cycles((strlen(expected) + 1) * FRAME_CYCLES_9600);
+    TEST_ASSERT_TRUE(port_usart_tx_done(USART_0_ID));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, usart_arr[USART_0_ID].tx_messages_sent, __LINE__, "ERROR: Not all the messages were sent");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(strlen(expected) - 2, native_sim_get_irq_count(USART3_IRQn), __LINE__, "ERROR: Expected one TXE interrupt per byte not loaded while queuing");
+
+    uint8_t received[64] = {0};
+    uint32_t length = native_sim_usart_read_tx(USART_0, received, sizeof(received));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(strlen(expected), length, __LINE__, "ERROR: The peer did not receive all the messages");
+    TEST_ASSERT_EQUAL_MEMORY(expected, received, strlen(expected));
+}
+
+/**
+ * @brief Test the back-pressure of the TX queue: a message that does not fit is rejected and the queued ones are kept.
+ *
+ */
+void test_tx_backpressure(void)
+{
+    char msg[USART_TX_MESSAGE_MAX_LENGTH];
+    memset(msg, 'x', sizeof(msg));
+
+    // The virtual clock does not advance: the queue only drains the byte loaded into DR
+    TEST_ASSERT_TRUE(port_usart_send(USART_0_ID, msg, sizeof(msg)));
+    TEST_ASSERT_TRUE(port_usart_send(USART_0_ID, msg, sizeof(msg)));
+    TEST_ASSERT_FALSE(port_usart_send(USART_0_ID, msg, sizeof(msg)));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, port_usart_get_tx_rejected(USART_0_ID), __LINE__, "ERROR: The rejected message was not counted");
+
+    native_sim_advance_cycles((2 * sizeof(msg) + 1) * FRAME_CYCLES_9600);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, usart_arr[USART_0_ID].tx_messages_sent, __LINE__, "ERROR: The queued messages were not sent");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(USART_TX_QUEUE_LENGTH - 1, port_usart_get_tx_free(USART_0_ID), __LINE__, "ERROR: The TX queue is not empty");
+}
+
+/**
+ * @brief Test the transmission of a burst of messages in DMA mode: one transfer per message and no USART interrupt.
+ *
+ */
+void test_dma_tx(void)
+{
+    const char *messages[] = {"status: idle\n", "melody: 3\n", "volume: 7\n", "ok\n"};
+    char expected[64] = "";
+    port_usart_set_mode(USART_0_ID, PORT_USART_MODE_DMA);
+    native_sim_reset_irq_counts();
+    for (uint32_t i = 0; i < sizeof(messages) / sizeof(messages[0]); i++)
+    {
+        TEST_ASSERT_TRUE(port_usart_send(USART_0_ID, messages[i], strlen(messages[i])));
+        strcat(expected, messages[i]);
+    }
+
+    native_sim_advance_cycles((strlen(expected) + 1) * FRAME_CYCLES_9600);
+    TEST_ASSERT_TRUE(port_usart_tx_done(USART_0_ID));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, usart_arr[USART_0_ID].tx_messages_sent, __LINE__, "ERROR: Not all the messages were sent");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, native_sim_get_irq_count(DMA1_Stream3_IRQn), __LINE__, "ERROR: Expected one transfer complete interrupt per message");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, native_sim_get_irq_count(USART3_IRQn), __LINE__, "ERROR: The USART interrupt must not be used in DMA mode");
+
+    uint8_t received[64] = {0};
+    uint32_t length = native_sim_usart_read_tx(USART_0, received, sizeof(received));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(strlen(expected), length, __LINE__, "ERROR: The peer did not receive all the messages");
+    TEST_ASSERT_EQUAL_MEMORY(expected, received, strlen(expected));
+}
+
+/**
+ * @brief Completion callback of the zero-copy messages: count the released buffers.
+ *
+ * @param p_data Buffer of the message
+ * @param p_arg Counter of released messages
+ */
+static void _release(const char *p_data, void *p_arg)
+{
+    (void)p_data;
+    (*(uint32_t *)p_arg)++;
+}
+
+/**
+ * @brief Test a zero-copy message in DMA mode: the stream reads the caller's buffer in a single transfer and releases
+ * it when the transfer completes.
+ *
+ */
+void test_dma_tx_zero_copy(void)
+{
+    static const char table[] = "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz\n";
+    uint32_t released = 0;
+    port_usart_set_mode(USART_0_ID, PORT_USART_MODE_DMA);
+    native_sim_reset_irq_counts();
+    TEST_ASSERT_TRUE(port_usart_send(USART_0_ID, "ok\n", 3));
+    TEST_ASSERT_TRUE(port_usart_send_ref(USART_0_ID, table, strlen(table), _release, &released));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, released, __LINE__, "ERROR: The buffer was released before it was sent");
+
+    native_sim_advance_cycles((strlen(table) + 4) * FRAME_CYCLES_9600);
+    TEST_ASSERT_TRUE(port_usart_tx_done(USART_0_ID));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, released, __LINE__, "ERROR: The buffer was not released once");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, native_sim_get_irq_count(DMA1_Stream3_IRQn), __LINE__, "ERROR: Expected one transfer per message");
+
+    uint8_t received[96] = {0};
+    uint32_t length = native_sim_usart_read_tx(USART_0, received, sizeof(received));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(strlen(table) + 3, length, __LINE__, "ERROR: The peer did not receive both messages");
+    TEST_ASSERT_EQUAL_MEMORY("ok\n", received, 3);
+    TEST_ASSERT_EQUAL_MEMORY(table, &received[3], strlen(table));
+}
+
+/**
+ * @brief Test that flushing the TX queue releases the zero-copy messages that were not sent.
+ *
+ */
+void test_tx_zero_copy_flush(void)
+{
+    static const char msg[] = "pending\n";
+    uint32_t released = 0;
+    for (uint32_t i = 0; i < USART_TX_REF_QUEUE_LENGTH; i++)
+    {
+        TEST_ASSERT_TRUE(port_usart_send_ref(USART_0_ID, msg, strlen(msg), _release, &released));
+    }
+    TEST_ASSERT_FALSE(port_usart_send_ref(USART_0_ID, msg, strlen(msg), _release, &released));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, released, __LINE__, "ERROR: A rejected message must not be released");
+
+    port_usart_reset_output_buffer(USART_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(USART_TX_REF_QUEUE_LENGTH, released, __LINE__, "ERROR: Every queued buffer must be released by the flush");
+    TEST_ASSERT_TRUE(port_usart_tx_done(USART_0_ID));
+}
+
+/**
+ * @brief Test the reception in DMA mode: the circular buffer is drained at half and full transfer.
+ *
+ */
+void test_dma_rx(void)
+{
+    char data[2 * USART_DMA_RX_LENGTH + 1];
+    for (uint32_t i = 0; i < sizeof(data) - 1; i += 8)
+    {
+        snprintf(&data[i], 9, "line %02u\n", (unsigned)(i / 8));
+    }
+    port_usart_set_mode(USART_0_ID, PORT_USART_MODE_DMA);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    native_sim_reset_irq_counts();
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)data, sizeof(data) - 1);
+    native_sim_advance_cycles((sizeof(data) - 1) * FRAME_CYCLES_9600);
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, native_sim_get_irq_count(DMA1_Stream1_IRQn), __LINE__, "ERROR: Expected one interrupt per half of the circular buffer");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, native_sim_get_irq_count(USART3_IRQn), __LINE__, "ERROR: The USART interrupt must not be used in DMA mode");
+    for (uint32_t i = 0; i < (sizeof(data) - 1) / 8; i++)
+    {
+        const char *p_line;
+        uint32_t length;
+        TEST_ASSERT_TRUE(port_usart_get_line(USART_0_ID, &p_line, &length));
+        UNITY_TEST_ASSERT_EQUAL_UINT32(7, length, __LINE__, "ERROR: Wrong length of a received line");
+        UNITY_TEST_ASSERT_EQUAL_MEMORY(&data[i * 8], p_line, length, __LINE__, "ERROR: Wrong content of a received line");
+        port_usart_reset_input_buffer(USART_0_ID);
+    }
+    TEST_ASSERT_FALSE(port_usart_rx_done(USART_0_ID));
+}
+
+/**
+ * @brief Test the idle-line framing in interrupt mode: the byte interrupt only stores, and each burst becomes one frame
+ * when the line has been idle for one character, whatever bytes it contains.
+ *
+ */
+void test_idle_framing(void)
+{
+    const uint8_t burst[] = {0x01, 0x0A, 0x00, 'b', 'i', 'n', 0x0A, 0xFF, 0x00, 0x7E};
+    port_usart_set_framing(USART_0_ID, PORT_USART_FRAMING_IDLE);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(USART_CR1_IDLEIE, USART_0->CR1 & USART_CR1_IDLEIE, __LINE__, "ERROR: The IDLE interrupt is not enabled");
+    native_sim_reset_irq_counts();
+    port_system_take_events();
+
+    native_sim_usart_inject_rx(USART_0, burst, sizeof(burst));
+    native_sim_advance_cycles(sizeof(burst) * FRAME_CYCLES_9600);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(sizeof(burst), native_sim_get_irq_count(USART3_IRQn), __LINE__, "ERROR: Expected one interrupt per byte");
+    TEST_ASSERT_FALSE(port_usart_rx_done(USART_0_ID)); // The END_CHAR_CONSTANT bytes do not end the frame
+    native_sim_advance_cycles(FRAME_CYCLES_9600);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(sizeof(burst) + 1, native_sim_get_irq_count(USART3_IRQn), __LINE__, "ERROR: Expected one interrupt when the line goes idle");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1U << USART_0_EVENT_RX, port_system_take_events(), __LINE__, "ERROR: The idle line must post the RX event");
+
+    // Two more bursts without terminator before the first frame is read
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)"play", 4);
+    native_sim_advance_cycles(6 * FRAME_CYCLES_9600);
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)"ok", 2);
+    native_sim_advance_cycles(4 * FRAME_CYCLES_9600);
+
+    const char *p_line;
+    uint32_t length;
+    TEST_ASSERT_TRUE(port_usart_get_line(USART_0_ID, &p_line, &length));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(sizeof(burst), length, __LINE__, "ERROR: Wrong length of the binary frame");
+    UNITY_TEST_ASSERT_EQUAL_MEMORY(burst, p_line, sizeof(burst), __LINE__, "ERROR: Wrong content of the binary frame");
+    port_usart_reset_input_buffer(USART_0_ID);
+    TEST_ASSERT_TRUE(port_usart_get_line(USART_0_ID, &p_line, &length));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, length, __LINE__, "ERROR: A burst without terminator was not completed by the idle line");
+    TEST_ASSERT_EQUAL_MEMORY("play", p_line, 4);
+    port_usart_reset_input_buffer(USART_0_ID);
+    TEST_ASSERT_TRUE(port_usart_get_line(USART_0_ID, &p_line, &length));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, length, __LINE__, "ERROR: Wrong length of the last frame");
+    port_usart_reset_input_buffer(USART_0_ID);
+    TEST_ASSERT_FALSE(port_usart_rx_done(USART_0_ID));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&usart_arr[USART_0_ID].rx_ring), __LINE__, "ERROR: The frames were not released");
+
+    port_usart_set_framing(USART_0_ID, PORT_USART_FRAMING_DELIMITER);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, USART_0->CR1 & USART_CR1_IDLEIE, __LINE__, "ERROR: The IDLE interrupt must be disabled with the delimiter framing");
+}
+
+/**
+ * @brief Test the idle-line framing when the interrupt is served late at the end of a burst: the last byte is still
+ * unread in DR when the line goes idle, so the ISR finds RXNE and IDLE set at once and the byte ends the frame.
+ *
+ */
+void test_idle_framing_late_isr(void)
+{
+    port_usart_set_framing(USART_0_ID, PORT_USART_FRAMING_IDLE);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)"ABC", 3);
+    native_sim_advance_cycles(2 * FRAME_CYCLES_9600);
+
+    uint32_t state = port_system_enter_critical();
+    native_sim_advance_cycles(FRAME_CYCLES_9600); // The last byte stays in DR
+    native_sim_advance_cycles(FRAME_CYCLES_9600); // The line goes idle
+    UNITY_TEST_ASSERT_EQUAL_UINT32(USART_SR_RXNE | USART_SR_IDLE, USART_0->SR & (USART_SR_RXNE | USART_SR_IDLE), __LINE__, "ERROR: RXNE and IDLE must be set at once");
+    port_system_exit_critical(state);
+    native_sim_advance_cycles(FRAME_CYCLES_9600);
+
+    const char *p_line;
+    uint32_t length;
+    TEST_ASSERT_TRUE(port_usart_get_line(USART_0_ID, &p_line, &length));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, length, __LINE__, "ERROR: The byte unread when the line went idle must end the frame");
+    TEST_ASSERT_EQUAL_MEMORY("ABC", p_line, 3);
+    port_usart_reset_input_buffer(USART_0_ID);
+    TEST_ASSERT_FALSE(port_usart_get_line(USART_0_ID, &p_line, &length));
+
+    // The next burst is a frame of its own
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)"FG", 2);
+    native_sim_advance_cycles(4 * FRAME_CYCLES_9600);
+    TEST_ASSERT_TRUE(port_usart_get_line(USART_0_ID, &p_line, &length));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, length, __LINE__, "ERROR: The next burst must be a frame of its own");
+    TEST_ASSERT_EQUAL_MEMORY("FG", p_line, 2);
+    port_usart_reset_input_buffer(USART_0_ID);
+
+    port_usart_set_framing(USART_0_ID, PORT_USART_FRAMING_DELIMITER);
+}
+
+/**
+ * @brief Test the idle line in DMA mode: a short line that does not reach half of the circular buffer is collected when
+ * the line goes idle instead of waiting for more bytes, and the idle-line framing also works with DMA.
+ *
+ */
+void test_dma_idle_flush(void)
+{
+    port_usart_set_mode(USART_0_ID, PORT_USART_MODE_DMA);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    native_sim_reset_irq_counts();
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)"ping\n", 5);
+    native_sim_advance_cycles(5 * FRAME_CYCLES_9600);
+    TEST_ASSERT_FALSE(port_usart_rx_done(USART_0_ID)); // Still in the DMA buffer
+    native_sim_advance_cycles(FRAME_CYCLES_9600);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, native_sim_get_irq_count(DMA1_Stream1_IRQn), __LINE__, "ERROR: The short line must not reach half of the DMA buffer");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, native_sim_get_irq_count(USART3_IRQn), __LINE__, "ERROR: Expected one interrupt when the line goes idle");
+    const char *p_line;
+    uint32_t length;
+    TEST_ASSERT_TRUE(port_usart_get_line(USART_0_ID, &p_line, &length));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, length, __LINE__, "ERROR: Wrong length of the collected line");
+    TEST_ASSERT_EQUAL_MEMORY("ping", p_line, 4);
+    port_usart_reset_input_buffer(USART_0_ID);
+
+    port_usart_set_framing(USART_0_ID, PORT_USART_FRAMING_IDLE);
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    const uint8_t burst[] = {0x00, 0x0A, 0x42};
+    native_sim_usart_inject_rx(USART_0, burst, sizeof(burst));
+    native_sim_advance_cycles((sizeof(burst) + 1) * FRAME_CYCLES_9600);
+    TEST_ASSERT_TRUE(port_usart_get_line(USART_0_ID, &p_line, &length));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(sizeof(burst), length, __LINE__, "ERROR: Wrong length of the DMA frame");
+    UNITY_TEST_ASSERT_EQUAL_MEMORY(burst, p_line, sizeof(burst), __LINE__, "ERROR: Wrong content of the DMA frame");
+    port_usart_reset_input_buffer(USART_0_ID);
+    TEST_ASSERT_FALSE(port_usart_rx_done(USART_0_ID));
+}
+
+/**
+ * @brief Test two USARTs working at the same time, each one in its own mode and at its own baud rate: a 9600-baud
+ * console on USART3 driven by its interrupt, and a 1-Mbaud data link on USART2 driven by DMA.
+ *
+ */
+void test_two_instances(void)
+{
+    port_usart_init(USART_1_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(RCC_APB1ENR_USART2EN, RCC->APB1ENR & RCC_APB1ENR_USART2EN, __LINE__, "ERROR: The clock of USART2 is not enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x008B, USART_1->BRR, __LINE__, "ERROR: USART2 does not start at its own baud rate");
+    TEST_ASSERT_TRUE(port_usart_set_baudrate(USART_1_ID, 1000000));
+    TEST_ASSERT_TRUE(port_usart_set_mode(USART_1_ID, PORT_USART_MODE_DMA));
+    port_usart_enable_rx_interrupt(USART_0_ID);
+    port_usart_enable_rx_interrupt(USART_1_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x0683, USART_0->BRR, __LINE__, "ERROR: Configuring USART2 changed the baud rate of USART3");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, USART_0->CR3 & (USART_CR3_DMAR | USART_CR3_DMAT), __LINE__, "ERROR: Configuring USART2 changed the mode of USART3");
+    native_sim_reset_irq_counts();
+    port_system_take_events();
+
+    // Full duplex on both links at once
+    char data[USART_DMA_RX_LENGTH + 1];
+    for (uint32_t i = 0; i < sizeof(data) - 1; i += 8)
+    {
+        snprintf(&data[i], 9, "data %02u\n", (unsigned)(i / 8));
+    }
+    native_sim_usart_inject_rx(USART_0, (const uint8_t *)"status\n", 7);
+    native_sim_usart_inject_rx(USART_1, (const uint8_t *)data, sizeof(data) - 1);
+    TEST_ASSERT_TRUE(port_usart_send(USART_0_ID, "console\n", 8));
+    TEST_ASSERT_TRUE(port_usart_send(USART_1_ID, data, sizeof(data) - 1));
+    native_sim_advance_cycles(9 * FRAME_CYCLES_9600);
+
+    uint32_t events = port_system_take_events();
+    UNITY_TEST_ASSERT_EQUAL_UINT32((1U << USART_0_EVENT_RX) | (1U << USART_0_EVENT_TX) | (1U << USART_1_EVENT_RX) | (1U << USART_1_EVENT_TX),
+                                   events, __LINE__, "ERROR: Each USART must post its own events");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(9, native_sim_get_irq_count(USART3_IRQn), __LINE__, "ERROR: USART3 must take one interrupt per frame (RXNE and TXE of the same frame share it)");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, native_sim_get_irq_count(USART2_IRQn), __LINE__, "ERROR: USART2 must take no byte interrupts in DMA mode, only the one of the idle line");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, native_sim_get_irq_count(DMA1_Stream5_IRQn), __LINE__, "ERROR: Expected one interrupt per half of the circular buffer of USART2");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, native_sim_get_irq_count(DMA1_Stream6_IRQn), __LINE__, "ERROR: Expected one transfer for the message of USART2");
+
+    const char *p_line;
+    uint32_t length;
+    TEST_ASSERT_TRUE(port_usart_get_line(USART_0_ID, &p_line, &length));
+    TEST_ASSERT_EQUAL_MEMORY("status", p_line, 6);
+    port_usart_reset_input_buffer(USART_0_ID);
+    TEST_ASSERT_FALSE(port_usart_get_line(USART_0_ID, &p_line, &length));
+    for (uint32_t i = 0; i < (sizeof(data) - 1) / 8; i++)
+    {
+        TEST_ASSERT_TRUE(port_usart_get_line(USART_1_ID, &p_line, &length));
+        UNITY_TEST_ASSERT_EQUAL_MEMORY(&data[i * 8], p_line, 7, __LINE__, "ERROR: Wrong line on USART2");
+        port_usart_reset_input_buffer(USART_1_ID);
+    }
+
+    uint8_t received[USART_DMA_RX_LENGTH];
+    UNITY_TEST_ASSERT_EQUAL_UINT32(8, native_sim_usart_read_tx(USART_0, received, sizeof(received)), __LINE__, "ERROR: Wrong bytes sent by USART3");
+    TEST_ASSERT_EQUAL_MEMORY("console\n", received, 8);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(sizeof(data) - 1, native_sim_usart_read_tx(USART_1, received, sizeof(received)), __LINE__, "ERROR: Wrong bytes sent by USART2");
+    TEST_ASSERT_EQUAL_MEMORY(data, received, sizeof(data) - 1);
+
+    port_usart_disable_rx_interrupt(USART_1_ID);
+    port_usart_disable_tx_interrupt(USART_1_ID);
+}
+
+/**
+ * @brief Test the instances on APB2: clock enable, baud rate from the APB2 clock and no DMA mode.
+ *
+ */
+void test_apb2_instances(void)
+{
+    RCC->CFGR |= (0x4U << RCC_CFGR_PPRE2_Pos); // APB2 = HCLK / 2
+    port_usart_init(USART_2_ID);
+    port_usart_init(USART_3_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(RCC_APB2ENR_USART1EN | RCC_APB2ENR_USART6EN, RCC->APB2ENR & (RCC_APB2ENR_USART1EN | RCC_APB2ENR_USART6EN), __LINE__, "ERROR: The clocks of USART1 and USART6 are not enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x0341, USART_2->BRR, __LINE__, "ERROR: BRR of USART1 must be computed with the 8 MHz APB2 clock");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x0341, USART_3->BRR, __LINE__, "ERROR: BRR of USART6 must be computed with the 8 MHz APB2 clock");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x0683, USART_0->BRR, __LINE__, "ERROR: The APB2 prescaler must not change USART3");
+    TEST_ASSERT_FALSE(port_usart_set_mode(USART_2_ID, PORT_USART_MODE_DMA));
+    TEST_ASSERT_FALSE(port_usart_set_flow_control(USART_3_ID, PORT_USART_FLOW_RTS_CTS)); // RTS and CTS of USART6 are on GPIOG, not bonded
+    TEST_ASSERT_TRUE(port_usart_set_flow_control(USART_3_ID, PORT_USART_FLOW_XON_XOFF));
+    TEST_ASSERT_TRUE(port_usart_set_flow_control(USART_3_ID, PORT_USART_FLOW_NONE));
+
+    TEST_ASSERT_TRUE(port_usart_send(USART_3_ID, "usart6\n", 7));
+    native_sim_advance_cycles(8 * native_sim_usart_get_frame_cycles(USART_3));
+    uint8_t received[8];
+    UNITY_TEST_ASSERT_EQUAL_UINT32(7, native_sim_usart_read_tx(USART_3, received, sizeof(received)), __LINE__, "ERROR: USART6 did not send its message");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(7, native_sim_get_irq_count(USART6_IRQn), __LINE__, "ERROR: USART6 must be served by its own interrupt");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, native_sim_usart_read_tx(USART_0, received, sizeof(received)), __LINE__, "ERROR: USART3 sent bytes of USART6");
+    RCC->CFGR &= ~RCC_CFGR_PPRE2;
+}
+
+/**
+ * @brief Main function to run the unit tests.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_usart_config);
+    RUN_TEST(test_baudrate_profiles);
+    RUN_TEST(test_baudrate_apb1_prescaler);
+    RUN_TEST(test_rx_message);
+    RUN_TEST(test_rx_throughput_115200);
+    RUN_TEST(test_rx_throughput_921600);
+    RUN_TEST(test_rx_overrun);
+    RUN_TEST(test_rx_line_errors);
+    RUN_TEST(test_dma_line_errors);
+    RUN_TEST(test_flow_rts_cts);
+    RUN_TEST(test_flow_rts_cts_long_line);
+    RUN_TEST(test_flow_xon_xoff);
+    RUN_TEST(test_flow_xon_xoff_text_only);
+    RUN_TEST(test_tx_message);
+    RUN_TEST(test_tx_burst);
+    RUN_TEST(test_tx_backpressure);
+    RUN_TEST(test_dma_tx);
+    RUN_TEST(test_dma_rx);
+    RUN_TEST(test_dma_tx_zero_copy);
+    RUN_TEST(test_tx_zero_copy_flush);
+    RUN_TEST(test_idle_framing);
+    RUN_TEST(test_idle_framing_late_isr);
+    RUN_TEST(test_dma_idle_flush);
+    RUN_TEST(test_two_instances);
+    RUN_TEST(test_apb2_instances);
+    return UNITY_END();
+}
@@ -268,16 +268,11 @@ void test_buffer_reset(void)
     // Call configuration function
     port_usart_init(USART_0_ID);
 
-    // Check that the input and output buffers are reset with the EMPTY value
-    for (int i = 0; i < USART_INPUT_BUFFER_LENGTH; i++)
-    {
-        UNITY_TEST_ASSERT_EQUAL_UINT8(EMPTY_BUFFER_CONSTANT, usart_arr[USART_0_ID].input_buffer[i], __LINE__, "ERROR: USART input buffer is not reset with the EMPTY_BUFFER_CONSTANT value");
-    }
-
-    for (int i = 0; i < USART_OUTPUT_BUFFER_LENGTH; i++)
-    {
-        UNITY_TEST_ASSERT_EQUAL_UINT8(EMPTY_BUFFER_CONSTANT, usart_arr[USART_0_ID].output_buffer[i], __LINE__, "ERROR: USART output buffer is not reset with the EMPTY_BUFFER_CONSTANT value");
-    }
+    // Check that the input ring and the TX queue are empty
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&usart_arr[USART_0_ID].rx_ring), __LINE__, "ERROR: USART input ring is not empty after the configuration");
+    UNITY_TEST_ASSERT_EQUAL_INT(false, port_usart_rx_done(USART_0_ID), __LINE__, "ERROR: USART must not have a received line after the configuration");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&usart_arr[USART_0_ID].tx_ring), __LINE__, "ERROR: USART TX queue is not empty after the configuration");
+    UNITY_TEST_ASSERT_EQUAL_INT(true, port_usart_tx_done(USART_0_ID), __LINE__, "ERROR: USART must not have a message in progress after the configuration");
 }
 
 /**
@@ -0,0 +1,77 @@
+#include <stdint.h>
+#include <unity.h>
+#include "button_debounce.h"
+
+static button_debounce_t debounce;
+static uint32_t pressed;
+static uint32_t released;
+
+static uint32_t _update(uint32_t sample)
+{
+    return button_debounce_update(&debounce, sample, &pressed, &released);
+}
+
+void setUp(void)
+{
+    button_debounce_init(&debounce, 0);
+}
+
+void tearDown(void)
+{
+}
+
+void test_change_after_samples(void)
+{
+    for (uint32_t i = 1; i < BUTTON_DEBOUNCE_SAMPLES; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(0, _update(0x5), __LINE__, "The change was accepted too early");
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x5, _update(0x5), __LINE__, "The change was not accepted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x5, pressed, __LINE__, "Wrong press edges");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, released, __LINE__, "Wrong release edges");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x5, debounce.state, __LINE__, "Wrong filtered state");
+
+    // Stable: no more edges
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, _update(0x5), __LINE__, "A stable input produced an edge");
+
+    for (uint32_t i = 0; i < BUTTON_DEBOUNCE_SAMPLES; i++)
+    {
+        _update(0x4);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x1, released, __LINE__, "Wrong release edges");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x4, debounce.state, __LINE__, "Wrong filtered state");
+}
+
+void test_bounce_is_filtered(void)
+{
+    // A bounce resets the counter of its bit: the input must be stable for the full window
+    uint32_t samples[] = {1, 0, 1, 1, 0, 1, 1, 1};
+    uint32_t edges = 0;
+    for (uint32_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+    {
+        edges += (_update(samples[i]) != 0);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, edges, __LINE__, "A bouncing input was accepted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, _update(1), __LINE__, "The stable input was not accepted");
+}
+
+void test_bits_are_independent(void)
+{
+    _update(0x80000000U);
+    _update(0x80000000U);
+    _update(0x80000001U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x80000000U, _update(0x80000001U), __LINE__, "Only the first bit completed its window");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, _update(0x80000001U), __LINE__, "The second bit completed its window early");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x1, _update(0x80000001U), __LINE__, "The second bit did not complete its window");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_change_after_samples);
+    RUN_TEST(test_bounce_is_filtered);
+    RUN_TEST(test_bits_are_independent);
+
+    return UNITY_END();
+}
@@ -0,0 +1,148 @@
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "cmd_registry.h"
+
+static const cmd_entry_t *p_called; /* Entry of the last handler called */
+static cmd_args_t last_args;
+static uint32_t calls;
+
+static uint32_t do_record(void *p_context, const cmd_args_t *p_args)
+{
+    p_called = (const cmd_entry_t *)p_context;
+    last_args = *p_args;
+    calls++;
+    return CMD_REGISTRY_OK;
+}
+
+static uint32_t do_fail(void *p_context, const cmd_args_t *p_args)
+{
+    return CMD_REGISTRY_FAILED;
+}
+
+// Commands of the jukebox console plus enough others to exercise a table of 32 names
+static const cmd_entry_t cmd_table[] = {
+    {"play", do_record, 0, 0}, {"stop", do_record, 0, 0}, {"pause", do_record, 0, 0}, {"next", do_record, 0, 0},
+    {"before", do_record, 0, 0}, {"longest", do_record, 0, 0}, {"shortest", do_record, 0, 0}, {"album", do_record, 0, 0},
+    {"select", do_record, 1, 1}, {"speed", do_record, 1, 1}, {"volume", do_record, 1, 1}, {"info", do_record, 0, 1},
+    {"status", do_record, 0, 0}, {"repeat", do_record, 0, 1}, {"shuffle", do_record, 0, 1}, {"seek", do_record, 1, 1},
+    {"tone", do_record, 2, 3}, {"rest", do_record, 1, 1}, {"tempo", do_record, 1, 1}, {"octave", do_record, 1, 1},
+    {"reg", do_record, 1, 2}, {"reset", do_record, 0, 0}, {"help", do_record, 0, 0}, {"version", do_record, 0, 0},
+    {"baud", do_record, 1, 1}, {"binary", do_record, 0, 1}, {"echo", do_record, 0, 4}, {"stats", do_record, 0, 0},
+    {"led", do_record, 1, 2}, {"button", do_record, 0, 0}, {"first", do_record, 0, 0}, {"fail", do_fail, 0, 0},
+    {NULL, NULL, 0, 0}};
+
+static cmd_registry_t registry;
+
+static uint32_t _dispatch(const char *p_line)
+{
+    p_called = NULL;
+    memset(&last_args, 0, sizeof(last_args));
+    return cmd_registry_dispatch(&registry, p_line, strlen(p_line), NULL);
+}
+
+void setUp(void)
+{
+    if (!cmd_registry_is_built(&registry, cmd_table))
+    {
+        cmd_registry_build(&registry, cmd_table);
+    }
+}
+
+void tearDown(void)
+{
+}
+
+void test_all_names_found(void)
+{
+    UNITY_TEST_ASSERT(cmd_registry_is_built(&registry, cmd_table), __LINE__, "The perfect hash of the table was not built");
+    for (const cmd_entry_t *p_entry = cmd_table; p_entry->p_name != NULL; p_entry++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_PTR(p_entry, cmd_registry_find(&registry, p_entry->p_name, strlen(p_entry->p_name)), __LINE__, "A registered command was not found");
+    }
+    UNITY_TEST_ASSERT_EQUAL_PTR(NULL, cmd_registry_find(&registry, "pla", 3), __LINE__, "A prefix of a command was found");
+    UNITY_TEST_ASSERT_EQUAL_PTR(NULL, cmd_registry_find(&registry, "plays", 5), __LINE__, "A command with a suffix was found");
+    UNITY_TEST_ASSERT_EQUAL_PTR(NULL, cmd_registry_find(&registry, "", 0), __LINE__, "An empty name was found");
+    UNITY_TEST_ASSERT_EQUAL_PTR(&cmd_table[0], cmd_registry_find(&registry, "playlist", 4), __LINE__, "The name length was not honoured");
+}
+
+void test_embedded_null(void)
+{
+    // The name is followed by null characters, so a comparison that stops at the first one accepts "play\0?"
+    static const char padded_name[8] = "play";
+    static const cmd_entry_t padded_table[] = {{padded_name, do_record, 0, 0}, {NULL, NULL, 0, 0}};
+    cmd_registry_t padded;
+    TEST_ASSERT_TRUE(cmd_registry_build(&padded, padded_table));
+    char name[] = "play\0?";
+    for (uint32_t c = 1; c < 256; c++) // Some of them hash into the slot of "play"
+    {
+        name[5] = (char)c;
+        UNITY_TEST_ASSERT_EQUAL_PTR(NULL, cmd_registry_find(&padded, name, sizeof(name) - 1), __LINE__, "A name with an embedded null character was found");
+    }
+    UNITY_TEST_ASSERT_EQUAL_PTR(&padded_table[0], cmd_registry_find(&padded, "play", 4), __LINE__, "The command was not found");
+}
+
+void test_dispatch_arguments(void)
+{
+    // Handlers receive the registry context; use the entry to check which one ran
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_OK, cmd_registry_dispatch(&registry, "select 3", 8, (void *)&cmd_table[8]), __LINE__, "A correct command failed");
+    UNITY_TEST_ASSERT_EQUAL_PTR(&cmd_table[8], p_called, __LINE__, "The handler was not called with its context");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, last_args.argc, __LINE__, "Wrong number of arguments");
+    UNITY_TEST_ASSERT_EQUAL_INT(3, last_args.argv[0], __LINE__, "Wrong decimal argument");
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_OK, _dispatch("  tone  -440 0x1F4\t+2\r"), __LINE__, "Separators or signs were not accepted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, last_args.argc, __LINE__, "Wrong number of arguments");
+    UNITY_TEST_ASSERT_EQUAL_INT(-440, last_args.argv[0], __LINE__, "Wrong negative argument");
+    UNITY_TEST_ASSERT_EQUAL_INT(500, last_args.argv[1], __LINE__, "Wrong hexadecimal argument");
+    UNITY_TEST_ASSERT_EQUAL_INT(2, last_args.argv[2], __LINE__, "Wrong signed argument");
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_OK, _dispatch("reg 2147483647 0xFFFFFFFF"), __LINE__, "The 32-bit limits were rejected");
+    UNITY_TEST_ASSERT_EQUAL_INT(2147483647, last_args.argv[0], __LINE__, "Wrong maximum argument");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, last_args.argv[1], __LINE__, "Wrong hexadecimal bit pattern");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_OK, _dispatch("reg -2147483648"), __LINE__, "The minimum argument was rejected");
+    UNITY_TEST_ASSERT_EQUAL_INT(INT32_MIN, last_args.argv[0], __LINE__, "Wrong minimum argument");
+
+    // The line is a view into the receive ring: it does not end with a null character
+    const char ring[] = "seek 12\nnext";
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_OK, cmd_registry_dispatch(&registry, ring, 7, NULL), __LINE__, "A line that is not null-terminated failed");
+    UNITY_TEST_ASSERT_EQUAL_INT(12, last_args.argv[0], __LINE__, "The argument was read past the end of the line");
+}
+
+void test_dispatch_errors(void)
+{
+    calls = 0;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_UNKNOWN, _dispatch("rewind"), __LINE__, "An unknown command was dispatched");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_UNKNOWN, _dispatch(""), __LINE__, "An empty line was dispatched");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_BAD_ARGUMENT, _dispatch("select"), __LINE__, "A missing argument was accepted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_BAD_ARGUMENT, _dispatch("play 1"), __LINE__, "An extra argument was accepted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_BAD_ARGUMENT, _dispatch("select 3x"), __LINE__, "A non-numeric argument was accepted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_BAD_ARGUMENT, _dispatch("select -"), __LINE__, "A sign without digits was accepted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_BAD_ARGUMENT, _dispatch("select 0x"), __LINE__, "A prefix without digits was accepted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_BAD_ARGUMENT, _dispatch("select 2147483648"), __LINE__, "An overflowing argument was accepted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_BAD_ARGUMENT, _dispatch("select 0x100000000"), __LINE__, "An overflowing hexadecimal argument was accepted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, calls, __LINE__, "A handler was called for a rejected line");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_FAILED, _dispatch("fail"), __LINE__, "The result of the handler was not returned");
+}
+
+void test_bad_tables(void)
+{
+    static const cmd_entry_t duplicated[] = {{"play", do_record, 0, 0}, {"stop", do_record, 0, 0}, {"play", do_record, 0, 0}, {NULL, NULL, 0, 0}};
+    static const cmd_entry_t too_many_args[] = {{"play", do_record, 0, CMD_REGISTRY_MAX_ARGS + 1}, {NULL, NULL, 0, 0}};
+    cmd_registry_t other;
+    UNITY_TEST_ASSERT(!cmd_registry_build(&other, duplicated), __LINE__, "A table with a repeated name was built");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(CMD_REGISTRY_UNKNOWN, cmd_registry_dispatch(&other, "play", 4, NULL), __LINE__, "A failed registry dispatched a command");
+    UNITY_TEST_ASSERT(!cmd_registry_build(&other, too_many_args), __LINE__, "A table with too many arguments was built");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_all_names_found);
+    RUN_TEST(test_embedded_null);
+    RUN_TEST(test_dispatch_arguments);
+    RUN_TEST(test_dispatch_errors);
+    RUN_TEST(test_bad_tables);
+
+    return UNITY_END();
+}
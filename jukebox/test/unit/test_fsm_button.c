@@ -1,7 +1,9 @@
+#include <string.h>
 #include <unity.h>
 #include "fsm_button.h"
 #include "port_system.h"
 #include "port_button.h"
+#include "sw_timer.h"
 
 static fsm_t *p_fsm;
 
@@ -72,6 +74,134 @@ void test_long_button_press(void)
     _test_button_press(1000);
 }
 
+// Change the button as the ISR does: level and tick of the edge
+void _set_button(bool pressed)
+{
+    buttons_arr[BUTTON_0_ID].flag_pressed = pressed;
+    buttons_arr[BUTTON_0_ID].edge_tick = port_system_get_millis();
+}
+
+// Let the time pass while the FSM is fired every millisecond
+void _run_ms(uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; i++)
+    {
+        while (fsm_button_fire(p_fsm))
+        {
+        }
+        port_system_delay_ms(1);
+    }
+}
+
+void _assert_gestures(const uint8_t *p_types, uint32_t n)
+{
+    fsm_button_gesture_t gesture;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        TEST_ASSERT_TRUE(fsm_button_get_gesture(p_fsm, &gesture));
+        UNITY_TEST_ASSERT_EQUAL_INT(p_types[i], gesture.type, __LINE__, "Unexpected gesture");
+    }
+    UNITY_TEST_ASSERT(!fsm_button_get_gesture(p_fsm, &gesture), __LINE__, "There are more gestures than expected");
+}
+
+void test_gesture_click(void)
+{
+    uint32_t tick_press = port_system_get_millis();
+    _set_button(true);
+    _run_ms(200);
+    _set_button(false);
+    _run_ms(200);
+
+    fsm_button_gesture_t gesture;
+    TEST_ASSERT_TRUE(fsm_button_get_gesture(p_fsm, &gesture));
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_GESTURE_PRESS, gesture.type, __LINE__, "The press was not queued");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(tick_press, gesture.tick, __LINE__, "The press must carry the tick of the edge");
+    TEST_ASSERT_TRUE(fsm_button_get_gesture(p_fsm, &gesture));
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_GESTURE_RELEASE, gesture.type, __LINE__, "The release was not queued");
+    UNITY_TEST_ASSERT(!fsm_button_get_gesture(p_fsm, &gesture), __LINE__, "The click must wait for the double-click window");
+
+    _run_ms(FSM_BUTTON_DOUBLE_CLICK_MS);
+    uint8_t expected[] = {BUTTON_GESTURE_CLICK};
+    _assert_gestures(expected, 1);
+}
+
+void test_gesture_double_click(void)
+{
+    _set_button(true);
+    _run_ms(200);
+    _set_button(false);
+    _run_ms(200);
+    _set_button(true);
+    _run_ms(200);
+    _set_button(false);
+    _run_ms(FSM_BUTTON_DOUBLE_CLICK_MS + 200);
+
+    uint8_t expected[] = {BUTTON_GESTURE_PRESS, BUTTON_GESTURE_RELEASE, BUTTON_GESTURE_PRESS, BUTTON_GESTURE_RELEASE, BUTTON_GESTURE_DOUBLE_CLICK};
+    _assert_gestures(expected, 5);
+}
+
+void test_gesture_long_press(void)
+{
+    fsm_button_set_gesture_config(p_fsm, 800, 200, FSM_BUTTON_DOUBLE_CLICK_MS);
+    _set_button(true);
+    _run_ms(790);
+    uint8_t expected_before[] = {BUTTON_GESTURE_PRESS};
+    _assert_gestures(expected_before, 1);
+
+    // The long press acts while the button is still pressed
+    _run_ms(20);
+    uint8_t expected_long[] = {BUTTON_GESTURE_LONG_PRESS};
+    _assert_gestures(expected_long, 1);
+
+    _run_ms(420);
+    _set_button(false);
+    _run_ms(FSM_BUTTON_DOUBLE_CLICK_MS + 200);
+    uint8_t expected_end[] = {BUTTON_GESTURE_REPEAT, BUTTON_GESTURE_REPEAT, BUTTON_GESTURE_RELEASE};
+    _assert_gestures(expected_end, 3);
+}
+
+void test_destroy_stops_timers(void)
+{
+    fsm_button_t *p_button = (fsm_button_t *)p_fsm;
+    buttons_arr[BUTTON_0_ID].flag_pressed = true;
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT(sw_timer_is_running(&p_button->debounce_timer), __LINE__, "The press did not start the debounce timer");
+
+    fsm_button_destroy(p_fsm);
+    UNITY_TEST_ASSERT(!sw_timer_is_running(&p_button->debounce_timer), __LINE__, "fsm_button_destroy() must unlink the running timers of the button");
+    fsm_button_init(p_fsm, BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
+
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT(sw_timer_is_running(&p_button->debounce_timer), __LINE__, "The press did not start the debounce timer");
+    fsm_destroy(p_fsm);
+    UNITY_TEST_ASSERT(!sw_timer_is_running(&p_button->debounce_timer), __LINE__, "fsm_destroy() must unlink the running timers of the button");
+    UNITY_TEST_ASSERT(!sw_timer_is_running(&p_button->gesture_timer), __LINE__, "fsm_destroy() must unlink the running timers of the button");
+
+    buttons_arr[BUTTON_0_ID].flag_pressed = false;
+    p_fsm = fsm_button_new(BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
+    port_system_gpio_exti_disable(BUTTON_0_PIN);
+}
+
+void test_init_uninitialized_memory(void)
+{
+    static fsm_button_t storage;
+    memset(&storage, 0xA5, sizeof(storage)); // Garbage timers: running, with wild links
+    fsm_t *p_static = fsm_button_new_static(&storage, BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
+    UNITY_TEST_ASSERT(!sw_timer_is_running(&storage.debounce_timer), __LINE__, "fsm_button_init() must initialize the timers without reading them");
+    UNITY_TEST_ASSERT(!sw_timer_is_running(&storage.gesture_timer), __LINE__, "fsm_button_init() must initialize the timers without reading them");
+
+    // The wheel is intact: the timers of both buttons start and stop
+    fsm_button_t *p_button = (fsm_button_t *)p_fsm;
+    buttons_arr[BUTTON_0_ID].flag_pressed = true;
+    fsm_fire(p_fsm);
+    fsm_fire(p_static);
+    UNITY_TEST_ASSERT(sw_timer_is_running(&p_button->debounce_timer), __LINE__, "The press did not start the debounce timer");
+    UNITY_TEST_ASSERT(sw_timer_is_running(&storage.debounce_timer), __LINE__, "The press did not start the debounce timer");
+    fsm_button_destroy(p_static);
+    UNITY_TEST_ASSERT(sw_timer_is_running(&p_button->debounce_timer), __LINE__, "Destroying a button must not stop the timers of another one");
+    buttons_arr[BUTTON_0_ID].flag_pressed = false;
+}
+
 int main(void)
 {
     port_system_init();
@@ -80,6 +210,11 @@ int main(void)
     RUN_TEST(test_initial_config);
     RUN_TEST(test_short_button_press);
     RUN_TEST(test_long_button_press);
+    RUN_TEST(test_gesture_click);
+    RUN_TEST(test_gesture_double_click);
+    RUN_TEST(test_gesture_long_press);
+    RUN_TEST(test_destroy_stops_timers);
+    RUN_TEST(test_init_uninitialized_memory);
 
     return UNITY_END();
 }
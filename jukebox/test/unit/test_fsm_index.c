@@ -0,0 +1,138 @@
+#include <unity.h>
+#include "fsm_index.h"
+
+enum
+{
+    IDLE = 0,
+    RUNNING,
+    DONE,
+    PARKED
+};
+
+static bool flag_start;
+static bool flag_stop;
+static uint32_t outputs;
+
+static bool check_start(fsm_t *p_this) { return flag_start; }
+static bool check_stop(fsm_t *p_this) { return flag_stop; }
+static bool check_true(fsm_t *p_this) { return true; }
+static bool check_false(fsm_t *p_this) { return false; }
+static void do_count(fsm_t *p_this) { outputs++; }
+
+#define PARKED_ROW {PARKED, check_false, PARKED, NULL}
+
+// Rows of the same state are not contiguous and the first matching row has priority. The PARKED rows are never reached:
+// they only take the table to FSM_INDEX_MIN_TRANSITIONS rows
+static fsm_trans_t fsm_trans_test[] = {
+    {IDLE, check_start, RUNNING, do_count},
+    {RUNNING, check_stop, DONE, do_count},
+    {IDLE, check_true, IDLE, NULL},
+    {RUNNING, check_true, RUNNING, NULL},
+    PARKED_ROW, PARKED_ROW, PARKED_ROW, PARKED_ROW, PARKED_ROW, PARKED_ROW,
+    PARKED_ROW, PARKED_ROW, PARKED_ROW, PARKED_ROW, PARKED_ROW, PARKED_ROW,
+    {-1, NULL, -1, NULL}};
+
+static fsm_index_t index_test;
+static fsm_t fsm;
+
+void setUp(void)
+{
+    flag_start = false;
+    flag_stop = false;
+    outputs = 0;
+    fsm_init(&fsm, fsm_trans_test);
+}
+
+void tearDown(void)
+{
+}
+
+void test_build(void)
+{
+    TEST_ASSERT_TRUE(fsm_index_build(&index_test, fsm_trans_test));
+    TEST_ASSERT_TRUE(fsm_index_is_built(&index_test, fsm_trans_test));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PARKED + 1, index_test.num_states, __LINE__, "The states must go up to the largest origin state");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, index_test.first[DONE + 1] - index_test.first[DONE], __LINE__, "DONE has no transitions");
+    UNITY_TEST_ASSERT_EQUAL_PTR(&fsm_trans_test[0], index_test.p_rows[index_test.first[IDLE]], __LINE__, "The table order must be kept within a state");
+    UNITY_TEST_ASSERT_EQUAL_PTR(&fsm_trans_test[2], index_test.p_rows[index_test.first[IDLE] + 1], __LINE__, "The table order must be kept within a state");
+    UNITY_TEST_ASSERT_EQUAL_PTR(&fsm_trans_test[1], index_test.p_rows[index_test.first[RUNNING]], __LINE__, "The table order must be kept within a state");
+}
+
+void test_fire_priority(void)
+{
+    fsm_index_build(&index_test, fsm_trans_test);
+
+    UNITY_TEST_ASSERT_EQUAL_INT(1, fsm_index_fire(&fsm, &index_test), __LINE__, "The catch-all row must fire");
+    UNITY_TEST_ASSERT_EQUAL_INT(IDLE, fsm_get_state(&fsm), __LINE__, "The catch-all row keeps the state");
+
+    flag_start = true;
+    fsm_index_fire(&fsm, &index_test);
+    UNITY_TEST_ASSERT_EQUAL_INT(RUNNING, fsm_get_state(&fsm), __LINE__, "The first row of the state has priority");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, outputs, __LINE__, "The output function was not called");
+
+    flag_stop = true;
+    fsm_index_fire(&fsm, &index_test);
+    UNITY_TEST_ASSERT_EQUAL_INT(DONE, fsm_get_state(&fsm), __LINE__, "The FSM did not change to DONE");
+    UNITY_TEST_ASSERT_EQUAL_INT(0, fsm_index_fire(&fsm, &index_test), __LINE__, "A state without transitions must not fire");
+}
+
+void test_same_as_fsm_fire(void)
+{
+    fsm_t reference;
+    fsm_init(&reference, fsm_trans_test);
+    fsm_index_build(&index_test, fsm_trans_test);
+
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        flag_start = (i % 3) == 0;
+        flag_stop = (i % 5) == 0;
+        int fired = fsm_fire(&reference);
+        UNITY_TEST_ASSERT_EQUAL_INT(fired, fsm_index_fire(&fsm, &index_test), __LINE__, "fsm_index_fire() must return the same as fsm_fire()");
+        UNITY_TEST_ASSERT_EQUAL_INT(fsm_get_state(&reference), fsm_get_state(&fsm), __LINE__, "fsm_index_fire() must reach the same state as fsm_fire()");
+        if (fsm_get_state(&fsm) == DONE)
+        {
+            fsm_set_state(&fsm, IDLE);
+            fsm_set_state(&reference, IDLE);
+        }
+    }
+}
+
+void test_small_table_not_indexed(void)
+{
+    static fsm_trans_t fsm_trans_small[] = {
+        {IDLE, check_true, RUNNING, do_count},
+        {-1, NULL, -1, NULL}};
+    TEST_ASSERT_FALSE(fsm_index_build(&index_test, fsm_trans_small));
+    TEST_ASSERT_FALSE(fsm_index_is_built(&index_test, fsm_trans_small));
+
+    // The FSM falls back to fsm_fire()
+    fsm_init(&fsm, fsm_trans_small);
+    UNITY_TEST_ASSERT_EQUAL_INT(1, fsm_index_fire(&fsm, &index_test), __LINE__, "A small table must be fired with fsm_fire()");
+    UNITY_TEST_ASSERT_EQUAL_INT(RUNNING, fsm_get_state(&fsm), __LINE__, "The FSM did not change to RUNNING");
+}
+
+void test_table_not_indexed(void)
+{
+    static fsm_trans_t fsm_trans_big[] = {
+        {FSM_INDEX_MAX_STATES, check_true, IDLE, do_count},
+        {-1, NULL, -1, NULL}};
+    TEST_ASSERT_FALSE(fsm_index_build(&index_test, fsm_trans_big));
+
+    // The FSM falls back to fsm_fire()
+    fsm_init(&fsm, fsm_trans_big);
+    UNITY_TEST_ASSERT_EQUAL_INT(1, fsm_index_fire(&fsm, &index_test), __LINE__, "A table that cannot be indexed must be fired with fsm_fire()");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, outputs, __LINE__, "The output function was not called");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_build);
+    RUN_TEST(test_fire_priority);
+    RUN_TEST(test_same_as_fsm_fire);
+    RUN_TEST(test_small_table_not_indexed);
+    RUN_TEST(test_table_not_indexed);
+
+    return UNITY_END();
+}
@@ -0,0 +1,168 @@
+#include <string.h>
+#include <unity.h>
+#include "fsm_pool.h"
+#include "fsm_button.h"
+#include "port_system.h"
+#include "port_button.h"
+
+typedef struct
+{
+    uint32_t a;
+    uint8_t b[6];
+} test_obj_t;
+
+FSM_POOL_DEFINE(test_pool, test_obj_t, 3, NULL);
+FSM_POOL_DEFINE(extra_pool_0, uint32_t, 1, NULL);
+FSM_POOL_DEFINE(extra_pool_1, uint32_t, 1, NULL);
+FSM_POOL_DEFINE(extra_pool_2, uint32_t, 1, NULL);
+FSM_POOL_DEFINE(extra_pool_3, uint32_t, 1, NULL);
+FSM_POOL_DEFINE(extra_pool_4, uint32_t, 1, NULL);
+FSM_POOL_DEFINE(extra_pool_5, uint32_t, 1, NULL);
+FSM_POOL_DEFINE(extra_pool_6, uint32_t, 1, NULL);
+FSM_POOL_DEFINE(extra_pool_7, uint32_t, 1, NULL);
+
+static const fsm_pool_stats_t *_find_stats(const char *p_name, fsm_pool_stats_t *p_stats, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (strcmp(p_stats[i].p_name, p_name) == 0)
+        {
+            return &p_stats[i];
+        }
+    }
+    return NULL;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_acquire_release(void)
+{
+    void *p_obj[3];
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        p_obj[i] = fsm_pool_acquire(&test_pool);
+        TEST_ASSERT_NOT_NULL(p_obj[i]);
+    }
+    TEST_ASSERT_NULL(fsm_pool_acquire(&test_pool));
+
+    TEST_ASSERT_TRUE(fsm_pool_release(p_obj[1]));
+    UNITY_TEST_ASSERT_EQUAL_PTR(p_obj[1], fsm_pool_acquire(&test_pool), __LINE__, "The released object must be reused");
+
+    TEST_ASSERT_TRUE(fsm_pool_release(p_obj[1]));
+    TEST_ASSERT_FALSE(fsm_pool_release(p_obj[1]));
+    UNITY_TEST_ASSERT_EQUAL_PTR(p_obj[1], fsm_pool_acquire(&test_pool), __LINE__, "A double release must not corrupt the free list");
+    TEST_ASSERT_NULL(fsm_pool_acquire(&test_pool));
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        fsm_pool_release(p_obj[i]);
+    }
+
+    fsm_pool_stats_t stats[FSM_POOL_MAX_POOLS];
+    const fsm_pool_stats_t *p_stats = _find_stats("test_pool", stats, fsm_pool_get_stats(stats, FSM_POOL_MAX_POOLS));
+    TEST_ASSERT_NOT_NULL(p_stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, p_stats->capacity, __LINE__, "Wrong capacity");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_stats->used, __LINE__, "All the objects were released");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, p_stats->high_water, __LINE__, "Wrong high-water mark");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, p_stats->failures, __LINE__, "The requests with the pool full must be counted");
+}
+
+void test_fsm_button_pool(void)
+{
+    fsm_t *p_fsm[FSM_BUTTON_POOL_SIZE];
+    for (uint32_t i = 0; i < FSM_BUTTON_POOL_SIZE; i++)
+    {
+        p_fsm[i] = fsm_button_new(BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
+        TEST_ASSERT_NOT_NULL(p_fsm[i]);
+    }
+    TEST_ASSERT_NULL(fsm_button_new(BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID));
+
+    // fsm_destroy() returns the object to the pool
+    fsm_destroy(p_fsm[0]);
+    fsm_t *p_again = fsm_button_new(BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_PTR(p_fsm[0], p_again, __LINE__, "fsm_destroy() did not return the FSM to the pool");
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_RELEASED, fsm_get_state(p_again), __LINE__, "The reused FSM was not initialized");
+
+    for (uint32_t i = 0; i < FSM_BUTTON_POOL_SIZE; i++)
+    {
+        fsm_destroy(p_fsm[i]);
+    }
+
+    fsm_pool_stats_t stats[FSM_POOL_MAX_POOLS];
+    const fsm_pool_stats_t *p_stats = _find_stats("fsm_button_pool", stats, fsm_pool_get_stats(stats, FSM_POOL_MAX_POOLS));
+    TEST_ASSERT_NOT_NULL(p_stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_stats->used, __LINE__, "All the buttons were destroyed");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FSM_BUTTON_POOL_SIZE, p_stats->high_water, __LINE__, "Wrong high-water mark");
+}
+
+void test_fsm_button_static(void)
+{
+    static fsm_button_t storage;
+    fsm_t *p_fsm = fsm_button_new_static(&storage, BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_PTR(&storage, p_fsm, __LINE__, "The FSM must be created in the caller storage");
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_RELEASED, fsm_get_state(p_fsm), __LINE__, "The FSM was not initialized");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(BUTTON_0_DEBOUNCE_TIME_MS, storage.debounce_time, __LINE__, "The FSM was not initialized");
+}
+
+static fsm_trans_t heap_tt[] = {{-1, NULL, -1, NULL}};
+
+void test_foreign_pointers(void)
+{
+    void *p_obj = fsm_pool_acquire(&test_pool);
+    TEST_ASSERT_NOT_NULL(p_obj);
+    uint32_t local = 0;
+    TEST_ASSERT_FALSE(fsm_pool_release(&local));
+    TEST_ASSERT_FALSE(fsm_pool_release((uint8_t *)p_obj + 1));
+
+    // fsm_new() still uses the heap and fsm_destroy() gives the FSM back to it without touching the pools
+    fsm_t *p_fsm = fsm_new(heap_tt);
+    TEST_ASSERT_NOT_NULL(p_fsm);
+    fsm_destroy(p_fsm);
+    fsm_pool_stats_t stats[FSM_POOL_MAX_POOLS];
+    const fsm_pool_stats_t *p_stats = _find_stats("test_pool", stats, fsm_pool_get_stats(stats, FSM_POOL_MAX_POOLS));
+    TEST_ASSERT_NOT_NULL(p_stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_stats->used, __LINE__, "A pointer that is not from a pool must not release an object");
+    TEST_ASSERT_TRUE(fsm_pool_release(p_obj));
+}
+
+void test_too_many_pools(void)
+{
+    fsm_pool_t *p_extra[] = {&extra_pool_0, &extra_pool_1, &extra_pool_2, &extra_pool_3,
+                             &extra_pool_4, &extra_pool_5, &extra_pool_6, &extra_pool_7};
+    fsm_pool_stats_t stats[FSM_POOL_MAX_POOLS];
+    uint32_t registered = fsm_pool_get_stats(stats, FSM_POOL_MAX_POOLS);
+    for (uint32_t i = 0; i < FSM_POOL_MAX_POOLS; i++)
+    {
+        void *p_obj = fsm_pool_acquire(p_extra[i]);
+        if (registered + i < FSM_POOL_MAX_POOLS)
+        {
+            TEST_ASSERT_NOT_NULL(p_obj);
+        }
+        else
+        {
+            TEST_ASSERT_NULL(p_obj);
+            UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_extra[i]->failures, __LINE__, "The rejected request must be counted");
+        }
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FSM_POOL_MAX_POOLS, fsm_pool_get_stats(stats, FSM_POOL_MAX_POOLS), __LINE__, "Wrong number of registered pools");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+
+    RUN_TEST(test_acquire_release);
+    RUN_TEST(test_fsm_button_pool);
+    RUN_TEST(test_fsm_button_static);
+    RUN_TEST(test_foreign_pointers);
+    RUN_TEST(test_too_many_pools);
+
+    return UNITY_END();
+}
@@ -0,0 +1,130 @@
+#include <unity.h>
+#include "fsm_sched.h"
+#include "port_system.h"
+#include "sw_timer.h"
+
+#define TEST_EVENT_A 4
+#define TEST_EVENT_B 5
+
+enum
+{
+    WAITING = 0,
+    TIMING
+};
+
+typedef struct
+{
+    fsm_t f;
+    bool input;
+    sw_timer_t timer;
+    uint32_t fires;
+} fsm_test_t;
+
+static bool check_input(fsm_t *p_this) { return ((fsm_test_t *)p_this)->input; }
+static bool check_timeout(fsm_t *p_this) { return sw_timer_has_expired(&((fsm_test_t *)p_this)->timer); }
+static void do_start_timer(fsm_t *p_this)
+{
+    fsm_test_t *p_fsm = (fsm_test_t *)p_this;
+    p_fsm->input = false;
+    sw_timer_start(&p_fsm->timer, 10);
+}
+
+static fsm_trans_t fsm_trans_test[] = {
+    {WAITING, check_input, TIMING, do_start_timer},
+    {TIMING, check_timeout, WAITING, NULL},
+    {-1, NULL, -1, NULL}};
+
+static int fire_counting(fsm_t *p_this)
+{
+    ((fsm_test_t *)p_this)->fires++;
+    return fsm_fire(p_this);
+}
+
+static fsm_test_t fsm_a;
+static fsm_test_t fsm_b;
+static int id_a;
+static int id_b;
+
+void setUp(void)
+{
+    sw_timer_stop(&fsm_a.timer);
+    sw_timer_stop(&fsm_b.timer);
+    fsm_a = (fsm_test_t){0};
+    fsm_b = (fsm_test_t){0};
+    fsm_init(&fsm_a.f, fsm_trans_test);
+    fsm_init(&fsm_b.f, fsm_trans_test);
+    sw_timer_init(&fsm_a.timer, TEST_EVENT_A);
+    sw_timer_init(&fsm_b.timer, TEST_EVENT_B);
+    fsm_sched_init();
+    port_system_take_events();
+    id_a = fsm_sched_add(&fsm_a.f, fire_counting, FSM_SCHED_EVENT(TEST_EVENT_A));
+    id_b = fsm_sched_add(&fsm_b.f, fire_counting, FSM_SCHED_EVENT(TEST_EVENT_B));
+}
+
+void tearDown(void)
+{
+}
+
+void test_first_dispatch(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_INT(0, id_a, __LINE__, "The first FSM must get the id 0");
+    UNITY_TEST_ASSERT_EQUAL_INT(1, id_b, __LINE__, "The second FSM must get the id 1");
+    TEST_ASSERT_FALSE(fsm_sched_dispatch());
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fsm_a.fires, __LINE__, "Every FSM must be fired once after being added");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fsm_b.fires, __LINE__, "Every FSM must be fired once after being added");
+
+    fsm_sched_dispatch();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fsm_a.fires, __LINE__, "An FSM without pending work must not be fired");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fsm_b.fires, __LINE__, "An FSM without pending work must not be fired");
+}
+
+void test_event_fires_only_subscribers(void)
+{
+    fsm_sched_dispatch();
+    fsm_a.input = true;
+    port_system_post_event(TEST_EVENT_A);
+    TEST_ASSERT_TRUE(fsm_sched_dispatch());
+    UNITY_TEST_ASSERT_EQUAL_INT(TIMING, fsm_get_state(&fsm_a.f), __LINE__, "The posted event did not fire its FSM");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fsm_b.fires, __LINE__, "An FSM not subscribed to the event must not be fired");
+}
+
+void test_post_from_main(void)
+{
+    fsm_sched_dispatch();
+    fsm_b.input = true;
+    fsm_sched_post(id_b);
+    TEST_ASSERT_TRUE(fsm_sched_has_work());
+    fsm_sched_dispatch();
+    UNITY_TEST_ASSERT_EQUAL_INT(TIMING, fsm_get_state(&fsm_b.f), __LINE__, "fsm_sched_post() did not fire the FSM");
+}
+
+void test_timer(void)
+{
+    fsm_sched_dispatch();
+    fsm_a.input = true;
+    fsm_sched_post(id_a);
+    fsm_sched_dispatch();
+    uint32_t fires = fsm_a.fires;
+
+    port_system_delay_ms(5);
+    fsm_sched_dispatch();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(fires, fsm_a.fires, __LINE__, "The FSM must not be fired before its timer expires");
+    UNITY_TEST_ASSERT_EQUAL_INT(TIMING, fsm_get_state(&fsm_a.f), __LINE__, "The FSM left TIMING too early");
+
+    port_system_delay_ms(6);
+    fsm_sched_dispatch();
+    UNITY_TEST_ASSERT_EQUAL_INT(WAITING, fsm_get_state(&fsm_a.f), __LINE__, "The event of the expired timer did not fire the FSM");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+
+    RUN_TEST(test_first_dispatch);
+    RUN_TEST(test_event_fires_only_subscribers);
+    RUN_TEST(test_post_from_main);
+    RUN_TEST(test_timer);
+
+    return UNITY_END();
+}
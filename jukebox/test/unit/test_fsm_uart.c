@@ -22,6 +22,20 @@
 
 /* Global variables */
 static fsm_t *p_fsm;
+static uint32_t released; /*!< Zero-copy messages released by the USART */
+static const char *p_released_data; /*!< Buffer of the last released message */
+
+/**
+ * @brief Completion callback of the zero-copy messages.
+ *
+ * @param p_data Buffer of the message
+ * @param p_arg Counter of released messages
+ */
+static void _release(const char *p_data, void *p_arg)
+{
+    (*(uint32_t *)p_arg)++;
+    p_released_data = p_data;
+}
 
 /**
  * @brief Set the Up object. It is called before a test function is called.
@@ -69,29 +83,37 @@ void test_usart_rx()
 {
     char char_array_test[] = "TEST RX";
 
-    // Copy the data to the USART buffer
-    memcpy(usart_arr[USART_0_ID].input_buffer, char_array_test, sizeof(char_array_test));
-
-    // Force read_complete
-    usart_arr[USART_0_ID].read_complete = true;
+    // Store the data in the USART input ring as the ISR does
+    for (uint32_t i = 0; i < strlen(char_array_test); i++)
+    {
+        spsc_ring_push(&usart_arr[USART_0_ID].rx_ring, (uint8_t)char_array_test[i]);
+    }
+    spsc_ring_push(&usart_arr[USART_0_ID].rx_ring, END_CHAR_CONSTANT);
+    usart_arr[USART_0_ID].rx_lines_in++;
 
     // First transition
     fsm_fire(p_fsm);
     UNITY_TEST_ASSERT_EQUAL_INT(WAIT_DATA, fsm_get_state(p_fsm), __LINE__, "The FSM did not remain in WAIT_DATA after receiving a data from the usart");
 
-    // Check that the data has been stored correctly from the USART buffer to the in_data buffer of the FSM
-    UNITY_TEST_ASSERT_EQUAL_MEMORY(char_array_test, ((fsm_usart_t *)p_fsm)->in_data, sizeof(char_array_test), __LINE__, "The data has not been stored correctly in the in_data buffer of the USART FSM");
+    // Check that the FSM gives a view of the line in the USART ring, without the end char
+    const char *p_line;
+    uint32_t length;
+    TEST_ASSERT_TRUE(fsm_usart_get_in_line(p_fsm, &p_line, &length));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(strlen(char_array_test), length, __LINE__, "The length of the received line is not correct");
+    UNITY_TEST_ASSERT_EQUAL_MEMORY(char_array_test, p_line, length, __LINE__, "The received line is not correct");
 
-    // Check that the USART buffer has been cleared correctly
-    char expected_buffer[sizeof(char_array_test)];
-    memset(expected_buffer, EMPTY_BUFFER_CONSTANT, sizeof(expected_buffer));
-    UNITY_TEST_ASSERT_EQUAL_MEMORY(expected_buffer, usart_arr[USART_0_ID].input_buffer, sizeof(expected_buffer), __LINE__, "The data has not been cleared correctly from the input buffer of the USART");
+    // Check that the copy of the data is correct
+    char in_data[USART_INPUT_BUFFER_LENGTH];
+    fsm_usart_get_in_data(p_fsm, in_data);
+    UNITY_TEST_ASSERT_EQUAL_MEMORY(char_array_test, in_data, sizeof(char_array_test), __LINE__, "The data has not been copied correctly from the input line of the USART FSM");
 
-    // Check that the read_complete flag has been cleared correctly
-    UNITY_TEST_ASSERT_EQUAL_INT(false, usart_arr[USART_0_ID].read_complete, __LINE__, "The read_complete flag has not been cleared correctly");
-
-    // Check that data_received flag has been set correctly
     UNITY_TEST_ASSERT_EQUAL_INT(true, ((fsm_usart_t *)p_fsm)->data_received, __LINE__, "The data_received flag has not been set correctly");
+
+    // Check that resetting the input data releases the line in the USART ring
+    fsm_usart_reset_input_data(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&usart_arr[USART_0_ID].rx_ring), __LINE__, "The line has not been released from the input ring of the USART");
+    UNITY_TEST_ASSERT_EQUAL_INT(false, port_usart_rx_done(USART_0_ID), __LINE__, "The USART must not have a received line after releasing it");
+    UNITY_TEST_ASSERT_EQUAL_INT(false, ((fsm_usart_t *)p_fsm)->data_received, __LINE__, "The data_received flag has not been cleared correctly");
 }
 
 /**
@@ -100,52 +122,167 @@ void test_usart_rx()
  */
 void test_usart_tx()
 {
-    char char_array_test[] = "TEST TX\n";
+    char first_msg[] = "TEST TX\n";
+    char second_msg[] = "SECOND TX\n";
 
-    // Copy the data to the out_data buffer of the FSM
-    memcpy(((fsm_usart_t *)p_fsm)->out_data, char_array_test, sizeof(char_array_test));
+    // Queue two messages back to back: the second one must not overwrite the first one
+    TEST_ASSERT_TRUE(fsm_usart_send(p_fsm, first_msg, strlen(first_msg)));
+    TEST_ASSERT_TRUE(fsm_usart_set_out_data(p_fsm, second_msg));
 
-    // Second transition (first char transmitted)
-    fsm_fire(p_fsm);
-    UNITY_TEST_ASSERT_EQUAL_INT(SEND_DATA, fsm_get_state(p_fsm), __LINE__, "The FSM did not change to SEND_DATA after sending a data to the usart");
+    // Check that the TXEIE bit has been enabled correctly --> All the chars are sent by the ISR
+    UNITY_TEST_ASSERT_EQUAL_INT(USART_CR1_TXEIE, usart_arr[USART_0_ID].p_usart->CR1 & USART_CR1_TXEIE, __LINE__, "The TXEIE bit has not been enabled correctly after queuing a message");
 
-    // Check that the data has been stored correctly from the out_data buffer of the FSM to the USART buffer
-    UNITY_TEST_ASSERT_EQUAL_MEMORY(((fsm_usart_t *)p_fsm)->out_data, usart_arr[USART_0_ID].output_buffer, sizeof(char_array_test), __LINE__, "The data has not been stored correctly in the output buffer of the USART");
+    // First transition
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_INT(SEND_DATA, fsm_get_state(p_fsm), __LINE__, "The FSM did not change to SEND_DATA after queuing a message");
 
-    printf("Assuming that all the chars have been sent correctly from the output buffer of the USART to the data register...\n");
+    printf("Assuming that all the chars have been sent correctly from the TX queue of the USART to the data register...\n");
 
-    // Check that the TXEIE bit has been enabled correctly --> The 2nd++ chars are sent by the ISR
-    UNITY_TEST_ASSERT_EQUAL_INT(USART_CR1_TXEIE, usart_arr[USART_0_ID].p_usart->CR1 & USART_CR1_TXEIE, __LINE__, "The TXEIE bit has not been enabled correctly after sending the first and following chars");
-    
     // Wait for the last char to be sent, leaving the ISR to send the rest of the chars.
-    while ((!usart_arr[USART_0_ID].write_complete))
-    {        
+    while (!port_usart_tx_done(USART_0_ID))
+    {
     }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, usart_arr[USART_0_ID].tx_messages_sent, __LINE__, "The ISR has not sent both messages");
 
-    // Check that the write_complete flag has been set correctly. It is the only way to assume that the last char has been sent
-    UNITY_TEST_ASSERT_EQUAL_INT(true, usart_arr[USART_0_ID].write_complete, __LINE__, "The write_complete flag has not been set correctly");
-
-    
-    // Third transition
+    // Second transition
     fsm_fire(p_fsm);
     UNITY_TEST_ASSERT_EQUAL_INT(WAIT_DATA, fsm_get_state(p_fsm), __LINE__, "The FSM did not change to WAIT_DATA after sending the last char to the usart");
 
-    // Check that the interrupt has been disabled correctly
+    // Check that the interrupt has been disabled correctly and the queue is empty
     UNITY_TEST_ASSERT_EQUAL_INT(0, usart_arr[USART_0_ID].p_usart->CR1 & USART_CR1_TXEIE, __LINE__, "The TXEIE bit has not been disabled correctly after sending the last char");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&usart_arr[USART_0_ID].tx_ring), __LINE__, "The TX queue of the USART is not empty after sending all the messages");
+}
+
+/**
+ * @brief Test that a full TX queue rejects messages without blocking.
+ * 
+ */
+void test_usart_tx_backpressure()
+{
+    char msg[USART_TX_MESSAGE_MAX_LENGTH];
+    memset(msg, 'x', sizeof(msg));
+
+    // The queue fits fewer than 4 messages of the maximum length
+    uint32_t accepted = 0;
+    while ((accepted < 4) && fsm_usart_send(p_fsm, msg, sizeof(msg)))
+    {
+        accepted++;
+    }
+    UNITY_TEST_ASSERT(accepted < 4, __LINE__, "The TX queue never reported back-pressure");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, port_usart_get_tx_rejected(USART_0_ID), __LINE__, "The rejected message has not been counted");
+
+    // A message longer than the maximum length is always rejected
+    port_usart_reset_output_buffer(USART_0_ID);
+    TEST_ASSERT_FALSE(fsm_usart_send(p_fsm, msg, USART_TX_MESSAGE_MAX_LENGTH + 1));
+    UNITY_TEST_ASSERT_EQUAL_INT(true, port_usart_tx_done(USART_0_ID), __LINE__, "The TX queue is not empty after resetting it");
+}
+
+/**
+ * @brief Test a zero-copy message sent from caller-owned memory, in order with the copied ones.
+ * 
+ */
+void test_usart_tx_zero_copy()
+{
+    static const char banner[] = "JUKEBOX READY\n"; // Lives in flash on the board
+    char status[] = "STATUS\n";
+    released = 0;
 
-    // Check that the usart output buffer has been cleared correctly
-    char expected_buffer[USART_OUTPUT_BUFFER_LENGTH];
-    memset(expected_buffer, EMPTY_BUFFER_CONSTANT, sizeof(expected_buffer));
-    UNITY_TEST_ASSERT_EQUAL_MEMORY(expected_buffer, usart_arr[USART_0_ID].output_buffer, sizeof(expected_buffer), __LINE__, "The data has not been cleared correctly from the output buffer of the USART");
+    TEST_ASSERT_TRUE(fsm_usart_send(p_fsm, status, strlen(status)));
+    TEST_ASSERT_TRUE(fsm_usart_send_ref(p_fsm, banner, strlen(banner), _release, &released));
+    TEST_ASSERT_TRUE(fsm_usart_send(p_fsm, status, strlen(status)));
 
-    // Check that the out_data buffer of the FSM has been cleared correctly
-    UNITY_TEST_ASSERT_EQUAL_MEMORY(expected_buffer, ((fsm_usart_t *)p_fsm)->out_data, sizeof(expected_buffer), __LINE__, "The data has not been cleared correctly from the out_data buffer of the USART FSM");
+    // Only the one-byte mark of the zero-copy message goes into the queue
+    UNITY_TEST_ASSERT(spsc_ring_count(&usart_arr[USART_0_ID].tx_ring) <= 2 * (strlen(status) + 1) + 1, __LINE__, "The zero-copy message has been copied into the TX queue");
 
-    // Check that the index has been reset correctly
-    UNITY_TEST_ASSERT_EQUAL_INT(0, usart_arr[USART_0_ID].o_idx, __LINE__, "The index has not been reset correctly after sending the last char");
+    while (!port_usart_tx_done(USART_0_ID))
+    {
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, usart_arr[USART_0_ID].tx_messages_sent, __LINE__, "The ISR has not sent the three messages");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, released, __LINE__, "The zero-copy message has not been released exactly once");
+    UNITY_TEST_ASSERT_EQUAL_PTR(banner, p_released_data, __LINE__, "The callback did not receive the buffer of the message");
+}
 
-    // Check that the write_complete flag has been cleared correctly
-    UNITY_TEST_ASSERT_EQUAL_INT(false, usart_arr[USART_0_ID].write_complete, __LINE__, "The write_complete flag has not been cleared correctly in the transition to WAIT_DATA");
+/**
+ * @brief Store an encoded frame in the USART input ring as the ISR does.
+ *
+ * @param p_data Encoded frame, with the delimiter
+ * @param length Length of the encoded frame
+ */
+static void _push_frame(const uint8_t *p_data, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        spsc_ring_push(&usart_arr[USART_0_ID].rx_ring, p_data[i]);
+    }
+    usart_arr[USART_0_ID].rx_lines_in++;
+}
+
+/**
+ * @brief Test the binary transport: pipelined command frames are delivered one by one and in order, damaged frames are
+ * skipped, and the responses are encoded frames with the sequence number of their command.
+ *
+ */
+void test_usart_binary_pipeline()
+{
+    fsm_usart_set_binary(p_fsm, true);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(USART_FRAME_DELIMITER, usart_arr[USART_0_ID].rx_delimiter, __LINE__, "The binary transport must delimit frames with 0x00");
+
+    usart_frame_t command = {.type = USART_FRAME_COMMAND, .code = 3, .length = 2, .payload = {0x00, 0x10}};
+    uint8_t encoded[USART_FRAME_ENCODED_MAX_LENGTH];
+    for (uint8_t seq = 1; seq <= 3; seq++)
+    {
+        command.seq = seq;
+        uint32_t length = usart_frame_encode(&command, encoded);
+        if (seq == 2)
+        {
+            encoded[3] ^= 0x40; // Damaged on the line
+        }
+        _push_frame(encoded, length);
+    }
+
+    const usart_frame_t *p_frame;
+    TEST_ASSERT_FALSE(fsm_usart_get_in_frame(p_fsm, &p_frame));
+    fsm_fire(p_fsm);
+    TEST_ASSERT_TRUE(fsm_usart_get_in_frame(p_fsm, &p_frame));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_frame->seq, __LINE__, "The first command frame was not delivered first");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, p_frame->code, __LINE__, "Wrong command code");
+    UNITY_TEST_ASSERT_EQUAL_MEMORY(command.payload, p_frame->payload, 2, __LINE__, "Wrong command payload");
+
+    // The next frames wait in the ring until the current one is released
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_frame->seq, __LINE__, "A pipelined frame overwrote the current one");
+    fsm_usart_reset_input_data(p_fsm);
+    fsm_fire(p_fsm);
+    TEST_ASSERT_TRUE(fsm_usart_get_in_frame(p_fsm, &p_frame));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, p_frame->seq, __LINE__, "The damaged frame was not skipped");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fsm_usart_get_frames_rejected(p_fsm), __LINE__, "The damaged frame was not counted");
+    fsm_usart_reset_input_data(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&usart_arr[USART_0_ID].rx_ring), __LINE__, "The frames have not been released from the input ring");
+
+    // Response with the sequence number of the command
+    usart_frame_t response = {.type = USART_FRAME_RESPONSE, .seq = 3, .code = USART_FRAME_STATUS_OK, .length = 0};
+    uint32_t length = usart_frame_encode(&response, encoded);
+    TEST_ASSERT_TRUE(fsm_usart_send_frame(p_fsm, &response));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(length + 1, spsc_ring_count(&usart_arr[USART_0_ID].tx_ring), __LINE__, "The encoded response was not queued");
+    UNITY_TEST_ASSERT_EQUAL_MEMORY(encoded, spsc_ring_peek(&usart_arr[USART_0_ID].tx_ring, length + 1) + 1, length, __LINE__, "Wrong encoded response");
+    while (!port_usart_tx_done(USART_0_ID))
+    {
+    }
+}
+
+/**
+ * @brief Test that the binary transport is refused while the USART uses XON/XOFF, whose bytes may appear in a frame.
+ *
+ */
+void test_usart_binary_xon_xoff()
+{
+    TEST_ASSERT_TRUE(port_usart_set_flow_control(USART_0_ID, PORT_USART_FLOW_XON_XOFF));
+    TEST_ASSERT_FALSE(fsm_usart_set_binary(p_fsm, true));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(END_CHAR_CONSTANT, usart_arr[USART_0_ID].rx_delimiter, __LINE__, "The binary transport was selected with XON/XOFF");
+    TEST_ASSERT_FALSE(((fsm_usart_t *)p_fsm)->binary);
+    TEST_ASSERT_TRUE(fsm_usart_set_binary(p_fsm, false));
+    TEST_ASSERT_TRUE(port_usart_set_flow_control(USART_0_ID, PORT_USART_FLOW_NONE));
+    TEST_ASSERT_TRUE(fsm_usart_set_binary(p_fsm, true));
 }
 
 /**
@@ -160,5 +297,9 @@ int main(void)
     RUN_TEST(test_initial_config);
     RUN_TEST(test_usart_rx);
     RUN_TEST(test_usart_tx);
+    RUN_TEST(test_usart_tx_backpressure);
+    RUN_TEST(test_usart_tx_zero_copy);
+    RUN_TEST(test_usart_binary_pipeline);
+    RUN_TEST(test_usart_binary_xon_xoff);
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unity.h>
+#include "melodies.h"
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_pack_fields(void)
+{
+    uint16_t packed = MELODY_PACK(NOTE_INDEX(NOTE_SI, 8), MELODY_DURATION_MAX);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(NOTE_INDEX(NOTE_SI, 8), MELODY_NOTE(packed), __LINE__, "Wrong note of the largest packed note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_DURATION_MAX, MELODY_CODE(packed), __LINE__, "Wrong code of the largest packed note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_PACK(LA4, 3), MELODY_PACK_MS(LA4, 260, 100), __LINE__, "The duration was not rounded down");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_PACK(LA4, 3), MELODY_PACK_MS(LA4, 250, 100), __LINE__, "The duration was not rounded up");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, MELODY_NOTE(MELODY_PACK_MS(SILENCE, 400, 200)), __LINE__, "The silence was not packed as note 0");
+}
+
+void test_cursor(void)
+{
+    // First notes of Happy Birthday: DO4 300 ms, DO4 100 ms, RE4 400 ms
+    melody_cursor_t cursor;
+    melody_note_t note;
+    melody_cursor_init(&cursor, &happy_birthday_melody);
+    UNITY_TEST_ASSERT(melody_cursor_next(&cursor, &note), __LINE__, "The first note was not decoded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(DO4, note.note, __LINE__, "Wrong first note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(300, note.duration_ms, __LINE__, "Wrong first duration");
+    melody_cursor_next(&cursor, &note);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(100, note.duration_ms, __LINE__, "Wrong second duration");
+    melody_cursor_next(&cursor, &note);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(RE4, note.note, __LINE__, "Wrong third note");
+
+    uint32_t count = 3;
+    while (melody_cursor_next(&cursor, &note))
+    {
+        count++;
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(happy_birthday_melody.melody_length, count, __LINE__, "The cursor did not stop at the end");
+    UNITY_TEST_ASSERT(!melody_cursor_next(&cursor, &note), __LINE__, "A note was decoded past the end");
+}
+
+void test_melodies(void)
+{
+    const melody_t *melodies[] = {&scale_melody, &happy_birthday_melody, &tetris_melody};
+    const uint32_t durations_ms[] = {4250, 9600, 12800};
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        melody_cursor_t cursor;
+        melody_note_t note;
+        uint32_t total = 0;
+        melody_cursor_init(&cursor, melodies[i]);
+        while (melody_cursor_next(&cursor, &note))
+        {
+            UNITY_TEST_ASSERT(note.note < NOTE_TABLE_LENGTH, __LINE__, "A note is not in the table");
+            UNITY_TEST_ASSERT(note.duration_ms > 0, __LINE__, "A note has no duration");
+            total += note.duration_ms;
+        }
+        UNITY_TEST_ASSERT_EQUAL_UINT32(durations_ms[i], total, __LINE__, "Wrong duration of a melody");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(durations_ms[i], melody_get_duration_ms(melodies[i]), __LINE__, "Wrong total duration");
+    }
+}
+
+void test_pack_old_layout(void)
+{
+    // First bar of Tetris with parallel arrays of notes and of durations in ms
+    const uint8_t notes[] = {MI5, SI4, DO5, RE5, DO5, SI4};
+    const uint16_t durations[] = {400, 200, 200, 400, 200, 200};
+    uint16_t packed[6];
+    uint32_t base = melody_tempo_base(durations, 6);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(200, base, __LINE__, "Wrong tempo base");
+    UNITY_TEST_ASSERT(melody_pack(packed, notes, durations, 6, base), __LINE__, "The melody was not packed");
+
+    const melody_t melody = {.p_name = "bar", .p_notes = packed, .melody_length = 6, .tempo_base_ms = (uint16_t)base};
+    UNITY_TEST_ASSERT_EQUAL_MEMORY(tetris_melody.p_notes, packed, sizeof(packed), __LINE__, "The packed bar differs from the Tetris melody");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1600, melody_get_duration_ms(&melody), __LINE__, "Wrong duration of the packed bar");
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, melody_tempo_base(durations, 0), __LINE__, "An empty melody has a tempo base");
+    const uint16_t too_long[] = {200, 60000};
+    UNITY_TEST_ASSERT(!melody_pack(packed, notes, too_long, 2, 100), __LINE__, "A duration that does not fit was packed");
+    const uint8_t bad_note[] = {NOTE_TABLE_LENGTH};
+    UNITY_TEST_ASSERT(!melody_pack(packed, bad_note, durations, 1, 200), __LINE__, "A note that is not in the table was packed");
+}
+
+void test_library(void)
+{
+    // The index starts with the melodies of melodies/jukebox.rtttl and has one entry per melody
+    UNITY_TEST_ASSERT(melody_library_length >= 4, __LINE__, "Melodies are missing from the library");
+    UNITY_TEST_ASSERT_EQUAL_PTR(&scale_melody, melody_library[0], __LINE__, "Wrong first melody of the library");
+    UNITY_TEST_ASSERT_EQUAL_PTR(&happy_birthday_melody, melody_library[1], __LINE__, "Wrong second melody of the library");
+    UNITY_TEST_ASSERT_EQUAL_PTR(&tetris_melody, melody_library[2], __LINE__, "Wrong third melody of the library");
+
+    // melodies/ode_to_joy.mid: a chord on the first beat, a rest and a tempo change before the last note
+    const melody_t *p_ode = NULL;
+    for (uint32_t i = 0; i < melody_library_length; i++)
+    {
+        if (strcmp(melody_library[i]->p_name, "ode_to_joy") == 0)
+        {
+            p_ode = melody_library[i];
+        }
+    }
+    UNITY_TEST_ASSERT(p_ode != NULL, __LINE__, "The MIDI melody is not in the library");
+    melody_cursor_t cursor;
+    melody_note_t note;
+    melody_cursor_init(&cursor, p_ode);
+    melody_cursor_next(&cursor, &note);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MI4, note.note, __LINE__, "The top note of the chord was not kept");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(500, note.duration_ms, __LINE__, "Wrong duration of a quarter note at 120 bpm");
+    for (uint32_t i = 1; i < 16; i++)
+    {
+        melody_cursor_next(&cursor, &note);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(SILENCE, note.note, __LINE__, "The rest is missing");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(500, note.duration_ms, __LINE__, "Wrong duration of the rest");
+    melody_cursor_next(&cursor, &note);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(DO4, note.note, __LINE__, "Wrong last note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1000, note.duration_ms, __LINE__, "The tempo change was not applied");
+    UNITY_TEST_ASSERT(!melody_cursor_next(&cursor, &note), __LINE__, "The melody is too long");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_pack_fields);
+    RUN_TEST(test_cursor);
+    RUN_TEST(test_melodies);
+    RUN_TEST(test_pack_old_layout);
+    RUN_TEST(test_library);
+
+    return UNITY_END();
+}
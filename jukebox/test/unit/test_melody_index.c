@@ -0,0 +1,94 @@
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "melody_index.h"
+
+static uint32_t _find(const char *p_name)
+{
+    return melody_index_find(p_name, strlen(p_name));
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_entries(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_UINT32(melody_library_length, melody_index_count(), __LINE__, "Wrong number of melodies");
+    for (uint32_t i = 0; i < melody_index_count(); i++)
+    {
+        const melody_info_t *p_info = melody_index_get(i);
+        UNITY_TEST_ASSERT_EQUAL_PTR(melody_library[i], p_info->p_melody, __LINE__, "The index is not in the order of the library");
+        UNITY_TEST_ASSERT(strcmp(melody_library[i]->p_name, p_info->p_name) == 0, __LINE__, "Wrong name");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(melody_library[i]->melody_length, p_info->melody_length, __LINE__, "Wrong number of notes");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(melody_get_duration_ms(melody_library[i]), p_info->duration_ms, __LINE__, "Wrong duration");
+    }
+    UNITY_TEST_ASSERT_EQUAL_PTR(NULL, melody_index_get(melody_index_count()), __LINE__, "A melody past the library has metadata");
+}
+
+void test_orders(void)
+{
+    // Library order: scale, happy_birthday, tetris, ode_to_joy (4250, 9600, 12800 and 9500 ms)
+    UNITY_TEST_ASSERT_EQUAL_UINT32(_find("tetris"), melody_index_longest(), __LINE__, "Wrong longest melody");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(_find("scale"), melody_index_shortest(), __LINE__, "Wrong shortest melody");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(_find("ode_to_joy"), melody_index_next(MELODY_ORDER_DURATION, _find("scale")), __LINE__, "Wrong next melody by duration");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(_find("happy_birthday"), melody_index_at(MELODY_ORDER_NAME, 0), __LINE__, "Wrong first melody by name");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(_find("tetris"), melody_index_previous(MELODY_ORDER_NAME, _find("happy_birthday")), __LINE__, "The previous melody did not wrap");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, melody_index_next(MELODY_ORDER_LIBRARY, melody_index_count() - 1), __LINE__, "The next melody did not wrap");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_INDEX_NOT_FOUND, melody_index_next(MELODY_ORDER_NAME, melody_index_count()), __LINE__, "A melody past the library has a next one");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_INDEX_NOT_FOUND, melody_index_at(MELODY_ORDER_DURATION, melody_index_count()), __LINE__, "A rank past the library has a melody");
+
+    // Every order is a sorted permutation and the ranks are its inverse
+    uint32_t orders[] = {MELODY_ORDER_LIBRARY, MELODY_ORDER_NAME, MELODY_ORDER_DURATION};
+    for (uint32_t o = 0; o < 3; o++)
+    {
+        for (uint32_t rank = 0; rank < melody_index_count(); rank++)
+        {
+            uint32_t melody = melody_index_at(orders[o], rank);
+            UNITY_TEST_ASSERT_EQUAL_UINT32(rank, melody_index_rank(orders[o], melody), __LINE__, "The rank is not the inverse of the order");
+            if (rank == 0)
+            {
+                continue;
+            }
+            const melody_info_t *p_previous = melody_index_get(melody_index_at(orders[o], rank - 1));
+            const melody_info_t *p_info = melody_index_get(melody);
+            if (orders[o] == MELODY_ORDER_NAME)
+            {
+                UNITY_TEST_ASSERT(strcmp(p_previous->p_name, p_info->p_name) < 0, __LINE__, "The names are not sorted");
+            }
+            else if (orders[o] == MELODY_ORDER_DURATION)
+            {
+                UNITY_TEST_ASSERT(p_previous->duration_ms <= p_info->duration_ms, __LINE__, "The durations are not sorted");
+            }
+        }
+    }
+}
+
+void test_find(void)
+{
+    for (uint32_t i = 0; i < melody_index_count(); i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(i, _find(melody_library[i]->p_name), __LINE__, "A melody was not found by its name");
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_INDEX_NOT_FOUND, _find("tetri"), __LINE__, "A prefix of a name was found");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_INDEX_NOT_FOUND, _find("tetris2"), __LINE__, "A name with a suffix was found");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_INDEX_NOT_FOUND, _find(""), __LINE__, "An empty name was found");
+    // The name is a view into the receive ring: it does not end with a null character
+    UNITY_TEST_ASSERT_EQUAL_UINT32(_find("scale"), melody_index_find("scale 3\n", 5), __LINE__, "A name that is not null-terminated was not found");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MELODY_INDEX_NOT_FOUND, melody_index_find("scale\0zz", 8), __LINE__, "A name with an embedded null character was found");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_entries);
+    RUN_TEST(test_orders);
+    RUN_TEST(test_find);
+
+    return UNITY_END();
+}
@@ -0,0 +1,71 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <unity.h>
+#include "note_table.h"
+
+#define MAX_ERROR_PPM 250U // Maximum frequency error of a table entry: half a tick of the shortest period (SI8)
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_indices(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, NOTE_INDEX(NOTE_DO, 0), __LINE__, "DO0 is not the first note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(108, NOTE_INDEX(NOTE_SI, 8), __LINE__, "SI8 is not the last note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(NOTE_TABLE_LENGTH - 1, NOTE_INDEX(NOTE_SI, 8), __LINE__, "Wrong table length");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, NOTE_OCTAVE(NOTE_INDEX(NOTE_LA, 4)), __LINE__, "Wrong octave of LA4");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(NOTE_LA, NOTE_SEMITONE(NOTE_INDEX(NOTE_LA, 4)), __LINE__, "Wrong semitone of LA4");
+    UNITY_TEST_ASSERT_EQUAL_PTR(&note_table[NOTE_SILENCE], note_table_get(NOTE_SILENCE), __LINE__, "The silence has no entry");
+    UNITY_TEST_ASSERT_EQUAL_PTR(NULL, note_table_get(NOTE_TABLE_LENGTH), __LINE__, "An index past the table was accepted");
+}
+
+void test_frequencies(void)
+{
+    // Reference values of melodies.h, in mHz
+    UNITY_TEST_ASSERT_EQUAL_UINT32(440000, note_table_get_frequency_mhz(NOTE_INDEX(NOTE_LA, 4)), __LINE__, "Wrong frequency of LA4");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(130813, note_table_get_frequency_mhz(NOTE_INDEX(NOTE_DO, 3)), __LINE__, "Wrong frequency of DO3");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(987767, note_table_get_frequency_mhz(NOTE_INDEX(NOTE_SI, 5)), __LINE__, "Wrong frequency of SI5");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(16352, note_table_get_frequency_mhz(NOTE_INDEX(NOTE_DO, 0)), __LINE__, "Wrong frequency of DO0");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(7902133, note_table_get_frequency_mhz(NOTE_INDEX(NOTE_SI, 8)), __LINE__, "Wrong frequency of SI8");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, note_table_get_frequency_mhz(NOTE_SILENCE), __LINE__, "The silence has a frequency");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, note_table_get_frequency_mhz(NOTE_TABLE_LENGTH), __LINE__, "An index past the table has a frequency");
+}
+
+void test_all_notes_accurate(void)
+{
+    uint64_t previous_period = UINT64_MAX;
+    for (uint32_t note = 1; note < NOTE_TABLE_LENGTH; note++)
+    {
+        const note_timer_t *p_timer = note_table_get(note);
+        uint64_t period = (uint64_t)(p_timer->psc + 1U) * (p_timer->arr + 1U);
+        uint64_t clock_mhz = (uint64_t)NOTE_TABLE_TIMER_CLOCK_HZ * 1000U;
+        uint64_t ideal = (uint64_t)note_table_get_frequency_mhz(note) * period;
+        uint64_t error = (ideal > clock_mhz) ? (ideal - clock_mhz) : (clock_mhz - ideal);
+
+        UNITY_TEST_ASSERT(p_timer->arr > 0, __LINE__, "A note has no period");
+        UNITY_TEST_ASSERT(period < previous_period, __LINE__, "The periods do not decrease with the note");
+        UNITY_TEST_ASSERT(error * 1000000U <= clock_mhz * MAX_ERROR_PPM, __LINE__, "A note is out of tune");
+        if (p_timer->psc > 0)
+        {
+            // The smallest prescaler is used, so the ARR has as much resolution as possible
+            UNITY_TEST_ASSERT((uint64_t)p_timer->psc * 0x10000U < period + p_timer->psc, __LINE__, "The prescaler is not the smallest one");
+        }
+        previous_period = period;
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_indices);
+    RUN_TEST(test_frequencies);
+    RUN_TEST(test_all_notes_accurate);
+
+    return UNITY_END();
+}
@@ -0,0 +1,95 @@
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "spsc_ring.h"
+
+#define RING_SIZE 16
+#define RING_SLACK 8
+
+static spsc_ring_t ring;
+static uint8_t buffer[RING_SIZE + RING_SLACK];
+
+static void _push_string(const char *p_string)
+{
+    while (*p_string != '\0')
+    {
+        spsc_ring_push(&ring, (uint8_t)*p_string++);
+    }
+}
+
+void setUp(void)
+{
+    memset(buffer, 0, sizeof(buffer));
+    spsc_ring_init(&ring, buffer, RING_SIZE, RING_SLACK);
+}
+
+void tearDown(void)
+{
+}
+
+void test_find_and_peek(void)
+{
+    uint32_t length;
+    _push_string("abc");
+    UNITY_TEST_ASSERT(!spsc_ring_find(&ring, '\n', &length), __LINE__, "A delimiter was found in an incomplete line");
+    _push_string("d\nef");
+    UNITY_TEST_ASSERT(spsc_ring_find(&ring, '\n', &length), __LINE__, "The delimiter was not found");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, length, __LINE__, "Wrong line length");
+    const uint8_t *p_line = spsc_ring_peek(&ring, length);
+    UNITY_TEST_ASSERT(p_line == &buffer[0], __LINE__, "A contiguous line was not viewed in place");
+    UNITY_TEST_ASSERT(memcmp(p_line, "abcd", 4) == 0, __LINE__, "Wrong line content");
+
+    spsc_ring_consume(&ring, length + 1);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, spsc_ring_count(&ring), __LINE__, "Wrong number of bytes left");
+    UNITY_TEST_ASSERT(!spsc_ring_find(&ring, '\n', &length), __LINE__, "A delimiter was found after consuming the line");
+}
+
+void test_wrapped_view(void)
+{
+    uint32_t length;
+    _push_string("0123456789ab\n");
+    spsc_ring_find(&ring, '\n', &length);
+    spsc_ring_consume(&ring, length + 1);
+
+    // The next line starts at index 13 and wraps after 3 bytes
+    _push_string("wrapped\n");
+    UNITY_TEST_ASSERT(spsc_ring_find(&ring, '\n', &length), __LINE__, "The delimiter of a wrapped line was not found");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(7, length, __LINE__, "Wrong wrapped line length");
+    const uint8_t *p_line = spsc_ring_peek(&ring, length);
+    UNITY_TEST_ASSERT(p_line == &buffer[13], __LINE__, "The view does not start at the tail");
+    UNITY_TEST_ASSERT(memcmp(p_line, "wrapped", 7) == 0, __LINE__, "Wrong wrapped line content");
+}
+
+void test_wrap_larger_than_slack(void)
+{
+    // The tail is at index 12: a view of 16 bytes wraps 12, one of 12 bytes wraps 8
+    _push_string("0123456789ab");
+    spsc_ring_consume(&ring, 12);
+    _push_string("0123456789abcdef");
+    UNITY_TEST_ASSERT(spsc_ring_peek(&ring, 16) == NULL, __LINE__, "A view larger than the slack was returned");
+    UNITY_TEST_ASSERT(spsc_ring_peek(&ring, 12) != NULL, __LINE__, "A view up to the slack was refused");
+}
+
+void test_full_ring_drops(void)
+{
+    for (uint32_t i = 0; i < RING_SIZE; i++)
+    {
+        UNITY_TEST_ASSERT(spsc_ring_push(&ring, (uint8_t)i), __LINE__, "A byte was refused with free space");
+    }
+    UNITY_TEST_ASSERT(!spsc_ring_push(&ring, 0xFF), __LINE__, "A byte was accepted with the ring full");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, ring.dropped, __LINE__, "The dropped byte was not counted");
+    spsc_ring_consume(&ring, 1);
+    UNITY_TEST_ASSERT(spsc_ring_push(&ring, 0xFF), __LINE__, "A byte was refused after consuming");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_find_and_peek);
+    RUN_TEST(test_wrapped_view);
+    RUN_TEST(test_wrap_larger_than_slack);
+    RUN_TEST(test_full_ring_drops);
+
+    return UNITY_END();
+}
@@ -0,0 +1,89 @@
+#include <stdint.h>
+#include <unity.h>
+#include "sw_timer.h"
+#include "port_system.h"
+
+#define TEST_EVENT 5
+
+static sw_timer_t timer_a;
+static sw_timer_t timer_b;
+
+void setUp(void)
+{
+    sw_timer_init(&timer_a, TEST_EVENT);
+    sw_timer_init(&timer_b, TEST_EVENT);
+    port_system_take_events();
+}
+
+void tearDown(void)
+{
+    sw_timer_stop(&timer_a);
+    sw_timer_stop(&timer_b);
+}
+
+void test_expiry_posts_event(void)
+{
+    sw_timer_start(&timer_a, 10);
+    port_system_delay_ms(10);
+    TEST_ASSERT_TRUE(sw_timer_is_running(&timer_a));
+    TEST_ASSERT_FALSE(sw_timer_has_expired(&timer_a));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_system_take_events() & (1U << TEST_EVENT), __LINE__, "The event was posted too early");
+
+    port_system_delay_ms(1);
+    TEST_ASSERT_FALSE(sw_timer_is_running(&timer_a));
+    TEST_ASSERT_TRUE(sw_timer_has_expired(&timer_a));
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1U << TEST_EVENT, port_system_take_events() & (1U << TEST_EVENT), __LINE__, "The expiry did not post the event");
+}
+
+void test_stop_and_restart(void)
+{
+    sw_timer_start(&timer_a, 5);
+    sw_timer_stop(&timer_a);
+    port_system_delay_ms(10);
+    TEST_ASSERT_FALSE(sw_timer_has_expired(&timer_a));
+
+    sw_timer_start(&timer_a, 5);
+    port_system_delay_ms(3);
+    sw_timer_start(&timer_a, 5); /* Restarting moves the expiry */
+    port_system_delay_ms(3);
+    TEST_ASSERT_FALSE(sw_timer_has_expired(&timer_a));
+    port_system_delay_ms(3);
+    TEST_ASSERT_TRUE(sw_timer_has_expired(&timer_a));
+}
+
+void test_same_slot_later_round(void)
+{
+    sw_timer_start(&timer_a, 3);
+    sw_timer_start(&timer_b, 3 + SW_TIMER_WHEEL_SLOTS);
+    port_system_delay_ms(4);
+    TEST_ASSERT_TRUE(sw_timer_has_expired(&timer_a));
+    UNITY_TEST_ASSERT(!sw_timer_has_expired(&timer_b), __LINE__, "A timer of a later round of the wheel expired early");
+
+    port_system_delay_ms(SW_TIMER_WHEEL_SLOTS - 1);
+    TEST_ASSERT_FALSE(sw_timer_has_expired(&timer_b));
+    port_system_delay_ms(1);
+    TEST_ASSERT_TRUE(sw_timer_has_expired(&timer_b));
+}
+
+void test_tick_wrap(void)
+{
+    port_system_set_millis(UINT32_MAX - 5);
+    sw_timer_start(&timer_a, 20);
+    port_system_delay_ms(20);
+    TEST_ASSERT_FALSE(sw_timer_has_expired(&timer_a));
+    port_system_delay_ms(1);
+    UNITY_TEST_ASSERT(sw_timer_has_expired(&timer_a), __LINE__, "The timer did not survive the wrap of the System tick");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+
+    RUN_TEST(test_expiry_posts_event);
+    RUN_TEST(test_stop_and_restart);
+    RUN_TEST(test_same_slot_later_round);
+    RUN_TEST(test_tick_wrap);
+
+    return UNITY_END();
+}
@@ -0,0 +1,108 @@
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "usart_frame.h"
+
+static usart_frame_t frame;
+static usart_frame_t decoded;
+static uint8_t encoded[USART_FRAME_ENCODED_MAX_LENGTH];
+
+void setUp(void)
+{
+    memset(&frame, 0, sizeof(frame));
+    memset(&decoded, 0, sizeof(decoded));
+    memset(encoded, 0xEE, sizeof(encoded));
+}
+
+void tearDown(void)
+{
+}
+
+void test_crc16_check_value(void)
+{
+    const uint8_t check[] = "123456789";
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x29B1, usart_frame_crc16(0xFFFF, check, 9), __LINE__, "Wrong CRC16-CCITT check value");
+    uint16_t crc = usart_frame_crc16(0xFFFF, check, 4);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x29B1, usart_frame_crc16(crc, &check[4], 5), __LINE__, "The CRC cannot be computed in pieces");
+}
+
+void test_round_trip_with_zeros(void)
+{
+    frame.type = USART_FRAME_COMMAND;
+    frame.seq = 0;
+    frame.code = 7;
+    frame.length = 5;
+    memcpy(frame.payload, "\x00\x01\x00\x00\xFF", 5);
+    uint32_t length = usart_frame_encode(&frame, encoded);
+
+    // Header (4) + payload (5) + CRC (2) + one COBS code + delimiter
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4 + 5 + 2 + 1 + 1, length, __LINE__, "Wrong encoded length");
+    UNITY_TEST_ASSERT(memchr(encoded, USART_FRAME_DELIMITER, length - 1) == NULL, __LINE__, "The encoded frame contains the delimiter");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(USART_FRAME_DELIMITER, encoded[length - 1], __LINE__, "The encoded frame does not end with the delimiter");
+
+    UNITY_TEST_ASSERT(usart_frame_decode(encoded, length - 1, &decoded), __LINE__, "A correct frame was rejected");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(USART_FRAME_COMMAND, decoded.type, __LINE__, "Wrong type");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, decoded.seq, __LINE__, "Wrong sequence number");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(7, decoded.code, __LINE__, "Wrong code");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, decoded.length, __LINE__, "Wrong payload length");
+    UNITY_TEST_ASSERT(memcmp(frame.payload, decoded.payload, 5) == 0, __LINE__, "Wrong payload");
+}
+
+void test_round_trip_max_payload(void)
+{
+    frame.type = USART_FRAME_RESPONSE;
+    frame.seq = 200;
+    frame.length = USART_FRAME_PAYLOAD_MAX_LENGTH;
+    for (uint32_t i = 0; i < USART_FRAME_PAYLOAD_MAX_LENGTH; i++)
+    {
+        frame.payload[i] = (uint8_t)(i * 37);
+    }
+    uint32_t length = usart_frame_encode(&frame, encoded);
+    UNITY_TEST_ASSERT(length <= USART_FRAME_ENCODED_MAX_LENGTH, __LINE__, "The encoded frame is longer than the maximum");
+    UNITY_TEST_ASSERT(usart_frame_decode(encoded, length - 1, &decoded), __LINE__, "A correct frame was rejected");
+    UNITY_TEST_ASSERT(memcmp(&frame, &decoded, sizeof(frame)) == 0, __LINE__, "Wrong decoded frame");
+
+    frame.length = USART_FRAME_PAYLOAD_MAX_LENGTH + 1;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, usart_frame_encode(&frame, encoded), __LINE__, "A payload longer than the maximum was encoded");
+}
+
+void test_damaged_frames(void)
+{
+    frame.type = USART_FRAME_COMMAND;
+    frame.seq = 1;
+    frame.code = 2;
+    frame.length = 3;
+    memcpy(frame.payload, "abc", 3);
+    uint32_t length = usart_frame_encode(&frame, encoded) - 1;
+
+    encoded[6] ^= 0x01;
+    UNITY_TEST_ASSERT(!usart_frame_decode(encoded, length, &decoded), __LINE__, "A frame with a flipped bit was accepted");
+    encoded[6] ^= 0x01;
+    UNITY_TEST_ASSERT(!usart_frame_decode(encoded, length - 1, &decoded), __LINE__, "A truncated frame was accepted");
+    UNITY_TEST_ASSERT(!usart_frame_decode(encoded, 0, &decoded), __LINE__, "An empty frame was accepted");
+
+    uint8_t bad_code[] = {0x09, 0x01, 0x02};
+    UNITY_TEST_ASSERT(!usart_frame_decode(bad_code, sizeof(bad_code), &decoded), __LINE__, "A COBS block longer than the frame was accepted");
+
+    // Correct CRC but a length field that does not match the payload
+    uint8_t raw[] = {USART_FRAME_COMMAND, 1, 2, 4, 'a', 'b', 'c', 0, 0};
+    uint16_t crc = usart_frame_crc16(0xFFFF, raw, 7);
+    raw[7] = (uint8_t)(crc >> 8);
+    raw[8] = (uint8_t)crc;
+    uint8_t cobs[] = {10, raw[0], raw[1], raw[2], raw[3], raw[4], raw[5], raw[6], raw[7], raw[8]};
+    UNITY_TEST_ASSERT(!usart_frame_decode(cobs, sizeof(cobs), &decoded), __LINE__, "A frame with a wrong length field was accepted");
+
+    UNITY_TEST_ASSERT(usart_frame_decode(encoded, length, &decoded), __LINE__, "The restored frame was rejected");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_crc16_check_value);
+    RUN_TEST(test_round_trip_with_zeros);
+    RUN_TEST(test_round_trip_max_payload);
+    RUN_TEST(test_damaged_frames);
+
+    return UNITY_END();
+}
@@ -0,0 +1,954 @@
+/**
+ * @file melody_gen.c
+ * @brief Host tool that converts the RTTTL and type-0 MIDI files of `melodies/` into the packed melody tables of
+ * `melodies.h`.
+ *
+ * Usage: `melody_gen <output.c> <file>...`. Files ending in `.mid` are read as Standard MIDI Files of format 0; any
+ * other file is read as RTTTL, one `name:d=4,o=5,b=120:notes` string per line (empty lines and lines starting with `#`
+ * are skipped). MIDI melodies take the name of the track, or of the file if the track has none.
+ *
+ * Every melody is reduced to a sequence of (note, duration in ms) with consecutive rests merged, and validated: notes
+ * must be in `note_table` (DO0 to SI8), names must be unique C identifiers once lower-cased, and melodies cannot be
+ * empty. The tempo base of each melody is the greatest common divisor of its durations, so the durations are exact and
+ * the codes as small as possible; if a code would not fit in `MELODY_DURATION_BITS` bits, the base is widened and the
+ * durations rounded to it, with a warning. Melodies whose packed notes and tempo base are identical share one array.
+ *
+ * The output defines one `const melody_t <name>_melody` per melody and the list `melody_library[]` in input order, and
+ * the read-only metadata index of `melody_index.h` over that list: total duration and name hash of each melody, the
+ * orders by name and by duration with their inverse permutations, and a hash table of the names.
+ * On any error nothing is written and the tool exits with status 1, which fails the build.
+ *
+ * @author Sistemas Digitales II
+ * @date 2024-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private defines ------------------------------------------------------------*/
+#define NAME_MAX_LENGTH 48U                       /*!< Longest melody name */
+#define NOTE_SILENCE 0U                           /*!< Index of the rest, as in note_table.h */
+#define NOTE_LAST 108U                            /*!< Index of SI8, the last note of note_table.h */
+#define DURATION_BITS 9U                          /*!< Bits of the duration code, as MELODY_DURATION_BITS in melodies.h */
+#define DURATION_MAX ((1U << DURATION_BITS) - 1U) /*!< Largest duration code */
+#define TEMPO_BASE_MAX 0xFFFFU                    /*!< Largest tempo base (uint16_t field of melody_t) */
+#define MELODY_MAX_LENGTH 0xFFFFU                 /*!< Most notes of a melody (uint16_t field of melody_t) */
+#define MIDI_NOTE_DO0 12U                         /*!< MIDI note number of DO0 (MIDI 60 is DO4) */
+#define LIBRARY_MAX_LENGTH 0xFFFEU                /*!< Most melodies (uint16_t positions, 0xFFFF marks an empty slot) */
+#define FNV_OFFSET_BASIS 2166136261U              /*!< Initial value of the 32-bit FNV-1a hash, as in melody_index.c */
+#define FNV_PRIME 16777619U                       /*!< Multiplier of the 32-bit FNV-1a hash */
+#define MIDI_NOTES 128U                           /*!< MIDI note numbers */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Melody being converted.
+ */
+typedef struct
+{
+    char name[NAME_MAX_LENGTH + 1]; /*!< Name, a lower-case C identifier */
+    char source[256];               /*!< File and line it comes from, for the messages */
+    uint8_t *p_notes;               /*!< Note indices */
+    uint32_t *p_durations;          /*!< Durations in ms */
+    uint16_t *p_packed;             /*!< Packed notes */
+    uint32_t length;                /*!< Number of notes */
+    uint32_t capacity;              /*!< Allocated notes */
+    uint32_t tempo_base;            /*!< Tempo base in ms */
+    uint32_t duration_ms;           /*!< Total duration once packed, in ms */
+    uint32_t name_hash;             /*!< FNV-1a hash of the name */
+    int32_t shared;                 /*!< Index of an earlier melody with the same packed notes, or -1 */
+} song_t;
+
+/* Private variables ------------------------------------------------------------*/
+static song_t *songs;       /*!< Melodies read so far */
+static uint32_t song_count; /*!< Number of melodies read */
+static uint32_t errors;     /*!< Number of errors reported */
+
+/* Private functions */
+/**
+ * @brief Report an error about a melody or a file.
+ */
+static void _error(const char *p_where, const char *p_format, ...)
+{
+    va_list args;
+    va_start(args, p_format);
+    fprintf(stderr, "melody_gen: error: %s: ", p_where);
+    vfprintf(stderr, p_format, args);
+    fputc('\n', stderr);
+    va_end(args);
+    errors++;
+}
+
+/**
+ * @brief Turn a name into a lower-case C identifier: other characters become single underscores.
+ */
+static void _make_name(char *p_name, const char *p_text, size_t length)
+{
+    size_t out = 0;
+    if ((length > 0) && isdigit((unsigned char)p_text[0]))
+    {
+        /* An identifier cannot start with a digit */
+        p_name[out++] = 'm';
+        p_name[out++] = '_';
+    }
+    for (size_t i = 0; (i < length) && (out < NAME_MAX_LENGTH); i++)
+    {
+        unsigned char c = (unsigned char)p_text[i];
+        if (isalnum(c))
+        {
+            p_name[out++] = (char)tolower(c);
+        }
+        else if ((out > 0) && (p_name[out - 1] != '_'))
+        {
+            p_name[out++] = '_';
+        }
+    }
+    while ((out > 0) && (p_name[out - 1] == '_'))
+    {
+        out--;
+    }
+    p_name[out] = '\0';
+}
+
+/**
+ * @brief Start a new melody.
+ */
+static song_t *_new_song(const char *p_name, size_t name_length, const char *p_source)
+{
+    song_t *p_songs = realloc(songs, (song_count + 1) * sizeof(song_t));
+    if (p_songs == NULL)
+    {
+        fprintf(stderr, "melody_gen: out of memory\n");
+        exit(1);
+    }
+    songs = p_songs;
+    song_t *p_song = &songs[song_count++];
+    memset(p_song, 0, sizeof(*p_song));
+    p_song->shared = -1;
+    snprintf(p_song->source, sizeof(p_song->source), "%s", p_source);
+    _make_name(p_song->name, p_name, name_length);
+    return p_song;
+}
+
+/**
+ * @brief Append a note to a melody, merging consecutive rests and skipping empty notes.
+ */
+static void _add_note(song_t *p_song, uint32_t note, uint32_t duration_ms)
+{
+    if (duration_ms == 0)
+    {
+        return;
+    }
+    if ((note == NOTE_SILENCE) && (p_song->length > 0) && (p_song->p_notes[p_song->length - 1] == NOTE_SILENCE))
+    {
+        p_song->p_durations[p_song->length - 1] += duration_ms;
+        return;
+    }
+    if (p_song->length == p_song->capacity)
+    {
+        p_song->capacity = (p_song->capacity == 0) ? 64 : 2 * p_song->capacity;
+        p_song->p_notes = realloc(p_song->p_notes, p_song->capacity);
+        p_song->p_durations = realloc(p_song->p_durations, p_song->capacity * sizeof(uint32_t));
+        if ((p_song->p_notes == NULL) || (p_song->p_durations == NULL))
+        {
+            fprintf(stderr, "melody_gen: out of memory\n");
+            exit(1);
+        }
+    }
+    p_song->p_notes[p_song->length] = (uint8_t)note;
+    p_song->p_durations[p_song->length] = duration_ms;
+    p_song->length++;
+}
+
+/**
+ * @brief Read a whole file into memory.
+ */
+static uint8_t *_read_file(const char *p_path, size_t *p_size)
+{
+    FILE *p_file = fopen(p_path, "rb");
+    if (p_file == NULL)
+    {
+        _error(p_path, "cannot open the file");
+        return NULL;
+    }
+    uint8_t *p_data = NULL;
+    size_t size = 0;
+    size_t capacity = 0;
+    for (;;)
+    {
+        if (size == capacity)
+        {
+            capacity = (capacity == 0) ? 4096 : 2 * capacity;
+            p_data = realloc(p_data, capacity + 1);
+            if (p_data == NULL)
+            {
+                fprintf(stderr, "melody_gen: out of memory\n");
+                exit(1);
+            }
+        }
+        size_t n = fread(&p_data[size], 1, capacity - size, p_file);
+        if (n == 0)
+        {
+            break;
+        }
+        size += n;
+    }
+    fclose(p_file);
+    p_data[size] = '\0';
+    *p_size = size;
+    return p_data;
+}
+
+/* RTTTL ---------------------------------------------------------------------*/
+/**
+ * @brief Parse a decimal number of an RTTTL string.
+ */
+static bool _rtttl_number(const char **pp, const char *p_end, uint32_t *p_value)
+{
+    const char *p = *pp;
+    uint32_t value = 0;
+    while ((p < p_end) && isdigit((unsigned char)*p) && (value < 100000U))
+    {
+        value = value * 10U + (uint32_t)(*p++ - '0');
+    }
+    if (p == *pp)
+    {
+        return false;
+    }
+    *pp = p;
+    *p_value = value;
+    return true;
+}
+
+/**
+ * @brief Check that a number is a valid RTTTL duration (1, 2, 4, 8, 16 or 32).
+ */
+static bool _rtttl_is_duration(uint32_t d)
+{
+    return (d == 1) || (d == 2) || (d == 4) || (d == 8) || (d == 16) || (d == 32);
+}
+
+/**
+ * @brief Parse one RTTTL string `name:settings:notes` (the line without its end).
+ *
+ * @return `true` if the string was parsed; otherwise the error is reported and the melody is left incomplete.
+ */
+static bool _parse_rtttl_line(const char *p_line, const char *p_end, const char *p_source)
+{
+    const char *p_colon1 = memchr(p_line, ':', (size_t)(p_end - p_line));
+    const char *p_colon2 = (p_colon1 != NULL) ? memchr(p_colon1 + 1, ':', (size_t)(p_end - p_colon1 - 1)) : NULL;
+    if (p_colon2 == NULL)
+    {
+        _error(p_source, "not an RTTTL string (name:settings:notes)");
+        return false;
+    }
+    song_t *p_song = _new_song(p_line, (size_t)(p_colon1 - p_line), p_source);
+
+    /* Settings, in any order; RTTTL defaults otherwise */
+    uint32_t default_duration = 4;
+    uint32_t default_octave = 6;
+    uint32_t bpm = 63;
+    for (const char *p = p_colon1 + 1; p < p_colon2;)
+    {
+        while ((p < p_colon2) && ((*p == ',') || isspace((unsigned char)*p)))
+        {
+            p++;
+        }
+        if (p == p_colon2)
+        {
+            break;
+        }
+        char key = (char)tolower((unsigned char)*p++);
+        uint32_t value;
+        if ((p >= p_colon2) || (*p++ != '=') || !_rtttl_number(&p, p_colon2, &value))
+        {
+            _error(p_source, "bad setting in \"%.*s\"", (int)(p_colon2 - p_colon1 - 1), p_colon1 + 1);
+            return false;
+        }
+        if ((key == 'd') && _rtttl_is_duration(value))
+        {
+            default_duration = value;
+        }
+        else if ((key == 'o') && (value <= 8))
+        {
+            default_octave = value;
+        }
+        else if ((key == 'b') && (value > 0) && (value <= 900))
+        {
+            bpm = value;
+        }
+        else
+        {
+            _error(p_source, "bad setting %c=%u", key, (unsigned)value);
+            return false;
+        }
+    }
+
+    /* Notes: [duration] letter [#] [.] [octave] [.] */
+    static const int8_t semitones[7] = {9, 11, 0, 2, 4, 5, 7}; /* a b c d e f g */
+    for (const char *p = p_colon2 + 1; p < p_end;)
+    {
+        while ((p < p_end) && ((*p == ',') || isspace((unsigned char)*p)))
+        {
+            p++;
+        }
+        if (p == p_end)
+        {
+            break;
+        }
+        const char *p_start = p;
+        uint32_t duration = default_duration;
+        uint32_t octave = default_octave;
+        bool dotted = false;
+        if (isdigit((unsigned char)*p) && (!_rtttl_number(&p, p_end, &duration) || !_rtttl_is_duration(duration)))
+        {
+            _error(p_source, "bad duration in note %u", (unsigned)(p_song->length + 1));
+            return false;
+        }
+        char letter = (p < p_end) ? (char)tolower((unsigned char)*p++) : '\0';
+        int32_t semitone;
+        if (letter == 'p')
+        {
+            semitone = -1;
+        }
+        else if ((letter >= 'a') && (letter <= 'g'))
+        {
+            semitone = semitones[letter - 'a'];
+        }
+        else if (letter == 'h')
+        {
+            semitone = 11; /* German name of SI */
+        }
+        else
+        {
+            _error(p_source, "bad note \"%.*s\"", (int)(p - p_start), p_start);
+            return false;
+        }
+        if ((p < p_end) && (*p == '#'))
+        {
+            semitone++;
+            p++;
+        }
+        if ((p < p_end) && (*p == '.'))
+        {
+            dotted = true;
+            p++;
+        }
+        if ((p < p_end) && isdigit((unsigned char)*p))
+        {
+            _rtttl_number(&p, p_end, &octave);
+        }
+        if ((p < p_end) && (*p == '.'))
+        {
+            dotted = true;
+            p++;
+        }
+        if ((p < p_end) && (*p != ',') && !isspace((unsigned char)*p))
+        {
+            _error(p_source, "bad note \"%.*s\"", (int)(p - p_start + 1), p_start);
+            return false;
+        }
+
+        /* A whole note lasts 4 beats: 240000 / bpm ms, and a dot adds half the duration */
+        uint32_t numerator = 240000U * (dotted ? 3U : 2U);
+        uint32_t denominator = bpm * duration * 2U;
+        uint32_t duration_ms = (numerator + denominator / 2U) / denominator;
+        uint32_t note = NOTE_SILENCE;
+        if (semitone >= 0)
+        {
+            note = octave * 12U + (uint32_t)semitone + 1U; /* SI# is DO of the next octave */
+            if (note > NOTE_LAST)
+            {
+                _error(p_source, "note %u of \"%s\" is above SI8", (unsigned)(p_song->length + 1), p_song->name);
+                return false;
+            }
+        }
+        _add_note(p_song, note, duration_ms);
+    }
+    return true;
+}
+
+/**
+ * @brief Parse a file of RTTTL strings, one per line.
+ */
+static void _parse_rtttl(const char *p_path)
+{
+    size_t size;
+    char *p_text = (char *)_read_file(p_path, &size);
+    if (p_text == NULL)
+    {
+        return;
+    }
+    uint32_t line_number = 0;
+    for (char *p_line = p_text; p_line < p_text + size;)
+    {
+        char *p_end = memchr(p_line, '\n', (size_t)(p_text + size - p_line));
+        if (p_end == NULL)
+        {
+            p_end = p_text + size;
+        }
+        line_number++;
+        char *p_last = p_end;
+        while ((p_last > p_line) && isspace((unsigned char)p_last[-1]))
+        {
+            p_last--;
+        }
+        while ((p_line < p_last) && isspace((unsigned char)*p_line))
+        {
+            p_line++;
+        }
+        if ((p_line < p_last) && (*p_line != '#'))
+        {
+            char source[256];
+            snprintf(source, sizeof(source), "%s:%u", p_path, (unsigned)line_number);
+            uint32_t count = song_count;
+            if (!_parse_rtttl_line(p_line, p_last, source))
+            {
+                song_count = count; /* The error is reported once, not again when packing */
+            }
+        }
+        p_line = p_end + 1;
+    }
+    free(p_text);
+}
+
+/* MIDI ----------------------------------------------------------------------*/
+/**
+ * @brief Reader of the bytes of a MIDI chunk.
+ */
+typedef struct
+{
+    const uint8_t *p;     /*!< Next byte */
+    const uint8_t *p_end; /*!< End of the chunk */
+    bool bad;             /*!< A read went past the end */
+} midi_reader_t;
+
+static uint32_t _midi_byte(midi_reader_t *p_reader)
+{
+    if (p_reader->p >= p_reader->p_end)
+    {
+        p_reader->bad = true;
+        return 0;
+    }
+    return *p_reader->p++;
+}
+
+static uint32_t _midi_be(const uint8_t *p, uint32_t bytes)
+{
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < bytes; i++)
+    {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static uint32_t _midi_vlq(midi_reader_t *p_reader)
+{
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        uint32_t byte = _midi_byte(p_reader);
+        value = (value << 7) | (byte & 0x7FU);
+        if ((byte & 0x80U) == 0)
+        {
+            return value;
+        }
+    }
+    p_reader->bad = true;
+    return value;
+}
+
+/**
+ * @brief Parse a Standard MIDI File of format 0 into a monophonic melody.
+ *
+ * Only the highest sounding note is kept at each instant, so chords and accompaniment reduce to the top voice. Tempo
+ * changes are honoured; the time is accumulated in µs and every note boundary is rounded to the ms, so the rounding
+ * errors do not add up along the melody.
+ */
+static void _parse_midi(const char *p_path)
+{
+    size_t size;
+    uint8_t *p_data = _read_file(p_path, &size);
+    if (p_data == NULL)
+    {
+        return;
+    }
+    if ((size < 22) || (memcmp(p_data, "MThd", 4) != 0) || (_midi_be(&p_data[4], 4) < 6))
+    {
+        _error(p_path, "not a Standard MIDI File");
+        free(p_data);
+        return;
+    }
+    uint32_t header_length = _midi_be(&p_data[4], 4);
+    uint32_t format = _midi_be(&p_data[8], 2);
+    uint32_t division = _midi_be(&p_data[12], 2);
+    if ((format != 0) || (_midi_be(&p_data[10], 2) != 1))
+    {
+        _error(p_path, "only MIDI files of format 0 (a single track) are supported");
+        free(p_data);
+        return;
+    }
+    if ((division & 0x8000U) || (division == 0))
+    {
+        _error(p_path, "SMPTE time division is not supported");
+        free(p_data);
+        return;
+    }
+    const uint8_t *p_track = &p_data[8 + header_length];
+    if ((p_track + 8 > p_data + size) || (memcmp(p_track, "MTrk", 4) != 0) || (p_track + 8 + _midi_be(&p_track[4], 4) > p_data + size))
+    {
+        _error(p_path, "the MIDI track is missing or truncated");
+        free(p_data);
+        return;
+    }
+    midi_reader_t reader = {.p = p_track + 8, .p_end = p_track + 8 + _midi_be(&p_track[4], 4), .bad = false};
+
+    /* Name of the file without directory or extension, unless the track has a name */
+    const char *p_base = strrchr(p_path, '/');
+    p_base = (p_base != NULL) ? p_base + 1 : p_path;
+    const char *p_dot = strrchr(p_base, '.');
+    song_t *p_song = _new_song(p_base, (p_dot != NULL) ? (size_t)(p_dot - p_base) : strlen(p_base), p_path);
+    bool named = false;
+
+    uint8_t active[MIDI_NOTES] = {0}; /* Note-on count of each MIDI note */
+    uint32_t tempo_us = 500000;       /* µs per quarter note (120 bpm by default) */
+    uint64_t time_us = 0;             /* Time of the current event */
+    uint64_t segment_start_us = 0;    /* Start of the note being built */
+    uint64_t emitted_ms = 0;          /* End of the last note added, in ms */
+    uint32_t segment_note = NOTE_SILENCE;
+    uint32_t status = 0;
+    bool ended = false;
+
+    while (!ended && !reader.bad && (reader.p < reader.p_end))
+    {
+        uint32_t delta = _midi_vlq(&reader);
+        time_us += (uint64_t)delta * tempo_us / division;
+        uint32_t byte = _midi_byte(&reader);
+        if (byte < 0x80U)
+        {
+            if (status == 0)
+            {
+                _error(p_path, "running status without a previous status");
+                break;
+            }
+            reader.p--; /* Running status: the byte is the first data byte */
+        }
+        else if (byte < 0xF0U)
+        {
+            status = byte;
+        }
+
+        if (byte == 0xFFU)
+        {
+            uint32_t type = _midi_byte(&reader);
+            uint32_t length = _midi_vlq(&reader);
+            if (reader.p + length > reader.p_end)
+            {
+                reader.bad = true;
+                break;
+            }
+            if ((type == 0x51U) && (length == 3))
+            {
+                tempo_us = _midi_be(reader.p, 3);
+            }
+            else if ((type == 0x03U) && (length > 0) && !named)
+            {
+                /* Track name, if it gives an identifier */
+                char name[NAME_MAX_LENGTH + 1];
+                _make_name(name, (const char *)reader.p, length);
+                if (name[0] != '\0')
+                {
+                    memcpy(p_song->name, name, sizeof(name));
+                }
+                named = true;
+            }
+            else if (type == 0x2FU)
+            {
+                ended = true;
+            }
+            reader.p += length;
+            continue;
+        }
+        if ((byte == 0xF0U) || (byte == 0xF7U))
+        {
+            uint32_t length = _midi_vlq(&reader);
+            reader.p += length;
+            if (reader.p > reader.p_end)
+            {
+                reader.bad = true;
+            }
+            continue;
+        }
+
+        uint32_t kind = status & 0xF0U;
+        uint32_t data1 = _midi_byte(&reader);
+        uint32_t data2 = ((kind == 0xC0U) || (kind == 0xD0U)) ? 0 : _midi_byte(&reader);
+        if ((kind != 0x80U) && (kind != 0x90U))
+        {
+            continue;
+        }
+        data1 &= 0x7FU;
+        if ((kind == 0x90U) && (data2 > 0))
+        {
+            if (active[data1] < UINT8_MAX)
+            {
+                active[data1]++;
+            }
+        }
+        else if (active[data1] > 0)
+        {
+            active[data1]--;
+        }
+
+        /* Highest sounding note after the event */
+        uint32_t top = NOTE_SILENCE;
+        for (int32_t n = MIDI_NOTES - 1; n >= 0; n--)
+        {
+            if (active[n] > 0)
+            {
+                if (((uint32_t)n < MIDI_NOTE_DO0) || ((uint32_t)n - MIDI_NOTE_DO0 + 1U > NOTE_LAST))
+                {
+                    _error(p_path, "MIDI note %d is out of DO0..SI8", (int)n);
+                    free(p_data);
+                    return;
+                }
+                top = (uint32_t)n - MIDI_NOTE_DO0 + 1U;
+                break;
+            }
+        }
+        if (top != segment_note)
+        {
+            uint64_t end_ms = (time_us + 500U) / 1000U;
+            if (time_us > segment_start_us)
+            {
+                _add_note(p_song, segment_note, (uint32_t)(end_ms - emitted_ms));
+                emitted_ms = end_ms;
+            }
+            segment_note = top;
+            segment_start_us = time_us;
+        }
+    }
+    if (reader.bad)
+    {
+        _error(p_path, "the MIDI track is truncated");
+    }
+    if (segment_note != NOTE_SILENCE)
+    {
+        _add_note(p_song, segment_note, (uint32_t)((time_us + 500U) / 1000U - emitted_ms));
+    }
+    free(p_data);
+}
+
+/* Packing -------------------------------------------------------------------*/
+static uint32_t _gcd(uint32_t a, uint32_t b)
+{
+    while (b != 0)
+    {
+        uint32_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+/**
+ * @brief Validate a melody, choose its tempo base and pack its notes.
+ */
+static void _pack(song_t *p_song)
+{
+    if (p_song->name[0] == '\0')
+    {
+        _error(p_song->source, "the melody has no name");
+        return;
+    }
+    if (p_song->length == 0)
+    {
+        _error(p_song->source, "melody \"%s\" has no notes", p_song->name);
+        return;
+    }
+    if (p_song->length > MELODY_MAX_LENGTH)
+    {
+        _error(p_song->source, "melody \"%s\" has more than %u notes", p_song->name, (unsigned)MELODY_MAX_LENGTH);
+        return;
+    }
+    uint32_t base = 0;
+    uint32_t longest = 0;
+    for (uint32_t i = 0; i < p_song->length; i++)
+    {
+        base = _gcd(base, p_song->p_durations[i]);
+        if (p_song->p_durations[i] > longest)
+        {
+            longest = p_song->p_durations[i];
+        }
+    }
+    if (longest / base > DURATION_MAX)
+    {
+        /* Tempo normalization: the exact base is too fine for the longest note */
+        base = (longest + DURATION_MAX - 1U) / DURATION_MAX;
+        uint32_t worst = 0;
+        for (uint32_t i = 0; i < p_song->length; i++)
+        {
+            uint32_t rounded = (p_song->p_durations[i] + base / 2U) / base * base;
+            uint32_t error = (rounded > p_song->p_durations[i]) ? rounded - p_song->p_durations[i] : p_song->p_durations[i] - rounded;
+            worst = (error > worst) ? error : worst;
+        }
+        fprintf(stderr, "melody_gen: warning: %s: melody \"%s\" rounded to a tempo base of %u ms (up to %u ms per note)\n",
+                p_song->source, p_song->name, (unsigned)base, (unsigned)worst);
+    }
+    if (base > TEMPO_BASE_MAX)
+    {
+        _error(p_song->source, "melody \"%s\" has notes too long to pack", p_song->name);
+        return;
+    }
+    p_song->tempo_base = base;
+    p_song->p_packed = malloc(p_song->length * sizeof(uint16_t));
+    if (p_song->p_packed == NULL)
+    {
+        fprintf(stderr, "melody_gen: out of memory\n");
+        exit(1);
+    }
+    for (uint32_t i = 0; i < p_song->length; i++)
+    {
+        uint32_t code = (p_song->p_durations[i] + base / 2U) / base;
+        if (code == 0)
+        {
+            code = 1; /* A note too short for the base still sounds */
+        }
+        p_song->p_packed[i] = (uint16_t)((p_song->p_notes[i] << DURATION_BITS) | code);
+        p_song->duration_ms += code * base;
+    }
+    p_song->name_hash = FNV_OFFSET_BASIS;
+    for (const char *p = p_song->name; *p != '\0'; p++)
+    {
+        p_song->name_hash = (p_song->name_hash ^ (uint8_t)*p) * FNV_PRIME;
+    }
+}
+
+/* Metadata index ------------------------------------------------------------*/
+/**
+ * @brief Order by name.
+ */
+static int _compare_name(const void *p_a, const void *p_b)
+{
+    return strcmp(songs[*(const uint16_t *)p_a].name, songs[*(const uint16_t *)p_b].name);
+}
+
+/**
+ * @brief Order by total duration, and by name for equal durations.
+ */
+static int _compare_duration(const void *p_a, const void *p_b)
+{
+    const song_t *p_song_a = &songs[*(const uint16_t *)p_a];
+    const song_t *p_song_b = &songs[*(const uint16_t *)p_b];
+    if (p_song_a->duration_ms != p_song_b->duration_ms)
+    {
+        return (p_song_a->duration_ms < p_song_b->duration_ms) ? -1 : 1;
+    }
+    return strcmp(p_song_a->name, p_song_b->name);
+}
+
+/**
+ * @brief Write an array of positions of the library.
+ */
+static void _write_positions(FILE *p_out, const char *p_name, const uint16_t *p_positions, uint32_t length)
+{
+    fprintf(p_out, "const uint16_t %s[%u] = {", p_name, (unsigned)length);
+    for (uint32_t i = 0; i < length; i++)
+    {
+        fprintf(p_out, "%s%u%s", (i % 16 == 0) ? "\n    " : " ", (unsigned)p_positions[i], (i + 1 < length) ? "," : "");
+    }
+    fprintf(p_out, "};\n\n");
+}
+
+/**
+ * @brief Write the metadata index: one entry per melody, the orders by name and by duration with their inverse, and
+ * an open-addressing table of the name hashes at most half full.
+ */
+static void _write_index(FILE *p_out)
+{
+    uint16_t *p_by_name = malloc(song_count * sizeof(uint16_t));
+    uint16_t *p_by_duration = malloc(song_count * sizeof(uint16_t));
+    uint16_t *p_rank = malloc(song_count * sizeof(uint16_t));
+    uint32_t slots = 2;
+    while (slots < 2U * song_count)
+    {
+        slots *= 2U;
+    }
+    uint16_t *p_slots = malloc(slots * sizeof(uint16_t));
+    if ((p_by_name == NULL) || (p_by_duration == NULL) || (p_rank == NULL) || (p_slots == NULL))
+    {
+        fprintf(stderr, "melody_gen: out of memory\n");
+        exit(1);
+    }
+    for (uint32_t s = 0; s < song_count; s++)
+    {
+        p_by_name[s] = (uint16_t)s;
+        p_by_duration[s] = (uint16_t)s;
+    }
+    qsort(p_by_name, song_count, sizeof(uint16_t), _compare_name);
+    qsort(p_by_duration, song_count, sizeof(uint16_t), _compare_duration);
+
+    fprintf(p_out, "const melody_info_t melody_index[%u] = {", (unsigned)song_count);
+    for (uint32_t s = 0; s < song_count; s++)
+    {
+        const song_t *p_song = &songs[s];
+        fprintf(p_out, "\n    {.p_melody = &%s_melody, .p_name = \"%s\", .melody_length = %u, .duration_ms = %u, .name_hash = 0x%08X}%s",
+                p_song->name, p_song->name, (unsigned)p_song->length, (unsigned)p_song->duration_ms, (unsigned)p_song->name_hash,
+                (s + 1 < song_count) ? "," : "");
+    }
+    fprintf(p_out, "};\n\n");
+    _write_positions(p_out, "melody_by_name", p_by_name, song_count);
+    for (uint32_t i = 0; i < song_count; i++)
+    {
+        p_rank[p_by_name[i]] = (uint16_t)i;
+    }
+    _write_positions(p_out, "melody_name_rank", p_rank, song_count);
+    _write_positions(p_out, "melody_by_duration", p_by_duration, song_count);
+    for (uint32_t i = 0; i < song_count; i++)
+    {
+        p_rank[p_by_duration[i]] = (uint16_t)i;
+    }
+    _write_positions(p_out, "melody_duration_rank", p_rank, song_count);
+
+    memset(p_slots, 0xFF, slots * sizeof(uint16_t));
+    for (uint32_t s = 0; s < song_count; s++)
+    {
+        uint32_t hash = songs[s].name_hash;
+        uint32_t slot = (hash ^ (hash >> 16)) & (slots - 1U);
+        while (p_slots[slot] != 0xFFFFU)
+        {
+            slot = (slot + 1U) & (slots - 1U);
+        }
+        p_slots[slot] = (uint16_t)s;
+    }
+    _write_positions(p_out, "melody_name_slots", p_slots, slots);
+    fprintf(p_out, "const uint32_t melody_name_mask = 0x%X;\n", (unsigned)(slots - 1U));
+    free(p_by_name);
+    free(p_by_duration);
+    free(p_rank);
+    free(p_slots);
+}
+
+/**
+ * @brief Write the C file with the melodies and the index.
+ */
+static bool _write_output(const char *p_path)
+{
+    FILE *p_out = fopen(p_path, "w");
+    if (p_out == NULL)
+    {
+        _error(p_path, "cannot create the file");
+        return false;
+    }
+    fprintf(p_out, "/**\n * @file melody_library.c\n * @brief Melodies generated by melody_gen from the files of `melodies/`. Do not edit.\n */\n\n");
+    fprintf(p_out, "/* Includes ------------------------------------------------------------------*/\n#include \"melodies.h\"\n#include \"melody_index.h\"\n\n");
+    fprintf(p_out, "/* Melodies ------------------------------------------------------------------*/\n");
+    for (uint32_t s = 0; s < song_count; s++)
+    {
+        const song_t *p_song = &songs[s];
+        const char *p_array = (p_song->shared >= 0) ? songs[p_song->shared].name : p_song->name;
+        fprintf(p_out, "// %s\n", p_song->source);
+        if (p_song->shared < 0)
+        {
+            fprintf(p_out, "static const uint16_t %s_melody_notes[%u] = {", p_song->name, (unsigned)p_song->length);
+            for (uint32_t i = 0; i < p_song->length; i++)
+            {
+                fprintf(p_out, "%s0x%04X%s", (i % 12 == 0) ? "\n    " : " ", p_song->p_packed[i], (i + 1 < p_song->length) ? "," : "");
+            }
+            fprintf(p_out, "};\n\n");
+        }
+        fprintf(p_out, "const melody_t %s_melody = {.p_name = \"%s\", .p_notes = %s_melody_notes, .melody_length = %u, .tempo_base_ms = %u};\n\n",
+                p_song->name, p_song->name, p_array, (unsigned)p_song->length, (unsigned)p_song->tempo_base);
+    }
+    fprintf(p_out, "/* Index ---------------------------------------------------------------------*/\n");
+    fprintf(p_out, "const melody_t *const melody_library[] = {");
+    for (uint32_t s = 0; s < song_count; s++)
+    {
+        fprintf(p_out, "\n    &%s_melody%s", songs[s].name, (s + 1 < song_count) ? "," : "");
+    }
+    fprintf(p_out, "};\n\nconst uint32_t melody_library_length = %u;\n\n", (unsigned)song_count);
+    _write_index(p_out);
+    bool ok = (ferror(p_out) == 0);
+    ok = (fclose(p_out) == 0) && ok;
+    if (!ok)
+    {
+        _error(p_path, "cannot write the file");
+    }
+    return ok;
+}
+
+/**
+ * @brief Main function of the tool.
+ *
+ * @return 0 if the output was written, 1 otherwise.
+ */
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: melody_gen <output.c> <file.rtttl|file.mid>...\n");
+        return 1;
+    }
+    for (int i = 2; i < argc; i++)
+    {
+        size_t length = strlen(argv[i]);
+        if ((length > 4) && (strcmp(&argv[i][length - 4], ".mid") == 0))
+        {
+            _parse_midi(argv[i]);
+        }
+        else
+        {
+            _parse_rtttl(argv[i]);
+        }
+    }
+    for (uint32_t s = 0; s < song_count; s++)
+    {
+        _pack(&songs[s]);
+        for (uint32_t t = 0; t < s; t++)
+        {
+            if (strcmp(songs[s].name, songs[t].name) == 0)
+            {
+                _error(songs[s].source, "melody \"%s\" is already defined in %s", songs[s].name, songs[t].source);
+                break;
+            }
+        }
+    }
+    if (song_count == 0)
+    {
+        _error(argv[1], "there are no melodies");
+    }
+    else if (song_count > LIBRARY_MAX_LENGTH)
+    {
+        _error(argv[1], "there are more than %u melodies", (unsigned)LIBRARY_MAX_LENGTH);
+    }
+    if (errors > 0)
+    {
+        return 1;
+    }
+    for (uint32_t s = 0; s < song_count; s++)
+    {
+        for (uint32_t t = 0; t < s; t++)
+        {
+            if ((songs[t].shared < 0) && (songs[s].length == songs[t].length) && (songs[s].tempo_base == songs[t].tempo_base) &&
+                (memcmp(songs[s].p_packed, songs[t].p_packed, songs[s].length * sizeof(uint16_t)) == 0))
+            {
+                songs[s].shared = (int32_t)t;
+                fprintf(stderr, "melody_gen: note: %s: melody \"%s\" shares the notes of \"%s\"\n", songs[s].source, songs[s].name, songs[t].name);
+                break;
+            }
+        }
+    }
+    if (!_write_output(argv[1]))
+    {
+        return 1;
+    }
+    printf("melody_gen: %u melodies written to %s\n", (unsigned)song_count, argv[1]);
+    return 0;
+}
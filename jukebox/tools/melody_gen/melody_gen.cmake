@@ -0,0 +1,22 @@
+# Melody library: melody_gen converts the RTTTL and MIDI files of melodies/ into melody_library.c at build time
+INCLUDE(ExternalProject)
+SET(MELODY_GEN_DIR ${CMAKE_BINARY_DIR}/melody_gen)
+SET(MELODY_GEN ${MELODY_GEN_DIR}/melody_gen${CMAKE_HOST_EXECUTABLE_SUFFIX})
+ExternalProject_Add(melody_gen
+    SOURCE_DIR ${CMAKE_CURRENT_LIST_DIR}
+    BINARY_DIR ${MELODY_GEN_DIR}
+    CMAKE_ARGS -DCMAKE_BUILD_TYPE=Release
+    INSTALL_COMMAND ""
+    BUILD_ALWAYS TRUE
+    BUILD_BYPRODUCTS ${MELODY_GEN})
+
+# Every file of melodies/, in alphabetical order (the order of the index)
+FILE(GLOB MELODY_FILES CONFIGURE_DEPENDS ${CMAKE_CURRENT_SOURCE_DIR}/melodies/*.rtttl ${CMAKE_CURRENT_SOURCE_DIR}/melodies/*.mid)
+LIST(SORT MELODY_FILES)
+SET(MELODY_LIBRARY ${CMAKE_BINARY_DIR}/generated/melody_library.c)
+ADD_CUSTOM_COMMAND(OUTPUT ${MELODY_LIBRARY}
+    COMMAND ${CMAKE_COMMAND} -E make_directory ${CMAKE_BINARY_DIR}/generated
+    COMMAND ${MELODY_GEN} ${MELODY_LIBRARY} ${MELODY_FILES}
+    DEPENDS melody_gen ${MELODY_GEN} ${MELODY_FILES}
+    COMMENT "Generating the melody library from ${CMAKE_CURRENT_SOURCE_DIR}/melodies")
+TARGET_SOURCES(${PROJECT_NAME} PRIVATE ${MELODY_LIBRARY})